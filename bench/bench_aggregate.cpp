@@ -0,0 +1,106 @@
+// COUNT(*)/MIN(id)/MAX(id) and deep OFFSET pages, answered from the row counts
+// in the tree versus the same result folded or skipped over a full scan.
+// usage: bench_aggregate [rows] [repeats]
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "row.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_aggregate.db";
+
+    uint64_t drain(BatchOperator& op) {
+        uint64_t rows = 0;
+        Batch batch;
+        while (op.next(batch)) {
+            rows += batch.selectedCount;
+        }
+        return rows;
+    }
+
+    template <typename Body>
+    double bestOf(uint32_t repeats, uint64_t& result, Body body) {
+        double best = 1e300;
+        for (uint32_t i = 0; i < repeats; i++) {
+            auto start = std::chrono::steady_clock::now();
+            result = body();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    void report(const char* label, double scanSeconds, uint64_t scanResult, double treeSeconds, uint64_t treeResult) {
+        if (scanResult != treeResult) {
+            std::fprintf(stderr, "%s: results differ (%llu, %llu)\n", label,
+                         static_cast<unsigned long long>(scanResult), static_cast<unsigned long long>(treeResult));
+        }
+        std::printf("%-30s %10.3f ms %10.4f ms %12llu\n", label, scanSeconds * 1e3, treeSeconds * 1e3,
+                    static_cast<unsigned long long>(treeResult));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t repeats = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 5;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    Table table(DB_FILE, 2 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+    for (uint32_t id = 1; id <= numRows; id++) {
+        table.insertRow(Row(id * 2, "user" + std::to_string(id % 100), std::to_string(id) + "@example.com"));
+    }
+
+    std::printf("%u rows, best of %u\n", numRows, repeats);
+    std::printf("%-30s %13s %13s %12s\n", "query", "scan", "row counts", "result");
+
+    uint64_t scanCount = 0;
+    double scanSeconds = bestOf(repeats, scanCount, [&]() {
+        AggregateOperator count(std::make_unique<TableScan>(table), {{AggregateFunction::COUNT, 0}});
+        Batch batch;
+        count.next(batch);
+        return static_cast<uint64_t>(batch.columns[0].integers[0]);
+    });
+    uint64_t treeCount = 0;
+    double treeSeconds = bestOf(repeats, treeCount, [&]() { return static_cast<uint64_t>(table.getNumRows()); });
+    report("COUNT(*)", scanSeconds, scanCount, treeSeconds, treeCount);
+
+    uint64_t scanRange = 0;
+    scanSeconds = bestOf(repeats, scanRange, [&]() {
+        AggregateOperator count(std::make_unique<TableScan>(table, numRows / 2, numRows),
+                                {{AggregateFunction::COUNT, 0}, {AggregateFunction::MAX, COLUMN_ID}});
+        Batch batch;
+        count.next(batch);
+        return static_cast<uint64_t>(batch.columns[0].integers[0] + batch.columns[1].integers[0]);
+    });
+    uint64_t treeRange = 0;
+    treeSeconds = bestOf(repeats, treeRange, [&]() {
+        uint32_t begin = table.countRowsBelow(numRows / 2);
+        uint32_t end = table.countRowsBelow(static_cast<uint64_t>(numRows) + 1);
+        uint32_t maximum = 0;
+        table.keyAtRank(end - 1, maximum);
+        return static_cast<uint64_t>(end - begin) + maximum;
+    });
+    report("COUNT(*) + MAX(id), half range", scanSeconds, scanRange, treeSeconds, treeRange);
+
+    // LIMIT 10 OFFSET <90% of the table>
+    uint32_t offset = numRows / 10 * 9;
+    uint64_t scanPage = 0;
+    scanSeconds = bestOf(repeats, scanPage, [&]() {
+        LimitOperator page(std::make_unique<TableScan>(table), offset, 10);
+        return drain(page);
+    });
+    uint64_t treePage = 0;
+    treeSeconds = bestOf(repeats, treePage, [&]() {
+        uint32_t start = 0;
+        table.keyAtRank(offset, start);
+        LimitOperator page(std::make_unique<TableScan>(table, start), 0, 10);
+        return drain(page);
+    });
+    report("LIMIT 10 OFFSET 90%", scanSeconds, scanPage, treeSeconds, treePage);
+
+    std::remove(DB_FILE);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// A script of inserts fed to the engine the way the REPL reads piped input
+// (std::getline per line, autocommit per statement, "Executed." and the
+// legacy "Table:" echo written to an output file) against runScript, which
+// maps the file, prints nothing per statement and commits once. Half the
+// statements are legacy "insert", half SQL INSERT. The REPL path commits,
+// and so syncs the WAL, once per statement, so it gets a shorter script.
+// usage: bench_batch [statements] [REPL statements]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "input_buffer.hpp"
+#include "meta_command_processor.hpp"
+#include "script_runner.hpp"
+#include "statement_processor.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_batch.db";
+    const char* const SCRIPT_FILE = "bench_batch.sql";
+    const char* const OUTPUT_FILE = "bench_batch.out";
+
+    double elapsed(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void removeDatabase() {
+        std::remove(DB_FILE);
+        std::remove((std::string(DB_FILE) + "-wal").c_str());
+    }
+
+    void writeScript(uint32_t statements) {
+        std::ofstream script(SCRIPT_FILE, std::ios::binary);
+        for (uint32_t id = 1; id <= statements; id++) {
+            if (id % 2 == 0) {
+                script << "insert " << id << " user" << id << " user" << id << "@example.com\n";
+            } else {
+                script << "INSERT INTO users VALUES (" << id << ", 'user" << id << "', 'user" << id
+                       << "@example.com');\n";
+            }
+        }
+    }
+
+    // What main's loop does for each line of piped input, minus the prompt
+    double replPath(uint32_t statements) {
+        removeDatabase();
+        Table table(DB_FILE);
+        StatementProcessor processor(table);
+        std::ifstream script(SCRIPT_FILE);
+        std::ofstream output(OUTPUT_FILE);
+        std::streambuf* saved = std::cout.rdbuf(output.rdbuf());
+        InputBuffer input(&script);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < statements; i++) {
+            input.readInput();
+            if (processor.execute(input.getBuffer()) == PrepareResult::PREPARE_SUCCESS) {
+                std::cout << "Executed.\n";
+            }
+        }
+        std::cout.flush();
+        double seconds = elapsed(start);
+        std::cout.rdbuf(saved);
+        if (table.getNumRows() != statements) {
+            std::printf("REPL path lost rows\n");
+            std::exit(1);
+        }
+        return seconds;
+    }
+
+    double batchPath(uint32_t statements) {
+        removeDatabase();
+        Table table(DB_FILE);
+        StatementProcessor processor(table);
+        MetaCommandProcessor metaCommands;
+        ScriptResult result = runScript(table, processor, metaCommands, SCRIPT_FILE);
+        if (result.errors != 0 || table.getNumRows() != statements) {
+            std::printf("batch lost rows\n");
+            std::exit(1);
+        }
+        return result.seconds;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t statements = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t replStatements = std::min(statements, argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 2000u);
+
+    std::printf("%-28s %10s %14s\n", "path", "time", "statements/s");
+    writeScript(replStatements);
+    double seconds = replPath(replStatements);
+    std::string label = "REPL, " + std::to_string(replStatements) + " statements";
+    std::printf("%-28s %7.1f ms %14.0f\n", label.c_str(), seconds * 1e3, replStatements / seconds);
+    writeScript(statements);
+    seconds = batchPath(statements);
+    label = "--batch, " + std::to_string(statements) + " statements";
+    std::printf("%-28s %7.1f ms %14.0f\n", label.c_str(), seconds * 1e3, statements / seconds);
+
+    removeDatabase();
+    std::remove(SCRIPT_FILE);
+    std::remove(OUTPUT_FILE);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Scans that read one column of every row, from the tree's fixed-width leaf
+// cells and from a column store projecting that column: the whole column, a
+// LIKE filter on it, and an equality filter whose value sits in one segment,
+// so the zone maps skip the rest. The column store scans are timed again
+// with a full delta buffer of fresh rows merged in.
+// usage: bench_column_scan [rows] [repeats]
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "column_store.hpp"
+#include "filter_kernels.hpp"
+#include "row.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_column_scan.db";
+
+    struct Query {
+        const char* label;
+        bool filtered;
+        FieldMatch match;
+        std::string literal;
+    };
+
+    // Usernames rise with the id, as when rows are loaded in order of a name
+    std::string nameOf(uint32_t id) {
+        char name[24];
+        std::snprintf(name, sizeof(name), "user%08u", id);
+        return name;
+    }
+
+    template <typename Scan>
+    uint64_t run(Scan& scan, const Query& query) {
+        if (query.filtered) {
+            FieldFilter filter;
+            makeFieldFilter(query.match, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, query.literal, filter);
+            scan.pushFilter(filter);
+        }
+        uint64_t bytes = 0;
+        Batch batch;
+        while (scan.next(batch)) {
+            for (uint32_t s = 0; s < batch.selectedCount; s++) {
+                bytes += batch.columns[COLUMN_USERNAME].texts[batch.selection[s]].size();
+            }
+        }
+        return bytes;
+    }
+
+    template <typename Body>
+    double bestOf(uint32_t repeats, uint64_t& result, Body body) {
+        double best = 1e300;
+        for (uint32_t i = 0; i < repeats; i++) {
+            auto start = std::chrono::steady_clock::now();
+            result = body();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t repeats = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 5;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    // enough cache for the whole table, so both sides scan memory
+    Table table(DB_FILE, numRows / LEAF_NODE_MAX_CELLS + 1024);
+    for (uint32_t id = 1; id <= numRows; id++) {
+        table.insertRow(Row(id, nameOf(id), "user" + std::to_string(id) + "@example.com"));
+    }
+    table.createColumnStore(1u << COLUMN_USERNAME);
+    const ColumnStore& store = *table.getColumnStore();
+
+    Query queries[] = {
+        {"username, all rows", false, FieldMatch::EQUALS, ""},
+        {"LIKE '%7%'", true, FieldMatch::CONTAINS, "7"},
+        {"= one name", true, FieldMatch::EQUALS, nameOf(numRows / 2)},
+    };
+    std::printf("%u rows, %zu segments; best of %u\n", numRows, store.getSegments().size(), repeats);
+    std::printf("%-20s %12s %12s %9s %14s %10s\n", "query", "row scan", "column scan", "speedup", "with delta",
+                "skipped");
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            // fills the delta buffer without folding it
+            for (uint32_t i = 1; i < COLUMN_DELTA_MAX_ROWS; i++) {
+                table.insertRow(Row(numRows + i, nameOf(numRows + i), "late@example.com"));
+            }
+            std::printf("after %zu buffered inserts:\n", store.getDelta().size());
+        }
+        for (const Query& query : queries) {
+            uint64_t rowBytes = 0;
+            uint64_t columnBytes = 0;
+            uint64_t skipped = 0;
+            double rows = bestOf(repeats, rowBytes, [&] {
+                TableScan scan(table);
+                return run(scan, query);
+            });
+            double columns = bestOf(repeats, columnBytes, [&] {
+                ColumnStoreScan scan(store);
+                uint64_t bytes = run(scan, query);
+                skipped = scan.getSegmentsSkipped();
+                return bytes;
+            });
+            if (rowBytes != columnBytes) {
+                std::printf("%s: the scans disagree\n", query.label);
+                return 1;
+            }
+            std::printf("%-20s %9.2f ms %9.2f ms %8.1fx %14s %10llu\n", query.label, rows * 1e3, columns * 1e3,
+                        rows / columns, pass == 0 ? "no" : "yes", static_cast<unsigned long long>(skipped));
+        }
+    }
+
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+    return 0;
+}
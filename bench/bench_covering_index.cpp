@@ -0,0 +1,96 @@
+// Lookups by username through an index on username alone versus one that
+// also carries email (INCLUDE), read through a small page cache: the plain
+// index fetches every matching row from the table tree, the covering index
+// answers from its own leaves.
+// usage: bench_covering_index [rows] [lookups] [cache pages]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "prepared_statement.hpp"
+#include "row.hpp"
+#include "table.hpp"
+
+namespace {
+    std::unique_ptr<PreparedStatement> prepare(Table& table, const std::string& sql) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        if (CompiledStatement::compile(sql, compiled, error) != PrepareResult::PREPARE_SUCCESS) {
+            std::fprintf(stderr, "%s: %s\n", sql.c_str(), error.c_str());
+            std::exit(1);
+        }
+        return std::make_unique<PreparedStatement>(table, compiled);
+    }
+
+    struct Result {
+        double seconds;     // per lookup
+        double pageReads;   // per lookup
+        uint64_t rows;
+    };
+
+    // Builds a table with one index on username, then reopens it with a
+    // cache of cachePages and runs a lookup per name
+    Result run(const char* file, const std::string& createIndex, uint32_t numRows,
+               const std::vector<std::string>& names, uint32_t cachePages) {
+        std::remove(file);
+        std::remove((std::string(file) + "-wal").c_str());
+        {
+            Table table(file, 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+            prepare(table, createIndex)->step();
+            for (uint32_t id = 1; id <= numRows; id++) {
+                table.insertRow(Row(id, "name" + std::to_string(id % 1000), "user" + std::to_string(id) + "@example.com"));
+            }
+        }
+
+        Table table(file, cachePages);
+        auto select = prepare(table, "SELECT id, email FROM users WHERE username = ?");
+        Result result{0, 0, 0};
+        uint64_t readsBefore = table.getPager().getStats().pageReads;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& name : names) {
+            select->reset();
+            select->bindText(1, name);
+            while (select->step() == StepResult::ROW) {
+                result.rows++;
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / names.size();
+        result.pageReads = static_cast<double>(table.getPager().getStats().pageReads - readsBefore) / names.size();
+        return result;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200;
+    uint32_t cachePages = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 256;
+
+    std::mt19937 generator(5);
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < numLookups; i++) {
+        names.push_back("name" + std::to_string(generator() % 1000));
+    }
+
+    Result plain = run("bench_plain_index.db", "CREATE INDEX ON users (username)", numRows, names, cachePages);
+    Result covering = run("bench_covering_index.db", "CREATE INDEX ON users (username) INCLUDE (email)", numRows,
+                          names, cachePages);
+
+    if (plain.rows != covering.rows) {
+        std::fprintf(stderr, "results differ (%llu, %llu)\n", static_cast<unsigned long long>(plain.rows),
+                     static_cast<unsigned long long>(covering.rows));
+    }
+    std::printf("%u rows, %u lookups of ~%llu rows each, %u cache pages\n", numRows, numLookups,
+                static_cast<unsigned long long>(plain.rows / numLookups), cachePages);
+    std::printf("%-28s %12s %14s\n", "SELECT id, email", "per lookup", "page reads");
+    std::printf("%-28s %9.3f ms %14.1f\n", "index on username", plain.seconds * 1e3, plain.pageReads);
+    std::printf("%-28s %9.3f ms %14.1f\n", "... INCLUDE (email)", covering.seconds * 1e3, covering.pageReads);
+    std::printf("%-28s %11.1fx %13.1fx\n", "saved", plain.seconds / covering.seconds,
+                plain.pageReads / covering.pageReads);
+
+    std::remove("bench_plain_index.db");
+    std::remove("bench_covering_index.db");
+    return 0;
+}
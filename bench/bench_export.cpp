@@ -0,0 +1,92 @@
+// Writing every row of users to a file: the select path (execute_select_all,
+// formatting through std::cout, here redirected into an ofstream) against
+// exportTable's ResultSink in CSV, TSV and binary. Reports MB/s of output and
+// rows/s; the table is read once beforehand so every run starts with its
+// pages cached.
+// usage: bench_export [rows]
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "database.hpp"
+#include "result_sink.hpp"
+#include "row.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_export.db";
+    const char* const OUT_FILE = "bench_export.out";
+
+    double elapsed(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void removeDatabase() {
+        std::remove(DB_FILE);
+        std::remove((std::string(DB_FILE) + "-wal").c_str());
+    }
+
+    double outputMegabytes() {
+        struct stat info;
+        return stat(OUT_FILE, &info) == 0 ? info.st_size / 1e6 : 0;
+    }
+
+    void report(const char* label, double seconds, uint32_t numRows) {
+        double megabytes = outputMegabytes();
+        std::printf("%-22s %7.1f ms %8.1f MB %10.1f %12.0f\n", label, seconds * 1e3, megabytes,
+                    megabytes / seconds, numRows / seconds);
+    }
+
+    double selectAll(Table& table) {
+        std::ofstream out(OUT_FILE, std::ios::binary | std::ios::trunc);
+        std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+        auto start = std::chrono::steady_clock::now();
+        table.execute_select_all();
+        std::cout.flush();
+        double seconds = elapsed(start);
+        std::cout.rdbuf(saved);
+        return seconds;
+    }
+
+    double exportAs(Table& table, ExportFormat format, uint32_t expectedRows) {
+        int fd = open(OUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t rows = exportTable(table, "users", fd, format);
+        double seconds = elapsed(start);
+        close(fd);
+        if (rows != expectedRows) {
+            std::printf("export lost rows\n");
+            std::exit(1);
+        }
+        return seconds;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 300000;
+
+    removeDatabase();
+    Database database(DB_FILE);
+    Table& table = database.getTable();
+    table.beginTransaction();
+    for (uint32_t id = 1; id <= numRows; id++) {
+        table.insertRow(Row(id, "user" + std::to_string(id), "user" + std::to_string(id) + "@example.com"));
+    }
+    table.commitTransaction();
+    exportAs(table, ExportFormat::BINARY, numRows);
+
+    std::printf("%u rows\n", numRows);
+    std::printf("%-22s %10s %11s %10s %12s\n", "path", "time", "output", "MB/s", "rows/s");
+    report("select (std::cout)", selectAll(table), numRows);
+    report(".export csv", exportAs(table, ExportFormat::CSV, numRows), numRows);
+    report(".export tsv", exportAs(table, ExportFormat::TSV, numRows), numRows);
+    report(".export binary", exportAs(table, ExportFormat::BINARY, numRows), numRows);
+
+    removeDatabase();
+    std::remove(OUT_FILE);
+    return 0;
+}
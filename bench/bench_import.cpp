@@ -0,0 +1,109 @@
+// CSV import into an empty users table: .import's path (mmap, chunks parsed
+// in parallel, sorted, built bottom up) with one worker and with more, against
+// inserting the same rows one insertRow at a time in one transaction. Rows
+// come in shuffled order, so the sort has work to do. Reports MB/s and rows/s
+// of the whole import, commit included. A table holds at most about 850,000
+// rows (65,536 pages of 13), so the files stay under ~50 MB.
+// usage: bench_import [rows] [max workers] [insertRow rows]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "csv_import.hpp"
+#include "database.hpp"
+#include "row.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_import.db";
+    const char* const CSV_FILE = "bench_import.csv";
+
+    double elapsed(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void removeDatabase() {
+        std::remove(DB_FILE);
+        std::remove((std::string(DB_FILE) + "-wal").c_str());
+    }
+
+    std::string usernameOf(uint32_t id) {
+        return "user" + std::to_string(id);
+    }
+
+    std::string emailOf(uint32_t id) {
+        return "user" + std::to_string(id) + "@example.com";
+    }
+
+    size_t writeCsv(const std::vector<uint32_t>& ids) {
+        std::FILE* file = std::fopen(CSV_FILE, "wb");
+        std::string line;
+        size_t bytes = 0;
+        for (uint32_t id : ids) {
+            line = std::to_string(id) + "," + usernameOf(id) + "," + emailOf(id) + "\n";
+            std::fwrite(line.data(), 1, line.size(), file);
+            bytes += line.size();
+        }
+        std::fclose(file);
+        return bytes;
+    }
+
+    double import(uint32_t workers, uint32_t expectedRows) {
+        removeDatabase();
+        DatabaseOptions options;
+        options.maxWorkerThreads = workers;
+        Database database(DB_FILE, options);
+        auto start = std::chrono::steady_clock::now();
+        ImportResult result = importCsv(database.getTable(), CSV_FILE, "users");
+        double seconds = elapsed(start);
+        if (result.rows != expectedRows || database.getTable().getNumRows() != expectedRows) {
+            std::printf("import lost rows\n");
+            std::exit(1);
+        }
+        return seconds;
+    }
+
+    double insertRows(const std::vector<uint32_t>& ids, uint32_t count) {
+        removeDatabase();
+        Database database(DB_FILE);
+        Table& table = database.getTable();
+        auto start = std::chrono::steady_clock::now();
+        table.beginTransaction();
+        for (uint32_t i = 0; i < count; i++) {
+            table.insertRow(Row(ids[i], usernameOf(ids[i]), emailOf(ids[i])));
+        }
+        table.commitTransaction();
+        return elapsed(start);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 500000;
+    uint32_t maxWorkers = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 8;
+    uint32_t insertCount = std::min(numRows, argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 50000u);
+
+    std::vector<uint32_t> ids(numRows);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(11));
+    double megabytes = writeCsv(ids) / 1e6;
+
+    std::printf("%u rows, %.1f MB of CSV, shuffled ids\n", numRows, megabytes);
+    std::printf("%-22s %10s %10s %12s\n", "path", "time", "MB/s", "rows/s");
+    for (uint32_t workers : {1u, maxWorkers}) {
+        double seconds = import(workers, numRows);
+        std::string label = ".import, " + std::to_string(workers) + (workers == 1 ? " worker" : " workers");
+        std::printf("%-22s %7.1f ms %10.1f %12.0f\n", label.c_str(), seconds * 1e3, megabytes / seconds,
+                    numRows / seconds);
+    }
+    double seconds = insertRows(ids, insertCount);
+    std::string label = "insertRow, " + std::to_string(insertCount) + " rows";
+    std::printf("%-22s %7.1f ms %10.1f %12.0f\n", label.c_str(), seconds * 1e3,
+                megabytes * insertCount / numRows / seconds, insertCount / seconds);
+
+    removeDatabase();
+    std::remove(CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Shape of the secondary indexes on a users table with long, similar emails
+// and usernames: tree height, internal pages and their fanout, and page reads
+// per index probe with a small cache. Rows go in in random order, like a
+// table filled over time.
+// usage: bench_index_height [rows] [lookups] [cache pages]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "index_node.hpp"
+#include "row.hpp"
+#include "secondary_index.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_index_height.db";
+
+    std::string usernameFor(uint32_t id) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "member_%08u", id * 2654435761u % 100000000u);
+        return name;
+    }
+
+    std::string emailFor(uint32_t id) {
+        return usernameFor(id) + ".accounts@customers.example-corporation.com";
+    }
+
+    struct Shape {
+        uint32_t height = 0;
+        uint64_t internalPages = 0;
+        uint64_t children = 0;
+        uint64_t leaves = 0;
+    };
+
+    void walk(Table& table, uint32_t pageNum, uint32_t depth, Shape& shape) {
+        IndexNode node(table.getPageAddress(pageNum));
+        shape.height = std::max(shape.height, depth);
+        if (node.isLeaf()) {
+            shape.leaves++;
+            return;
+        }
+        uint32_t count = node.numCells();
+        shape.internalPages++;
+        shape.children += count + 1;
+        for (uint32_t i = 0; i <= count; i++) {
+            walk(table, IndexNode(table.getPageAddress(pageNum)).childAt(i), depth + 1, shape);
+        }
+    }
+
+    void report(Table& table, const char* name, uint32_t column, const std::vector<std::string>& keys) {
+        const SecondaryIndex& index = *table.getIndex(column);
+        Shape shape;
+        walk(table, index.getRootPageNum(), 1, shape);
+
+        uint64_t readsBefore = table.getPager().getStats().pageReads;
+        auto start = std::chrono::steady_clock::now();
+        uint32_t found = 0;
+        for (const std::string& key : keys) {
+            IndexCursor cursor(index, key);
+            found += !cursor.isEnd() && cursor.key() == key;
+            table.getPager().evictToCapacity();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t reads = table.getPager().getStats().pageReads - readsBefore;
+
+        std::printf("%-9s %7u %10llu %8.1f %8llu %10.2f %8.2f us %7u\n", name, shape.height,
+                    static_cast<unsigned long long>(shape.internalPages),
+                    static_cast<double>(shape.children) / shape.internalPages,
+                    static_cast<unsigned long long>(shape.leaves), static_cast<double>(reads) / keys.size(),
+                    seconds / keys.size() * 1e6, found);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20000;
+    uint32_t cachePages = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 16;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    std::vector<uint32_t> ids;
+    for (uint32_t id = 1; id <= numRows; id++) {
+        ids.push_back(id);
+    }
+    std::mt19937 generator(5);
+    std::shuffle(ids.begin(), ids.end(), generator);
+
+    {
+        Table table(DB_FILE, 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+        table.createIndex(COLUMN_USERNAME);
+        table.createIndex(COLUMN_EMAIL);
+        for (uint32_t id : ids) {
+            table.insertRow(Row(id, usernameFor(id), emailFor(id)));
+        }
+    }
+    std::vector<std::string> usernames;
+    std::vector<std::string> emails;
+    for (uint32_t i = 0; i < numLookups; i++) {
+        uint32_t id = ids[generator() % numRows];
+        usernames.push_back(usernameFor(id));
+        emails.push_back(emailFor(id));
+    }
+
+    std::printf("%u rows, %u random probes per index, cache %u pages\n", numRows, numLookups, cachePages);
+    std::printf("%-9s %7s %10s %8s %8s %10s %11s %7s\n", "index", "height", "internal", "fanout", "leaves",
+                "reads", "latency", "found");
+    {
+        Table table(DB_FILE, cachePages);
+        report(table, "username", COLUMN_USERNAME, usernames);
+        report(table, "email", COLUMN_EMAIL, emails);
+    }
+
+    std::remove(DB_FILE);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Point lookups by email and prefix lookups by username through the planner,
+// before and after CREATE INDEX: a leaf-chain scan per lookup versus a
+// secondary index probe plus a primary key fetch.
+// usage: bench_index_lookup [rows] [lookups]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "prepared_statement.hpp"
+#include "row.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_index_lookup.db";
+
+    std::string emailFor(uint32_t id) {
+        return "user" + std::to_string(id) + "@example.com";
+    }
+
+    std::unique_ptr<PreparedStatement> prepare(Table& table, const std::string& sql) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        if (CompiledStatement::compile(sql, compiled, error) != PrepareResult::PREPARE_SUCCESS) {
+            std::fprintf(stderr, "%s: %s\n", sql.c_str(), error.c_str());
+            std::exit(1);
+        }
+        return std::make_unique<PreparedStatement>(table, compiled);
+    }
+
+    // Runs the statement once per key; returns seconds per lookup and adds the rows found
+    double lookups(PreparedStatement& select, const std::vector<std::string>& keys, uint64_t& rows) {
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& key : keys) {
+            select.reset();
+            select.bindText(1, key);
+            while (select.step() == StepResult::ROW) {
+                rows++;
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / keys.size();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    Table table(DB_FILE, 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+    for (uint32_t id = 1; id <= numRows; id++) {
+        table.insertRow(Row(id, "name" + std::to_string(id % 1000), emailFor(id)));
+    }
+
+    std::mt19937 generator(3);
+    std::vector<std::string> emails;
+    std::vector<std::string> prefixes;
+    for (uint32_t i = 0; i < numLookups; i++) {
+        emails.push_back(emailFor(generator() % numRows + 1));
+        prefixes.push_back("name" + std::to_string(generator() % 1000) + "%");
+    }
+    auto byEmail = prepare(table, "SELECT id FROM users WHERE email = ?");
+    auto byPrefix = prepare(table, "SELECT id FROM users WHERE username LIKE ?");
+
+    uint64_t scanRows = 0;
+    double scanEmail = lookups(*byEmail, emails, scanRows);
+    double scanPrefix = lookups(*byPrefix, prefixes, scanRows);
+
+    auto build = std::chrono::steady_clock::now();
+    prepare(table, "CREATE INDEX ON users (email)")->step();
+    prepare(table, "CREATE INDEX ON users (username)")->step();
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - build).count();
+
+    uint64_t indexRows = 0;
+    double indexEmail = lookups(*byEmail, emails, indexRows);
+    double indexPrefix = lookups(*byPrefix, prefixes, indexRows);
+
+    if (scanRows != indexRows) {
+        std::fprintf(stderr, "results differ (%llu, %llu)\n", static_cast<unsigned long long>(scanRows),
+                     static_cast<unsigned long long>(indexRows));
+    }
+    std::printf("%u rows, %u lookups each, both indexes built in %.1f ms\n", numRows, numLookups, buildSeconds * 1e3);
+    std::printf("%-32s %12s %12s %9s\n", "query", "scan", "index", "speedup");
+    std::printf("%-32s %9.3f ms %9.4f ms %8.0fx\n", "email = ?", scanEmail * 1e3, indexEmail * 1e3,
+                scanEmail / indexEmail);
+    std::printf("%-32s %9.3f ms %9.4f ms %8.0fx\n", "username LIKE 'nameN%'", scanPrefix * 1e3,
+                indexPrefix * 1e3, scanPrefix / indexPrefix);
+
+    std::remove(DB_FILE);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Inserts and point lookups per primary key type: the users table's 32-bit
+// ids, and CREATE TABLE tables keyed by a BIGINT, an (INT, BIGINT) pair, a
+// TEXT(16) and a (TEXT(8), BIGINT) pair. The tree searches of the two integer
+// keys are timed again with the byte-by-byte comparison every key type falls
+// back to, which is what the fixed-width specialization saves.
+// usage: bench_key_types [rows] [lookups]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_key_types.db";
+
+    struct KeyType {
+        const char* name;
+        std::vector<ColumnSchema> columns;
+        std::vector<uint32_t> primaryKey;
+    };
+
+    Field integerField(int64_t value) {
+        Field field;
+        field.integer = value;
+        return field;
+    }
+
+    Field bytesField(std::string value) {
+        Field field;
+        field.bytes = std::move(value);
+        return field;
+    }
+
+    // The row with number n: key columns first, then a payload column. Integer
+    // keys are spread past 32 bits; pairs spread n over 64 tenants.
+    std::vector<Field> rowFor(const KeyType& type, uint64_t n) {
+        std::vector<Field> row;
+        int64_t wide = static_cast<int64_t>(n * 2654435761u) + (int64_t(1) << 40);
+        for (uint32_t column = 0; column < type.primaryKey.size(); column++) {
+            bool text = type.columns[column].type == ColumnType::TEXT;
+            bool leading = type.primaryKey.size() == 2 && column == 0;
+            if (text) {
+                row.push_back(bytesField(leading ? "t" + std::to_string(n % 64) : "key" + std::to_string(n)));
+            } else {
+                row.push_back(integerField(leading ? static_cast<int64_t>(n % 64) : wide));
+            }
+        }
+        row.push_back(bytesField("payload"));
+        return row;
+    }
+
+    std::vector<Field> keyOf(const std::vector<Field>& row, size_t keyColumns) {
+        return std::vector<Field>(row.begin(), row.begin() + static_cast<std::ptrdiff_t>(keyColumns));
+    }
+
+    double seconds(const std::function<void()>& work) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200000;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    Table table(DB_FILE, 40000);
+    std::mt19937 generator(9);
+    std::vector<uint32_t> order(numRows);
+    for (uint32_t i = 0; i < numRows; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), generator);
+    std::vector<uint32_t> probes(numLookups);
+    for (uint32_t& probe : probes) {
+        probe = static_cast<uint32_t>(generator() % numRows);
+    }
+
+    std::printf("%u rows inserted in random order, %u lookups\n", numRows, numLookups);
+    std::printf("%-22s %-7s %12s %12s %14s\n", "key", "format", "insert", "lookup", "byte compare");
+
+    uint64_t found = 0;
+    double insert = seconds([&] {
+        for (uint32_t i : order) {
+            table.insertRow(Row(i + 1, "user", "user@example.com"));
+        }
+    });
+    double lookup = seconds([&] {
+        for (uint32_t probe : probes) {
+            uint32_t pageNum;
+            uint32_t cellNum;
+            found += table.findRow(probe + 1, pageNum, cellNum);
+        }
+    });
+    std::printf("%-22s %-7s %9.3f us %9.3f us %14s\n", "users id (uint32)", "node", insert / numRows * 1e6,
+                lookup / numLookups * 1e6, "-");
+
+    std::vector<KeyType> types = {
+        {"BIGINT", {{"k", ColumnType::BIGINT, 0}, {"v", ColumnType::TEXT, 0}}, {0}},
+        {"(INT, BIGINT)", {{"t", ColumnType::INT, 0}, {"k", ColumnType::BIGINT, 0}, {"v", ColumnType::TEXT, 0}}, {0, 1}},
+        {"TEXT(16)", {{"k", ColumnType::TEXT, 16}, {"v", ColumnType::TEXT, 0}}, {0}},
+        {"(TEXT(8), BIGINT)", {{"t", ColumnType::TEXT, 8}, {"k", ColumnType::BIGINT, 0}, {"v", ColumnType::TEXT, 0}},
+         {0, 1}},
+    };
+    const char* formatNames[] = {"bytes", "fixed8", "fixed16"};
+    for (size_t t = 0; t < types.size(); t++) {
+        const KeyType& type = types[t];
+        std::string name = "k" + std::to_string(t);
+        table.createTable(Schema(name, type.columns, type.primaryKey));
+        SchemaTable& target = *table.getSchemaTable(name);
+        insert = seconds([&] {
+            for (uint32_t i : order) {
+                target.insertRow(rowFor(type, i));
+            }
+        });
+        std::vector<std::vector<Field>> keys;
+        std::vector<std::string> encoded;
+        for (uint32_t probe : probes) {
+            keys.push_back(keyOf(rowFor(type, probe), type.primaryKey.size()));
+            encoded.push_back(encodeKey(keys.back(), target.getSchema()));
+        }
+        std::vector<Field> row;
+        lookup = seconds([&] {
+            for (const std::vector<Field>& key : keys) {
+                found += target.getRow(key, row);
+            }
+        });
+
+        // the same tree searched with each key format; only the search is timed
+        auto searchTime = [&](const SecondaryIndex& tree) {
+            return seconds([&] {
+                for (const std::string& key : encoded) {
+                    uint32_t pageNum;
+                    uint32_t cellNum;
+                    tree.seek(key, 0, pageNum, cellNum);
+                    found += cellNum != UINT32_MAX;
+                }
+            });
+        };
+        KeyFormat format = target.getTree().getKeyFormat();
+        char compare[32] = "-";
+        if (format != KeyFormat::BYTES) {
+            SecondaryIndex asBytes(table, INDEX_NO_COLUMN, target.getRootPageNum());
+            searchTime(asBytes);  // warms the cache for both
+            double generic = searchTime(asBytes);
+            double specialized = searchTime(target.getTree());
+            std::snprintf(compare, sizeof(compare), "%.2fx slower", generic / specialized);
+        }
+        std::printf("%-22s %-7s %9.3f us %9.3f us %14s\n", type.name, formatNames[static_cast<int>(format)],
+                    insert / numRows * 1e6, lookup / numLookups * 1e6, compare);
+    }
+    if (found == 0) {
+        std::printf("nothing found\n");
+    }
+
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+    return 0;
+}
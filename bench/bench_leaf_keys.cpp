@@ -0,0 +1,139 @@
+// Leaf keys on dense (1..n, in order) and sparse (random 32-bit) ids: how full
+// the leaves are, what a frame-of-reference key block (base key plus bit-packed
+// deltas) would take against the 4-byte key in each cell, and the cost of
+// finding a key inside a cached leaf: Node::leafNodeFind against a plain
+// binary search.
+// usage: bench_leaf_keys [rows] [lookups]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cursor.hpp"
+#include "node.hpp"
+#include "row.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_leaf_keys.db";
+
+    uint32_t binarySearch(Node& leaf, uint32_t key) {
+        uint32_t minIndex = 0;
+        uint32_t onePastMaxIndex = *leaf.leafNodeNumCells();
+        while (minIndex < onePastMaxIndex) {
+            uint32_t currentIndex = (minIndex + onePastMaxIndex) / 2;
+            if (*leaf.leafNodeKey(currentIndex) < key) {
+                minIndex = currentIndex + 1;
+            } else {
+                onePastMaxIndex = currentIndex;
+            }
+        }
+        return minIndex;
+    }
+
+    uint32_t bitsFor(uint32_t value) {
+        uint32_t bits = 0;
+        while (value != 0) {
+            bits++;
+            value >>= 1;
+        }
+        return bits;
+    }
+
+    template <typename Find>
+    double timeLookups(const std::vector<std::pair<uint8_t*, uint32_t>>& probes, Find find, uint32_t& found) {
+        found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& [page, key] : probes) {
+            Node leaf(page);
+            found += *leaf.leafNodeKey(find(leaf, key)) == key;
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / probes.size();
+    }
+
+    void run(const char* name, const std::vector<uint32_t>& ids, uint32_t numLookups) {
+        std::remove(DB_FILE);
+        std::remove((std::string(DB_FILE) + "-wal").c_str());
+        Table table(DB_FILE, 4 * (static_cast<uint32_t>(ids.size()) / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+        for (uint32_t id : ids) {
+            table.insertRow(Row(id, "user", "user@example.com"));
+        }
+
+        std::vector<uint32_t> leaves;
+        uint64_t cells = 0;
+        uint64_t packedBytes = 0;
+        uint32_t pageNum = Cursor(table).getPageNum();
+        do {
+            Node leaf(table.getPageAddress(pageNum));
+            uint32_t numCells = *leaf.leafNodeNumCells();
+            if (numCells > 0) {
+                leaves.push_back(pageNum);
+                cells += numCells;
+                uint32_t deltaBits = bitsFor(*leaf.leafNodeKey(numCells - 1) - *leaf.leafNodeKey(0));
+                packedBytes += sizeof(uint32_t) + 1 + (numCells * deltaBits + 7) / 8;  // base, width, deltas
+            }
+            pageNum = *leaf.leafNodeRightSibling();
+        } while (pageNum != 0);
+
+        std::mt19937 generator(7);
+        // every page stays cached (the cache is never trimmed here), so the
+        // frames can be resolved up front and only the search is timed
+        std::vector<std::pair<uint8_t*, uint32_t>> probes;
+        for (uint32_t i = 0; i < numLookups; i++) {
+            uint8_t* page = table.getPageAddress(leaves[generator() % leaves.size()]);
+            Node leaf(page);
+            probes.emplace_back(page, *leaf.leafNodeKey(generator() % *leaf.leafNodeNumCells()));
+        }
+        uint32_t predictedFound = 0;
+        uint32_t binaryFound = 0;
+        // best of three, alternating, so neither side gets the warmer caches
+        double predicted = 1e9;
+        double binary = 1e9;
+        for (uint32_t repeat = 0; repeat < 3; repeat++) {
+            binary = std::min(binary, timeLookups(probes, binarySearch, binaryFound));
+            predicted = std::min(predicted, timeLookups(
+                                                probes, [](Node& leaf, uint32_t key) { return leaf.leafNodeFind(key); },
+                                                predictedFound));
+        }
+
+        double rowsPerLeaf = static_cast<double>(cells) / leaves.size();
+        double rawKeyBytes = rowsPerLeaf * LEAF_NODE_KEY_SIZE;
+        double packedKeyBytes = static_cast<double>(packedBytes) / leaves.size();
+        std::printf("%-7s %8zu %8.2f %10.1f %10.1f %10.1f %9.1f ns %9.1f ns %7u %7u\n", name, leaves.size(),
+                    rowsPerLeaf, rawKeyBytes, packedKeyBytes, rawKeyBytes - packedKeyBytes, predicted * 1e9,
+                    binary * 1e9, predictedFound, binaryFound);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000000;
+
+    std::vector<uint32_t> dense;
+    for (uint32_t id = 1; id <= numRows; id++) {
+        dense.push_back(id);
+    }
+    std::mt19937 generator(3);
+    std::unordered_set<uint32_t> seen;
+    std::vector<uint32_t> sparse;
+    while (sparse.size() < numRows) {
+        uint32_t id = generator();
+        if (id != 0 && seen.insert(id).second) {
+            sparse.push_back(id);
+        }
+    }
+
+    std::printf("%u rows, %u lookups of present keys in cached leaves\n", numRows, numLookups);
+    std::printf("a leaf cell is %u bytes: %u of key, %u of row\n", LEAF_NODE_CELL_SIZE, LEAF_NODE_KEY_SIZE,
+                LEAF_NODE_VALUE_SIZE);
+    std::printf("%-7s %8s %8s %10s %10s %10s %12s %12s %7s %7s\n", "keys", "leaves", "rows", "key bytes",
+                "FOR bytes", "saved", "leafNodeFind", "binary", "found", "found");
+    run("dense", dense, numLookups);
+    run("sparse", sparse, numLookups);
+
+    std::remove(DB_FILE);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Table::getRow on ids that are not in the table, with a small cache: the leaf
+// filters answer most of them from the internal nodes alone. Present ids are
+// looked up too, for comparison. Rows have even ids, so every odd id inside the
+// key range is absent and lands on a real leaf.
+// usage: bench_negative_lookup [rows] [lookups] [cache pages]
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "row.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_negative_lookup.db";
+
+    struct Result {
+        double seconds;    // per lookup
+        double pageReads;  // per lookup
+        uint32_t found;
+    };
+
+    Result lookups(Table& table, const std::vector<uint32_t>& keys) {
+        uint64_t readsBefore = table.getPager().getStats().pageReads;
+        uint32_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t key : keys) {
+            try {
+                found += table.getRow(key).getId() == key;
+            } catch (const std::out_of_range&) {
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return Result{seconds / keys.size(),
+                      static_cast<double>(table.getPager().getStats().pageReads - readsBefore) / keys.size(), found};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20000;
+    uint32_t cachePages = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 64;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    {
+        Table table(DB_FILE, 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+        for (uint32_t id = 1; id <= numRows; id++) {
+            table.insertRow(Row(2 * id, "name" + std::to_string(id), "user" + std::to_string(id) + "@example.com"));
+        }
+    }
+    std::mt19937 generator(11);
+    std::vector<uint32_t> absent;
+    std::vector<uint32_t> present;
+    for (uint32_t i = 0; i < numLookups; i++) {
+        uint32_t id = generator() % numRows + 1;
+        absent.push_back(2 * id - 1);
+        present.push_back(2 * id);
+    }
+
+    Table table(DB_FILE, cachePages);
+    Result missing = lookups(table, absent);
+    LeafFilters::Stats stats = table.getLeafFilterStats();
+    Result hits = lookups(table, present);
+
+    std::printf("%u rows, %u random lookups each, cache %u pages\n", numRows, numLookups, cachePages);
+    std::printf("%-10s %12s %12s %8s\n", "getRow", "latency", "reads", "found");
+    std::printf("%-10s %9.2f us %12.2f %8u\n", "absent", missing.seconds * 1e6, missing.pageReads, missing.found);
+    std::printf("%-10s %9.2f us %12.2f %8u\n", "present", hits.seconds * 1e6, hits.pageReads, hits.found);
+    std::printf("leaf filters: %llu probes, %llu leaf reads saved, %llu false positives (%.2f%% of absent ids)\n",
+                static_cast<unsigned long long>(stats.probes), static_cast<unsigned long long>(stats.negatives),
+                static_cast<unsigned long long>(stats.falsePositives),
+                100.0 * stats.falsePositives / (stats.negatives + stats.falsePositives));
+
+    std::remove(DB_FILE);
+    return 0;
+}
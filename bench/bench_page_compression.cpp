@@ -0,0 +1,126 @@
+// Plain versus compressed database files: file size, the time to load rows and
+// write them out at close, and a cold full scan with a small cache. Before the
+// scan the file is dropped from the OS page cache (posix_fadvise), so its
+// reads go to the device. Also times the page codec on its own.
+// usage: bench_page_compression [rows] [scan cache pages]
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "compressed_file.hpp"
+#include "node.hpp"
+#include "row.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    off_t fileSize(const std::string& filename) {
+        struct stat fileStat;
+        stat(filename.c_str(), &fileStat);
+        return fileStat.st_size;
+    }
+
+    void dropFromOsCache(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    void run(bool compress, uint32_t numRows, uint32_t scanCachePages) {
+        const std::string filename = compress ? "bench_compressed.db" : "bench_plain.db";
+        std::remove(filename.c_str());
+        std::remove((filename + "-wal").c_str());
+
+        auto start = std::chrono::steady_clock::now();
+        double closeSeconds;
+        uint32_t numPages;
+        {
+            Table table(filename, 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1), compress);
+            for (uint32_t id = 1; id <= numRows; id++) {
+                table.insertRow(Row(id, "name" + std::to_string(id), "user" + std::to_string(id) + "@example.com"));
+            }
+            numPages = table.getPager().getNumPages();
+            auto closing = std::chrono::steady_clock::now();
+            table.getPager().flushAllPages();  // every page is written here
+            closeSeconds = secondsSince(closing);
+        }
+        double loadSeconds = secondsSince(start);
+        off_t size = fileSize(filename);
+
+        dropFromOsCache(filename);
+        Table table(filename, scanCachePages);
+        Pager::Stats before = table.getPager().getStats();
+        start = std::chrono::steady_clock::now();
+        TableScan scan(table);
+        Batch batch;
+        uint64_t rows = 0;
+        while (scan.next(batch)) {
+            rows += batch.selectedCount;
+        }
+        double scanSeconds = secondsSince(start);
+        Pager::Stats after = table.getPager().getStats();
+
+        std::printf("%-11s %9.2f MB %7.2fx %9.3f s %9.3f s %9.3f s %10.0f %10.2f MB\n",
+                    compress ? "compressed" : "plain", size / 1e6, static_cast<double>(numPages) * PAGE_SIZE / size,
+                    loadSeconds, closeSeconds, scanSeconds, rows / scanSeconds,
+                    (after.fileBytesRead - before.fileBytesRead) / 1e6);
+        std::remove(filename.c_str());
+    }
+
+    // A full leaf, as the load above writes them
+    void codecThroughput() {
+        std::vector<uint8_t> page(PAGE_SIZE, 0);
+        Node leaf(page.data());
+        leaf.initializeLeafNode();
+        for (uint32_t i = 0; i < LEAF_NODE_MAX_CELLS; i++) {
+            uint32_t id = 100000 + i;
+            *leaf.leafNodeKey(i) = id;
+            Row(id, "name" + std::to_string(id), "user" + std::to_string(id) + "@example.com")
+                .serialize(leaf.leafNodeValue(i));
+        }
+        *leaf.leafNodeNumCells() = LEAF_NODE_MAX_CELLS;
+
+        const uint32_t iterations = 200000;
+        std::vector<uint8_t> encoded(COMPRESSED_PAGE_MAX_SIZE);
+        uint32_t length = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            page[LEAF_NODE_HEADER_SIZE] ^= 1;  // keep the loop from being hoisted
+            length = compressPage(page.data(), encoded.data());
+        }
+        double compressSeconds = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        uint32_t failures = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            failures += !decompressPage(encoded.data(), length, page.data());
+        }
+        double decompressSeconds = secondsSince(start);
+        std::printf("codec on a full leaf: %u -> %u bytes, compress %.0f MB/s (%.2f us/page), "
+                    "decompress %.0f MB/s%s\n",
+                    PAGE_SIZE, length, iterations * PAGE_SIZE / compressSeconds / 1e6,
+                    compressSeconds / iterations * 1e6, iterations * PAGE_SIZE / decompressSeconds / 1e6,
+                    failures ? " (FAILED)" : "");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t scanCachePages = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 256;
+
+    std::printf("%u rows, cold scan with a %u-page cache\n", numRows, scanCachePages);
+    std::printf("%-11s %12s %8s %11s %11s %11s %10s %13s\n", "file", "size", "ratio", "load", "write out",
+                "cold scan", "rows/s", "scan read");
+    run(false, numRows, scanCachePages);
+    run(true, numRows, scanCachePages);
+    codecThroughput();
+    return 0;
+}
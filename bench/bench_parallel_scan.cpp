@@ -0,0 +1,88 @@
+// Warm-cache full-table scan: serial cursor walk vs ParallelScan at 1..N threads.
+// usage: bench_parallel_scan [rows] [max_threads]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cursor.hpp"
+#include "parallel_scan.hpp"
+#include "row.hpp"
+#include "table.hpp"
+#include "scheduler.hpp"
+
+namespace {
+    // what an aggregation query would compute: row count, key sum, username bytes
+    struct ScanTotals {
+        uint64_t rows = 0;
+        uint64_t keySum = 0;
+        uint64_t usernameBytes = 0;
+    };
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 300000;
+    uint32_t maxThreads = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : std::thread::hardware_concurrency();
+    const char* filename = "bench_parallel_scan.db";
+    std::remove(filename);
+
+    Table table(filename);
+    for (uint32_t i = 0; i < numRows; i++) {
+        table.insertRow(Row(i, "user" + std::to_string(i % 1000), "user@example.com"));
+    }
+
+    auto scanRow = [](ScanTotals& totals, uint32_t key, const void* row) {
+        totals.rows++;
+        totals.keySum += key;
+        totals.usernameBytes += std::strlen(static_cast<const char*>(row) + sizeof(uint32_t));
+    };
+    auto combine = [](ScanTotals& into, const ScanTotals& from) {
+        into.rows += from.rows;
+        into.keySum += from.keySum;
+        into.usernameBytes += from.usernameBytes;
+    };
+
+    // serial baseline (also warms the cache)
+    auto start = std::chrono::steady_clock::now();
+    ScanTotals serial;
+    Cursor cursor(table);
+    while (!cursor.isEndOfTable()) {
+        void* slot = cursor.cursorSlot();
+        uint32_t key;
+        std::memcpy(&key, slot, sizeof(uint32_t));
+        scanRow(serial, key, slot);
+        cursor.cursorAdvance();
+    }
+    double serialSeconds = secondsSince(start);
+    std::printf("rows=%u serial: %.3f ms (%.1f Mrows/s)\n", numRows, serialSeconds * 1e3, serial.rows / serialSeconds / 1e6);
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for (uint32_t threads : threadCounts) {
+        Scheduler scheduler(threads);
+        ParallelScan scan(table, scheduler);
+        scan.reduce(ScanTotals{}, scanRow, combine);  // warm-up
+        const int iterations = 5;
+        start = std::chrono::steady_clock::now();
+        ScanTotals totals;
+        for (int i = 0; i < iterations; i++) {
+            totals = scan.reduce(ScanTotals{}, scanRow, combine);
+        }
+        double seconds = secondsSince(start) / iterations;
+        std::printf("threads=%2u parallel: %.3f ms (%.1f Mrows/s, speedup %.2fx)%s\n", threads, seconds * 1e3,
+                    totals.rows / seconds / 1e6, serialSeconds / seconds,
+                    (totals.rows == serial.rows && totals.keySum == serial.keySum) ? "" : "  MISMATCH");
+    }
+
+    return 0;
+}
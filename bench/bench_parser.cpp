@@ -0,0 +1,89 @@
+// Parser throughput, and heap allocations per statement, against the old
+// whitespace tokenizer.
+// usage: bench_parser [iterations]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "arena.hpp"
+#include "parser.hpp"
+#include "tokenizer.hpp"
+
+namespace {
+    std::atomic<uint64_t> heapAllocations(0);
+}
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    const std::vector<std::string> STATEMENTS = {
+        "INSERT INTO users VALUES (12345, 'alice', 'alice@example.com')",
+        "SELECT id, username FROM users WHERE id >= 100 AND id < 200 ORDER BY username LIMIT 10",
+        "UPDATE users SET email = 'new@example.com' WHERE id = 42",
+        "DELETE FROM users WHERE id > 1000 OR username = 'spam'",
+        "SELECT * FROM users",
+    };
+
+    void report(const char* name, uint64_t statements, uint64_t bytes, double seconds, uint64_t allocations) {
+        std::printf("%-22s %8.1f ns/stmt  %8.1f MB/s  %5.2f allocs/stmt\n", name, seconds * 1e9 / statements,
+                    bytes / seconds / 1e6, static_cast<double>(allocations) / statements);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint64_t bytesPerRound = 0;
+    for (const std::string& sql : STATEMENTS) {
+        bytesPerRound += sql.size();
+    }
+    uint64_t statements = static_cast<uint64_t>(iterations) * STATEMENTS.size();
+    uint64_t checksum = 0;
+
+    uint64_t allocationsBefore = heapAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (const std::string& sql : STATEMENTS) {
+            Arena arena;
+            Parser parser(sql, arena);
+            const Statement* statement = nullptr;
+            if (parser.parse(statement) != PrepareResult::PREPARE_SUCCESS) {
+                std::fprintf(stderr, "parse failed: %s\n", parser.getError().c_str());
+                return 1;
+            }
+            checksum += static_cast<uint64_t>(statement->kind);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("parser (AST)", statements, bytesPerRound * iterations, seconds, heapAllocations.load() - allocationsBefore);
+
+    allocationsBefore = heapAllocations.load();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (const std::string& sql : STATEMENTS) {
+            checksum += tokenize(sql).size();
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("tokenize (legacy)", statements, bytesPerRound * iterations, seconds, heapAllocations.load() - allocationsBefore);
+
+    std::printf("checksum %llu\n", static_cast<unsigned long long>(checksum));
+    return 0;
+}
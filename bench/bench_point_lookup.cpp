@@ -0,0 +1,87 @@
+// Table::getRow latency through the B+ tree descent versus the hash index on
+// id. "Cold" reopens the file with a one-page cache (by default), so every page
+// a lookup touches is read from the file; "warm" uses a cache that holds the
+// whole table.
+// usage: bench_point_lookup [rows] [lookups] [cold cache pages]
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_index.hpp"
+#include "row.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_point_lookup.db";
+
+    struct Result {
+        double seconds;    // per lookup
+        double pageReads;  // per lookup
+    };
+
+    Result lookups(uint32_t cachePages, const std::vector<uint32_t>& keys, bool warmUp) {
+        Table table(DB_FILE, cachePages);
+        uint64_t checksum = 0;
+        if (warmUp) {
+            for (uint32_t key : keys) {
+                checksum += table.getRow(key).getId();
+            }
+        }
+        uint64_t readsBefore = table.getPager().getStats().pageReads;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t key : keys) {
+            checksum += table.getRow(key).getId();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (checksum == 0) {
+            std::fprintf(stderr, "no rows found\n");
+        }
+        return Result{seconds / keys.size(),
+                      static_cast<double>(table.getPager().getStats().pageReads - readsBefore) / keys.size()};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t numLookups = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20000;
+    uint32_t coldPages = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    uint32_t warmPages = 4 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1);
+    {
+        Table table(DB_FILE, warmPages);
+        for (uint32_t id = 1; id <= numRows; id++) {
+            table.insertRow(Row(id, "name" + std::to_string(id), "user" + std::to_string(id) + "@example.com"));
+        }
+    }
+    std::mt19937 generator(9);
+    std::vector<uint32_t> keys;
+    for (uint32_t i = 0; i < numLookups; i++) {
+        keys.push_back(generator() % numRows + 1);
+    }
+
+    Result treeCold = lookups(coldPages, keys, false);
+    Result treeWarm = lookups(warmPages, keys, true);
+    uint32_t buckets;
+    {
+        Table table(DB_FILE, warmPages);
+        table.createHashIndex();
+        buckets = table.getHashIndex()->getBucketCount();
+    }
+    Result hashCold = lookups(coldPages, keys, false);
+    Result hashWarm = lookups(warmPages, keys, true);
+
+    std::printf("%u rows, %u random lookups, %u hash buckets, cold cache %u pages\n", numRows, numLookups, buckets,
+                coldPages);
+    std::printf("%-12s %14s %12s %14s %12s\n", "getRow", "cold", "reads", "warm", "reads");
+    std::printf("%-12s %11.2f us %12.2f %11.2f us %12.2f\n", "tree", treeCold.seconds * 1e6, treeCold.pageReads,
+                treeWarm.seconds * 1e6, treeWarm.pageReads);
+    std::printf("%-12s %11.2f us %12.2f %11.2f us %12.2f\n", "hash", hashCold.seconds * 1e6, hashCold.pageReads,
+                hashWarm.seconds * 1e6, hashWarm.pageReads);
+
+    std::remove(DB_FILE);
+    return 0;
+}
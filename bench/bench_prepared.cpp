@@ -0,0 +1,120 @@
+// Per-statement overhead of the REPL path against prepared statements: bulk
+// inserts, then a repeated point lookup with and without the plan cache.
+// usage: bench_prepared [rows]
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
+#include "statement_processor.hpp"
+#include "table.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_prepared.db";
+
+    void report(const char* name, uint32_t statements, double seconds) {
+        std::printf("%-34s %8.0f ns/stmt\n", name, seconds * 1e9 / statements);
+    }
+
+    template <typename Body>
+    double timed(Body body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Loads rows inside one transaction so the timing is statement overhead, not fsync
+    template <typename Insert>
+    void benchInsert(const char* name, uint32_t rows, Insert insert) {
+        std::remove(DB_FILE);
+        std::remove((std::string(DB_FILE) + "-wal").c_str());
+        Table table(DB_FILE);
+        StatementProcessor processor(table);
+        std::cout.setstate(std::ios::badbit);  // legacy inserts echo every row
+        processor.execute("BEGIN");
+        double seconds = timed([&]() { insert(table, processor, rows); });
+        processor.execute("COMMIT");
+        std::cout.clear();
+        if (std::string(table.getRow(rows).getUsername()) != "user" + std::to_string(rows)) {
+            std::fprintf(stderr, "%s: last row missing\n", name);
+        }
+        report(name, rows, seconds);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t rows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100000;
+
+    benchInsert("insert: legacy text", rows, [](Table&, StatementProcessor& processor, uint32_t count) {
+        for (uint32_t id = 1; id <= count; id++) {
+            processor.execute("insert " + std::to_string(id) + " user" + std::to_string(id) + " user@example.com");
+        }
+    });
+    benchInsert("insert: SQL text (cache miss)", rows, [](Table&, StatementProcessor& processor, uint32_t count) {
+        for (uint32_t id = 1; id <= count; id++) {
+            processor.execute("INSERT INTO users VALUES (" + std::to_string(id) + ", 'user" + std::to_string(id) +
+                              "', 'user@example.com')");
+        }
+    });
+    benchInsert("insert: prepared, bind + step", rows, [](Table&, StatementProcessor& processor, uint32_t count) {
+        std::unique_ptr<PreparedStatement> insert;
+        processor.prepare("INSERT INTO users VALUES (?, ?, 'user@example.com')", insert);
+        std::string name;
+        for (uint32_t id = 1; id <= count; id++) {
+            name = "user" + std::to_string(id);
+            insert->bindInteger(1, id);
+            insert->bindText(2, name);
+            insert->step();
+            insert->reset();
+        }
+    });
+
+    // point lookups against the table just loaded
+    Table table(DB_FILE);
+    StatementProcessor processor(table);
+    const std::string lookup = "SELECT username FROM users WHERE id = 4242";
+    uint64_t checksum = 0;
+
+    double seconds = timed([&]() {
+        for (uint32_t i = 0; i < rows; i++) {
+            std::shared_ptr<const CompiledStatement> compiled;
+            std::string error;
+            CompiledStatement::compile(lookup, compiled, error);
+            PreparedStatement select(table, compiled);
+            checksum += select.step() == StepResult::ROW;
+        }
+    });
+    report("lookup: compile every time", rows, seconds);
+
+    PlanCache cache;
+    seconds = timed([&]() {
+        for (uint32_t i = 0; i < rows; i++) {
+            std::shared_ptr<const CompiledStatement> compiled;
+            std::string error;
+            cache.lookup(lookup, compiled, error);
+            PreparedStatement select(table, compiled);
+            checksum += select.step() == StepResult::ROW;
+        }
+    });
+    report("lookup: plan cache hit", rows, seconds);
+
+    std::unique_ptr<PreparedStatement> select;
+    processor.prepare("SELECT username FROM users WHERE id = ?", select);
+    seconds = timed([&]() {
+        for (uint32_t i = 0; i < rows; i++) {
+            select->bindInteger(1, 4242);
+            checksum += select->step() == StepResult::ROW;
+            select->reset();
+        }
+    });
+    report("lookup: prepared, bind + step", rows, seconds);
+
+    std::printf("checksum %llu (plan cache: %llu hits, %llu misses)\n", static_cast<unsigned long long>(checksum),
+                static_cast<unsigned long long>(cache.getStats().hits),
+                static_cast<unsigned long long>(cache.getStats().misses));
+    std::remove(DB_FILE);
+    return 0;
+}
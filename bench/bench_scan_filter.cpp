@@ -0,0 +1,148 @@
+// Selective scans at 1%, 10% and 100% selectivity, three ways: a row-at-a-time
+// cursor that deserializes every Row, a batch scan filtered by the evaluator
+// after decoding, and the scan with the predicate pushed down into the leaf.
+// usage: bench_scan_filter [rows] [repeats]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "arena.hpp"
+#include "cursor.hpp"
+#include "filter_kernels.hpp"
+#include "parser.hpp"
+#include "row.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    const char* const DB_FILE = "bench_scan_filter.db";
+
+    struct Query {
+        const char* label;
+        const char* condition;     // for the evaluator
+        bool onUsername;
+        FieldMatch match;          // for the pushed-down kernel
+        const char* literal;
+        std::function<bool(const Row&)> test;  // for the row-at-a-time baseline
+    };
+
+    bool endsWith(const char* text, const char* suffix) {
+        size_t textLength = std::strlen(text);
+        size_t suffixLength = std::strlen(suffix);
+        return textLength >= suffixLength && std::strcmp(text + textLength - suffixLength, suffix) == 0;
+    }
+
+    // WHERE clause of a SELECT, with its columns resolved to scan positions
+    const Expr* parseCondition(const std::string& sql, Arena& arena) {
+        Parser parser(sql, arena);
+        const Statement* statement = nullptr;
+        if (parser.parse(statement) != PrepareResult::PREPARE_SUCCESS) {
+            std::fprintf(stderr, "%s: %s\n", sql.c_str(), parser.getError().c_str());
+            std::exit(1);
+        }
+        std::function<void(const Expr*)> resolve = [&](const Expr* expr) {
+            if (expr == nullptr) {
+                return;
+            }
+            if (expr->kind == ExprKind::COLUMN) {
+                expr->column = expr->text == "username" ? COLUMN_USERNAME : COLUMN_EMAIL;
+            }
+            resolve(expr->left);
+            resolve(expr->right);
+        };
+        resolve(statement->select->where);
+        return statement->select->where;
+    }
+
+    uint64_t drain(BatchOperator& op) {
+        uint64_t rows = 0;
+        Batch batch;
+        while (op.next(batch)) {
+            rows += batch.selectedCount;
+        }
+        return rows;
+    }
+
+    template <typename Body>
+    double bestOf(uint32_t repeats, uint64_t& rows, Body body) {
+        double best = 1e300;
+        for (uint32_t i = 0; i < repeats; i++) {
+            auto start = std::chrono::steady_clock::now();
+            rows = body();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numRows = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t repeats = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 5;
+    std::remove(DB_FILE);
+    std::remove((std::string(DB_FILE) + "-wal").c_str());
+
+    // the cache holds the whole table, so every run measures filtering, not reads
+    Table table(DB_FILE, 2 * (numRows / LEAF_NODE_RIGHT_SPLIT_COUNT + 1));
+    // username "user<id % 100>"; every tenth email is at corp.com
+    for (uint32_t id = 1; id <= numRows; id++) {
+        table.insertRow(Row(id, "user" + std::to_string(id % 100),
+                            std::to_string(id) + (id % 10 == 0 ? "@corp.com" : "@example.com")));
+    }
+
+    const Query queries[] = {
+        {"username = 'user42'       (1%)", "username = 'user42'", true, FieldMatch::EQUALS, "user42",
+         [](const Row& row) { return std::strcmp(row.getUsername(), "user42") == 0; }},
+        {"email LIKE '%@corp.com'   (10%)", "email LIKE '%@corp.com'", false, FieldMatch::SUFFIX, "@corp.com",
+         [](const Row& row) { return endsWith(row.getEmail(), "@corp.com"); }},
+        {"email LIKE '%.com'        (100%)", "email LIKE '%.com'", false, FieldMatch::SUFFIX, ".com",
+         [](const Row& row) { return endsWith(row.getEmail(), ".com"); }},
+    };
+
+    Arena arena;
+    std::vector<Value> noBindings;
+    VectorEvaluator evaluator(noBindings);
+    std::printf("%u rows, best of %u\n", numRows, repeats);
+    std::printf("%-34s %12s %12s %12s %9s\n", "query", "row cursor", "filter op", "pushdown", "matches");
+    for (const Query& query : queries) {
+        uint64_t cursorRows = 0;
+        double cursorSeconds = bestOf(repeats, cursorRows, [&]() {
+            uint64_t rows = 0;
+            Cursor cursor(table);
+            while (!cursor.isEndOfTable()) {
+                rows += query.test(Row::deserialize(cursor.cursorSlot()));
+                cursor.cursorAdvance();
+            }
+            return rows;
+        });
+
+        std::string sql = std::string("SELECT * FROM users WHERE ") + query.condition;
+        const Expr* predicate = parseCondition(sql, arena);
+        uint64_t filterRows = 0;
+        double filterSeconds = bestOf(repeats, filterRows, [&]() {
+            FilterOperator filter(std::make_unique<TableScan>(table), {predicate}, evaluator);
+            return drain(filter);
+        });
+
+        FieldFilter kernel;
+        makeFieldFilter(query.match, query.onUsername ? Row::getUsernameOffset() : Row::getEmailOffset(),
+                        query.onUsername ? COLUMN_USERNAME_SIZE : COLUMN_EMAIL_SIZE, query.literal, kernel);
+        uint64_t pushdownRows = 0;
+        double pushdownSeconds = bestOf(repeats, pushdownRows, [&]() {
+            TableScan scan(table);
+            scan.pushFilter(kernel);
+            return drain(scan);
+        });
+
+        if (cursorRows != filterRows || filterRows != pushdownRows) {
+            std::fprintf(stderr, "%s: results differ (%llu, %llu, %llu)\n", query.label,
+                         static_cast<unsigned long long>(cursorRows), static_cast<unsigned long long>(filterRows),
+                         static_cast<unsigned long long>(pushdownRows));
+        }
+        std::printf("%-34s %9.2f ms %9.2f ms %9.2f ms %9llu\n", query.label, cursorSeconds * 1e3,
+                    filterSeconds * 1e3, pushdownSeconds * 1e3, static_cast<unsigned long long>(pushdownRows));
+    }
+    std::remove(DB_FILE);
+    return 0;
+}
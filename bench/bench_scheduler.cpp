@@ -0,0 +1,77 @@
+// Scheduler overhead: cost per spawned task and how much work gets stolen.
+// usage: bench_scheduler [tasks] [max_workers]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "scheduler.hpp"
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const char* name, uint32_t tasks, double seconds, const Scheduler::Stats& before, const Scheduler::Stats& after) {
+        std::printf("%-28s %8.1f ns/task  (%llu run, %llu stolen)\n", name, seconds * 1e9 / tasks,
+                    static_cast<unsigned long long>(after.tasksRun - before.tasksRun),
+                    static_cast<unsigned long long>(after.tasksStolen - before.tasksStolen));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t numTasks = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 200000;
+    uint32_t maxWorkers = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 0;
+    Scheduler scheduler(maxWorkers);
+    std::printf("workers=%u tasks=%u\n", scheduler.getNumWorkers(), numTasks);
+
+    // 1. external thread spawns empty tasks round-robin across the deques
+    std::atomic<uint32_t> completed(0);
+    Scheduler::Stats before = scheduler.getStats();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numTasks; i++) {
+        scheduler.submit([&]() { completed.fetch_add(1, std::memory_order_relaxed); });
+    }
+    while (completed.load() < numTasks) {
+        std::this_thread::yield();
+    }
+    report("spawn (external submit)", numTasks, secondsSince(start), before, scheduler.getStats());
+
+    // 2. parallelFor, caller helps
+    before = scheduler.getStats();
+    start = std::chrono::steady_clock::now();
+    scheduler.parallelFor(numTasks, [](uint32_t) {});
+    report("parallelFor", numTasks, secondsSince(start), before, scheduler.getStats());
+
+    // 3. one task fans out into its own deque; idle workers must steal to help
+    completed = 0;
+    before = scheduler.getStats();
+    start = std::chrono::steady_clock::now();
+    scheduler.submit([&]() {
+        for (uint32_t i = 0; i < numTasks; i++) {
+            scheduler.submit([&]() { completed.fetch_add(1, std::memory_order_relaxed); });
+        }
+    });
+    while (completed.load() < numTasks) {
+        std::this_thread::yield();
+    }
+    report("fan-out from one worker", numTasks, secondsSince(start), before, scheduler.getStats());
+
+    // 4. mixed classes: maintenance tasks with yield points under foreground load
+    completed = 0;
+    before = scheduler.getStats();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numTasks; i++) {
+        TaskPriority priority = (i % 4 == 0) ? TaskPriority::MAINTENANCE : TaskPriority::FOREGROUND_QUERY;
+        scheduler.submit([&]() {
+            scheduler.yieldPoint();
+            completed.fetch_add(1, std::memory_order_relaxed);
+        }, priority);
+    }
+    while (completed.load() < numTasks) {
+        std::this_thread::yield();
+    }
+    report("mixed priorities + yield", numTasks, secondsSince(start), before, scheduler.getStats());
+    return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Bump allocator for data that lives exactly as long as one statement (tokens,
+AST nodes). The first block is part of the object, so a statement that fits in
+it never touches the heap; larger ones chain extra blocks. Nothing is freed
+individually - reset() or destruction releases everything at once, which is
+why only trivially destructible types may be placed here.
+*/
+class Arena {
+private:
+    static constexpr size_t INLINE_SIZE = 4096;
+    static constexpr size_t MIN_BLOCK_SIZE = 16384;
+
+    alignas(std::max_align_t) uint8_t inlineBlock[INLINE_SIZE];
+    std::vector<std::unique_ptr<uint8_t[]>> heapBlocks;
+    uint8_t* block;
+    size_t blockSize;
+    size_t used;
+
+public:
+    Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    void reset();
+    size_t getHeapBlockCount() const { return heapBlocks.size(); }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T* makeArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) {
+            new (items + i) T();
+        }
+        return items;
+    }
+
+    std::string_view copyString(std::string_view text);
+};
+
+// Growable array whose storage lives in an Arena. Growing copies into a new
+// arena array (the old one is simply abandoned), so T must be trivially copyable.
+template <typename T>
+struct ArenaList {
+    T* items = nullptr;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+
+    void push(Arena& arena, const T& item) {
+        static_assert(std::is_trivially_copyable<T>::value, "ArenaList relocates items with a plain copy");
+        if (count == capacity) {
+            uint32_t newCapacity = capacity == 0 ? 4 : capacity * 2;
+            T* grown = static_cast<T*>(arena.allocate(sizeof(T) * newCapacity, alignof(T)));
+            for (uint32_t i = 0; i < count; i++) {
+                grown[i] = items[i];
+            }
+            items = grown;
+            capacity = newCapacity;
+        }
+        items[count++] = item;
+    }
+
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](uint32_t index) const { return items[index]; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+};
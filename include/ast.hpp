@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "arena.hpp"
+
+// Statement syntax trees. Every node lives in the Arena the statement was
+// parsed into, and names/literals are views into the statement text (or into
+// the arena, for string literals that needed unescaping).
+
+enum class ExprKind : uint8_t {
+    INTEGER,
+    STRING,
+    PARAMETER,
+    COLUMN,
+    UNARY,
+    BINARY,
+    AGGREGATE
+};
+
+enum class Operator : uint8_t {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    LIKE,  // case-sensitive; % matches any run of characters, _ any one
+    AND,
+    OR,
+    NOT,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    NEGATE
+};
+
+enum class AggregateFunction : uint8_t {
+    COUNT,
+    SUM,
+    MIN,
+    MAX
+};
+
+struct Expr {
+    ExprKind kind;
+    Operator op;             // UNARY / BINARY
+    int64_t integer;         // INTEGER
+    std::string_view text;   // STRING value or COLUMN name
+    uint32_t parameter;      // PARAMETER: 0-based position among the statement's ?s
+    AggregateFunction aggregate;  // AGGREGATE
+    // COLUMN: resolved table column, filled in when the statement is planned;
+    // AGGREGATE, and COLUMN in a grouped SELECT list: column of the aggregated rows
+    mutable uint32_t column;
+    const Expr* left;        // UNARY operand, BINARY left side, AGGREGATE argument (null for COUNT(*))
+    const Expr* right;       // BINARY right side
+    uint32_t offset;         // position in the statement, for error messages
+};
+
+struct OrderTerm {
+    std::string_view column;
+    bool descending;
+};
+
+struct Assignment {
+    std::string_view column;
+    const Expr* value;
+};
+
+struct ColumnDefinition {
+    std::string_view name;
+    std::string_view typeName;
+    uint32_t size;       // TEXT(32) -> 32; 0 when not given
+    bool primaryKey;
+};
+
+struct SelectStatement {
+    std::string_view table;
+    bool star;                       // SELECT *
+    ArenaList<const Expr*> columns;  // projection, when !star
+    const Expr* where;
+    ArenaList<std::string_view> groupBy;
+    ArenaList<OrderTerm> orderBy;
+    const Expr* limit;
+    const Expr* offset;
+};
+
+struct InsertStatement {
+    std::string_view table;
+    ArenaList<std::string_view> columns;  // empty = table order
+    ArenaList<ArenaList<const Expr*>> rows;
+};
+
+struct UpdateStatement {
+    std::string_view table;
+    ArenaList<Assignment> assignments;
+    const Expr* where;
+};
+
+struct DeleteStatement {
+    std::string_view table;
+    const Expr* where;
+};
+
+struct CreateTableStatement {
+    std::string_view table;
+    ArenaList<ColumnDefinition> columns;
+    ArenaList<std::string_view> primaryKey;  // PRIMARY KEY (a, b) after the columns; empty if none
+};
+
+struct CreateIndexStatement {
+    std::string_view name;  // empty if omitted
+    std::string_view table;
+    std::string_view column;
+    ArenaList<std::string_view> include;  // INCLUDE columns, copied into the index entries
+    std::string_view method;  // USING method, empty if omitted
+};
+
+enum class StatementKind : uint8_t {
+    SELECT,
+    INSERT,
+    UPDATE,
+    DELETE,
+    CREATE_TABLE,
+    CREATE_INDEX,
+    BEGIN,
+    COMMIT,
+    ROLLBACK
+};
+
+// Exactly one of the pointers matching kind is set
+struct Statement {
+    StatementKind kind;
+    const SelectStatement* select;
+    const InsertStatement* insert;
+    const UpdateStatement* update;
+    const DeleteStatement* remove;
+    const CreateTableStatement* createTable;
+    const CreateIndexStatement* createIndex;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "row.hpp"
+
+class Table;
+
+// Rows per segment, and how many changed rows the delta buffer holds before
+// they are folded into the segments
+constexpr uint32_t COLUMN_SEGMENT_ROWS = 4096;
+constexpr uint32_t COLUMN_DELTA_MAX_ROWS = 1024;
+
+/*
+A column-oriented copy of the users table: the ids and the projected text
+columns of every row, in id order, for scans that read a few columns of many
+rows. A leaf holds each row as one fixed-width cell, so a scan of the
+usernames alone still copies the full 291 bytes per row; here each column is
+stored on its own, its values packed back to back without padding.
+
+Rows are kept in segments of up to COLUMN_SEGMENT_ROWS consecutive ids. Each
+segment has a zone map, the smallest and largest value of every projected
+column, so a scan whose filter no value in that range can pass skips the
+segment. Segments are never changed in place, except to mark a row deleted:
+inserted and updated rows go to the delta buffer, which scans merge in id
+order, and once it reaches COLUMN_DELTA_MAX_ROWS rows they are folded in. A
+fold rebuilds only the segments whose ids the delta rows fall among or that
+have deleted rows, splitting any that grew too large, and appends the rest.
+
+Nothing is stored in the file but the catalog entry naming the projected
+columns. The table builds the store from its tree when it is first scanned
+(after an open, or after a rollback, which marks it stale), keeps it current
+on insert, update and delete, and holds its write latch to change it.
+*/
+class ColumnStore {
+public:
+    // One projected column's values in a segment: value i is bytes[ends[i - 1], ends[i])
+    struct TextColumn {
+        std::string bytes;
+        std::vector<uint32_t> ends;
+        std::string min;  // zone map, over every row including deleted ones
+        std::string max;
+
+        std::string_view value(uint32_t i) const {
+            uint32_t begin = i == 0 ? 0 : ends[i - 1];
+            return std::string_view(bytes.data() + begin, ends[i] - begin);
+        }
+    };
+
+    struct Segment {
+        std::vector<uint32_t> ids;  // ascending; the zone map of the id column is front() and back()
+        TextColumn columns[3];      // by users column number; only the projected text columns are filled
+        std::vector<bool> deleted;
+        uint32_t deletedRows = 0;
+    };
+
+    // A row in the delta buffer: the projected columns' values by column number
+    struct DeltaRow {
+        std::string values[3];
+    };
+
+private:
+    uint32_t columns;  // the projected text columns, bit per column number
+    std::vector<Segment> segments;
+    std::map<uint32_t, DeltaRow> delta;
+    uint32_t deletesSinceFold;  // rows marked deleted in segments; they count towards a fold too
+    uint64_t folds;
+
+    DeltaRow deltaRowOf(const Row& row) const;
+    void appendRow(Segment& segment, uint32_t id, const DeltaRow& values) const;
+    void finishSegment(Segment& segment) const;
+    // Splits rows (ids and values, in id order) into segments of at most COLUMN_SEGMENT_ROWS
+    void addSegments(std::vector<Segment>& into, const std::vector<std::pair<uint32_t, DeltaRow>>& rows) const;
+    void fold();
+
+public:
+    explicit ColumnStore(uint32_t columns);
+
+    uint32_t getColumns() const { return columns; }
+    bool projects(uint32_t column) const { return (columns & (1u << column)) != 0; }
+
+    // Replaces the contents with the table's rows, read from its tree
+    void rebuild(Table& table);
+    // Called by the table after it has inserted, updated or deleted the row
+    void insert(const Row& row);
+    void update(const Row& row);
+    void remove(uint32_t id);
+
+    const std::vector<Segment>& getSegments() const { return segments; }
+    const std::map<uint32_t, DeltaRow>& getDelta() const { return delta; }
+    // Times the delta buffer has been folded into the segments
+    uint64_t getFolds() const { return folds; }
+    // Live rows, segments and delta together
+    uint32_t getNumRows() const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+
+// Slots are allocated in whole units of this many bytes
+constexpr uint32_t COMPRESSED_SLOT_UNIT = 128;
+// Worst case for compressPage: one control byte per 128 literal bytes
+constexpr uint32_t COMPRESSED_PAGE_MAX_SIZE = PAGE_SIZE + PAGE_SIZE / 128;
+// writePage checkpoints by itself once the slots waiting for a checkpoint add
+// up to this many units and a quarter of the file
+constexpr uint32_t COMPRESSED_PENDING_FREE_MIN_UNITS = 256;
+
+// Zero-run codec: a control byte c < 0x80 is followed by c + 1 literal bytes,
+// c >= 0x80 stands for (c & 0x7f) + 1 zero bytes. Rows are padded to their
+// column widths, so leaf pages are mostly zero runs. Returns the encoded length
+// (at most COMPRESSED_PAGE_MAX_SIZE bytes are written to out).
+uint32_t compressPage(const uint8_t* page, uint8_t* out);
+// False if data is not a well-formed encoding of exactly one page
+bool decompressPage(const uint8_t* data, uint32_t length, uint8_t* page);
+
+/*
+A database file holding compressed pages. Each page is stored in a slot of
+whole COMPRESSED_SLOT_UNIT-byte units anywhere in the file, and an indirection
+map (page number -> offset, length, capacity) says where. A page that no longer
+compresses below PAGE_SIZE is stored as is. The superblock in the first unit
+starts with a magic number, which is how the pager tells these files from plain
+ones: a plain file starts with the root node's type byte.
+
+The map lives in memory and is written out by checkpoint, to a fresh extent,
+before the superblock is pointed at it. A page is rewritten in place while its
+new image fits its slot and fills at least half of it; otherwise it moves to a
+new slot, and the old one is only reused after the next checkpoint, so the map on disk never points at a
+slot holding another page. The pager checkpoints along with the WAL; writes
+that move many pages between those (eviction outside a transaction, say) also
+checkpoint once the slots they left behind reach a quarter of the file, so it
+cannot keep growing. Free extents are rebuilt from the map on open.
+
+Thread-safe: the pager reads under its cache lock but the background flusher
+writes outside it.
+*/
+class CompressedPageFile {
+private:
+    struct Slot {
+        uint32_t offset;    // in units; 0 = never written (unit 0 is the superblock)
+        uint16_t length;    // bytes stored; PAGE_SIZE = uncompressed
+        uint16_t capacity;  // in units
+    };
+
+    int fileDescriptor;
+    std::vector<Slot> slots;
+    std::map<uint32_t, uint32_t> freeExtents;  // offset -> length, in units
+    std::vector<std::pair<uint32_t, uint32_t>> pendingFree;  // freed since the last checkpoint
+    uint32_t pendingFreeUnits;
+    uint32_t endUnit;                          // one past the last unit in use
+    std::pair<uint32_t, uint32_t> mapExtent;   // where the current map is stored
+    uint64_t storedBytes;                      // sum of the slots' lengths
+    bool changed;                              // slots written since the last checkpoint
+    mutable std::mutex mutex;
+
+    uint32_t allocate(uint32_t units);
+    void release(uint32_t offset, uint32_t units);
+    void writeSuperblock(uint32_t mapBytes, uint32_t mapChecksum);
+    void checkpointLocked();
+
+public:
+    // Whether the file behind fd is in this format
+    static bool detect(int fd);
+    // Opens an existing compressed file, or formats an empty one when create is
+    // set. Throws std::runtime_error on a bad superblock or map.
+    CompressedPageFile(int fd, bool create);
+
+    uint32_t getNumPages() const;
+    // Bytes of page images stored, against getNumPages() * PAGE_SIZE uncompressed
+    uint64_t getStoredBytes() const;
+
+    // Pages never written read as zeros. Both return the bytes moved to or from the file.
+    uint32_t readPage(uint32_t pageNum, uint8_t* page);
+    uint32_t writePage(uint32_t pageNum, const uint8_t* page);
+    // Makes every page written so far durable: writes the map, then the
+    // superblock, with an fsync after each. Trims free space off the file's end.
+    void checkpoint();
+};
@@ -5,7 +5,7 @@
 // Shared constants
 constexpr uint32_t COLUMN_USERNAME_SIZE = 32;
 constexpr uint32_t COLUMN_EMAIL_SIZE = 255;
-constexpr uint32_t TABLE_MAX_PAGES = 100;
+constexpr uint32_t TABLE_MAX_PAGES = 65536;
 constexpr uint32_t PAGE_SIZE = 4096;
 
 // Derived storage layout constants
@@ -53,20 +53,103 @@ constexpr uint32_t INTERNAL_NODE_NUM_KEYS_SIZE = sizeof(uint32_t);
 constexpr uint32_t INTERNAL_NODE_NUM_KEYS_OFFSET = COMMON_NODE_HEADER_SIZE;
 constexpr uint32_t INTERNAL_NODE_RIGHT_CHILD_SIZE = sizeof(uint32_t);
 constexpr uint32_t INTERNAL_NODE_RIGHT_CHILD_OFFSET = INTERNAL_NODE_NUM_KEYS_OFFSET + INTERNAL_NODE_NUM_KEYS_SIZE;
+constexpr uint32_t INTERNAL_NODE_RIGHT_CHILD_ROWS_SIZE = sizeof(uint32_t);
+constexpr uint32_t INTERNAL_NODE_RIGHT_CHILD_ROWS_OFFSET = INTERNAL_NODE_RIGHT_CHILD_OFFSET + INTERNAL_NODE_RIGHT_CHILD_SIZE;
 constexpr uint32_t INTERNAL_NODE_HEADER_SIZE = COMMON_NODE_HEADER_SIZE +
                                            INTERNAL_NODE_NUM_KEYS_SIZE +
-                                           INTERNAL_NODE_RIGHT_CHILD_SIZE;
+                                           INTERNAL_NODE_RIGHT_CHILD_SIZE +
+                                           INTERNAL_NODE_RIGHT_CHILD_ROWS_SIZE;
 
 // Internal Node Body Layout
 constexpr uint32_t INTERNAL_NODE_CHILD_SIZE = sizeof(uint32_t);
 constexpr uint32_t INTERNAL_NODE_KEY_SIZE = sizeof(uint32_t);
-constexpr uint32_t INTERNAL_NODE_CELL_SIZE = INTERNAL_NODE_CHILD_SIZE + INTERNAL_NODE_KEY_SIZE;
+// rows in the child's subtree (an order-statistic tree: COUNT(*) and OFFSET need no scan)
+constexpr uint32_t INTERNAL_NODE_ROWS_SIZE = sizeof(uint32_t);
+constexpr uint32_t INTERNAL_NODE_ROWS_OFFSET = INTERNAL_NODE_CHILD_SIZE + INTERNAL_NODE_KEY_SIZE;
+constexpr uint32_t INTERNAL_NODE_CELL_SIZE = INTERNAL_NODE_CHILD_SIZE + INTERNAL_NODE_KEY_SIZE + INTERNAL_NODE_ROWS_SIZE;
 
 
-constexpr uint32_t INTERNAL_NODE_SPACE_FOR_CELLS = PAGE_SIZE - INTERNAL_NODE_HEADER_SIZE; // 4096 -8 = 4082
-constexpr uint32_t INTERNAL_NODE_MAX_KEYS = INTERNAL_NODE_SPACE_FOR_CELLS / INTERNAL_NODE_CELL_SIZE; // 4082 / 8 = 510
-constexpr uint32_t INTERNAL_NODE_MAX_CHILDREN = INTERNAL_NODE_MAX_KEYS + 1; // 511 
+constexpr uint32_t INTERNAL_NODE_SPACE_FOR_CELLS = PAGE_SIZE - INTERNAL_NODE_HEADER_SIZE; // 4096 - 18 = 4078
+constexpr uint32_t INTERNAL_NODE_MAX_KEYS = INTERNAL_NODE_SPACE_FOR_CELLS / INTERNAL_NODE_CELL_SIZE; // 4078 / 12 = 339
+constexpr uint32_t INTERNAL_NODE_MAX_CHILDREN = INTERNAL_NODE_MAX_KEYS + 1; // 340
 // constexpr uint32_t INTERNAL_NODE_MAX_KEYS = 8; // for testing
 // constexpr uint32_t INTERNAL_NODE_MAX_CHILDREN = INTERNAL_NODE_MAX_KEYS + 1; //
 
-constexpr uint32_t INVALID_PAGE_NUM = UINT32_MAX;
\ No newline at end of file
+constexpr uint32_t INVALID_PAGE_NUM = UINT32_MAX;
+
+// Secondary index nodes: slotted pages of variable-length cells. After the
+// common header come the cell count, the link (next leaf, or the right child
+// of an internal node), where the cell area starts and the length of the key
+// prefix; then the prefix, padded to an even length, and one 2-byte slot per
+// cell, in key order, holding the cell's offset. Cells fill the page from the
+// end: key length (2 bytes), key bytes, row id, then for leaves the payload
+// length (2 bytes) and payload (the index's included columns), and for
+// internal nodes the child page, whose subtree holds keys up to and including
+// the cell's. The prefix is what every key of an internal node starts with,
+// stored once and left out of its cells; leaves have none.
+constexpr uint32_t INDEX_NODE_NUM_CELLS_OFFSET = COMMON_NODE_HEADER_SIZE;
+constexpr uint32_t INDEX_NODE_LINK_OFFSET = INDEX_NODE_NUM_CELLS_OFFSET + sizeof(uint32_t);
+constexpr uint32_t INDEX_NODE_CELLS_START_OFFSET = INDEX_NODE_LINK_OFFSET + sizeof(uint32_t);
+constexpr uint32_t INDEX_NODE_PREFIX_LENGTH_OFFSET = INDEX_NODE_CELLS_START_OFFSET + sizeof(uint32_t);
+constexpr uint32_t INDEX_NODE_HEADER_SIZE = INDEX_NODE_PREFIX_LENGTH_OFFSET + sizeof(uint32_t);
+constexpr uint32_t INDEX_NODE_SLOT_SIZE = sizeof(uint16_t);
+constexpr uint32_t INDEX_KEY_MAX_SIZE = COLUMN_EMAIL_SIZE;
+
+// Hash index pages (see HashIndex). A bucket page holds its entry count, the
+// next page of the bucket's overflow chain (0 = none) and then unordered
+// (id, leaf page) pairs. The header page holds the linear hashing state
+// (level, split pointer, entry and bucket counts), the next directory page and
+// then bucket page numbers, which continue in the directory pages after it.
+constexpr uint32_t HASH_BUCKET_COUNT_OFFSET = COMMON_NODE_HEADER_SIZE;
+constexpr uint32_t HASH_BUCKET_OVERFLOW_OFFSET = HASH_BUCKET_COUNT_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_BUCKET_HEADER_SIZE = HASH_BUCKET_OVERFLOW_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_ENTRY_SIZE = 2 * sizeof(uint32_t);
+constexpr uint32_t HASH_BUCKET_MAX_ENTRIES = (PAGE_SIZE - HASH_BUCKET_HEADER_SIZE) / HASH_ENTRY_SIZE; // 510
+constexpr uint32_t HASH_LEVEL_OFFSET = COMMON_NODE_HEADER_SIZE;
+constexpr uint32_t HASH_SPLIT_OFFSET = HASH_LEVEL_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_ENTRIES_OFFSET = HASH_SPLIT_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_BUCKETS_OFFSET = HASH_ENTRIES_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_NEXT_DIRECTORY_OFFSET = HASH_BUCKETS_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_DIRECTORY_HEADER_SIZE = HASH_NEXT_DIRECTORY_OFFSET + sizeof(uint32_t);
+constexpr uint32_t HASH_DIRECTORY_MAX_BUCKETS = (PAGE_SIZE - HASH_DIRECTORY_HEADER_SIZE) / sizeof(uint32_t); // 1017
+// a bucket is split once the index averages this share of a bucket page per bucket
+constexpr double HASH_MAX_LOAD = 0.75;
+
+// Zone map pages (see ZoneMap). A zone page holds an entry for each of
+// ZONE_PAGE_MAX_LEAVES consecutive page numbers: the smallest and largest
+// 8-byte prefix of the usernames in that leaf, then the same for the emails.
+// The header page holds the number of zone page slots and the next directory
+// page, then the zone page numbers (0 = none yet), which continue in the
+// directory pages after it.
+constexpr uint32_t ZONE_PREFIX_SIZE = sizeof(uint64_t);
+constexpr uint32_t ZONE_ENTRY_SIZE = 4 * ZONE_PREFIX_SIZE;
+constexpr uint32_t ZONE_PAGE_MAX_LEAVES = (PAGE_SIZE - COMMON_NODE_HEADER_SIZE) / ZONE_ENTRY_SIZE; // 127
+constexpr uint32_t ZONE_SLOTS_OFFSET = COMMON_NODE_HEADER_SIZE;
+constexpr uint32_t ZONE_NEXT_DIRECTORY_OFFSET = ZONE_SLOTS_OFFSET + sizeof(uint32_t);
+constexpr uint32_t ZONE_DIRECTORY_HEADER_SIZE = ZONE_NEXT_DIRECTORY_OFFSET + sizeof(uint32_t);
+constexpr uint32_t ZONE_DIRECTORY_MAX_SLOTS = (PAGE_SIZE - ZONE_DIRECTORY_HEADER_SIZE) / sizeof(uint32_t); // 1020
+
+// The last bytes of the root page (page 0) are never used by either node
+// layout; they hold the file format stamp and the page number of the index
+// catalog (0 = no indexes)
+constexpr uint32_t ROOT_PAGE_CATALOG_OFFSET = PAGE_SIZE - sizeof(uint32_t);
+constexpr uint32_t ROOT_PAGE_FORMAT_OFFSET = ROOT_PAGE_CATALOG_OFFSET - sizeof(uint32_t);
+static_assert(LEAF_NODE_HEADER_SIZE + LEAF_NODE_MAX_CELLS * LEAF_NODE_CELL_SIZE <= ROOT_PAGE_FORMAT_OFFSET,
+              "leaf cells would overwrite the format stamp");
+static_assert(INTERNAL_NODE_HEADER_SIZE + INTERNAL_NODE_MAX_KEYS * INTERNAL_NODE_CELL_SIZE <= ROOT_PAGE_FORMAT_OFFSET,
+              "internal cells would overwrite the format stamp");
+
+// Format stamp: magic in the high half, version in the low half. Bump the
+// version whenever a page layout changes; files with another stamp are
+// refused on open. Version 1: internal cells with subtree row counts, slotted
+// index pages with a stored key prefix, hash index pages and the catalog.
+// Version 2: the catalog may point at a table catalog (CREATE TABLE tables);
+// version 1 files are still read, and restamped when a table is created.
+// Version 3: the catalog may name the columns of a column store; older files
+// are restamped when one is created.
+// Version 4: the catalog may point at a zone map; older files are restamped
+// when one is created.
+constexpr uint32_t DATABASE_FORMAT_MAGIC = 0x534C0000;  // "SL"
+constexpr uint32_t DATABASE_FORMAT_VERSION = 4;
+constexpr uint32_t DATABASE_FORMAT_MIN_VERSION = 1;
+constexpr uint32_t DATABASE_FORMAT_STAMP = DATABASE_FORMAT_MAGIC | DATABASE_FORMAT_VERSION;
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class Table;
+
+// Bytes of the file each parse task takes, cut at the next line end
+constexpr size_t IMPORT_CHUNK_BYTES = 4u << 20;
+
+struct ImportResult {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;       // size of the file
+    uint32_t chunks = 0;      // pieces parsed as separate tasks
+    bool bulkLoaded = false;  // the users tree was built bottom up (see Table::bulkLoad)
+};
+
+/*
+Loads a CSV file into "users" or a CREATE TABLE table: a row per line, the
+table's columns in order, separated by commas. A field may be quoted ("a,b",
+with "" for a quote inside it) but may not run across lines. A first line
+naming the table's columns is a header and skipped; empty lines are skipped
+and \r\n line ends accepted. Numbers are written as in SQL; text is taken as
+it is, and users' text columns are checked against their sizes as by INSERT.
+
+The file is mapped into memory and cut at line ends into chunks of about
+chunkBytes. The chunks are parsed as parallel tasks on the table's scheduler
+(one after another if it has none), finding delimiters 16 bytes at a time
+with SSE2, and the rows are then sorted by key. Rows for users go to
+Table::bulkLoad, which builds an empty tree bottom up; rows for a CREATE
+TABLE table are inserted in key order.
+
+All or nothing: the import runs in a transaction of its own, or under a
+savepoint inside the caller's. Throws std::runtime_error if the file cannot
+be read, and std::invalid_argument for an unknown table, a malformed line
+(giving its number), a value that does not fit its column or a key that is
+already taken; the table is then as it was before.
+*/
+ImportResult importCsv(Table& table, const std::string& path, std::string_view tableName,
+                       size_t chunkBytes = IMPORT_CHUNK_BYTES);
@@ -20,6 +20,9 @@ public:
     uint32_t getCellNum() const { return cellNum; }
     uint32_t getPageNum() const { return pageNum; }
     bool isEndOfTable() const { return endOfTable; }
+    // Moves off the end of the current leaf (and past any emptied leaves) to the
+    // next row; lets a cursor positioned by key start a range scan
+    void skipExhaustedLeaves();
 private:
     void leafNodeFind(uint32_t key, uint32_t pageNum);
     void internalNodeFind(uint32_t key, uint32_t pageNum);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "page_flusher.hpp"
+#include "scheduler.hpp"
+#include "table.hpp"
+
+struct DatabaseOptions {
+    // Upper bound on scheduler worker threads; 0 = one per hardware thread
+    uint32_t maxWorkerThreads = 0;
+    // Page cache size in frames (soft cap, see Pager::evictToCapacity)
+    uint32_t cachePages = PAGER_DEFAULT_CACHE_PAGES;
+    // Create a new file with compressed pages (existing files keep their format)
+    bool compressPages = false;
+    FlusherOptions flusher;
+};
+
+// Handle for one open database file: owns the table and the engine-wide
+// scheduler that query execution and background work share.
+class Database {
+private:
+    // declared first so it is destroyed last; ~Database drains it before the table goes
+    Scheduler scheduler;
+    Table table;
+    PageFlusher flusher;
+
+public:
+    explicit Database(const std::string& filename, const DatabaseOptions& options = DatabaseOptions());
+    ~Database();
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    Table& getTable() { return table; }
+    Scheduler& getScheduler() { return scheduler; }
+    PageFlusher& getFlusher() { return flusher; }
+};
@@ -3,6 +3,7 @@
 enum class MetaCommandResult {
     META_COMMAND_SUCCESS,
     META_COMMAND_UNRECOGNIZED_COMMAND,
+    META_COMMAND_FAILURE,  // the command printed why
     META_COMMAND_EXIT
 };
 
@@ -22,5 +23,11 @@ enum class ExecuteResult {
 
 enum class NodeType {
     NODE_INTERNAL,
-    NODE_LEAF
+    NODE_LEAF,
+    NODE_INDEX_INTERNAL,  // secondary index pages (see IndexNode)
+    NODE_INDEX_LEAF,
+    NODE_HASH_DIRECTORY,  // primary key hash index pages (see HashIndex)
+    NODE_HASH_BUCKET,
+    NODE_ZONE_DIRECTORY,  // per-leaf column summaries (see ZoneMap)
+    NODE_ZONE_PAGE
 };
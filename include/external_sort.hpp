@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pager.hpp"
+
+// Bytes of sort records an ExternalSorter keeps in memory before it spills a run
+constexpr size_t SORT_MEMORY_BUDGET = 32u << 20;
+// LIMITs up to this many rows are sorted with a bounded heap instead
+constexpr uint64_t TOP_N_MAX_ROWS = 65536;
+
+/*
+Normalized sort keys: each value is appended so that comparing two whole keys
+with memcmp orders rows by the values in turn. Integers are stored big-endian
+with the sign bit flipped; text is stored with 0x00 escaped as 0x00 0xFF and
+terminated by 0x00 0x00, so a string sorts before its extensions. Descending
+values have every byte of their encoding inverted.
+*/
+void appendSortKey(std::string& key, int64_t value, bool descending);
+void appendSortKey(std::string& key, std::string_view value, bool descending);
+
+// A temporary file of pages, read and written through its own small Pager.
+// The file is unlinked as soon as it is open, so it disappears with the object.
+class SpillFile {
+private:
+    std::unique_ptr<Pager> pager;
+    uint64_t size;
+
+    void copy(uint64_t offset, uint8_t* data, size_t length, bool write);
+
+public:
+    SpillFile();
+    // Returns the offset the bytes were written at
+    uint64_t append(const void* data, size_t length);
+    void read(uint64_t offset, void* data, size_t length);
+    uint64_t getSize() const { return size; }
+    const Pager& getPager() const { return *pager; }
+};
+
+/*
+Sorts records of (normalized key, payload) by key with memcmp; ties keep
+insertion order. Records are buffered in memory; whenever they outgrow the
+memory budget the buffer is sorted and written to a SpillFile as one run, and
+finish() sets up a k-way merge over the runs. With a limit of at most
+TOP_N_MAX_ROWS only the limit smallest records are kept, in a bounded max-heap,
+and nothing spills.
+
+In memory the records are sorted through fixed-size entries: the first 8 key
+bytes as an integer (the prefix), compared first, and the position of the full
+key, compared only when prefixes tie. An 8-byte sequence number appended to
+every key is the tiebreak that keeps the sort stable and every key distinct.
+*/
+class ExternalSorter {
+private:
+    struct Entry {
+        uint64_t prefix;
+        uint32_t offset;  // into buffer: key bytes, then payload
+        uint32_t keyLength;
+        uint32_t payloadLength;
+    };
+
+    struct Record {
+        std::string bytes;  // key, then payload
+        uint32_t keyLength;
+    };
+
+    struct Run {
+        uint64_t position;  // of the next record in the spill file
+        uint64_t end;
+        Record current;
+    };
+
+    size_t memoryBudget;
+    uint64_t limit;
+    uint64_t sequence;
+    uint64_t emitted;
+    bool finished;
+
+    std::vector<uint8_t> buffer;
+    std::vector<Entry> entries;
+
+    std::vector<Record> topN;  // max-heap on key while adding, then sorted ascending
+
+    std::unique_ptr<SpillFile> spill;
+    std::vector<Run> runs;
+    std::vector<uint32_t> merge;  // min-heap of runs that still have a current record
+    uint32_t lastRun;             // run whose record was returned last; advanced on the next call
+
+    std::string scratch;
+
+    bool bounded() const { return limit <= TOP_N_MAX_ROWS; }
+    void sortBuffer();
+    void spillBuffer();
+    bool readRecord(Run& run);
+
+public:
+    explicit ExternalSorter(size_t memoryBudget = SORT_MEMORY_BUDGET, uint64_t limit = UINT64_MAX);
+    void add(std::string_view key, std::string_view payload);
+    // No more adds after this
+    void finish();
+    // Records in key order, at most limit of them; the views stay valid until the next call
+    bool next(std::string_view& key, std::string_view& payload);
+
+    uint32_t getSpilledRuns() const { return static_cast<uint32_t>(runs.size()); }
+    uint64_t getSpilledBytes() const { return spill ? spill->getSize() : 0; }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+Predicate kernels that run on serialized leaf cells, before anything is
+decoded. Text fields are fixed width and zero-padded (see Row), so equality
+is a whole-field compare and prefix tests never need the field's length;
+both compare 16 bytes per step with SSE2 where available. Every kernel reads
+only inside its field, never past the end of the page.
+*/
+
+enum class FieldMatch : uint8_t {
+    EQUALS,    // field == pattern
+    PREFIX,    // LIKE 'pattern%'
+    SUFFIX,    // LIKE '%pattern'
+    CONTAINS   // LIKE '%pattern%'
+};
+
+struct FieldFilter {
+    FieldMatch match;
+    uint32_t fieldOffset;  // within the cell
+    uint32_t fieldSize;
+    uint32_t patternLength;
+    std::string pattern;   // zero-padded to at least fieldSize bytes
+};
+
+// False if no field of fieldSize bytes can match (an EQUALS pattern longer
+// than the longest value the field holds)
+bool makeFieldFilter(FieldMatch match, uint32_t fieldOffset, uint32_t fieldSize, std::string_view pattern,
+                     FieldFilter& filter);
+
+// Keeps the cells listed in selection[0, count) whose field matches; cell i
+// starts at cells + i * cellStride. Returns the new count.
+uint32_t applyFieldFilter(const FieldFilter& filter, const uint8_t* cells, uint32_t cellStride, uint32_t* selection,
+                          uint32_t count);
+
+// applyFieldFilter for text stored back to back rather than in fixed-width
+// fields (see ColumnStore): value i is bytes[ends[i - 1], ends[i]), the first
+// starting at bytes. filter's offset and size are not used.
+uint32_t applyTextFilter(const FieldFilter& filter, const char* bytes, const uint32_t* ends, uint32_t* selection,
+                         uint32_t count);
+
+// False if no value in [min, max] can pass filter; only EQUALS and PREFIX
+// filters ever rule a range out
+bool textRangeMayMatch(const FieldFilter& filter, std::string_view min, std::string_view max);
+
+// Length of the zero-terminated text in a field of size bytes
+uint32_t fieldLength(const char* field, uint32_t size);
+
+// LIKE with % and _ wildcards, case-sensitive
+bool likeMatch(std::string_view text, std::string_view pattern);
+
+// Recognizes LIKE patterns one kernel can answer; literal is the pattern
+// without its wildcards. False for anything else (inner % or any _).
+bool classifyLike(std::string_view pattern, FieldMatch& match, std::string_view& literal);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Table;
+
+/*
+An on-disk linear hashing index over the primary key, mapping each id to the
+leaf page that holds its row. A point lookup reads one bucket page (rarely
+more, when the bucket has overflowed) and then that leaf, instead of
+descending the tree a level at a time; range scans still use the tree.
+
+Buckets are chains of pages allocated from the table's pager, so they share
+its cache, transactions and WAL. Bucket b is addressed by the low `level` bits
+of the key's hash, or by one more bit once the split pointer has passed b.
+When the index fills past HASH_MAX_LOAD, the bucket at the split pointer is
+split into itself and a new bucket at the end, so the table grows one bucket at
+a time and never rehashes as a whole. The directory of bucket page numbers is
+read into memory when the index is opened.
+
+The table calls put for every row a leaf split moves, and remove on delete.
+Callers hold the table's write latch to modify it.
+*/
+class HashIndex {
+private:
+    Table& table;
+    uint32_t headerPageNum;
+    uint32_t level;
+    uint32_t splitPointer;
+    uint32_t entryCount;
+    std::vector<uint32_t> bucketPages;     // first page of each bucket's chain
+    std::vector<uint32_t> directoryPages;  // the header page, then its continuations
+
+    uint32_t bucketOf(uint32_t key) const;
+    // Adds an entry known to be absent, extending the bucket's chain if it is full
+    void addToBucket(uint32_t bucket, uint32_t key, uint32_t leafPageNum);
+    void appendBucket();
+    void splitBucket();
+    void saveState();
+
+public:
+    // Reads the state and directory from the header page
+    HashIndex(Table& table, uint32_t headerPageNum);
+    // Sets up an empty index with one bucket, its header in pageNum
+    static void initialize(Table& table, uint32_t pageNum);
+
+    uint32_t getHeaderPageNum() const { return headerPageNum; }
+    uint32_t getEntryCount() const { return entryCount; }
+    uint32_t getBucketCount() const { return static_cast<uint32_t>(bucketPages.size()); }
+
+    // The leaf page holding key; false if the key is not indexed
+    bool find(uint32_t key, uint32_t& leafPageNum) const;
+    // Adds key or points it at a different leaf
+    void put(uint32_t key, uint32_t leafPageNum);
+    // False if the key is not indexed
+    bool remove(uint32_t key);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "constants.hpp"
+#include "enums.hpp"
+#include "key_format.hpp"
+
+// Index entries order by key bytes (a string sorts before its extensions),
+// then by row id, so every entry is distinct
+int compareIndexEntries(std::string_view keyA, uint32_t idA, std::string_view keyB, uint32_t idB);
+
+/*
+View of a secondary index page (layout in constants.hpp). It shares the common
+node header with Node, so Node::nodeParent/isRootNode/getNodeType work on it
+too. Removing a cell leaves a hole in the cell area; insertCell compacts the
+page when the hole space is what it needs. Internal nodes store their keys
+without the node's prefix(): keys passed in are whole, key() returns the rest,
+and lowerBound compares the prefix once before searching the rests.
+*/
+class IndexNode {
+private:
+    uint8_t* data;
+
+    uint32_t prefixLength() const;
+    uint32_t slotsStart() const;
+    uint16_t* slot(uint32_t cellNum) const;
+    const uint8_t* cell(uint32_t cellNum) const;
+    static uint32_t storedSize(const uint8_t* cell, bool leaf);
+    uint32_t usedBytes() const;
+    void compact();
+    void shortenPrefix(uint32_t length);
+    bool placeCell(uint32_t cellNum, std::string_view storedKey, uint32_t id, uint32_t child,
+                   std::string_view payload);
+
+public:
+    explicit IndexNode(void* data) : data(static_cast<uint8_t*>(data)) {}
+
+    // prefix is for internal nodes: keys inserted later that do not start with
+    // it make the node rewrite its cells with a shorter one. Without one, the
+    // first key inserted is taken as the prefix.
+    void initialize(bool leaf, std::string_view prefix = std::string_view());
+    bool isLeaf() const;
+    uint32_t numCells() const;
+    // Leaf: next leaf page (0 = none). Internal: right child, holding keys above every cell.
+    uint32_t* link();
+    uint32_t* parent();
+    bool isRoot() const;
+    void setRoot(bool root);
+
+    std::string_view prefix() const;
+    // Without the prefix, in an internal node
+    std::string_view key(uint32_t cellNum) const;
+    uint32_t id(uint32_t cellNum) const;
+    uint32_t child(uint32_t cellNum) const;  // internal only
+    std::string_view payload(uint32_t cellNum) const;  // leaf only
+    void setChild(uint32_t cellNum, uint32_t pageNum);
+    // childNum == numCells() is the right child
+    uint32_t childAt(uint32_t childNum);
+    // Which child slot points at pageNum; numCells() for the right child
+    uint32_t findChild(uint32_t pageNum);
+
+    // First cell whose entry is >= (key, id), comparing keys as Keys says
+    // (ByteKeys, Fixed8Keys or Fixed16Keys; see key_format.hpp)
+    template <typename Keys>
+    uint32_t lowerBound(std::string_view key, uint32_t id) const;
+    uint32_t lowerBound(std::string_view key, uint32_t id) const { return lowerBound<ByteKeys>(key, id); }
+    static uint32_t cellSize(bool leaf, uint32_t keyLength, uint32_t payloadLength = 0);
+    // Bytes a prefix of this length takes ahead of the slots
+    static uint32_t prefixSpace(uint32_t prefixLength);
+    // Bytes a cell and its slot may still take, counting the holes compaction would reclaim
+    uint32_t freeSpace() const;
+    // False, changing nothing, if the cell does not fit (counting the cells
+    // it would lengthen by shortening the prefix). child is stored in internal
+    // cells, payload in leaf cells.
+    bool insertCell(uint32_t cellNum, std::string_view key, uint32_t id, uint32_t child = 0,
+                    std::string_view payload = std::string_view());
+    void removeCell(uint32_t cellNum);
+};
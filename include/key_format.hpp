@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/*
+How the keys of a slotted B+ tree (IndexNode pages) compare. Every tree orders
+its keys as bytes; a key format lets the search and split code, which take it
+as a template argument, use what is known about the keys up front instead of
+finding it out per comparison.
+
+BYTES keys may have any length up to INDEX_KEY_MAX_SIZE and compare as
+strings. FIXED_8 and FIXED_16 trees hold keys of exactly 8 or 16 bytes (one or
+two encoded integer columns): their leaves split under whole keys, so an
+internal node's keys, once its prefix is cut off, all have the same length
+too, and a comparison is one or two big-endian word loads instead of a
+byte-by-byte walk.
+*/
+enum class KeyFormat : uint8_t {
+    BYTES,
+    FIXED_8,
+    FIXED_16
+};
+
+// Any keys; a search key is compared byte by byte against the node's
+struct ByteKeys {
+    // Leaves split under the shortest key that separates the halves
+    static constexpr bool SHORT_SEPARATORS = true;
+
+    class Probe {
+    private:
+        std::string_view key;
+
+    public:
+        explicit Probe(std::string_view searchKey) : key(searchKey) {}
+        // <0, 0 or >0 as nodeKey sorts before, with or after the search key
+        int compare(std::string_view nodeKey) const { return nodeKey.compare(key); }
+    };
+};
+
+template <uint32_t Width>
+struct FixedKeys {
+    static_assert(Width % sizeof(uint64_t) == 0, "fixed keys are whole words");
+    static constexpr uint32_t WORDS = Width / sizeof(uint64_t);
+    // Separators are whole keys, so every key in the tree keeps its width
+    static constexpr bool SHORT_SEPARATORS = false;
+
+    // Reads a word of key bytes as a big-endian number
+    static uint64_t loadWord(const char* bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return __builtin_bswap64(word);
+    }
+
+    class Probe {
+    private:
+        std::string_view key;
+        uint64_t words[WORDS];
+        // the last word's significant bits; the bytes after a shorter key are cleared
+        uint64_t lastMask;
+
+    public:
+        explicit Probe(std::string_view searchKey) : key(searchKey), words{}, lastMask(0) {
+            if (key.size() == 0 || key.size() > Width) {
+                return;
+            }
+            char padded[Width] = {};
+            std::memcpy(padded, key.data(), key.size());
+            for (uint32_t w = 0; w < WORDS; w++) {
+                words[w] = loadWord(padded + w * sizeof(uint64_t));
+            }
+            uint32_t tail = static_cast<uint32_t>(key.size() % sizeof(uint64_t));
+            lastMask = tail == 0 ? ~uint64_t(0) : ~uint64_t(0) << (64 - 8 * tail);
+        }
+
+        // Node keys as long as the search key are compared a word at a time.
+        // In an internal node such a key is shorter than Width (the node's
+        // prefix is cut off) and followed by the cell's id and child, 8 bytes,
+        // so the last word may read past it but not past the cell; the bytes
+        // beyond it are masked off. Keys of another length (a search from an
+        // empty key, a tree written before the format applied) compare as bytes.
+        int compare(std::string_view nodeKey) const {
+            if (nodeKey.size() != key.size() || key.size() == 0 || key.size() > Width) {
+                return nodeKey.compare(key);
+            }
+            uint32_t lastWord = static_cast<uint32_t>((key.size() - 1) / sizeof(uint64_t));
+            for (uint32_t w = 0; w < WORDS; w++) {
+                uint64_t value = loadWord(nodeKey.data() + w * sizeof(uint64_t));
+                if (w == lastWord) {
+                    value &= lastMask;
+                }
+                if (value != words[w]) {
+                    return value < words[w] ? -1 : 1;
+                }
+                if (w == lastWord) {
+                    break;
+                }
+            }
+            return 0;
+        }
+    };
+};
+
+using Fixed8Keys = FixedKeys<8>;
+using Fixed16Keys = FixedKeys<16>;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 128 bits per leaf: about 10 bits for each of a full leaf's 13 keys
+constexpr uint32_t LEAF_FILTER_WORDS = 2;
+constexpr uint32_t LEAF_FILTER_HASHES = 4;
+
+/*
+In-memory Bloom filters over the keys of each leaf of the table's tree,
+indexed by page number. A lookup descends the internal nodes as usual but
+stops above the leaf: the filters also record which pages are leaves, so the
+leaf's filter can be checked before its page is read, and an absent key is
+answered without reading it. A present key always passes; about 1% of absent
+keys in a full leaf pass too and cost the leaf read anyway.
+
+Nothing is stored in the file. The table builds the filters when it opens,
+rebuilds those of the pages a rollback restored, and keeps them current on
+insert, leaf split and delete (deletes rebuild the leaf's filter, as Bloom
+filters cannot remove a key).
+*/
+class LeafFilters {
+public:
+    struct Stats {
+        uint64_t probes;          // lookups that reached a leaf's filter
+        uint64_t negatives;       // answered absent by the filter: leaf reads saved
+        uint64_t falsePositives;  // passed the filter, but the leaf did not hold the key
+    };
+
+private:
+    std::vector<std::array<uint64_t, LEAF_FILTER_WORDS>> filters;
+    std::vector<bool> leaves;
+    std::atomic<uint64_t> probes{0};
+    std::atomic<uint64_t> negatives{0};
+    std::atomic<uint64_t> falsePositives{0};
+
+public:
+    // Forgets every page (counters are kept)
+    void clear();
+    // Empties pageNum's filter and records whether the page is a leaf
+    void reset(uint32_t pageNum, bool isLeaf);
+    void add(uint32_t pageNum, uint32_t key);
+
+    bool isLeaf(uint32_t pageNum) const { return pageNum < leaves.size() && leaves[pageNum]; }
+    // False only if the leaf at pageNum cannot hold key; counts the probe
+    bool mayContain(uint32_t pageNum, uint32_t key);
+    // Called when a key that passed mayContain was not in the leaf
+    void recordFalsePositive() { falsePositives.fetch_add(1, std::memory_order_relaxed); }
+
+    Stats getStats() const;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+enum class TokenType : uint8_t {
+    END,
+    ERROR,       // text holds the offending character(s)
+    IDENTIFIER,  // bare or "double quoted" (text excludes the quotes)
+    INTEGER,
+    STRING,      // 'single quoted'; text excludes the quotes, '' escapes are left in
+    PARAMETER,   // ? placeholder for a bound value
+
+    COMMA,
+    LEFT_PAREN,
+    RIGHT_PAREN,
+    SEMICOLON,
+    STAR,
+    PLUS,
+    MINUS,
+    SLASH,
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+
+    KW_SELECT,
+    KW_FROM,
+    KW_WHERE,
+    KW_ORDER,
+    KW_GROUP,
+    KW_BY,
+    KW_ASC,
+    KW_DESC,
+    KW_LIMIT,
+    KW_OFFSET,
+    KW_INSERT,
+    KW_INTO,
+    KW_VALUES,
+    KW_UPDATE,
+    KW_SET,
+    KW_DELETE,
+    KW_CREATE,
+    KW_TABLE,
+    KW_INDEX,
+    KW_INCLUDE,
+    KW_USING,
+    KW_ON,
+    KW_PRIMARY,
+    KW_KEY,
+    KW_AND,
+    KW_OR,
+    KW_NOT,
+    KW_LIKE,
+    KW_BEGIN,
+    KW_COMMIT,
+    KW_ROLLBACK,
+    KW_TRANSACTION
+};
+
+struct Token {
+    TokenType type;
+    std::string_view text;
+    uint32_t offset;  // byte offset in the statement, for error messages
+};
+
+// Produces tokens on demand straight from the statement text; tokens are
+// views into that text, so it must outlive them.
+class Lexer {
+private:
+    std::string_view input;
+    size_t position;
+
+    Token make(TokenType type, size_t start, size_t length);
+    Token lexQuoted(TokenType type, char quote);
+
+public:
+    explicit Lexer(std::string_view input);
+
+    Token next();
+    // Case-insensitive keyword lookup; IDENTIFIER if word is not a keyword
+    static TokenType keywordType(std::string_view word);
+};
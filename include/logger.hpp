@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// How much the engine reports. A message goes out when its level is at or
+// below the current one; OFF, the default, keeps the library silent.
+enum class LogLevel : uint8_t {
+    OFF = 0,
+    ERROR = 1,  // failures the caller also sees as an exception or status, plus ones it cannot (background flushes)
+    DEBUG = 2
+};
+
+using LogSink = std::function<void(LogLevel level, const std::string& message)>;
+
+void setLogLevel(LogLevel level);
+LogLevel getLogLevel();
+// Where messages go; an empty sink restores the default, one line per message on std::cerr
+void setLogSink(LogSink sink);
+
+inline bool logEnabled(LogLevel level) {
+    return level != LogLevel::OFF && level <= getLogLevel();
+}
+// Safe from any thread; messages from different threads are not interleaved
+void logMessage(LogLevel level, const std::string& message);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A file mapped read-only into memory, for reading it front to back without
+// copying it through a buffer. The pages are read in on first touch, and the
+// kernel is told they will be read in order.
+class MappedFile {
+private:
+    const char* data;
+    size_t size;
+
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view getText() const { return std::string_view(data, size); }
+    size_t getSize() const { return size; }
+};
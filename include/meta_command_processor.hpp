@@ -3,12 +3,17 @@
 #include <unordered_map>
 #include <functional>
 #include <string>
+#include <vector>
 #include "enums.hpp"
 #include "table.hpp"
 
 class MetaCommandProcessor {
 private:
     std::unordered_map<std::string, std::function<MetaCommandResult(Table* table)>> commands;
+    // Commands taking arguments, by their first word; they get the words after it
+    std::unordered_map<std::string,
+                       std::function<MetaCommandResult(Table* table, const std::vector<std::string>& args)>>
+        argumentCommands;
 
 public:
     MetaCommandProcessor();
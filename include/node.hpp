@@ -19,6 +19,8 @@ public:
     void* leafNodeValue(uint32_t cellNum);
     void initializeLeafNode();
     void leafNodeInsert(uint32_t key, const Row* value, uint32_t cellNum);
+    // Cell holding key, or the cell it would be inserted at
+    uint32_t leafNodeFind(uint32_t key);
     void printLeafNode();
     uint32_t* leafNodeRightSibling();
     
@@ -29,6 +31,8 @@ public:
     uint32_t* internalNodeCell(uint32_t cellNum);
     uint32_t* internalNodeChild(uint32_t childNum);
     uint32_t* internalNodeKey(uint32_t keyNum);
+    // rows under child childNum (childNum == numKeys is the right child)
+    uint32_t* internalNodeChildRows(uint32_t childNum);
     uint32_t internalNodeFindChild(uint32_t childPageNum);
     void internalNodeUpdateMaxKey(uint32_t childPageNum, uint32_t newNodeMax);
     void initializeInternalNode();
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "pager.hpp"
+#include "scheduler.hpp"
+
+struct FlusherOptions {
+    bool enabled = true;
+    // fraction of cache frames the flusher tries to keep clean
+    double targetCleanFraction = 0.25;
+    uint32_t intervalMs = 5;
+    // I/O budget; unused budget carries over for at most one second
+    uint64_t maxBytesPerSecond = 64ull * 1024 * 1024;
+};
+
+/*
+Background writer. Runs as a periodic MAINTENANCE task on the engine scheduler
+and writes cold dirty pages ahead of eviction, so a foreground eviction finds
+clean victims instead of blocking on a synchronous write.
+*/
+class PageFlusher {
+public:
+    struct Stats {
+        uint64_t runs;
+        uint64_t pagesWritten;
+    };
+
+private:
+    // shared with queued timer tasks, which may fire after the flusher is gone
+    struct State;
+    std::shared_ptr<State> state;
+
+    static void scheduleNext(const std::shared_ptr<State>& state, uint64_t generation);
+    static uint32_t runOnce(State& state);
+
+public:
+    PageFlusher(Pager& pager, Scheduler& scheduler, const FlusherOptions& options = FlusherOptions());
+    ~PageFlusher();
+    PageFlusher(const PageFlusher&) = delete;
+    PageFlusher& operator=(const PageFlusher&) = delete;
+
+    void start();
+    // Waits for a pass in progress; no pass starts afterwards. Idempotent.
+    void stop();
+    // One pass on the calling thread, within the current I/O budget
+    uint32_t flushNow();
+
+    Stats getStats() const;
+};
@@ -1,23 +1,153 @@
 #pragma once
 #include "constants.hpp"
-#include <iostream>
-#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <map>
+#include <mutex>
+#include <vector>
+
+constexpr uint32_t PAGER_DEFAULT_CACHE_PAGES = 4096;
+// A commit that leaves the WAL at least this long checkpoints it
+constexpr uint64_t PAGER_DEFAULT_CHECKPOINT_BYTES = 4u << 20;
+
+class CompressedPageFile;
 
 class Pager {
+public:
+    struct Stats {
+        uint64_t pageReads;        // cache misses served from the file
+        uint64_t pageWrites;       // pages written to the database file
+        uint64_t writeCalls;       // pwrite calls issued for them (< pageWrites when coalesced)
+        uint64_t evictions;
+        uint64_t dirtyEvictions;   // evictions that had to write the page first
+        uint64_t backgroundWrites; // pages cleaned by flushColdPages
+        uint64_t fileBytesRead;    // bytes behind pageReads (less than PAGE_SIZE each when compressed)
+        uint64_t fileBytesWritten; // bytes behind pageWrites
+        uint64_t checkpoints;      // WAL checkpoints, including the one at close
+    };
+
 private:
-    std::fstream fileDescriptor;
+    int fileDescriptor;
+    int walDescriptor;
+    std::string walFilename;
+    uint64_t walBytes;          // length of the WAL since the last checkpoint
+    uint64_t checkpointBytes;
+    // Set when the file stores compressed pages; otherwise page n is at n * PAGE_SIZE
+    std::unique_ptr<CompressedPageFile> compressedFile;
     uint32_t fileLength;
     uint8_t* pages[TABLE_MAX_PAGES];
-    void getFdStatus(const std::string& context);  // Debug helper method
+    bool dirtyPages[TABLE_MAX_PAGES];
     uint32_t numPages;
+    std::mutex cacheMutex;  // getPage may be called from parallel scan workers
+
+    // Frame cache: at most cacheCapacity pages stay cached past a safe point.
+    // CLOCK replacement; referencedPages is the second-chance bit.
+    uint32_t cacheCapacity;
+    std::atomic<uint32_t> cachedCount;
+    std::atomic<uint32_t> dirtyCount;
+    uint32_t clockHand;
+    bool referencedPages[TABLE_MAX_PAGES];
+    bool flushingPages[TABLE_MAX_PAGES];  // snapshot being written by flushColdPages
+    // Set when a sweep found every cached page pinned, so evictToCapacity
+    // returns at once instead of sweeping again for each statement of a large
+    // transaction; cleared whenever a page may have become evictable
+    std::atomic<bool> evictionBlocked;
+    std::vector<uint8_t*> freeFrames;
+
+    // Held by whoever changes page contents (Table mutations, rollback) and by
+    // flushColdPages while it snapshots pages, so it never copies a half-done update
+    std::mutex writeLatch;
+    // Held by flushColdPages from snapshot to write and by checkpoint, so a
+    // checkpoint never truncates the WAL while an older page image is still
+    // on its way to the file. Taken before writeLatch.
+    std::mutex checkpointMutex;
+
+    std::atomic<uint64_t> pageReads;
+    std::atomic<uint64_t> pageWrites;
+    std::atomic<uint64_t> writeCalls;
+    std::atomic<uint64_t> evictions;
+    std::atomic<uint64_t> dirtyEvictions;
+    std::atomic<uint64_t> backgroundWrites;
+    std::atomic<uint64_t> fileBytesRead;
+    std::atomic<uint64_t> fileBytesWritten;
+    std::atomic<uint64_t> checkpoints;
+
+    // Undo journal: one level per open transaction/savepoint. Each level holds the
+    // before-image of every page first written while that level was on top
+    // (empty vector = page did not exist yet) and numPages when the level opened.
+    struct UndoLevel {
+        std::map<uint32_t, std::vector<uint8_t>> beforeImages;
+        uint32_t numPagesAtStart;
+    };
+    std::vector<UndoLevel> undoLevels;
+
+    void readPageFromFile(uint32_t pageNum, uint8_t* page);
+    void writePageToFile(uint32_t pageNum, const uint8_t* page);
+    void syncFile();
+    void walAppendCommit(const std::vector<uint32_t>& pageNums);
+    void walRecover();
+    void writeDirtyPages();
+    void restoreLevel(UndoLevel& level, std::vector<uint32_t>& changedPages);
+    void markDirty(uint32_t pageNum);
+    void markClean(uint32_t pageNum);
+    void dropFrame(uint32_t pageNum);
+    bool isPinned(uint32_t pageNum) const;
 
 public:
-    Pager(const std::string& filename);
+    // cachePages is a soft cap: the cache may exceed it between safe points.
+    // compressPages formats a new (empty) file for compressed pages; an
+    // existing file keeps the format it was created with.
+    Pager(const std::string& filename, uint32_t cachePages = PAGER_DEFAULT_CACHE_PAGES, bool compressPages = false);
     ~Pager();
 
     uint8_t* getPage(uint32_t page_num);
+    uint8_t* getPageForWrite(uint32_t pageNum);
     uint32_t getFileLength() const;
+    // nullptr for a plain file
+    const CompressedPageFile* getCompressedFile() const { return compressedFile.get(); }
     void pagerFlush(uint32_t pageNum);
-    void flushAllPages(); 
+    // Close-time checkpoint: discards an open transaction, writes every dirty
+    // page, syncs the file and deletes the WAL
+    void flushAllPages();
+    // Writes every dirty page to the database file, syncs it and empties the
+    // WAL, whose commits are then all in the file. Does nothing while a
+    // transaction is open. commitTransaction calls it once the WAL reaches
+    // the checkpoint size.
+    void checkpoint();
+    void setCheckpointBytes(uint64_t bytes) { checkpointBytes = bytes; }
+    uint64_t getWalBytes() const { return walBytes; }
     uint32_t getNumPages() const { return numPages; }
+    bool isDirty(uint32_t pageNum) const { return pageNum < TABLE_MAX_PAGES && dirtyPages[pageNum]; }
+    bool isCached(uint32_t pageNum) const { return pageNum < TABLE_MAX_PAGES && pages[pageNum] != nullptr; }
+
+    // Eviction only happens here, never inside getPage, because callers hold raw
+    // page pointers for the length of an operation. Call between operations, with
+    // no page pointers live. Dirty victims are written synchronously.
+    void evictToCapacity();
+    // Background writer: cleans up to maxPages dirty pages, least recently used
+    // first, writing runs of adjacent pages with one pwrite each. Pages journaled
+    // by an open transaction are never written (no-steal). Returns pages written.
+    uint32_t flushColdPages(uint32_t maxPages);
+    std::mutex& getWriteLatch() { return writeLatch; }
+    uint32_t getCacheCapacity() const { return cacheCapacity; }
+    uint32_t getCachedCount() const { return cachedCount; }
+    uint32_t getDirtyCount() const { return dirtyCount; }
+    Stats getStats() const;
+
+    // Transactions: pages written between begin and commit stay in memory;
+    // commit makes all of them durable with one WAL write and one fsync.
+    // The rollbacks return every page they changed back: pages given their
+    // before-image, then pages dropped because they were allocated inside
+    // (those are >= getNumPages() afterwards)
+    void beginTransaction();
+    void commitTransaction();
+    std::vector<uint32_t> rollbackTransaction();
+    bool inTransaction() const { return !undoLevels.empty(); }
+
+    // Nested savepoints inside an open transaction (used for statement atomicity)
+    void savepoint();
+    void releaseSavepoint();
+    std::vector<uint32_t> rollbackToSavepoint();
 };
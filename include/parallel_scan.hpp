@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cursor.hpp"
+#include "node.hpp"
+#include "table.hpp"
+#include "scheduler.hpp"
+
+// Scans of fewer rows than this are not worth splitting into tasks
+constexpr uint32_t PARALLEL_SCAN_MIN_ROWS = 4096;
+
+// Inclusive key range scanned as one unit of parallel work
+struct ScanMorsel {
+    uint32_t lowKey;
+    uint32_t highKey;
+};
+
+/*
+Full-table scan split into morsels along the B+ tree's own separators: the
+internal node keys (max key of each child) bound the key ranges of disjoint
+subtrees. Each morsel is a scheduler task with its own cursor and its own
+partial result; partials are combined in key order at the end.
+*/
+class ParallelScan {
+private:
+    Table& table;
+    Scheduler& scheduler;
+
+public:
+    ParallelScan(Table& db_table, Scheduler& db_scheduler) : table(db_table), scheduler(db_scheduler) {}
+
+    // Descends level by level until at least targetMorsels subtrees are found
+    // (or the leaves are reached) and turns their separators into key ranges
+    std::vector<ScanMorsel> planMorsels(uint32_t targetMorsels) const;
+
+    // onRow(key, rowBytes) for every row in the morsel, in key order
+    template <typename RowFn>
+    void scanMorsel(const ScanMorsel& morsel, RowFn& onRow) const;
+
+    // onRow(Partial&, key, rowBytes) accumulates into a per-morsel partial;
+    // combine(Partial& into, const Partial& from) merges them
+    template <typename Partial, typename RowFn, typename CombineFn>
+    Partial reduce(const Partial& identity, RowFn onRow, CombineFn combine, uint32_t targetMorsels = 0) const;
+
+    // For callers that scan a morsel their own way: morselFn(morsel) returns
+    // the morsel's partial, combine(Partial& into, Partial& from) folds the
+    // partials into the first one in key order. Partial must be default
+    // constructible and movable. morselFn must not evict pages: other
+    // morsels' tasks hold pointers into the cache.
+    template <typename MorselFn, typename CombineFn>
+    auto reduceMorsels(MorselFn morselFn, CombineFn combine, uint32_t targetMorsels = 0) const
+        -> decltype(morselFn(ScanMorsel{}));
+};
+
+template <typename RowFn>
+void ParallelScan::scanMorsel(const ScanMorsel& morsel, RowFn& onRow) const {
+    Cursor cursor(table, morsel.lowKey);
+    if (cursor.isEndOfTable()) {
+        return;
+    }
+    uint32_t pageNum = cursor.getPageNum();
+    uint32_t cellNum = cursor.getCellNum();
+    // one page lookup per leaf; cells are read straight out of the frame
+    while (true) {
+        Node leaf(table.getPageAddress(pageNum));
+        uint32_t numCells = *leaf.leafNodeNumCells();
+        for (; cellNum < numCells; cellNum++) {
+            uint32_t key = *leaf.leafNodeKey(cellNum);
+            if (key > morsel.highKey) {
+                return;
+            }
+            onRow(key, static_cast<const void*>(leaf.leafNodeValue(cellNum)));
+        }
+        pageNum = *leaf.leafNodeRightSibling();
+        if (pageNum == 0) {
+            return;
+        }
+        cellNum = 0;
+        scheduler.yieldPoint();
+    }
+}
+
+template <typename Partial, typename RowFn, typename CombineFn>
+Partial ParallelScan::reduce(const Partial& identity, RowFn onRow, CombineFn combine, uint32_t targetMorsels) const {
+    return reduceMorsels(
+        [&](const ScanMorsel& morsel) {
+            // accumulate locally so workers don't share cache lines in the partials
+            Partial local = identity;
+            auto onMorselRow = [&](uint32_t key, const void* row) { onRow(local, key, row); };
+            scanMorsel(morsel, onMorselRow);
+            return local;
+        },
+        [&](Partial& into, Partial& from) { combine(into, static_cast<const Partial&>(from)); }, targetMorsels);
+}
+
+template <typename MorselFn, typename CombineFn>
+auto ParallelScan::reduceMorsels(MorselFn morselFn, CombineFn combine, uint32_t targetMorsels) const
+    -> decltype(morselFn(ScanMorsel{})) {
+    using Partial = decltype(morselFn(ScanMorsel{}));
+    if (targetMorsels == 0) {
+        targetMorsels = scheduler.getNumWorkers() * 4;
+    }
+    // never empty: the last morsel always reaches UINT32_MAX
+    std::vector<ScanMorsel> morsels = planMorsels(targetMorsels);
+    std::vector<Partial> partials(morsels.size());
+
+    scheduler.parallelFor(static_cast<uint32_t>(morsels.size()),
+                          [&](uint32_t morselIndex) { partials[morselIndex] = morselFn(morsels[morselIndex]); });
+
+    Partial result = std::move(partials[0]);
+    for (size_t i = 1; i < partials.size(); i++) {
+        combine(result, partials[i]);
+    }
+    return result;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "enums.hpp"
+#include "lexer.hpp"
+
+/*
+Recursive-descent parser for the SQL subset:
+
+  SELECT * | expr, ... FROM table [WHERE expr] [GROUP BY col, ...]
+         [ORDER BY col [ASC|DESC], ...] [LIMIT expr [OFFSET expr]]
+  INSERT INTO table [(col, ...)] VALUES (expr, ...), ...
+  UPDATE table SET col = expr, ... [WHERE expr]
+  DELETE FROM table [WHERE expr]
+  CREATE TABLE table (col type [(size)] [PRIMARY KEY], ...)
+  CREATE INDEX [name] ON table (col) [USING method] [INCLUDE (col, ...)]
+  BEGIN [TRANSACTION] | COMMIT | ROLLBACK
+
+Comparisons are =, <>, <, <=, >, >= and LIKE; COUNT(*), COUNT(expr),
+SUM(expr), MIN(expr) and MAX(expr) are aggregate calls. Values anywhere in an
+expression may be ? placeholders, bound at execution time. An optional
+trailing ';' is allowed. The AST goes into the caller's arena and refers to
+the statement text, so both must outlive it.
+*/
+class Parser {
+private:
+    Lexer lexer;
+    Token current;
+    Arena& arena;
+    std::string error;
+    uint32_t parameterCount;
+
+    void advance();
+    bool accept(TokenType type);
+    Token expect(TokenType type, const char* what);
+    [[noreturn]] void fail(const char* message);
+    std::string_view expectIdentifier(const char* what);
+
+    const SelectStatement* parseSelect();
+    const InsertStatement* parseInsert();
+    const UpdateStatement* parseUpdate();
+    const DeleteStatement* parseDelete();
+    const CreateTableStatement* parseCreateTable();
+    const CreateIndexStatement* parseCreateIndex();
+
+    const Expr* parseExpression();
+    const Expr* parseOr();
+    const Expr* parseAnd();
+    const Expr* parseNot();
+    const Expr* parseComparison();
+    const Expr* parseAdditive();
+    const Expr* parseMultiplicative();
+    const Expr* parseUnary();
+    const Expr* parsePrimary();
+    const Expr* parseAggregate(Expr* call);
+    const Expr* makeBinary(Operator op, const Expr* left, const Expr* right, uint32_t offset);
+
+public:
+    Parser(std::string_view sql, Arena& arena);
+
+    // PREPARE_SUCCESS with statement set, PREPARE_UNRECOGNIZED_STATEMENT when the
+    // text does not start with a statement keyword, or PREPARE_SYNTAX_ERROR with
+    // a message in getError()
+    PrepareResult parse(const Statement*& statement);
+    const std::string& getError() const { return error; }
+    // Number of ? placeholders, numbered left to right
+    uint32_t getParameterCount() const { return parameterCount; }
+};
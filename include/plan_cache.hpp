@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "prepared_statement.hpp"
+
+constexpr uint32_t PLAN_CACHE_DEFAULT_CAPACITY = 64;
+
+/*
+LRU cache of compiled statements keyed by normalized statement text, so
+statements that differ only in whitespace or keyword/identifier case share one
+plan. Literals are part of the key: statements meant to be reused with
+different values should use ? parameters.
+*/
+class PlanCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CompiledStatement>>;
+
+    uint32_t capacity;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;  // views into entries' keys
+    std::string keyBuffer;
+    uint64_t hits;
+    uint64_t misses;
+
+public:
+    explicit PlanCache(uint32_t capacity = PLAN_CACHE_DEFAULT_CAPACITY);
+    PlanCache(const PlanCache&) = delete;
+    PlanCache& operator=(const PlanCache&) = delete;
+
+    // Returns the cached plan for sql or compiles and caches it; failures are
+    // not cached (see CompiledStatement::compile). A cached plan for one of
+    // table's CREATE TABLE tables is compiled again if the schema has changed.
+    PrepareResult lookup(std::string_view sql, std::shared_ptr<const CompiledStatement>& compiled, std::string& error,
+                         const Table* table = nullptr);
+    void clear();
+
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getSize() const { return static_cast<uint32_t>(entries.size()); }
+    Stats getStats() const { return Stats{hits, misses}; }
+
+    // Token stream joined by single spaces: keywords upper case, identifiers
+    // lower case, literals unchanged. Text the lexer rejects is kept verbatim.
+    static void normalize(std::string_view sql, std::string& out);
+};
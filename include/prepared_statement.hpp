@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "enums.hpp"
+#include "row.hpp"
+#include "schema.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+/*
+A statement parsed and planned once: column names resolved, ORDER BY and
+INSERT/UPDATE targets mapped to table columns. It is immutable afterwards, so
+the plan cache hands the same one to any number of PreparedStatements.
+
+The database has one built-in table, "users" (id INTEGER PRIMARY KEY,
+username TEXT(32), email TEXT(255)); CREATE TABLE adds more, whose plans hold
+the schema version they were made against (see Table::getSchemaVersion).
+*/
+struct CompiledStatement {
+    std::string sql;  // the AST points into this copy
+    Arena arena;
+    const Statement* statement;
+    uint32_t parameterCount;
+
+    bool keyOrder;                          // SELECT: scan order already satisfies ORDER BY
+    std::vector<uint32_t> orderColumns;     // SELECT: ORDER BY columns (of the aggregated rows, if grouped)
+    bool grouped;                           // SELECT: has aggregate calls or GROUP BY
+    std::vector<uint32_t> groupColumns;     // SELECT: GROUP BY columns
+    std::vector<AggregateSpec> aggregates;  // SELECT: one per aggregate call in the select list
+    std::vector<uint32_t> insertTargets;    // INSERT: column of each VALUES position
+    std::vector<uint32_t> assignedColumns;  // UPDATE: column of each SET
+    uint32_t indexColumn;                   // CREATE INDEX: the indexed column
+    uint32_t indexIncludes;                 // CREATE INDEX: INCLUDE columns, bit per column
+    bool indexHash;                         // CREATE INDEX: USING HASH (only on id)
+    bool indexColumnar;                     // CREATE INDEX: USING COLUMNAR; indexIncludes holds every column
+    bool indexZoneMap;                      // CREATE INDEX: USING ZONEMAP (on username or email; covers both)
+    uint32_t scanColumns;                   // SELECT/UPDATE/DELETE: columns read from scanned rows, bit per column
+    std::string tableName;                  // the table the statement names, lower case
+    bool schemaTable;                       // that table was made by CREATE TABLE
+    uint64_t schemaVersion;                 // schemaTable: the table's schema version when planned
+    std::vector<std::string> columnNames;   // the table's columns, in order
+    std::vector<uint32_t> keyColumns;       // the table's primary key columns, in key order
+    std::unique_ptr<const Schema> newSchema;  // CREATE TABLE: the table to create
+
+    explicit CompiledStatement(std::string text);
+    CompiledStatement(const CompiledStatement&) = delete;
+    CompiledStatement& operator=(const CompiledStatement&) = delete;
+
+    // PREPARE_SUCCESS, or the parser's result / PREPARE_INTERNAL_FAILURE (unknown
+    // table or column) with a message in error. Tables other than users are
+    // looked up in table; without one only users is known.
+    static PrepareResult compile(std::string sql, std::shared_ptr<const CompiledStatement>& compiled,
+                                 std::string& error, const Table* table = nullptr);
+};
+
+enum class StepResult {
+    ROW,   // a result row is available through getColumn()
+    DONE,
+    ERROR  // see getError(); the statement's changes were rolled back
+};
+
+/*
+One execution handle for a compiled statement: bind parameters (1-based, as
+in SQLite), then step() until DONE. SELECT produces one row per step; other
+statements do all their work in the first step, atomically (their own
+transaction in autocommit mode, a savepoint inside BEGIN ... COMMIT).
+reset() rewinds so the statement can run again with new bindings.
+*/
+class PreparedStatement {
+private:
+    Table& table;
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::vector<Value> bindings;
+    std::vector<bool> bound;
+    std::vector<std::string> boundText;  // storage for bindText values
+    VectorEvaluator evaluator;            // VALUES, LIMIT and SET expressions
+    std::string error;
+
+    // SELECT state: the operator pipeline is built on the first step and
+    // step() hands out the rows of its current output batch one at a time
+    bool started;
+    bool finished;
+    std::unique_ptr<BatchOperator> pipeline;
+    Batch output;
+    Batch projectInput;  // kept across executions so reruns reuse its storage
+    uint32_t outputPosition;
+    std::vector<Value> currentValues;
+    ScanStats scanStats;
+
+    void refreshPlan();
+    std::unique_ptr<BatchOperator> scanMatching(const Expr* where, uint32_t columns);
+    std::unique_ptr<BatchOperator> scanSchemaTable(const Expr* where);
+    std::unique_ptr<BatchOperator> answerFromTree(const Expr* where);
+    std::unique_ptr<BatchOperator> aggregateInParallel(const Expr* where);
+    void buildSelectPipeline();
+    int64_t evaluateCount(const Expr* expr, int64_t fallback, const char* clause);
+    void runChange();
+    void runSchemaChange(SchemaTable& target);
+    bool nextSelectRow();
+    void checkBindings() const;
+
+public:
+    PreparedStatement(Table& table, std::shared_ptr<const CompiledStatement> compiled);
+    ~PreparedStatement();
+    PreparedStatement(const PreparedStatement&) = delete;
+    PreparedStatement& operator=(const PreparedStatement&) = delete;
+
+    uint32_t getParameterCount() const { return compiled->parameterCount; }
+    StatementKind getKind() const { return compiled->statement->kind; }
+    // throw std::out_of_range for an index outside 1..getParameterCount()
+    void bindInteger(uint32_t index, int64_t value);
+    void bindText(uint32_t index, std::string_view value);
+    void clearBindings();
+
+    StepResult step();
+    void reset();
+
+    // Current row, valid until the next step()/reset()
+    uint32_t getColumnCount() const { return static_cast<uint32_t>(currentValues.size()); }
+    const Value& getColumn(uint32_t index) const { return currentValues.at(index); }
+    const std::string& getError() const { return error; }
+
+    // What the table scans of this execution have done so far; reset() clears it
+    struct Stats {
+        uint64_t leavesRead;
+        uint64_t leavesSkipped;  // ruled out by the zone map without being read
+    };
+    Stats getStats() const { return Stats{scanStats.leavesRead, scanStats.leavesSkipped}; }
+
+    // Runs body as one atomic unit on table (see class comment)
+    static PrepareResult runAtomically(Table& table, const std::function<PrepareResult()>& body);
+};
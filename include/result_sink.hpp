@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vector_executor.hpp"
+
+class Table;
+
+// Bytes per output block; blocks are page-aligned and handed to writev together
+constexpr size_t SINK_BLOCK_BYTES = 256u << 10;
+constexpr uint32_t SINK_BLOCKS = 8;
+// Starts a binary export: the magic, then the column count as a 4-byte little-endian number
+constexpr char SINK_BINARY_MAGIC[4] = {'S', 'L', 'R', 'B'};
+
+enum class ExportFormat : uint8_t {
+    CSV,    // commas; fields with a comma, quote or line break quoted, quotes doubled
+    TSV,    // tabs; tab, line break, carriage return and backslash escaped as \t \n \r \\ (nothing quoted)
+    BINARY  // per value a type byte, then an 8-byte integer or a 4-byte length and the bytes, little-endian
+};
+
+/*
+Writes result rows to a file descriptor in one of the ExportFormats. Rows are
+formatted straight into SINK_BLOCKS page-aligned blocks of SINK_BLOCK_BYTES:
+text is copied once from the batch or value it is viewed in, and integers are
+formatted in place with std::to_chars (moving to the next block first when
+one has too little room left, so a block may end short). Once every block
+has been used they all go out in a single writev, 2 MB per system call.
+Nothing goes through iostreams.
+
+Binary rows have no terminator: a reader knows the column count from the
+header (see writeHeader) and reads that many values per row. The type byte
+is 0 for an integer and 1 for text.
+*/
+class ResultSink {
+private:
+    int fileDescriptor;
+    ExportFormat format;
+    std::vector<char*> blocks;
+    std::vector<size_t> used;  // bytes written to each block
+    uint32_t current;          // block being filled
+    uint64_t rowsWritten;
+    uint64_t bytesWritten;
+
+    // Room for bytes more in one block, moving on (and writing the blocks out) if needed
+    char* reserve(size_t bytes);
+    // Copies bytes, across blocks if they do not fit in one
+    void append(const char* data, size_t length);
+    void writeText(std::string_view text);
+    void writeValue(const Value& value);
+    // One line (CSV, TSV) or the values back to back (binary)
+    void writeFields(const Value* values, uint32_t count);
+    void writeBlocks();
+
+public:
+    // fd stays open and owned by the caller
+    ResultSink(int fd, ExportFormat format);
+    // Writes out what is buffered; errors are lost here, so call flush() to see them
+    ~ResultSink();
+    ResultSink(const ResultSink&) = delete;
+    ResultSink& operator=(const ResultSink&) = delete;
+
+    // CSV and TSV: a line of column names. Binary: the magic and the column
+    // count. Call once, before any row.
+    void writeHeader(const std::vector<std::string>& columnNames);
+    void writeRow(const Value* values, uint32_t count);
+    void writeRow(const std::vector<Value>& values) { writeRow(values.data(), static_cast<uint32_t>(values.size())); }
+    // The selected rows of batch, every column in order
+    void writeBatch(const Batch& batch);
+    // Writes out everything buffered. Throws std::runtime_error if the write fails.
+    void flush();
+
+    uint64_t getRowsWritten() const { return rowsWritten; }
+    // Bytes handed to the file so far (not counting what is still buffered)
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+    // Reads a binary export back into rows of the header's column count,
+    // text pointing into data. Throws std::invalid_argument if data is not a
+    // whole binary export.
+    static std::vector<std::vector<Value>> decodeBinary(std::string_view data);
+};
+
+// "csv", "tsv" or "binary" (any case); false for anything else
+bool parseExportFormat(std::string_view name, ExportFormat& format);
+
+/*
+Writes every row of "users" or a CREATE TABLE table, in key order, to fd,
+with a header. users rows come from TableScan, which copies each leaf's cells
+into batch columns; CREATE TABLE rows from SchemaTableScan. Returns the rows
+written. Throws std::invalid_argument for an unknown table and
+std::runtime_error if a write fails.
+*/
+uint64_t exportTable(Table& table, std::string_view tableName, int fd, ExportFormat format);
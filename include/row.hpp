@@ -29,6 +29,9 @@ public:
     void printRow() const;
 
     static constexpr uint32_t getRowSize() { return ROW_SIZE; }
+    // Field positions in the serialized form, for code that reads cells in place
+    static constexpr uint32_t getUsernameOffset() { return USERNAME_OFFSET; }
+    static constexpr uint32_t getEmailOffset() { return EMAIL_OFFSET; }
     uint32_t getId() const { return id; }
     // const char* getUsername() const { return username; }
     const char* getUsername() const;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Lower value = more urgent. Workers always drain a more urgent class first.
+enum class TaskPriority : uint8_t {
+    FOREGROUND_QUERY = 0,
+    IO_COMPLETION = 1,
+    MAINTENANCE = 2
+};
+constexpr uint32_t NUM_TASK_PRIORITIES = 3;
+
+/*
+Engine-wide task scheduler shared by query execution, I/O completion and
+background maintenance. Each worker owns one deque per priority class; it pops
+from the back of its own deque and, when that is empty, steals from the front
+of the other workers' deques of the same class before looking at a less urgent
+class. Long-running tasks call yieldPoint() so more urgent work queued behind
+them runs without waiting for them to finish.
+*/
+class Scheduler {
+public:
+    struct Stats {
+        uint64_t tasksRun;
+        uint64_t tasksStolen;
+    };
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks[NUM_TASK_PRIORITIES];
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<uint32_t> queuedTasks[NUM_TASK_PRIORITIES];
+    std::atomic<uint32_t> nextQueue;
+    std::atomic<uint64_t> tasksRun;
+    std::atomic<uint64_t> tasksStolen;
+    bool stopping;
+
+    // Delayed tasks, guarded by sleepMutex. nextTimerDue (steady_clock ticks) lets
+    // busy workers check for due timers without taking the lock.
+    struct TimedTask {
+        std::function<void()> task;
+        TaskPriority priority;
+    };
+    std::multimap<std::chrono::steady_clock::time_point, TimedTask> timers;
+    std::atomic<int64_t> nextTimerDue;
+
+    bool popOwn(uint32_t queueIndex, uint32_t priority, std::function<void()>& task);
+    bool steal(uint32_t thiefIndex, uint32_t priority, std::function<void()>& task);
+    bool tryRunOne(uint32_t queueIndex, uint32_t leastUrgentPriority);
+    bool hasQueuedTasks() const;
+    void promoteDueTimers();
+    void workerLoop(uint32_t queueIndex);
+
+public:
+    // maxWorkers caps the number of threads; 0 means one per hardware thread
+    explicit Scheduler(uint32_t maxWorkers = 0);
+    ~Scheduler();
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void submit(std::function<void()> task, TaskPriority priority = TaskPriority::FOREGROUND_QUERY);
+    // Queues task once delay has elapsed. Returns false (and drops the task) after
+    // shutdown has started; timers not yet due at shutdown never run.
+    bool submitAfter(std::chrono::milliseconds delay, std::function<void()> task,
+                     TaskPriority priority = TaskPriority::MAINTENANCE);
+    // Runs body(0) .. body(count - 1) and returns once all have finished; the
+    // calling thread runs tasks of the same (or more urgent) class meanwhile.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& body,
+                     TaskPriority priority = TaskPriority::FOREGROUND_QUERY);
+    // Cooperative yield: runs queued tasks more urgent than the current one.
+    // Cheap when there are none; a no-op outside scheduler tasks.
+    void yieldPoint();
+    // Finishes every queued task, then joins the workers. Idempotent.
+    void shutdown();
+
+    uint32_t getNumWorkers() const { return static_cast<uint32_t>(queues.size()); }
+    Stats getStats() const { return Stats{tasksRun.load(), tasksStolen.load()}; }
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "constants.hpp"
+#include "key_format.hpp"
+
+// A CREATE TABLE table has at most this many columns (statements track the
+// columns they read as a 32-bit mask)
+constexpr uint32_t SCHEMA_MAX_COLUMNS = 32;
+// Largest encoded row, so that a page of the table's tree always holds a few
+constexpr uint32_t SCHEMA_ROW_MAX_SIZE = 1024;
+// Primary keys are stored as index keys, which are at most this long encoded
+constexpr uint32_t SCHEMA_KEY_MAX_SIZE = INDEX_KEY_MAX_SIZE;
+// Bytes an INT or BIGINT key column takes in an encoded key
+constexpr uint32_t SCHEMA_INTEGER_KEY_SIZE = sizeof(int64_t);
+
+enum class ColumnType : uint8_t {
+    INT,     // 32-bit signed
+    BIGINT,  // 64-bit signed
+    DOUBLE,
+    TEXT,
+    BLOB
+};
+
+struct ColumnSchema {
+    std::string name;  // lower case
+    ColumnType type;
+    uint32_t size;     // TEXT/BLOB: most bytes a value may have; 0 = any, up to the row limit
+};
+
+// One column's value; the member used follows the column's type
+struct Field {
+    int64_t integer = 0;  // INT, BIGINT
+    double real = 0;      // DOUBLE
+    std::string bytes;    // TEXT, BLOB
+};
+
+/*
+The shape of a CREATE TABLE table: its name, its columns in order and which
+of them make up the primary key, in key order (one column, or several for a
+composite key such as (tenant_id, seq)). Names are kept in lower case and
+looked up without regard to case, as SQL identifiers are. The catalog stores
+a schema as bytes (serialize), next to the root page of the table's tree.
+*/
+class Schema {
+private:
+    std::string name;
+    std::vector<ColumnSchema> columns;
+    std::vector<uint32_t> primaryKey;
+
+public:
+    // Throws std::invalid_argument for no or too many columns, duplicate
+    // names, no key column or one listed twice, a DOUBLE key column, a
+    // TEXT/BLOB key column without a size, a key whose encoding may be longer
+    // than an index key, or fixed-width rows over SCHEMA_ROW_MAX_SIZE
+    Schema(std::string_view name, std::vector<ColumnSchema> columns, std::vector<uint32_t> primaryKey);
+
+    // INT/INTEGER, BIGINT, DOUBLE/REAL, TEXT/VARCHAR, BLOB; false for anything else
+    static bool parseType(std::string_view typeName, ColumnType& type);
+    static const char* typeName(ColumnType type);
+
+    const std::string& getName() const { return name; }
+    const std::vector<ColumnSchema>& getColumns() const { return columns; }
+    uint32_t getNumColumns() const { return static_cast<uint32_t>(columns.size()); }
+    // The key columns, in key order
+    const std::vector<uint32_t>& getPrimaryKey() const { return primaryKey; }
+    // FIXED_8 or FIXED_16 for a key of one or two INT/BIGINT columns, whose
+    // encoded keys all have that width; BYTES otherwise
+    KeyFormat getKeyFormat() const;
+    // The column's position, or getNumColumns() if there is none by that name
+    uint32_t findColumn(std::string_view columnName) const;
+    // Every column has a fixed width: numbers, and TEXT/BLOB with a size
+    bool isFixedWidth() const;
+
+    std::string serialize() const;
+    // Throws std::runtime_error if data is not a serialized schema
+    static Schema deserialize(std::string_view name, std::string_view data);
+};
+
+/*
+Encodes rows of one schema, planned once when the table is opened. Numbers
+take their fixed width (INT 4 bytes, BIGINT and DOUBLE 8) and TEXT/BLOB a
+2-byte length before the bytes. When every column has a fixed width, TEXT(n)
+and BLOB(n) are padded to n bytes: every row then has the same size, each
+column sits at an offset computed up front, and reading one column is a
+single load instead of a walk over the columns before it. Rows of other
+schemas store each value in as few bytes as it needs.
+*/
+class RowCodec {
+private:
+    struct ColumnPlan {
+        ColumnType type;
+        uint32_t size;    // declared TEXT/BLOB size (0 = any)
+        uint32_t offset;  // fixed-width rows only
+    };
+
+    std::vector<ColumnPlan> plan;
+    bool fixedWidth;
+    uint32_t fixedSize;  // bytes per row, when fixedWidth
+
+    uint32_t offsetOf(std::string_view row, uint32_t column) const;
+
+public:
+    explicit RowCodec(const Schema& schema);
+
+    bool isFixedWidth() const { return fixedWidth; }
+    uint32_t getFixedSize() const { return fixedSize; }
+
+    // Replaces out with the encoded row. Throws std::invalid_argument if a
+    // value is out of its column's range or size, or the row is over
+    // SCHEMA_ROW_MAX_SIZE.
+    void encode(const std::vector<Field>& row, std::string& out) const;
+    void decode(std::string_view data, std::vector<Field>& row) const;
+
+    // One column of an encoded row
+    int64_t integerAt(std::string_view row, uint32_t column) const;  // INT, BIGINT
+    double realAt(std::string_view row, uint32_t column) const;      // DOUBLE
+    std::string_view bytesAt(std::string_view row, uint32_t column) const;  // TEXT, BLOB; points into row
+};
+
+// A primary key value as index key bytes whose byte order is the value order:
+// integers big-endian with the sign bit flipped, TEXT/BLOB as they are.
+// Throws std::invalid_argument for a TEXT/BLOB key over SCHEMA_KEY_MAX_SIZE.
+std::string encodeKey(const Field& value, ColumnType type);
+// The values of the schema's first keyValues.size() key columns, in key
+// order, as index key bytes: each encoded as above, except that a TEXT/BLOB
+// value followed by another key column has each 0 byte written as 0 1 and
+// ends in 0 0, so that it cannot run into the next value and the bytes sort
+// column by column. The key of fewer columns than the schema has is a prefix
+// of the keys of all rows holding those values. Throws std::invalid_argument
+// if the key would be over SCHEMA_KEY_MAX_SIZE.
+std::string encodeKey(const std::vector<Field>& keyValues, const Schema& schema);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "schema.hpp"
+#include "secondary_index.hpp"
+
+class Table;
+
+/*
+A table made with CREATE TABLE. Its rows live in a B+ tree of the same
+slotted pages as the secondary indexes, allocated from the database's pager,
+so every table shares one cache, one WAL and one transaction. Each entry is
+keyed by the encoded primary key (see encodeKey), so the tree is in key
+order, column by column for a composite key, and it carries the row encoded by the schema's RowCodec as its
+payload. Rows are read, added and removed under the same latch and eviction
+rules as the users table. Table owns these objects; the catalog records
+each table's schema and root page.
+*/
+class SchemaTable {
+private:
+    Table& table;
+    Schema schema;
+    RowCodec codec;
+    SecondaryIndex tree;
+
+    std::string wholeKey(const std::vector<Field>& key) const;
+
+public:
+    SchemaTable(Table& table, Schema schema, uint32_t rootPageNum);
+
+    const Schema& getSchema() const { return schema; }
+    const std::string& getName() const { return schema.getName(); }
+    const RowCodec& getCodec() const { return codec; }
+    // Ordered by primary key, with the schema's key format; payloads are encoded rows
+    const SecondaryIndex& getTree() const { return tree; }
+    uint32_t getRootPageNum() const { return tree.getRootPageNum(); }
+    Table& getTable() const { return table; }
+
+    // The row's primary key as tree key bytes
+    std::string keyOf(const std::vector<Field>& row) const;
+
+    // Throws std::invalid_argument if a value does not fit its column or the
+    // primary key is taken
+    void insertRow(const std::vector<Field>& row);
+    // key holds a value per key column, in key order; throws
+    // std::invalid_argument if it does not. False if there is no such row.
+    bool getRow(const std::vector<Field>& key, std::vector<Field>& row) const;
+    bool deleteRow(const std::vector<Field>& key);
+    // Rows, counted by walking the tree's leaves
+    uint64_t getNumRows() const;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "meta_command_processor.hpp"
+#include "statement_processor.hpp"
+#include "table.hpp"
+
+struct ScriptResult {
+    uint64_t statements;  // statements and meta commands run, failed ones included
+    uint64_t errors;
+    double seconds;
+    bool exitRequested;  // the script ran .exit
+};
+
+/*
+Runs a SQL script for --batch and .read. The file is mapped into memory and
+read a line at a time; each line is one statement or meta command, as at the
+prompt, and blank lines and lines starting with -- are skipped. Nothing is
+printed for a statement that succeeds except the rows a SELECT returns. A
+failure prints the usual message followed by the file and line, and the
+script carries on; the failed statement's changes are undone.
+
+Unless a transaction is already open, the whole script runs in one, so its
+changes reach the WAL in a single commit at the end (or when .exit stops it).
+BEGIN inside such a script fails as nested. Throws std::runtime_error if the
+file cannot be read.
+*/
+ScriptResult runScript(Table& table, StatementProcessor& statements, MetaCommandProcessor& metaCommands,
+                       const std::string& path);
+
+// "Ran N statements (E errors) in T ms, R statements/s"
+std::string describeScriptResult(const ScriptResult& result);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "index_node.hpp"
+#include "row.hpp"
+
+class Table;
+
+// The column of a tree that indexes no users column (the rows of a CREATE TABLE table)
+constexpr uint32_t INDEX_NO_COLUMN = UINT32_MAX;
+
+/*
+A B+ tree over one text column of the users table, mapping each row's value
+to its id. Entries are (value, id) pairs in IndexNode pages allocated from the
+table's pager, so they share its cache, transactions and WAL. Leaf entries
+also carry the values of the index's included columns, so a query that only
+needs those, the id and the key can be answered without the table. Like the primary
+tree, the root never moves (a root split copies it down a level first) and
+deletes leave underfull leaves in place. Unlike it, an internal cell's key is
+a separator rather than an entry: at or above every entry under its child,
+below the ones after it, and cut to the few bytes that tell the two apart when
+a leaf splits. With the prefix internal nodes store once, long similar keys
+still give a high fanout. A tree whose keys all have one width (a table keyed
+by integer columns) is given that KeyFormat: its searches and splits then run
+the code specialized for it, chosen once per call. Callers hold the table's
+write latch to modify it.
+*/
+class SecondaryIndex {
+private:
+    struct Entry {
+        std::string key;
+        uint32_t id;
+        uint32_t child;
+        std::string payload;
+    };
+
+    Table& table;
+    uint32_t column;
+    uint32_t rootPageNum;
+    uint32_t includedColumns;  // bit per column number
+    KeyFormat keyFormat;
+
+    template <typename Keys>
+    static Entry separatorBetween(const Entry& left, const Entry& right);
+    template <typename Keys>
+    uint32_t findLeaf(std::string_view key, uint32_t id) const;
+    template <typename Keys>
+    void insertWith(std::string_view key, uint32_t id, std::string_view payload);
+    template <typename Keys>
+    bool removeWith(std::string_view key, uint32_t id);
+    template <typename Keys>
+    void seekWith(std::string_view key, uint32_t id, uint32_t& pageNum, uint32_t& cellNum) const;
+    template <typename Keys>
+    void insertEntry(uint32_t pageNum, uint32_t cellNum, const Entry& entry);
+    template <typename Keys>
+    void splitNode(uint32_t pageNum, std::vector<Entry>& entries);
+    uint32_t moveRootDown();
+
+public:
+    SecondaryIndex(Table& table, uint32_t column, uint32_t rootPageNum, uint32_t includedColumns = 0,
+                   KeyFormat keyFormat = KeyFormat::BYTES);
+    // Sets up an empty tree in pageNum
+    static void initializeRoot(Table& table, uint32_t pageNum);
+    // The indexed column's text in a row
+    static std::string_view valueOf(const Row& row, uint32_t column);
+
+    uint32_t getColumn() const { return column; }
+    uint32_t getRootPageNum() const { return rootPageNum; }
+    uint32_t getIncludedColumns() const { return includedColumns; }
+    KeyFormat getKeyFormat() const { return keyFormat; }
+    Table& getTable() const { return table; }
+    // Whether every column in columnMask (bit per column) is the id, the key or included
+    bool covers(uint32_t columnMask) const;
+
+    // The included columns of a row, in column order, each as a length byte and the text
+    std::string payloadOf(const Row& row) const;
+    // One included column's text from a payload
+    std::string_view includedValue(std::string_view payload, uint32_t column) const;
+
+    void insert(std::string_view key, uint32_t id, std::string_view payload = std::string_view());
+    // False if the entry is not there
+    bool remove(std::string_view key, uint32_t id);
+
+    // Position of the first entry >= (key, id): the leaf page and cell in it
+    void seek(std::string_view key, uint32_t id, uint32_t& pageNum, uint32_t& cellNum) const;
+};
+
+// Walks index entries in order from a seek position; page pointers are fetched
+// per call, so the pager may evict between calls
+class IndexCursor {
+private:
+    const SecondaryIndex& index;
+    uint32_t pageNum;
+    uint32_t cellNum;
+    bool endOfIndex;
+
+    void skipExhaustedLeaves();
+
+public:
+    // At the first entry whose key is >= key
+    IndexCursor(const SecondaryIndex& index, std::string_view key);
+    bool isEnd() const { return endOfIndex; }
+    std::string_view key() const;  // valid until the cursor moves
+    uint32_t id() const;
+    std::string_view payload() const;  // valid until the cursor moves
+    void advance();
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "database.hpp"
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
+#include "vector_executor.hpp"
+
+/*
+The library's entry point for programs that embed the engine instead of
+talking to the REPL. Nothing here writes to stdout or stderr: failures come
+back as exceptions, and the engine's own diagnostics go through the logger
+(logger.hpp), which is off unless the program turns it on.
+
+    Connection db("app.db");
+    db.execute("CREATE TABLE t (id BIGINT PRIMARY KEY, name TEXT(20))");
+    db.insertBatch("INSERT INTO t VALUES (?, ?)", rows);
+    Query query = db.prepare("SELECT name FROM t WHERE id > ?");
+    query.bind(1, 10);
+    for (const Query& row : query) {
+        use(row.columnText(0));
+    }
+
+A Query borrows its Connection's database, so it must go before the
+Connection is closed. One Connection is one thread's; queries on it run one
+at a time.
+*/
+class Query {
+private:
+    std::unique_ptr<PreparedStatement> statement;
+
+public:
+    explicit Query(std::unique_ptr<PreparedStatement> statement);
+    Query(Query&&) = default;
+    Query& operator=(Query&&) = default;
+
+    StatementKind getKind() const { return statement->getKind(); }
+    uint32_t getParameterCount() const { return statement->getParameterCount(); }
+    // Parameters are 1-based, as in SQLite; throw std::out_of_range outside 1..getParameterCount()
+    void bind(uint32_t index, int64_t value) { statement->bindInteger(index, value); }
+    void bind(uint32_t index, std::string_view value) { statement->bindText(index, value); }
+    void clearBindings() { statement->clearBindings(); }
+
+    // true with a result row available, false once the statement is done.
+    // Throws ExecutionError with the engine's message if it fails; its changes
+    // have been rolled back by then.
+    bool step();
+    // Rewinds so the statement can run again; bindings are kept
+    void reset() { statement->reset(); }
+
+    // The current row, valid until the next step() or reset(). Text is a view
+    // into the batch the scan decoded the row's leaf into, not a copy.
+    uint32_t getColumnCount() const { return statement->getColumnCount(); }
+    bool columnIsText(uint32_t index) const { return statement->getColumn(index).isText; }
+    int64_t columnInteger(uint32_t index) const { return statement->getColumn(index).integer; }
+    std::string_view columnText(uint32_t index) const { return statement->getColumn(index).text; }
+    const Value& column(uint32_t index) const { return statement->getColumn(index); }
+
+    // Steps through the rows; each one is read through the Query itself
+    class Iterator {
+    private:
+        Query* query;  // nullptr at the end
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Query;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Query*;
+        using reference = const Query&;
+
+        explicit Iterator(Query* query) : query(query) {}
+        const Query& operator*() const { return *query; }
+        const Query* operator->() const { return query; }
+        Iterator& operator++() {
+            if (!query->step()) {
+                query = nullptr;
+            }
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return query == other.query; }
+        bool operator!=(const Iterator& other) const { return query != other.query; }
+    };
+    // Takes the first step; iterating again needs a reset() first
+    Iterator begin() { return ++Iterator(this); }
+    Iterator end() { return Iterator(nullptr); }
+};
+
+class Connection {
+private:
+    std::unique_ptr<Database> database;
+    PlanCache planCache;
+
+    Table& table();
+
+public:
+    // Opens filename, creating it if needed. Throws std::runtime_error if it
+    // cannot be opened or is not a database.
+    explicit Connection(const std::string& filename, const DatabaseOptions& options = DatabaseOptions());
+    // Closes the database if close() has not
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Checkpoints and closes the file; an open transaction is rolled back.
+    // Anything else but isOpen() throws std::logic_error afterwards.
+    void close();
+    bool isOpen() const { return database != nullptr; }
+
+    // Compiles sql (through the plan cache). Throws std::invalid_argument with
+    // the parser's message if it is not a statement this engine runs.
+    Query prepare(std::string_view sql);
+    // Prepares sql and steps it to the end, dropping any rows; returns how many there were
+    uint64_t execute(std::string_view sql);
+    // Runs insertSql, an INSERT with ? parameters, once for each row, binding
+    // the row's values in order. All rows go in or none do: they share one
+    // transaction, or one savepoint inside BEGIN ... COMMIT. Returns the rows
+    // inserted; throws ExecutionError (or std::invalid_argument for a bad
+    // statement or row width) after rolling back.
+    uint64_t insertBatch(std::string_view insertSql, const std::vector<std::vector<Value>>& rows);
+
+    // The engine underneath, for what this interface does not cover
+    Database& getDatabase();
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "enums.hpp"
+#include "prepared_statement.hpp"
 #include "table.hpp"
 
 class StatementProcessor {
@@ -16,4 +18,10 @@ public:
     ~StatementProcessor();
 
     PrepareResult execute(const std::string& statement);
+    // Compiles sql once (through the plan cache) into a statement that can be
+    // bound and stepped many times; syntax errors are printed as by execute()
+    PrepareResult prepare(const std::string& sql, std::unique_ptr<PreparedStatement>& prepared);
+    // Quiet: only errors and SELECT rows are printed (no per-row confirmation of legacy inserts)
+    void setQuiet(bool quiet);
+    bool isQuiet() const;
 };
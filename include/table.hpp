@@ -1,35 +1,176 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "constants.hpp"
 #include "enums.hpp"
 #include "row.hpp"
 
 #include "pager.hpp"
+#include "leaf_filter.hpp"
+
+class SecondaryIndex;
+class Scheduler;
+class HashIndex;
+class ColumnStore;
+class ZoneMap;
+class Schema;
+class SchemaTable;
+
+// A leaf found by routing keys alone (see Table::leafCovering): its page, the
+// largest key it may hold (UINT32_MAX for the last leaf) and its place among
+// its parent's children; parentPageNum is INVALID_PAGE_NUM for a root leaf
+struct LeafPosition {
+    uint32_t pageNum;
+    uint32_t upperBound;
+    uint32_t parentPageNum;
+    uint32_t childIndex;
+    uint32_t parentUpperBound;
+};
 
 class Table {
 private:
     Pager* pager;
     uint32_t rootPageNum; // root node key
+    // Secondary indexes, as recorded in the catalog page
+    std::vector<std::unique_ptr<SecondaryIndex>> indexes;
+    // Hash index over the ids, if one was created
+    std::unique_ptr<HashIndex> hashIndex;
+    // Bloom filter per leaf, built on open; a rollback rebuilds the pages it restored
+    LeafFilters leafFilters;
+    // Column-oriented copy of the rows, if one was created; built from the tree
+    // when first scanned after an open or a rollback (stale until then)
+    std::unique_ptr<ColumnStore> columnStore;
+    bool columnStoreStale;
+    // Per-leaf username and email ranges, if a zone map was created
+    std::unique_ptr<ZoneMap> zoneMap;
+    // Runs full scans as parallel morsels when set (see Database)
+    Scheduler* scheduler;
+    // CREATE TABLE tables: the catalog tree (name -> root page and schema),
+    // if any table was created, and a handle per table, sorted by name
+    std::unique_ptr<SecondaryIndex> tableCatalog;
+    std::vector<std::unique_ptr<SchemaTable>> schemaTables;
+    uint64_t schemaVersion;
+
+    std::string rootProblem();
+    void loadIndexes();
+    void loadTables(uint32_t catalogRoot);
+    void addCatalogEntry(uint32_t column, uint32_t pageNum, uint32_t includedColumns);
+    // Writes this build's format stamp over an older one, before adding what older builds misread
+    void stampFormat();
+    void insertIntoTree(const Row& row);
+    // Points the hash index at pageNum for every row in that leaf
+    void rehashLeaf(uint32_t pageNum);
+    void rebuildLeafFilter(uint32_t pageNum);
+    void rebuildLeafFilters();
+    void rebuildLeafFilters(const std::vector<uint32_t>& changedPages);
+    uint32_t subtreeRows(uint32_t pageNum) const;
+    void adjustRowCounts(uint32_t leafPageNum, int32_t delta);
+    void refreshRowCounts(uint32_t pageNum);
 
 public:
-    Table(std::string filename);
+    // compressPages: see Pager
+    Table(std::string filename, uint32_t cachePages = PAGER_DEFAULT_CACHE_PAGES, bool compressPages = false);
     ~Table();
     
     uint8_t* getPageAddress(uint32_t pageNum) const;
+    uint8_t* getPageForWrite(uint32_t pageNum);
     uint32_t getRootPageNum() const { return rootPageNum; }
+    Pager& getPager() { return *pager; }
+    void setScheduler(Scheduler* db_scheduler) { scheduler = db_scheduler; }
+    Scheduler* getScheduler() const { return scheduler; }
     void insertRow(const Row& row);
+    // Adds rows given as serialized Rows, sorted by id without duplicates. An
+    // empty table is built bottom up: evenly filled leaves left to right, then
+    // each level of internal nodes above them, every page written once; any
+    // other table takes the rows through insertRow. Indexes, the hash index,
+    // the zone map and the leaf filters end up as after inserting each row.
+    // True if the tree was built bottom up.
+    bool bulkLoad(const std::vector<const uint8_t*>& rows);
     Row getRow(uint32_t key);
+    // The leaf and cell holding key; false if there is no such row. Goes through
+    // the hash index if there is one, else descends the tree and checks the
+    // leaf's Bloom filter before reading the leaf.
+    bool findRow(uint32_t key, uint32_t& leafPageNum, uint32_t& cellNum);
+    LeafFilters::Stats getLeafFilterStats() const { return leafFilters.getStats(); }
+    // Overwrites the row with the same id; throws std::out_of_range if there is none
+    void updateRow(const Row& row);
+    // Removes the row from its leaf. Leaves may become underfull or empty; they
+    // are not merged, and parent keys stay valid upper bounds. False if absent.
+    bool deleteRow(uint32_t key);
+    // Builds a secondary index on COLUMN_USERNAME or COLUMN_EMAIL from the rows
+    // already stored; insertRow/updateRow/deleteRow keep it current from then on.
+    // includedColumns (bit per column; only the other text column) are copied
+    // into the index entries. Throws std::invalid_argument for other columns or
+    // if the index exists.
+    void createIndex(uint32_t column, uint32_t includedColumns = 0);
+    // nullptr if the column has no index
+    const SecondaryIndex* getIndex(uint32_t column) const;
+    // Builds a hash index from id to leaf page, which Cursor then uses to find
+    // existing keys without descending the tree. Throws std::invalid_argument if
+    // it exists.
+    void createHashIndex();
+    // nullptr if there is none
+    const HashIndex* getHashIndex() const { return hashIndex.get(); }
+    // Builds a column store (see ColumnStore) of the ids and the text columns
+    // in columnMask (bit per column) from the rows already stored, recorded in
+    // the catalog; insertRow/updateRow/deleteRow keep it current from then on.
+    // Throws std::invalid_argument if the mask names no text column or another
+    // column, or if the table has a column store already.
+    void createColumnStore(uint32_t columnMask);
+    // nullptr if there is none; rebuilds it from the tree first if it is stale
+    const ColumnStore* getColumnStore();
+    // The column store's text columns (bit per column), without building it; 0 if there is none
+    uint32_t getColumnStoreColumns() const;
+    // Builds a zone map (see ZoneMap) from the leaves already stored, recorded
+    // in the catalog; inserts, updates, deletes and splits keep it current from
+    // then on, and TableScan consults it. Throws std::invalid_argument if it exists.
+    void createZoneMap();
+    // nullptr if there is none
+    const ZoneMap* getZoneMap() const { return zoneMap.get(); }
+    // Creates an empty table with schema's rows in this file, recorded in the
+    // table catalog. Throws std::invalid_argument if the name is taken (users
+    // included).
+    void createTable(const Schema& schema);
+    // The CREATE TABLE table with that name (any case); nullptr if there is none
+    SchemaTable* getSchemaTable(std::string_view name) const;
+    // "users", then the CREATE TABLE tables by name
+    std::vector<std::string> getTableNames() const;
+    // Changes whenever a table is created, or a rollback drops or restores
+    // one; plans compiled against another version must be compiled again
+    uint64_t getSchemaVersion() const { return schemaVersion; }
     void leafNodeSplitAndInsert(uint32_t key, const Row* value, uint32_t cellNumToInsertAt, uint32_t oldNodePageNum);
     uint32_t getUnusedPageNum() const { return pager->getNumPages(); }
+    // From the per-child row counts in internal nodes, so O(height), not a scan
     uint32_t getNumRows() const;
+    // Number of rows with id < key; O(height)
+    uint32_t countRowsBelow(uint64_t key) const;
+    // The leaf whose key range holds key; false if the tree has no leaf.
+    // Reads internal nodes only, O(height).
+    bool leafCovering(uint32_t key, LeafPosition& position) const;
+    // Moves to the next leaf in key order, through the parent while it has
+    // children left; false after the last leaf. Reads no leaf either.
+    bool nextLeaf(LeafPosition& position) const;
+    // The id of the rank'th row in key order (0-based); false if rank >= getNumRows()
+    bool keyAtRank(uint32_t rank, uint32_t& key) const;
+    uint32_t getMaxKey(uint32_t pageNum) const;
     void createNewRoot(uint32_t rightChildPageNum);
     void internalNodeInsert(uint32_t key, uint32_t childPageNum);
     void internalNodeSplitAndInsert(uint32_t parentPageNum, uint32_t oldNodePageNum);
 
+    // Transactions (forwarded to the pager)
+    void beginTransaction() { pager->beginTransaction(); }
+    void commitTransaction() { pager->commitTransaction(); }
+    void rollbackTransaction();
+    bool inTransaction() const { return pager->inTransaction(); }
+    void savepoint() { pager->savepoint(); }
+    void releaseSavepoint() { pager->releaseSavepoint(); }
+    void rollbackToSavepoint();
+
     ExecuteResult execute_insert(const std::vector<std::string> tokens);
     ExecuteResult execute_insert_multiple(const std::vector<std::string> tokens);
     ExecuteResult execute_select_all();
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "column_store.hpp"
+#include "external_sort.hpp"
+#include "filter_kernels.hpp"
+#include "schema_table.hpp"
+#include "secondary_index.hpp"
+#include "table.hpp"
+#include "zone_map.hpp"
+
+// Rows per batch: large enough to amortize per-batch dispatch, small enough
+// that a batch's columns stay in cache
+constexpr uint32_t BATCH_SIZE = 1024;
+
+// Columns of the built-in users table, in the order scans lay them out
+constexpr uint32_t COLUMN_ID = 0;
+constexpr uint32_t COLUMN_USERNAME = 1;
+constexpr uint32_t COLUMN_EMAIL = 2;
+constexpr uint32_t NUM_TABLE_COLUMNS = 3;
+
+struct Value {
+    bool isText;
+    int64_t integer;
+    std::string_view text;
+};
+
+// Statement-level failure (type errors, bad values, duplicate keys); the
+// statement fails and its changes are rolled back
+class ExecutionError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// One column of a batch. Indexed by row position; only the positions in the
+// batch's selection vector hold meaningful values.
+struct ColumnVector {
+    bool isText = false;
+    std::vector<int64_t> integers;
+    std::vector<std::string_view> texts;
+
+    // Switches type and makes room for rows [0, rows); storage only grows, so a
+    // reused vector stops allocating once it has seen a full batch
+    void setType(bool text, uint32_t rows = BATCH_SIZE);
+    Value get(uint32_t row) const {
+        return isText ? Value{true, 0, texts[row]} : Value{false, integers[row], std::string_view()};
+    }
+};
+
+/*
+A batch of up to BATCH_SIZE rows in columnar form. Rows that have been
+filtered out stay in place; selection lists the live positions in ascending
+order, so filters never move column data. Text columns are views, valid until
+the operator that produced the batch is asked for the next one.
+*/
+struct Batch {
+    uint32_t size = 0;
+    uint32_t selectedCount = 0;
+    std::vector<uint32_t> selection;
+    std::vector<ColumnVector> columns;
+    std::vector<char> textStorage;  // backs the text columns of scanned batches
+
+    void setColumnCount(uint32_t count);
+    void selectAll(uint32_t rows);
+};
+
+/*
+Evaluates expressions one batch at a time: each operator node runs one tight
+loop over the selected rows instead of dispatching per row. Only the rows in
+the given selection are evaluated, so AND/OR still short-circuit per row
+(a division by zero in a row the left side already rejected is not an error).
+*/
+class VectorEvaluator {
+private:
+    const std::vector<Value>& bindings;
+    // one temporary per expression depth; deques so deeper levels never move shallower ones
+    std::deque<ColumnVector> scratch;
+    std::deque<std::vector<uint32_t>> narrowed;  // selections for short-circuit operands
+    Batch noColumns;
+
+    ColumnVector& scratchAt(uint32_t depth);
+    std::vector<uint32_t>& narrowedAt(uint32_t depth);
+    void evaluateAt(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count,
+                    ColumnVector& out, uint32_t depth);
+    void evaluateLogical(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count,
+                         ColumnVector& out, uint32_t depth);
+    uint32_t filterAt(const Expr& predicate, const Batch& batch, uint32_t* selection, uint32_t count, uint32_t depth);
+
+public:
+    explicit VectorEvaluator(const std::vector<Value>& bindings) : bindings(bindings) {}
+
+    // out[row] for every row in selection[0, count). COLUMN expressions read
+    // batch.columns[expr.column].
+    void evaluate(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count, ColumnVector& out);
+    // Compacts selection to the rows where predicate is true; returns the new count
+    uint32_t filter(const Expr& predicate, const Batch& batch, uint32_t* selection, uint32_t count);
+    // For expressions that reference no columns (VALUES, LIMIT)
+    Value evaluateConstant(const Expr& expr);
+};
+
+// Pull-based operator: next() fills batch with the next rows. Returns false once
+// exhausted; a batch returned with true has at least one selected row.
+class BatchOperator {
+public:
+    virtual ~BatchOperator() = default;
+    virtual bool next(Batch& batch) = 0;
+};
+
+// Leaves the table scans of one statement read and skipped, added to as they
+// go; atomic, since the morsels of a parallel scan share one
+struct ScanStats {
+    std::atomic<uint64_t> leavesRead{0};
+    std::atomic<uint64_t> leavesSkipped{0};
+};
+
+/*
+Reads rows with ids in [low, high] in key order, decoding the fixed-width
+cells of each leaf straight into columns (id, username, email). Pushed-down
+filters run on the cells in the page first, so only the rows that pass all of
+them are copied out.
+
+When the table has a zone map, the ranges the filters (and pushZoneRange)
+confine username and email to are checked against each leaf's zone before the
+leaf is read. The scan then finds each next leaf through the internal nodes
+rather than the sibling pointers, so a leaf it skips is never read.
+*/
+class TableScan : public BatchOperator {
+private:
+    Table& table;
+    int64_t low;
+    int64_t high;
+    uint32_t pageNum;
+    uint32_t cellNum;
+    bool started;
+    bool done;
+    bool evicts;  // trims the page cache between batches and leaves
+    std::vector<FieldFilter> filters;
+    std::vector<ZoneRange> zoneRanges;
+    const ZoneMap* zones;  // set once started, when there are ranges to check
+    LeafPosition leaf;     // zones: where the current leaf is among the routing keys
+    ScanStats* stats;
+    uint64_t rowsExamined;
+    uint64_t rowsMaterialized;
+    uint64_t leavesRead;
+    uint64_t leavesSkipped;
+
+    void countLeafRead();
+    bool nextZoneLeaf(bool advance);
+
+public:
+    // evicts = false for a scan running beside others on the same table (one
+    // ParallelScan morsel), whose page pointers eviction would invalidate
+    TableScan(Table& table, int64_t low = 0, int64_t high = UINT32_MAX, bool evicts = true);
+    // Only before the first next(); fieldOffset is relative to the serialized Row
+    void pushFilter(FieldFilter filter);
+    // Only before the first next(): lets the zone map skip leaves with no row
+    // in range; the rows read are not checked against it (see ZoneMap::rangeUpTo)
+    void pushZoneRange(ZoneRange range);
+    // Adds the leaves read and skipped to stats as well; only before the first next()
+    void countInto(ScanStats* scanStats) { stats = scanStats; }
+    bool next(Batch& batch) override;
+
+    // Cells in [low, high] the scan looked at, and how many of them it decoded
+    uint64_t getRowsExamined() const { return rowsExamined; }
+    uint64_t getRowsMaterialized() const { return rowsMaterialized; }
+    // Leaves read, and leaves the zone map ruled out without reading them
+    uint64_t getLeavesRead() const { return leavesRead; }
+    uint64_t getLeavesSkipped() const { return leavesSkipped; }
+};
+
+/*
+Reads the rows with ids in [low, high] whose indexed column equals value
+(EQUALS) or starts with it (PREFIX), through a secondary index instead of the
+leaf chain. The matches are collected and sorted by id first, so rows come out
+in key order as from TableScan. Each is then fetched from the table by a point
+lookup, and pushed-down filters run on its cell before it is copied out.
+
+A covering scan never reads the table: it rebuilds each row from the index
+entry (key, id and included columns) and filters that instead. Columns the
+index does not hold come out empty, so the caller must only use it when the
+index covers every column the query reads.
+*/
+class IndexScan : public BatchOperator {
+private:
+    Table& table;
+    const SecondaryIndex& index;
+    FieldMatch match;
+    std::string value;
+    int64_t low;
+    int64_t high;
+    bool covering;
+    std::vector<FieldFilter> filters;
+    // (id, covering: row number in coveredRows), sorted by id
+    std::vector<std::pair<uint32_t, uint32_t>> matches;
+    std::vector<char> coveredRows;  // covering: serialized rows, ROW_SIZE_BYTES each
+    size_t position;
+    bool started;
+    uint64_t rowsExamined;
+    uint64_t tableLookups;
+
+    void collectMatches();
+    bool coverEntry(uint32_t id, std::string_view key, std::string_view payload);
+
+public:
+    IndexScan(Table& table, const SecondaryIndex& index, FieldMatch match, std::string_view value, int64_t low = 0,
+              int64_t high = UINT32_MAX, bool covering = false);
+    // Only before the first next(); fieldOffset is relative to the serialized Row
+    void pushFilter(FieldFilter filter);
+    bool next(Batch& batch) override;
+
+    // Index entries in [low, high] that matched value, and how many rows were
+    // fetched from the table for them (none when covering)
+    uint64_t getRowsExamined() const { return rowsExamined; }
+    uint64_t getTableLookups() const { return tableLookups; }
+};
+
+/*
+Reads the rows with ids in [low, high] in key order from a table's column
+store instead of its tree: the id and the projected columns of each row, the
+other columns coming out empty, so the caller must only use it when the store
+covers every column the query reads. Segments and the delta buffer are merged
+by id. Pushed-down filters run on a segment's packed columns before anything
+is copied out, and a segment whose zone map shows no value can pass one is
+skipped whole. Each batch resumes after the last id returned, so the store
+may change between batches.
+*/
+class ColumnStoreScan : public BatchOperator {
+private:
+    const ColumnStore& store;
+    int64_t nextId;
+    int64_t high;
+    bool done;
+    std::vector<std::pair<uint32_t, FieldFilter>> filters;  // (column, filter)
+    std::vector<uint32_t> selection;
+    std::vector<uint32_t> textEnds;  // per row and text column: where its value ends in textStorage
+    uint64_t rowsExamined;
+    uint64_t segmentsSkipped;
+    const ColumnStore::Segment* lastSkipped;
+
+    bool mayMatch(const ColumnStore::Segment& segment) const;
+    bool deltaMatches(const ColumnStore::DeltaRow& values) const;
+    // Appends a row's value of a text column to textStorage, nothing if it is not projected
+    void copyText(Batch& batch, uint32_t column, std::string_view text);
+
+public:
+    ColumnStoreScan(const ColumnStore& store, int64_t low = 0, int64_t high = UINT32_MAX);
+    // Only before the first next(); fieldOffset is relative to the serialized
+    // Row, and the store must project the field's column
+    void pushFilter(FieldFilter filter);
+    bool next(Batch& batch) override;
+
+    // Rows in [low, high] the scan looked at, and segments whose zone maps ruled them out
+    uint64_t getRowsExamined() const { return rowsExamined; }
+    uint64_t getSegmentsSkipped() const { return segmentsSkipped; }
+};
+
+/*
+Reads the rows of a CREATE TABLE table in primary key order, one column per
+schema column: INT and BIGINT as integers, TEXT and BLOB as text, and DOUBLE
+as text too (the fewest digits that read back as the same number), since
+batches have no floating-point type. Rows are copied out of the tree a batch
+at a time and decoded by the table's RowCodec. With a whole key (see
+encodeKey) only the row holding it is read; with the key of a composite key's
+leading columns, the rows whose keys start with it.
+*/
+class SchemaTableScan : public BatchOperator {
+private:
+    const SchemaTable& table;
+    std::string key;
+    bool keyed;
+    bool wholeKey;
+    std::unique_ptr<IndexCursor> cursor;
+    bool done;
+    std::vector<uint32_t> rowEnds;  // where each row of the batch ends in textStorage
+    std::vector<std::pair<uint32_t, uint32_t>> realText;  // DOUBLE columns: (offset, length) per row and column
+
+public:
+    explicit SchemaTableScan(const SchemaTable& table);
+    SchemaTableScan(const SchemaTable& table, std::string key, bool wholeKey);
+    bool next(Batch& batch) override;
+};
+
+// Keeps the rows for which every predicate is true
+class FilterOperator : public BatchOperator {
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::vector<const Expr*> predicates;
+    VectorEvaluator& evaluator;
+
+public:
+    // evaluator is borrowed (it must outlive the operator) so its scratch space
+    // is reused when a statement builds a new pipeline for every execution
+    FilterOperator(std::unique_ptr<BatchOperator> child, std::vector<const Expr*> predicates,
+                   VectorEvaluator& evaluator);
+    bool next(Batch& batch) override;
+};
+
+// Output column i is expressions[i] evaluated over the input batch
+class ProjectOperator : public BatchOperator {
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::vector<const Expr*> expressions;
+    VectorEvaluator& evaluator;
+    Batch& input;  // projected text columns point into it
+
+public:
+    // input is a borrowed scratch batch for the child's output, like evaluator
+    ProjectOperator(std::unique_ptr<BatchOperator> child, std::vector<const Expr*> expressions,
+                    VectorEvaluator& evaluator, Batch& input);
+    bool next(Batch& batch) override;
+};
+
+struct SortKey {
+    uint32_t column;
+    bool descending;
+};
+
+/*
+Collects its whole input, then emits it ordered by keys (stable). Each row
+becomes a normalized key plus its column values, sorted by an ExternalSorter:
+in memory up to memoryBudget bytes, in spilled runs merged from a temporary
+file beyond that. With a limit (the rows a LIMIT/OFFSET above will consume)
+only that many smallest rows are kept, in a bounded heap when it is small.
+*/
+class SortOperator : public BatchOperator {
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::vector<SortKey> keys;
+    bool sorted;
+    ExternalSorter sorter;
+    std::vector<bool> textColumns;
+    Arena batchText;  // the text of the batch last returned
+    std::string key;
+    std::string payload;
+
+    void collect();
+
+public:
+    SortOperator(std::unique_ptr<BatchOperator> child, std::vector<SortKey> keys, uint64_t limit = UINT64_MAX,
+                 size_t memoryBudget = SORT_MEMORY_BUDGET);
+    bool next(Batch& batch) override;
+    uint32_t getSpilledRuns() const { return sorter.getSpilledRuns(); }
+};
+
+// Skips offset rows, then passes at most limit rows; stops pulling once satisfied
+class LimitOperator : public BatchOperator {
+private:
+    std::unique_ptr<BatchOperator> child;
+    int64_t toSkip;
+    int64_t remaining;
+
+public:
+    LimitOperator(std::unique_ptr<BatchOperator> child, int64_t offset, int64_t limit);
+    bool next(Batch& batch) override;
+};
+
+struct AggregateSpec {
+    AggregateFunction function;
+    uint32_t column;  // input column; ignored by COUNT
+};
+
+/*
+Hash GROUP BY: folds its whole input into one row per distinct combination of
+groupColumns, emitted in order of first appearance with the group columns
+first and then one column per spec. Without group columns everything folds
+into one row; with no input rows there is then nothing for MIN/MAX to return
+(there are no NULLs), so the result is empty unless every spec is COUNT or SUM.
+*/
+class AggregateOperator : public BatchOperator {
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::vector<uint32_t> groupColumns;
+    std::vector<AggregateSpec> specs;
+    bool folded;
+    uint32_t position;  // next group to emit
+
+    std::unordered_map<std::string, uint32_t> groupIndex;  // encoded group values -> group
+    std::vector<Value> groupValues;      // numGroups x groupColumns; text points into groupText
+    Arena groupText;
+    std::vector<uint64_t> groupRows;
+    std::vector<int64_t> integers;       // numGroups x specs: SUM, or integer MIN/MAX
+    std::vector<std::string> texts;      // numGroups x specs: text MIN/MAX
+    std::vector<bool> textResult;        // per spec: MIN/MAX over a text column
+
+    void fold();
+    uint32_t findGroup(const Batch& input, uint32_t row, std::string& key);
+    void addGroupValue(Value value);
+    uint32_t addGroup(const std::string& key);
+
+public:
+    AggregateOperator(std::unique_ptr<BatchOperator> child, std::vector<AggregateSpec> specs);
+    AggregateOperator(std::unique_ptr<BatchOperator> child, std::vector<uint32_t> groupColumns,
+                      std::vector<AggregateSpec> specs);
+    // Reads the whole input now and releases it; next() then only emits groups
+    void foldInput();
+    // Adds the groups of other (same group columns and specs, input already
+    // folded) to this one's. Groups new to this operator follow its own in
+    // other's order, so partials of consecutive key ranges merged in key order
+    // come out as a single aggregate over the whole range would.
+    void merge(AggregateOperator& other);
+    bool next(Batch& batch) override;
+};
+
+// Emits one precomputed row (none if values is empty), for results answered
+// without reading the table
+class SingleRowOperator : public BatchOperator {
+private:
+    std::vector<Value> values;
+    bool done;
+
+public:
+    explicit SingleRowOperator(std::vector<Value> values);
+    bool next(Batch& batch) override;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "filter_kernels.hpp"
+
+class Table;
+
+// Rows whose column (username or email) may match a predicate: their first
+// ZONE_PREFIX_SIZE bytes, zero-padded and read big-endian, lie in [low, high]
+struct ZoneRange {
+    uint32_t column;
+    uint64_t low;
+    uint64_t high;
+};
+
+/*
+A zone map over the users table's leaves: for each leaf, the smallest and
+largest prefix (the first 8 bytes, as a big-endian number) of its usernames
+and of its emails. Prefixes order as the texts do, so a scan whose filter
+needs a username in some range skips every leaf whose zone lies outside it,
+without reading the leaf (see TableScan). Ids need no zone map: the internal
+nodes already bound each leaf's keys.
+
+Entries are indexed by leaf page number, ZONE_PAGE_MAX_LEAVES to a zone page;
+the directory of zone page numbers is read into memory when the map is opened.
+Zone pages are allocated from the table's pager as leaves appear, so they
+share its cache, transactions and WAL. A leaf without a zone page, or one that
+is not a leaf, has the full range and is never skipped.
+
+Zones only ever have to contain their leaf's values: the table widens a zone
+on insert and update, and recomputes it when a split or a delete changes which
+rows a leaf holds. Callers hold the table's write latch to modify it.
+*/
+class ZoneMap {
+private:
+    Table& table;
+    uint32_t headerPageNum;
+    std::vector<uint32_t> zonePages;       // by leaf page number / ZONE_PAGE_MAX_LEAVES; 0 = none yet
+    std::vector<uint32_t> directoryPages;  // the header page, then its continuations
+
+    // The zone page holding pageNum's entry, allocating it (and directory space) if needed
+    uint32_t zonePageFor(uint32_t pageNum);
+    void writeEntry(uint32_t pageNum, const uint64_t (&entry)[4]);
+
+public:
+    // Reads the directory from the header page
+    ZoneMap(Table& table, uint32_t headerPageNum);
+    // Sets up an empty map, its header in pageNum
+    static void initialize(Table& table, uint32_t pageNum);
+
+    uint32_t getHeaderPageNum() const { return headerPageNum; }
+    uint32_t getZonePageCount() const;
+
+    // Widens leaf pageNum's zone to take in the serialized row at cell
+    void widen(uint32_t pageNum, const uint8_t* cell);
+    // Sets pageNum's zone from the rows it holds now; an empty leaf gets an empty zone
+    void recompute(uint32_t pageNum);
+    // False if no row in leaf pageNum can lie in every range
+    bool mayMatch(uint32_t pageNum, const std::vector<ZoneRange>& ranges) const;
+
+    // The range an EQUALS or PREFIX filter on username or email confines its
+    // column to; false for other filters, which no zone can rule out
+    static bool rangeOf(const FieldFilter& filter, ZoneRange& range);
+    // The ranges of "column < text" or "<=" (upTo), and "column > text" or ">=" (from)
+    static ZoneRange rangeUpTo(uint32_t column, std::string_view text);
+    static ZoneRange rangeFrom(uint32_t column, std::string_view text);
+};
@@ -0,0 +1,36 @@
+#include "arena.hpp"
+
+#include <cstring>
+
+Arena::Arena() : block(inlineBlock), blockSize(INLINE_SIZE), used(0) {}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(block) + used;
+    size_t padding = (alignment - address % alignment) % alignment;
+    if (used + padding + size > blockSize) {
+        // chain a new block; the rest of the current one is abandoned
+        size_t newSize = size + alignment > MIN_BLOCK_SIZE ? size + alignment : MIN_BLOCK_SIZE;
+        heapBlocks.emplace_back(new uint8_t[newSize]);
+        block = heapBlocks.back().get();
+        blockSize = newSize;
+        used = 0;
+        address = reinterpret_cast<uintptr_t>(block);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    void* result = block + used + padding;
+    used += padding + size;
+    return result;
+}
+
+void Arena::reset() {
+    heapBlocks.clear();
+    block = inlineBlock;
+    blockSize = INLINE_SIZE;
+    used = 0;
+}
+
+std::string_view Arena::copyString(std::string_view text) {
+    char* copy = static_cast<char*>(allocate(text.size() == 0 ? 1 : text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
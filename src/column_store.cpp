@@ -0,0 +1,183 @@
+#include "column_store.hpp"
+
+#include <algorithm>
+
+#include "cursor.hpp"
+#include "secondary_index.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+ColumnStore::ColumnStore(uint32_t columns) : columns(columns), deletesSinceFold(0), folds(0) {}
+
+ColumnStore::DeltaRow ColumnStore::deltaRowOf(const Row& row) const {
+    DeltaRow values;
+    for (uint32_t column = COLUMN_USERNAME; column < NUM_TABLE_COLUMNS; column++) {
+        if (projects(column)) {
+            values.values[column] = std::string(SecondaryIndex::valueOf(row, column));
+        }
+    }
+    return values;
+}
+
+void ColumnStore::appendRow(Segment& segment, uint32_t id, const DeltaRow& values) const {
+    segment.ids.push_back(id);
+    for (uint32_t column = COLUMN_USERNAME; column < NUM_TABLE_COLUMNS; column++) {
+        if (projects(column)) {
+            TextColumn& text = segment.columns[column];
+            text.bytes += values.values[column];
+            text.ends.push_back(static_cast<uint32_t>(text.bytes.size()));
+        }
+    }
+}
+
+// Sets up the deleted flags and zone maps once a segment's rows are in
+void ColumnStore::finishSegment(Segment& segment) const {
+    segment.deleted.assign(segment.ids.size(), false);
+    segment.deletedRows = 0;
+    for (uint32_t column = COLUMN_USERNAME; column < NUM_TABLE_COLUMNS; column++) {
+        if (!projects(column) || segment.ids.empty()) {
+            continue;
+        }
+        TextColumn& text = segment.columns[column];
+        std::string_view min = text.value(0);
+        std::string_view max = min;
+        for (uint32_t i = 1; i < text.ends.size(); i++) {
+            std::string_view value = text.value(i);
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        text.min = std::string(min);
+        text.max = std::string(max);
+    }
+}
+
+void ColumnStore::addSegments(std::vector<Segment>& into,
+                              const std::vector<std::pair<uint32_t, DeltaRow>>& rows) const {
+    if (rows.empty()) {
+        return;
+    }
+    // even sizes, so a segment that just overflowed becomes two half-full ones
+    size_t count = (rows.size() + COLUMN_SEGMENT_ROWS - 1) / COLUMN_SEGMENT_ROWS;
+    size_t begin = 0;
+    for (size_t s = 0; s < count; s++) {
+        size_t end = rows.size() * (s + 1) / count;
+        Segment segment;
+        for (size_t i = begin; i < end; i++) {
+            appendRow(segment, rows[i].first, rows[i].second);
+        }
+        finishSegment(segment);
+        into.push_back(std::move(segment));
+        begin = end;
+    }
+}
+
+void ColumnStore::rebuild(Table& table) {
+    segments.clear();
+    delta.clear();
+    deletesSinceFold = 0;
+    Segment segment;
+    for (Cursor cursor(table); !cursor.isEndOfTable(); cursor.cursorAdvance()) {
+        Row row = Row::deserialize(cursor.cursorSlot());
+        appendRow(segment, row.getId(), deltaRowOf(row));
+        if (segment.ids.size() == COLUMN_SEGMENT_ROWS) {
+            finishSegment(segment);
+            segments.push_back(std::move(segment));
+            segment = Segment();
+        }
+    }
+    if (!segment.ids.empty()) {
+        finishSegment(segment);
+        segments.push_back(std::move(segment));
+    }
+}
+
+void ColumnStore::insert(const Row& row) {
+    delta[row.getId()] = deltaRowOf(row);
+    if (delta.size() + deletesSinceFold >= COLUMN_DELTA_MAX_ROWS) {
+        fold();
+    }
+}
+
+// The old version is deleted where it is and the new one buffered, so a
+// segment never changes its values in place
+void ColumnStore::update(const Row& row) {
+    remove(row.getId());
+    insert(row);
+}
+
+void ColumnStore::remove(uint32_t id) {
+    if (delta.erase(id) != 0) {
+        return;
+    }
+    auto segment = std::lower_bound(segments.begin(), segments.end(), id,
+                                    [](const Segment& s, uint32_t wanted) { return s.ids.back() < wanted; });
+    if (segment == segments.end()) {
+        return;
+    }
+    auto position = std::lower_bound(segment->ids.begin(), segment->ids.end(), id);
+    size_t row = static_cast<size_t>(position - segment->ids.begin());
+    if (position == segment->ids.end() || *position != id || segment->deleted[row]) {
+        return;
+    }
+    segment->deleted[row] = true;
+    segment->deletedRows++;
+    if (++deletesSinceFold + delta.size() >= COLUMN_DELTA_MAX_ROWS) {
+        fold();
+    }
+}
+
+// Delta rows belong to the segment whose ids they fall among: those before the
+// second segment's first id to the first, and so on, the rest to the last
+void ColumnStore::fold() {
+    std::vector<Segment> folded;
+    folded.reserve(segments.size() + 1);
+    auto pending = delta.begin();
+    std::vector<std::pair<uint32_t, DeltaRow>> rows;
+    for (size_t s = 0; s < segments.size(); s++) {
+        Segment& segment = segments[s];
+        auto end = s + 1 == segments.size() ? delta.end() : delta.lower_bound(segments[s + 1].ids.front());
+        if (pending == end && segment.deletedRows == 0) {
+            folded.push_back(std::move(segment));
+            continue;
+        }
+        rows.clear();
+        for (size_t i = 0; i < segment.ids.size(); i++) {
+            for (; pending != end && pending->first < segment.ids[i]; ++pending) {
+                rows.emplace_back(pending->first, std::move(pending->second));
+            }
+            if (segment.deleted[i]) {
+                continue;
+            }
+            DeltaRow values;
+            for (uint32_t column = COLUMN_USERNAME; column < NUM_TABLE_COLUMNS; column++) {
+                if (projects(column)) {
+                    values.values[column] = std::string(segment.columns[column].value(static_cast<uint32_t>(i)));
+                }
+            }
+            rows.emplace_back(segment.ids[i], std::move(values));
+        }
+        for (; pending != end; ++pending) {
+            rows.emplace_back(pending->first, std::move(pending->second));
+        }
+        addSegments(folded, rows);
+    }
+    if (segments.empty()) {
+        rows.clear();
+        for (auto& entry : delta) {
+            rows.emplace_back(entry.first, std::move(entry.second));
+        }
+        addSegments(folded, rows);
+    }
+    segments = std::move(folded);
+    delta.clear();
+    deletesSinceFold = 0;
+    folds++;
+}
+
+uint32_t ColumnStore::getNumRows() const {
+    size_t rows = delta.size();
+    for (const Segment& segment : segments) {
+        rows += segment.ids.size() - segment.deletedRows;
+    }
+    return static_cast<uint32_t>(rows);
+}
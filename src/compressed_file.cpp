@@ -0,0 +1,347 @@
+#include "compressed_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Superblock, in unit 0: magic, version, numPages, map offset (units), map bytes, map checksum
+    constexpr uint32_t SUPERBLOCK_MAGIC = 0x5A4C5153;  // "SQLZ"
+    constexpr uint32_t SUPERBLOCK_VERSION = 1;
+    constexpr uint32_t SUPERBLOCK_FIELDS = 6;
+
+    constexpr uint32_t MAX_RUN = 128;
+    constexpr uint8_t ZERO_RUN = 0x80;
+
+    // FNV-1a, as for WAL records
+    uint32_t checksum(const uint8_t* data, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void writeFully(int fd, const uint8_t* data, size_t length, off_t offset) {
+        while (length > 0) {
+            ssize_t written = pwrite(fd, data, length, offset);
+            if (written < 0) {
+                throw std::runtime_error("Failed to write page to file");
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+            offset += written;
+        }
+    }
+
+    bool readFully(int fd, uint8_t* data, size_t length, off_t offset) {
+        while (length > 0) {
+            ssize_t bytesRead = pread(fd, data, length, offset);
+            if (bytesRead <= 0) {
+                return false;
+            }
+            data += bytesRead;
+            length -= static_cast<size_t>(bytesRead);
+            offset += bytesRead;
+        }
+        return true;
+    }
+
+    uint32_t unitsFor(uint32_t bytes) {
+        return (bytes + COMPRESSED_SLOT_UNIT - 1) / COMPRESSED_SLOT_UNIT;
+    }
+
+    off_t unitOffset(uint32_t unit) {
+        return static_cast<off_t>(unit) * COMPRESSED_SLOT_UNIT;
+    }
+}
+
+uint32_t compressPage(const uint8_t* page, uint8_t* out) {
+    uint32_t in = 0;
+    uint32_t length = 0;
+    while (in < PAGE_SIZE) {
+        uint32_t limit = std::min(in + MAX_RUN, PAGE_SIZE);
+        uint32_t end = in;
+        uint64_t word;
+        while (end + sizeof(word) <= limit && (std::memcpy(&word, page + end, sizeof(word)), word == 0)) {
+            end += sizeof(word);
+        }
+        while (end < limit && page[end] == 0) {
+            end++;
+        }
+        // shorter runs cost no more as literals, and do not split a literal run
+        uint32_t zeros = end - in;
+        if (zeros >= 3 || (zeros > 0 && end == PAGE_SIZE)) {
+            out[length++] = static_cast<uint8_t>(ZERO_RUN | (zeros - 1));
+            in = end;
+            continue;
+        }
+        // literals run up to the next three zeros; fewer than three are at in,
+        // so there is at least one
+        uint32_t start = in;
+        while (in < limit) {
+            const void* zero = std::memchr(page + in, 0, limit - in);
+            if (zero == nullptr) {
+                in = limit;
+                break;
+            }
+            uint32_t at = static_cast<uint32_t>(static_cast<const uint8_t*>(zero) - page);
+            if (at + 2 < PAGE_SIZE && page[at + 1] == 0 && page[at + 2] == 0) {
+                in = at;
+                break;
+            }
+            in = at + 1;
+        }
+        out[length++] = static_cast<uint8_t>(in - start - 1);
+        std::memcpy(out + length, page + start, in - start);
+        length += in - start;
+    }
+    return length;
+}
+
+bool decompressPage(const uint8_t* data, uint32_t length, uint8_t* page) {
+    // zero runs then only move the output position
+    std::memset(page, 0, PAGE_SIZE);
+    uint32_t in = 0;
+    uint32_t out = 0;
+    while (in < length) {
+        uint8_t control = data[in++];
+        uint32_t run = (control & (ZERO_RUN - 1)) + 1;
+        if (out + run > PAGE_SIZE) {
+            return false;
+        }
+        if ((control & ZERO_RUN) == 0) {
+            if (in + run > length) {
+                return false;
+            }
+            std::memcpy(page + out, data + in, run);
+            in += run;
+        }
+        out += run;
+    }
+    return out == PAGE_SIZE;
+}
+
+bool CompressedPageFile::detect(int fd) {
+    uint32_t magic = 0;
+    return pread(fd, &magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) && magic == SUPERBLOCK_MAGIC;
+}
+
+CompressedPageFile::CompressedPageFile(int fd, bool create)
+    : fileDescriptor(fd), pendingFreeUnits(0), endUnit(1), mapExtent(0, 0), storedBytes(0), changed(false) {
+    static_assert(sizeof(Slot) == 2 * sizeof(uint32_t), "map entries are written as they are laid out");
+    if (create) {
+        writeSuperblock(0, checksum(nullptr, 0));
+        if (fsync(fileDescriptor) != 0) {
+            throw std::runtime_error("Failed to sync database file");
+        }
+        return;
+    }
+
+    uint32_t superblock[SUPERBLOCK_FIELDS];
+    if (!readFully(fileDescriptor, reinterpret_cast<uint8_t*>(superblock), sizeof(superblock), 0) ||
+        superblock[0] != SUPERBLOCK_MAGIC || superblock[1] != SUPERBLOCK_VERSION ||
+        superblock[4] != superblock[2] * sizeof(Slot) || superblock[2] > TABLE_MAX_PAGES) {
+        throw std::runtime_error("Corrupt compressed database superblock");
+    }
+    slots.resize(superblock[2]);
+    uint32_t mapBytes = superblock[4];
+    if ((mapBytes > 0 && !readFully(fileDescriptor, reinterpret_cast<uint8_t*>(slots.data()), mapBytes,
+                                    unitOffset(superblock[3]))) ||
+        checksum(reinterpret_cast<const uint8_t*>(slots.data()), mapBytes) != superblock[5]) {
+        throw std::runtime_error("Corrupt compressed database page map");
+    }
+    mapExtent = {superblock[3], unitsFor(mapBytes)};
+
+    // everything the superblock, the map and the slots do not cover is free
+    std::vector<std::pair<uint32_t, uint32_t>> used = {{0, 1}};
+    if (mapExtent.second > 0) {
+        used.push_back(mapExtent);
+    }
+    for (const Slot& slot : slots) {
+        if (slot.offset != 0) {
+            used.emplace_back(slot.offset, slot.capacity);
+            storedBytes += slot.length;
+        }
+    }
+    std::sort(used.begin(), used.end());
+    struct stat fileStat;
+    fstat(fileDescriptor, &fileStat);
+    endUnit = unitsFor(static_cast<uint32_t>(fileStat.st_size));
+    uint32_t next = 0;
+    for (const auto& [offset, units] : used) {
+        if (offset > next) {
+            freeExtents.emplace(next, offset - next);
+        }
+        next = std::max(next, offset + units);
+    }
+    if (next < endUnit) {
+        freeExtents.emplace(next, endUnit - next);
+    }
+    endUnit = std::max(endUnit, next);
+}
+
+uint32_t CompressedPageFile::getNumPages() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint32_t>(slots.size());
+}
+
+uint64_t CompressedPageFile::getStoredBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return storedBytes;
+}
+
+// First fit, else grows the file
+uint32_t CompressedPageFile::allocate(uint32_t units) {
+    for (auto it = freeExtents.begin(); it != freeExtents.end(); ++it) {
+        if (it->second >= units) {
+            uint32_t offset = it->first;
+            uint32_t remaining = it->second - units;
+            freeExtents.erase(it);
+            if (remaining > 0) {
+                freeExtents.emplace(offset + units, remaining);
+            }
+            return offset;
+        }
+    }
+    uint32_t offset = endUnit;
+    endUnit += units;
+    return offset;
+}
+
+// Returns an extent to the free map, merging it with its neighbours
+void CompressedPageFile::release(uint32_t offset, uint32_t units) {
+    auto next = freeExtents.lower_bound(offset);
+    if (next != freeExtents.end() && offset + units == next->first) {
+        units += next->second;
+        next = freeExtents.erase(next);
+    }
+    if (next != freeExtents.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += units;
+            return;
+        }
+    }
+    freeExtents.emplace(offset, units);
+}
+
+void CompressedPageFile::writeSuperblock(uint32_t mapBytes, uint32_t mapChecksum) {
+    uint32_t superblock[SUPERBLOCK_FIELDS] = {SUPERBLOCK_MAGIC, SUPERBLOCK_VERSION, static_cast<uint32_t>(slots.size()),
+                                              mapExtent.first, mapBytes, mapChecksum};
+    writeFully(fileDescriptor, reinterpret_cast<const uint8_t*>(superblock), sizeof(superblock), 0);
+}
+
+uint32_t CompressedPageFile::readPage(uint32_t pageNum, uint8_t* page) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pageNum >= slots.size() || slots[pageNum].offset == 0) {
+        std::memset(page, 0, PAGE_SIZE);
+        return 0;
+    }
+    const Slot& slot = slots[pageNum];
+    if (slot.length == PAGE_SIZE) {
+        if (!readFully(fileDescriptor, page, PAGE_SIZE, unitOffset(slot.offset))) {
+            throw std::runtime_error("Failed to read page from file");
+        }
+        return PAGE_SIZE;
+    }
+    uint8_t buffer[PAGE_SIZE];
+    if (!readFully(fileDescriptor, buffer, slot.length, unitOffset(slot.offset))) {
+        throw std::runtime_error("Failed to read page from file");
+    }
+    if (!decompressPage(buffer, slot.length, page)) {
+        throw std::runtime_error("Corrupt compressed page " + std::to_string(pageNum));
+    }
+    return slot.length;
+}
+
+uint32_t CompressedPageFile::writePage(uint32_t pageNum, const uint8_t* page) {
+    uint8_t buffer[COMPRESSED_PAGE_MAX_SIZE];
+    uint32_t length = compressPage(page, buffer);
+    const uint8_t* image = buffer;
+    if (length >= PAGE_SIZE) {
+        image = page;
+        length = PAGE_SIZE;
+    }
+    uint32_t units = unitsFor(length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pageNum >= slots.size()) {
+        slots.resize(pageNum + 1, Slot{0, 0, 0});
+    }
+    Slot& slot = slots[pageNum];
+    // a page that shrank to under half its slot moves too, or one that was
+    // briefly incompressible would hold a full page's space for good
+    if (slot.offset == 0 || units > slot.capacity || 2 * units < slot.capacity) {
+        // the map on disk may still point at the old slot
+        if (slot.offset != 0) {
+            pendingFree.emplace_back(slot.offset, slot.capacity);
+            pendingFreeUnits += slot.capacity;
+        }
+        slot.offset = allocate(units);
+        slot.capacity = static_cast<uint16_t>(units);
+    }
+    storedBytes = storedBytes - slot.length + length;
+    slot.length = static_cast<uint16_t>(length);
+    changed = true;
+    writeFully(fileDescriptor, image, length, unitOffset(slot.offset));
+    if (pendingFreeUnits >= COMPRESSED_PENDING_FREE_MIN_UNITS && pendingFreeUnits >= endUnit / 4) {
+        checkpointLocked();
+    }
+    return length;
+}
+
+void CompressedPageFile::checkpoint() {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkpointLocked();
+}
+
+void CompressedPageFile::checkpointLocked() {
+    if (!changed) {
+        if (fsync(fileDescriptor) != 0) {
+            throw std::runtime_error("Failed to sync database file");
+        }
+        return;
+    }
+    uint32_t mapBytes = static_cast<uint32_t>(slots.size() * sizeof(Slot));
+    const uint8_t* map = reinterpret_cast<const uint8_t*>(slots.data());
+    std::pair<uint32_t, uint32_t> oldMap = mapExtent;
+    mapExtent = {0, unitsFor(mapBytes)};
+    if (mapExtent.second > 0) {
+        mapExtent.first = allocate(mapExtent.second);
+        writeFully(fileDescriptor, map, mapBytes, unitOffset(mapExtent.first));
+    }
+    if (fsync(fileDescriptor) != 0) {
+        throw std::runtime_error("Failed to sync database file");
+    }
+    writeSuperblock(mapBytes, checksum(map, mapBytes));
+    if (fsync(fileDescriptor) != 0) {
+        throw std::runtime_error("Failed to sync database file");
+    }
+
+    // nothing on disk refers to these any more
+    if (oldMap.second > 0) {
+        pendingFree.push_back(oldMap);
+    }
+    for (const auto& [offset, units] : pendingFree) {
+        release(offset, units);
+    }
+    pendingFree.clear();
+    pendingFreeUnits = 0;
+    changed = false;
+    if (!freeExtents.empty()) {
+        auto last = std::prev(freeExtents.end());
+        if (last->first + last->second == endUnit) {
+            endUnit = last->first;
+            freeExtents.erase(last);
+            if (ftruncate(fileDescriptor, unitOffset(endUnit)) != 0) {
+                throw std::runtime_error("Failed to truncate database file");
+            }
+        }
+    }
+}
@@ -0,0 +1,397 @@
+#include "csv_import.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "mapped_file.hpp"
+#include "row.hpp"
+#include "scheduler.hpp"
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    constexpr std::string_view USERS_TABLE_NAME = "users";
+    constexpr std::string_view USERS_COLUMNS[NUM_TABLE_COLUMNS] = {"id", "username", "email"};
+    constexpr size_t USERS_MAX_LENGTH[NUM_TABLE_COLUMNS] = {0, COLUMN_USERNAME_SIZE - 1, COLUMN_EMAIL_SIZE - 1};
+
+    // The first ',', '"' or '\n' in [p, end), or end
+    const char* findDelimiter(const char* p, const char* end) {
+#if defined(__SSE2__)
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; end - p >= 16; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, quote)),
+                                        _mm_cmpeq_epi8(block, newline));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0) {
+                return p + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+        }
+#endif
+        while (p < end && *p != ',' && *p != '"' && *p != '\n') {
+            p++;
+        }
+        return p;
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = (a[i] >= 'A' && a[i] <= 'Z') ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            char y = (b[i] >= 'A' && b[i] <= 'Z') ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+            if (x != y) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+    Splits the line at p into numColumns fields and returns the start of the
+    next line. Fields point into the file, except quoted ones holding "",
+    which are copied without the doubled quotes into unquoted (a string per
+    field, so that the views stay put). Throws std::invalid_argument for a
+    malformed line or another number of fields.
+    */
+    const char* splitLine(const char* p, const char* end, size_t numColumns, std::vector<std::string_view>& fields,
+                          std::vector<std::string>& unquoted) {
+        fields.clear();
+        while (true) {
+            if (fields.size() == numColumns) {
+                throw std::invalid_argument("more than " + std::to_string(numColumns) + " fields");
+            }
+            if (p < end && *p == '"') {
+                const char* start = p + 1;
+                const char* q = start;
+                std::string& text = unquoted[fields.size()];
+                bool escaped = false;
+                while (true) {
+                    q = findDelimiter(q, end);
+                    if (q == end || *q == '\n') {
+                        throw std::invalid_argument("quoted field not closed on its line");
+                    }
+                    if (*q == ',') {
+                        q++;
+                    } else if (q + 1 < end && q[1] == '"') {
+                        // "" stands for one quote
+                        if (!escaped) {
+                            text.clear();
+                            escaped = true;
+                        }
+                        text.append(start, q + 1);
+                        q += 2;
+                        start = q;
+                    } else {
+                        break;
+                    }
+                }
+                if (escaped) {
+                    text.append(start, q);
+                    fields.push_back(text);
+                } else {
+                    fields.emplace_back(start, static_cast<size_t>(q - start));
+                }
+                p = q + 1;
+                if (p < end && *p == '\r' && (p + 1 == end || p[1] == '\n')) {
+                    p++;
+                }
+            } else {
+                const char* q = findDelimiter(p, end);
+                if (q < end && *q == '"') {
+                    throw std::invalid_argument("quote inside an unquoted field");
+                }
+                size_t length = static_cast<size_t>(q - p);
+                if (length > 0 && p[length - 1] == '\r' && (q == end || *q == '\n')) {
+                    length--;
+                }
+                fields.emplace_back(p, length);
+                p = q;
+            }
+            if (p == end || *p == '\n') {
+                break;
+            }
+            if (*p != ',') {
+                throw std::invalid_argument("text after a quoted field");
+            }
+            p++;
+        }
+        if (fields.size() != numColumns) {
+            throw std::invalid_argument(std::to_string(fields.size()) + " fields, not " + std::to_string(numColumns));
+        }
+        return p == end ? end : p + 1;
+    }
+
+    template <typename Integer>
+    bool parseInteger(std::string_view text, Integer& value) {
+        const char* end = text.data() + text.size();
+        auto result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    // Rows of one chunk, and the first line that failed
+    struct ChunkResult {
+        std::vector<uint8_t> cells;                                  // users: serialized Rows
+        std::vector<std::pair<uint32_t, const uint8_t*>> userRows;   // users: (id, cell), sorted
+        std::vector<std::pair<std::string, std::vector<Field>>> schemaRows;  // CREATE TABLE: (key, row), sorted
+        uint64_t lines = 0;
+        uint64_t errorLine = 0;  // within the chunk, from 1; 0 = none
+        std::string error;
+    };
+
+    // Writes a users row straight into its serialized form, zero-padded like Row's
+    void appendUserRow(const std::vector<std::string_view>& fields, std::vector<uint8_t>& cells) {
+        uint32_t id;
+        if (!fields[COLUMN_ID].empty() && fields[COLUMN_ID][0] == '-') {
+            throw std::invalid_argument("Row ID cannot be negative");
+        }
+        if (!parseInteger(fields[COLUMN_ID], id)) {
+            throw std::invalid_argument("id needs an integer up to " + std::to_string(UINT32_MAX) + ", not '" +
+                                        std::string(fields[COLUMN_ID]) + "'");
+        }
+        for (uint32_t column = COLUMN_USERNAME; column < NUM_TABLE_COLUMNS; column++) {
+            if (fields[column].size() > USERS_MAX_LENGTH[column]) {
+                throw std::invalid_argument(std::string(USERS_COLUMNS[column]) + " is longer than " +
+                                            std::to_string(USERS_MAX_LENGTH[column]) + " characters");
+            }
+        }
+        size_t offset = cells.size();
+        cells.resize(offset + ROW_SIZE_BYTES, 0);
+        uint8_t* cell = cells.data() + offset;
+        std::memcpy(cell, &id, sizeof(id));
+        std::memcpy(cell + Row::getUsernameOffset(), fields[COLUMN_USERNAME].data(), fields[COLUMN_USERNAME].size());
+        std::memcpy(cell + Row::getEmailOffset(), fields[COLUMN_EMAIL].data(), fields[COLUMN_EMAIL].size());
+    }
+
+    // A field of a CREATE TABLE row, checked as INSERT checks a literal
+    Field fieldOf(std::string_view text, const ColumnSchema& column) {
+        Field field;
+        switch (column.type) {
+            case ColumnType::INT:
+            case ColumnType::BIGINT:
+                if (!parseInteger(text, field.integer)) {
+                    throw std::invalid_argument(column.name + " needs an integer, not '" + std::string(text) + "'");
+                }
+                if (column.type == ColumnType::INT && (field.integer < INT32_MIN || field.integer > INT32_MAX)) {
+                    throw std::invalid_argument(column.name + " is out of range for an INT column");
+                }
+                break;
+            case ColumnType::DOUBLE: {
+                std::string number(text);
+                char* end = nullptr;
+                field.real = std::strtod(number.c_str(), &end);
+                if (number.empty() || *end != '\0') {
+                    throw std::invalid_argument(column.name + " needs a number, not '" + number + "'");
+                }
+                break;
+            }
+            default:
+                if (column.size != 0 && text.size() > column.size) {
+                    throw std::invalid_argument(column.name + " is longer than " + std::to_string(column.size) +
+                                                " bytes");
+                }
+                field.bytes.assign(text);
+        }
+        return field;
+    }
+
+    bool isHeader(const std::vector<std::string_view>& fields, const std::vector<std::string_view>& columnNames) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (!equalsIgnoreCase(fields[i], columnNames[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parses [begin, end), which starts a line and ends after one; sorts the
+    // rows by key. schemaTable is null for users. Stops at the first bad line.
+    void parseChunk(const char* begin, const char* end, bool startsFile, const SchemaTable* schemaTable,
+                    const std::vector<std::string_view>& columnNames, ChunkResult& result) {
+        size_t numColumns = columnNames.size();
+        std::vector<std::string_view> fields;
+        fields.reserve(numColumns);
+        std::vector<std::string> unquoted(numColumns);
+        const char* p = begin;
+        while (p < end) {
+            result.lines++;
+            if (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] == '\n'))) {
+                p += (*p == '\r' && p + 1 < end) ? 2 : 1;
+                continue;
+            }
+            try {
+                p = splitLine(p, end, numColumns, fields, unquoted);
+                if (startsFile && result.lines == 1 && isHeader(fields, columnNames)) {
+                    continue;
+                }
+                if (schemaTable == nullptr) {
+                    appendUserRow(fields, result.cells);
+                    continue;
+                }
+                std::vector<Field> row;
+                row.reserve(numColumns);
+                for (size_t i = 0; i < numColumns; i++) {
+                    row.push_back(fieldOf(fields[i], schemaTable->getSchema().getColumns()[i]));
+                }
+                std::string key = schemaTable->keyOf(row);
+                result.schemaRows.emplace_back(std::move(key), std::move(row));
+            } catch (const std::invalid_argument& e) {
+                result.errorLine = result.lines;
+                result.error = e.what();
+                return;
+            }
+        }
+        // cells stop moving once every row is in
+        for (size_t offset = 0; offset < result.cells.size(); offset += ROW_SIZE_BYTES) {
+            uint32_t id;
+            std::memcpy(&id, result.cells.data() + offset, sizeof(id));
+            result.userRows.emplace_back(id, result.cells.data() + offset);
+        }
+        auto byKey = [](const auto& a, const auto& b) { return a.first < b.first; };
+        if (!std::is_sorted(result.userRows.begin(), result.userRows.end(), byKey)) {
+            std::sort(result.userRows.begin(), result.userRows.end(), byKey);
+        }
+        if (!std::is_sorted(result.schemaRows.begin(), result.schemaRows.end(), byKey)) {
+            std::sort(result.schemaRows.begin(), result.schemaRows.end(), byKey);
+        }
+    }
+
+    // Concatenates the chunks' sorted runs into one sorted sequence, merging
+    // neighbouring runs pairwise; runs already in order (a file sorted by key)
+    // are only appended
+    template <typename Entry>
+    std::vector<Entry> mergeRuns(std::vector<ChunkResult>& chunks, std::vector<Entry> ChunkResult::*runs) {
+        std::vector<Entry> all;
+        std::vector<size_t> bounds{0};
+        size_t total = 0;
+        for (ChunkResult& chunk : chunks) {
+            total += (chunk.*runs).size();
+        }
+        all.reserve(total);
+        for (ChunkResult& chunk : chunks) {
+            std::move((chunk.*runs).begin(), (chunk.*runs).end(), std::back_inserter(all));
+            bounds.push_back(all.size());
+        }
+        auto byKey = [](const Entry& a, const Entry& b) { return a.first < b.first; };
+        for (size_t width = 1; width + 1 < bounds.size(); width *= 2) {
+            for (size_t i = 0; i + width + 1 < bounds.size(); i += 2 * width) {
+                auto first = all.begin() + bounds[i];
+                auto middle = all.begin() + bounds[i + width];
+                auto last = all.begin() + bounds[std::min(i + 2 * width, bounds.size() - 1)];
+                if (first != middle && middle != last && byKey(*middle, *(middle - 1))) {
+                    std::inplace_merge(first, middle, last, byKey);
+                }
+            }
+        }
+        return all;
+    }
+
+    ImportResult load(Table& table, std::string_view text, std::string_view tableName, size_t chunkBytes) {
+        SchemaTable* schemaTable = nullptr;
+        std::vector<std::string_view> columnNames(std::begin(USERS_COLUMNS), std::end(USERS_COLUMNS));
+        if (!equalsIgnoreCase(tableName, USERS_TABLE_NAME)) {
+            schemaTable = table.getSchemaTable(tableName);
+            if (schemaTable == nullptr) {
+                throw std::invalid_argument("No such table: " + std::string(tableName));
+            }
+            columnNames.clear();
+            for (const ColumnSchema& column : schemaTable->getSchema().getColumns()) {
+                columnNames.push_back(column.name);
+            }
+        }
+
+        // chunk c starts at the line after byte c * chunkBytes; empty if a line spans the whole piece
+        std::vector<const char*> starts{text.data()};
+        const char* fileEnd = text.data() + text.size();
+        for (size_t offset = chunkBytes; offset < text.size(); offset += chunkBytes) {
+            const void* lineEnd = std::memchr(text.data() + offset - 1, '\n', text.size() - offset + 1);
+            starts.push_back(lineEnd == nullptr ? fileEnd : std::max(starts.back(), static_cast<const char*>(lineEnd) + 1));
+        }
+        starts.push_back(fileEnd);
+        uint32_t numChunks = static_cast<uint32_t>(starts.size() - 1);
+
+        std::vector<ChunkResult> chunks(numChunks);
+        auto parse = [&](uint32_t c) {
+            parseChunk(starts[c], starts[c + 1], c == 0, schemaTable, columnNames, chunks[c]);
+        };
+        if (Scheduler* scheduler = table.getScheduler()) {
+            scheduler->parallelFor(numChunks, parse);
+        } else {
+            for (uint32_t c = 0; c < numChunks; c++) {
+                parse(c);
+            }
+        }
+        uint64_t linesBefore = 0;
+        for (const ChunkResult& chunk : chunks) {
+            if (chunk.errorLine != 0) {
+                throw std::invalid_argument("line " + std::to_string(linesBefore + chunk.errorLine) + ": " +
+                                            chunk.error);
+            }
+            linesBefore += chunk.lines;
+        }
+
+        ImportResult result;
+        result.bytes = text.size();
+        result.chunks = numChunks;
+        if (schemaTable != nullptr) {
+            auto rows = mergeRuns(chunks, &ChunkResult::schemaRows);
+            for (const auto& row : rows) {
+                schemaTable->insertRow(row.second);
+            }
+            result.rows = rows.size();
+            return result;
+        }
+        auto keyed = mergeRuns(chunks, &ChunkResult::userRows);
+        std::vector<const uint8_t*> rows;
+        rows.reserve(keyed.size());
+        for (size_t i = 0; i < keyed.size(); i++) {
+            if (i > 0 && keyed[i].first == keyed[i - 1].first) {
+                throw std::invalid_argument("Duplicate key " + std::to_string(keyed[i].first));
+            }
+            rows.push_back(keyed[i].second);
+        }
+        try {
+            result.bulkLoaded = table.bulkLoad(rows);
+        } catch (const std::invalid_argument& e) {
+            // insertRow's duplicate key, in a table that had rows already
+            throw std::invalid_argument(std::string(e.what()) + " (a row in the file has an id already in " +
+                                        std::string(USERS_TABLE_NAME) + ")");
+        }
+        result.rows = rows.size();
+        return result;
+    }
+}
+
+ImportResult importCsv(Table& table, const std::string& path, std::string_view tableName, size_t chunkBytes) {
+    MappedFile file(path);
+    bool autocommit = !table.inTransaction();
+    if (autocommit) {
+        table.beginTransaction();
+    } else {
+        table.savepoint();
+    }
+    ImportResult result;
+    try {
+        result = load(table, file.getText(), tableName, std::max<size_t>(chunkBytes, 1));
+    } catch (...) {
+        autocommit ? table.rollbackTransaction() : table.rollbackToSavepoint();
+        throw;
+    }
+    autocommit ? table.commitTransaction() : table.releaseSavepoint();
+    return result;
+}
@@ -1,7 +1,16 @@
 #include "cursor.hpp"
 #include "node.hpp"
+#include "hash_index.hpp"
 
 Cursor::Cursor(Table& table, uint32_t key) : table(table), endOfTable(false) {
+    // an indexed key goes straight to its leaf
+    uint32_t leafPageNum;
+    const HashIndex* hashIndex = table.getHashIndex();
+    if (hashIndex != nullptr && hashIndex->find(key, leafPageNum)) {
+        leafNodeFind(key, leafPageNum);
+        return;
+    }
+
     // Start at root page
     uint32_t rootPageNum = table.getRootPageNum();
     uint8_t* nodeData = table.getPageAddress(rootPageNum);
@@ -38,23 +47,8 @@ void Cursor::leafNodeFind(uint32_t key, uint32_t pageNum) {
         return;
     }
 
-    uint32_t minIndex = 0;
-    uint32_t onePastMaxIndex = *node.leafNodeNumCells();
-    // binary search inside of leaf node to find key OR insertion position
-    while (minIndex < onePastMaxIndex) { 
-        uint32_t currentIndex = (minIndex + onePastMaxIndex) / 2;
-        uint32_t currentKey = *node.leafNodeKey(currentIndex);
-        if (currentKey == key) {
-            this->cellNum = currentIndex;
-            return;
-        } else if (currentKey < key) {
-            minIndex = currentIndex + 1;
-        } else {
-            onePastMaxIndex = currentIndex;
-        }
-    }
     // if key is not found, cellNum will point to its insertion position; follows BST property
-    this->cellNum = minIndex;
+    this->cellNum = node.leafNodeFind(key);
 }
 
 void Cursor::internalNodeFind(uint32_t key, uint32_t pageNum) {
@@ -102,20 +96,26 @@ void* Cursor::cursorSlot() {
 
 void Cursor::cursorAdvance() {
     cellNum += 1;
-    uint8_t* nodeData = table.getPageAddress(pageNum);
-    Node node(nodeData);
-    uint32_t numCells = *node.leafNodeNumCells();
+    skipExhaustedLeaves();
+}
 
-    if (cellNum >= numCells) {
-        // advance to next leaf node 
+// Deletes can leave leaves empty, so keep following siblings until a leaf has a cell
+void Cursor::skipExhaustedLeaves() {
+    while (true) {
+        uint8_t* nodeData = table.getPageAddress(pageNum);
+        Node node(nodeData);
+        if (cellNum < *node.leafNodeNumCells()) {
+            endOfTable = false;
+            return;
+        }
+        // advance to next leaf node
         uint32_t rightSibling = *node.leafNodeRightSibling();
         if (rightSibling == 0) {
             endOfTable = true;
-        } else {
-            pageNum = rightSibling;
-            cellNum = 0;
-            endOfTable = false;
+            return;
         }
+        pageNum = rightSibling;
+        cellNum = 0;
     }
 }
 
@@ -127,11 +127,8 @@ void Cursor::findLeftmostLeaf(uint32_t startPageNum) {
     // If it's a leaf, we're done
     if (node.getNodeType() == NodeType::NODE_LEAF) {
         pageNum = startPageNum;
-        // Check if table is empty
-        if (*node.leafNodeNumCells() == 0) {
-            endOfTable = true;
-        }
-
+        // Check if table is empty (or its first leaves were emptied by deletes)
+        skipExhaustedLeaves();
         return;
     }
     
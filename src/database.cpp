@@ -0,0 +1,14 @@
+#include "database.hpp"
+
+Database::Database(const std::string& filename, const DatabaseOptions& options)
+    : scheduler(options.maxWorkerThreads), table(filename, options.cachePages, options.compressPages),
+      flusher(table.getPager(), scheduler, options.flusher) {
+    table.setScheduler(&scheduler);
+    flusher.start();
+}
+
+Database::~Database() {
+    // background tasks may still reference the table
+    flusher.stop();
+    scheduler.shutdown();
+}
@@ -0,0 +1,287 @@
+#include "external_sort.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+    // Frames cached for a spill file: one page per run being merged plus the
+    // one being written is all the access pattern needs
+    constexpr uint32_t SPILL_CACHE_PAGES = 256;
+    constexpr uint32_t SEQUENCE_SIZE = sizeof(uint64_t);
+    constexpr uint32_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);  // key length, payload length
+
+    void appendBigEndian(std::string& key, uint64_t value, bool invert) {
+        if (invert) {
+            value = ~value;
+        }
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            key.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    uint64_t loadPrefix(const uint8_t* key) {
+        uint64_t prefix = 0;
+        for (uint32_t i = 0; i < sizeof(uint64_t); i++) {
+            prefix = (prefix << 8) | key[i];
+        }
+        return prefix;
+    }
+
+    int compareKeys(std::string_view a, std::string_view b) {
+        int result = std::memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+        if (result != 0) {
+            return result;
+        }
+        return (a.size() > b.size()) - (a.size() < b.size());
+    }
+}
+
+void appendSortKey(std::string& key, int64_t value, bool descending) {
+    appendBigEndian(key, static_cast<uint64_t>(value) ^ (1ull << 63), descending);
+}
+
+void appendSortKey(std::string& key, std::string_view value, bool descending) {
+    size_t start = key.size();
+    if (std::memchr(value.data(), '\0', value.size()) == nullptr) {
+        key.append(value);
+    } else {
+        for (char c : value) {
+            key.push_back(c);
+            if (c == '\0') {
+                key.push_back('\xff');
+            }
+        }
+    }
+    key.append(2, '\0');
+    if (descending) {
+        for (size_t i = start; i < key.size(); i++) {
+            key[i] = static_cast<char>(~key[i]);
+        }
+    }
+}
+
+SpillFile::SpillFile() : size(0) {
+    const char* directory = std::getenv("TMPDIR");
+    std::string path = std::string(directory != nullptr && *directory != '\0' ? directory : "/tmp") +
+                       "/sql_liter_sort_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        throw std::runtime_error("could not create a temporary file for sorting");
+    }
+    close(fd);
+    pager = std::make_unique<Pager>(path, SPILL_CACHE_PAGES);
+    unlink(path.c_str());
+}
+
+// Moves bytes between data and the file, a page at a time; no page pointer
+// outlives its memcpy, so the pager may evict before each page
+void SpillFile::copy(uint64_t offset, uint8_t* data, size_t length, bool write) {
+    while (length > 0) {
+        uint32_t pageNum = static_cast<uint32_t>(offset / PAGE_SIZE);
+        uint32_t pageOffset = static_cast<uint32_t>(offset % PAGE_SIZE);
+        size_t chunk = std::min<size_t>(length, PAGE_SIZE - pageOffset);
+        pager->evictToCapacity();
+        if (write) {
+            std::memcpy(pager->getPageForWrite(pageNum) + pageOffset, data, chunk);
+        } else {
+            std::memcpy(data, pager->getPage(pageNum) + pageOffset, chunk);
+        }
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+uint64_t SpillFile::append(const void* data, size_t length) {
+    if (size + length > static_cast<uint64_t>(TABLE_MAX_PAGES) * PAGE_SIZE) {
+        throw std::runtime_error("sort needs more temporary space than a spill file holds");
+    }
+    uint64_t offset = size;
+    copy(offset, static_cast<uint8_t*>(const_cast<void*>(data)), length, true);
+    size += length;
+    return offset;
+}
+
+void SpillFile::read(uint64_t offset, void* data, size_t length) {
+    copy(offset, static_cast<uint8_t*>(data), length, false);
+}
+
+ExternalSorter::ExternalSorter(size_t memoryBudget, uint64_t limit)
+    : memoryBudget(std::min<size_t>(memoryBudget, UINT32_MAX)), limit(limit), sequence(0), emitted(0),
+      finished(false), lastRun(UINT32_MAX) {}
+
+void ExternalSorter::add(std::string_view key, std::string_view payload) {
+    if (limit == 0) {
+        return;
+    }
+    // the sequence number makes ties resolve in insertion order
+    scratch.assign(key);
+    appendBigEndian(scratch, sequence++, false);
+    uint32_t keyLength = static_cast<uint32_t>(scratch.size());
+
+    if (bounded()) {
+        auto byKey = [](const Record& a, const Record& b) {
+            return compareKeys(std::string_view(a.bytes.data(), a.keyLength),
+                               std::string_view(b.bytes.data(), b.keyLength)) < 0;
+        };
+        if (topN.size() == limit) {
+            const Record& largest = topN.front();
+            if (compareKeys(scratch, std::string_view(largest.bytes.data(), largest.keyLength)) >= 0) {
+                return;
+            }
+            // reuse the evicted record's storage
+            std::pop_heap(topN.begin(), topN.end(), byKey);
+        } else {
+            topN.emplace_back();
+        }
+        Record& record = topN.back();
+        record.bytes.assign(scratch);
+        record.bytes.append(payload);
+        record.keyLength = keyLength;
+        std::push_heap(topN.begin(), topN.end(), byKey);
+        return;
+    }
+
+    size_t recordSize = keyLength + payload.size();
+    if (!entries.empty() &&
+        buffer.size() + recordSize + (entries.size() + 1) * sizeof(Entry) > memoryBudget) {
+        spillBuffer();
+    }
+    Entry entry{loadPrefix(reinterpret_cast<const uint8_t*>(scratch.data())), static_cast<uint32_t>(buffer.size()),
+                keyLength, static_cast<uint32_t>(payload.size())};
+    buffer.insert(buffer.end(), scratch.begin(), scratch.end());
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+    entries.push_back(entry);
+}
+
+void ExternalSorter::sortBuffer() {
+    const uint8_t* bytes = buffer.data();
+    std::sort(entries.begin(), entries.end(), [bytes](const Entry& a, const Entry& b) {
+        if (a.prefix != b.prefix) {
+            return a.prefix < b.prefix;
+        }
+        // every key is at least the 8-byte sequence number long, so the prefix was all real bytes
+        return compareKeys(std::string_view(reinterpret_cast<const char*>(bytes) + a.offset + SEQUENCE_SIZE,
+                                            a.keyLength - SEQUENCE_SIZE),
+                           std::string_view(reinterpret_cast<const char*>(bytes) + b.offset + SEQUENCE_SIZE,
+                                            b.keyLength - SEQUENCE_SIZE)) < 0;
+    });
+}
+
+// Writes the buffered records out as one sorted run: header, key, payload per record
+void ExternalSorter::spillBuffer() {
+    if (!spill) {
+        spill = std::make_unique<SpillFile>();
+    }
+    sortBuffer();
+    Run run{spill->getSize(), 0, Record()};
+    for (const Entry& entry : entries) {
+        uint32_t header[2] = {entry.keyLength, entry.payloadLength};
+        spill->append(header, RECORD_HEADER_SIZE);
+        spill->append(buffer.data() + entry.offset, entry.keyLength + entry.payloadLength);
+    }
+    run.end = spill->getSize();
+    runs.push_back(std::move(run));
+    buffer.clear();
+    entries.clear();
+}
+
+bool ExternalSorter::readRecord(Run& run) {
+    if (run.position >= run.end) {
+        return false;
+    }
+    uint32_t header[2];
+    spill->read(run.position, header, RECORD_HEADER_SIZE);
+    run.current.keyLength = header[0];
+    run.current.bytes.resize(header[0] + header[1]);
+    spill->read(run.position + RECORD_HEADER_SIZE, &run.current.bytes[0], run.current.bytes.size());
+    run.position += RECORD_HEADER_SIZE + run.current.bytes.size();
+    return true;
+}
+
+void ExternalSorter::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    if (bounded()) {
+        std::sort(topN.begin(), topN.end(), [](const Record& a, const Record& b) {
+            return compareKeys(std::string_view(a.bytes.data(), a.keyLength),
+                               std::string_view(b.bytes.data(), b.keyLength)) < 0;
+        });
+        return;
+    }
+    if (runs.empty()) {
+        sortBuffer();
+        return;
+    }
+    if (!entries.empty()) {
+        spillBuffer();
+    }
+    buffer.shrink_to_fit();
+    entries.shrink_to_fit();
+    for (uint32_t i = 0; i < runs.size(); i++) {
+        if (readRecord(runs[i])) {
+            merge.push_back(i);
+        }
+    }
+    std::make_heap(merge.begin(), merge.end(), [this](uint32_t a, uint32_t b) {
+        return compareKeys(std::string_view(runs[a].current.bytes.data(), runs[a].current.keyLength),
+                           std::string_view(runs[b].current.bytes.data(), runs[b].current.keyLength)) > 0;
+    });
+}
+
+bool ExternalSorter::next(std::string_view& key, std::string_view& payload) {
+    finish();
+    if (emitted >= limit) {
+        return false;
+    }
+    const char* bytes = nullptr;
+    uint32_t keyLength = 0;
+    size_t length = 0;
+    if (bounded()) {
+        if (emitted >= topN.size()) {
+            return false;
+        }
+        const Record& record = topN[emitted];
+        bytes = record.bytes.data();
+        keyLength = record.keyLength;
+        length = record.bytes.size();
+    } else if (runs.empty()) {
+        if (emitted >= entries.size()) {
+            return false;
+        }
+        const Entry& entry = entries[emitted];
+        bytes = reinterpret_cast<const char*>(buffer.data()) + entry.offset;
+        keyLength = entry.keyLength;
+        length = entry.keyLength + entry.payloadLength;
+    } else {
+        auto greater = [this](uint32_t a, uint32_t b) {
+            return compareKeys(std::string_view(runs[a].current.bytes.data(), runs[a].current.keyLength),
+                               std::string_view(runs[b].current.bytes.data(), runs[b].current.keyLength)) > 0;
+        };
+        // the run returned last time can move on now that its record is no longer in use
+        if (lastRun != UINT32_MAX && readRecord(runs[lastRun])) {
+            merge.push_back(lastRun);
+            std::push_heap(merge.begin(), merge.end(), greater);
+        }
+        lastRun = UINT32_MAX;
+        if (merge.empty()) {
+            return false;
+        }
+        std::pop_heap(merge.begin(), merge.end(), greater);
+        lastRun = merge.back();
+        merge.pop_back();
+        const Record& record = runs[lastRun].current;
+        bytes = record.bytes.data();
+        keyLength = record.keyLength;
+        length = record.bytes.size();
+    }
+    emitted++;
+    key = std::string_view(bytes, keyLength - SEQUENCE_SIZE);
+    payload = std::string_view(bytes + keyLength, length - keyLength);
+    return true;
+}
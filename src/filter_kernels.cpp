@@ -0,0 +1,208 @@
+#include "filter_kernels.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr uint32_t CHUNK = 16;
+
+    // field[0, n) == pattern[0, n). field has available readable bytes;
+    // pattern is padded so it can always be read in whole chunks.
+    bool bytesEqual(const char* field, const char* pattern, uint32_t n, uint32_t available) {
+#if defined(__SSE2__)
+        uint32_t i = 0;
+        for (; i + CHUNK <= n; i += CHUNK) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) {
+                return false;
+            }
+        }
+        if (i == n) {
+            return true;
+        }
+        if (i + CHUNK <= available) {
+            // one more full load, ignoring the bytes past n
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+            uint32_t tailMask = (1u << (n - i)) - 1;
+            return (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & tailMask) == tailMask;
+        }
+        return std::memcmp(field + i, pattern + i, n - i) == 0;
+#else
+        (void)available;
+        return std::memcmp(field, pattern, n) == 0;
+#endif
+    }
+
+    template <typename Test>
+    uint32_t compact(const uint8_t* cells, uint32_t cellStride, uint32_t fieldOffset, uint32_t* selection,
+                     uint32_t count, Test test) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t cell = selection[i];
+            selection[kept] = cell;
+            kept += test(reinterpret_cast<const char*>(cells + cell * cellStride + fieldOffset));
+        }
+        return kept;
+    }
+}
+
+uint32_t fieldLength(const char* field, uint32_t size) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t i = 0;
+    for (; i + CHUNK <= size; i += CHUNK) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(field + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+        if (mask != 0) {
+            return i + static_cast<uint32_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+    const void* end = std::memchr(field + i, 0, size - i);
+    return end == nullptr ? size : static_cast<uint32_t>(static_cast<const char*>(end) - field);
+#else
+    const void* end = std::memchr(field, 0, size);
+    return end == nullptr ? size : static_cast<uint32_t>(static_cast<const char*>(end) - field);
+#endif
+}
+
+bool makeFieldFilter(FieldMatch match, uint32_t fieldOffset, uint32_t fieldSize, std::string_view pattern,
+                     FieldFilter& filter) {
+    // a stored value is at most fieldSize - 1 bytes, followed by zeros
+    if (match == FieldMatch::EQUALS && pattern.size() >= fieldSize) {
+        return false;
+    }
+    filter.match = match;
+    filter.fieldOffset = fieldOffset;
+    filter.fieldSize = fieldSize;
+    filter.patternLength = static_cast<uint32_t>(pattern.size());
+    filter.pattern.assign(pattern.data(), pattern.size());
+    filter.pattern.resize(std::max<size_t>(pattern.size(), fieldSize) + CHUNK, '\0');
+    return true;
+}
+
+uint32_t applyFieldFilter(const FieldFilter& filter, const uint8_t* cells, uint32_t cellStride, uint32_t* selection,
+                          uint32_t count) {
+    const char* pattern = filter.pattern.data();
+    uint32_t length = filter.patternLength;
+    uint32_t size = filter.fieldSize;
+    switch (filter.match) {
+        case FieldMatch::EQUALS:
+            // the value and its terminating zero; the padding after it is zero on both sides
+            return compact(cells, cellStride, filter.fieldOffset, selection, count,
+                           [&](const char* field) { return bytesEqual(field, pattern, length + 1, size); });
+        case FieldMatch::PREFIX:
+            if (length >= size) {
+                return 0;
+            }
+            return compact(cells, cellStride, filter.fieldOffset, selection, count,
+                           [&](const char* field) { return bytesEqual(field, pattern, length, size); });
+        case FieldMatch::SUFFIX:
+            return compact(cells, cellStride, filter.fieldOffset, selection, count, [&](const char* field) {
+                uint32_t fieldLen = fieldLength(field, size);
+                return fieldLen >= length && std::memcmp(field + fieldLen - length, pattern, length) == 0;
+            });
+        case FieldMatch::CONTAINS:
+            return compact(cells, cellStride, filter.fieldOffset, selection, count, [&](const char* field) {
+                std::string_view text(field, fieldLength(field, size));
+                return text.find(std::string_view(pattern, length)) != std::string_view::npos;
+            });
+    }
+    return count;
+}
+
+uint32_t applyTextFilter(const FieldFilter& filter, const char* bytes, const uint32_t* ends, uint32_t* selection,
+                         uint32_t count) {
+    std::string_view pattern(filter.pattern.data(), filter.patternLength);
+    auto keep = [&](auto test) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t row = selection[i];
+            uint32_t begin = row == 0 ? 0 : ends[row - 1];
+            selection[kept] = row;
+            kept += test(std::string_view(bytes + begin, ends[row] - begin));
+        }
+        return kept;
+    };
+    switch (filter.match) {
+        case FieldMatch::EQUALS:
+            return keep([&](std::string_view text) { return text == pattern; });
+        case FieldMatch::PREFIX:
+            return keep([&](std::string_view text) { return text.substr(0, pattern.size()) == pattern; });
+        case FieldMatch::SUFFIX:
+            return keep([&](std::string_view text) {
+                return text.size() >= pattern.size() && text.substr(text.size() - pattern.size()) == pattern;
+            });
+        case FieldMatch::CONTAINS:
+            return keep([&](std::string_view text) { return text.find(pattern) != std::string_view::npos; });
+    }
+    return count;
+}
+
+bool textRangeMayMatch(const FieldFilter& filter, std::string_view min, std::string_view max) {
+    std::string_view pattern(filter.pattern.data(), filter.patternLength);
+    switch (filter.match) {
+        case FieldMatch::EQUALS:
+            return min <= pattern && pattern <= max;
+        case FieldMatch::PREFIX:
+            // the values starting with pattern sort together, from pattern itself up
+            return pattern <= max && min.substr(0, pattern.size()) <= pattern;
+        default:
+            return true;
+    }
+}
+
+bool likeMatch(std::string_view text, std::string_view pattern) {
+    // greedy matching that backtracks to the most recent % only
+    size_t t = 0;
+    size_t p = 0;
+    size_t starPattern = std::string_view::npos;
+    size_t starText = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == text[t])) {
+            t++;
+            p++;
+        } else if (p < pattern.size() && pattern[p] == '%') {
+            starPattern = p++;
+            starText = t;
+        } else if (starPattern != std::string_view::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '%') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+bool classifyLike(std::string_view pattern, FieldMatch& match, std::string_view& literal) {
+    bool leading = !pattern.empty() && pattern.front() == '%';
+    if (leading) {
+        pattern.remove_prefix(1);
+    }
+    bool trailing = !pattern.empty() && pattern.back() == '%';
+    if (trailing) {
+        pattern.remove_suffix(1);
+    }
+    if (pattern.find_first_of("%_") != std::string_view::npos) {
+        return false;
+    }
+    literal = pattern;
+    if (leading && trailing) {
+        match = FieldMatch::CONTAINS;
+    } else if (leading) {
+        match = FieldMatch::SUFFIX;
+    } else if (trailing) {
+        match = FieldMatch::PREFIX;
+    } else {
+        match = FieldMatch::EQUALS;
+    }
+    return true;
+}
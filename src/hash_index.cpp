@@ -0,0 +1,205 @@
+#include "hash_index.hpp"
+
+#include <cstring>
+#include <utility>
+
+#include "table.hpp"
+
+namespace {
+    uint32_t* field(uint8_t* page, uint32_t offset) {
+        return reinterpret_cast<uint32_t*>(page + offset);
+    }
+
+    uint32_t read(const uint8_t* page, uint32_t offset) {
+        return *reinterpret_cast<const uint32_t*>(page + offset);
+    }
+
+    // Entry i of a bucket page: the key, then the leaf page
+    uint32_t* entry(uint8_t* page, uint32_t i) {
+        return field(page, HASH_BUCKET_HEADER_SIZE + i * HASH_ENTRY_SIZE);
+    }
+
+    const uint32_t* entry(const uint8_t* page, uint32_t i) {
+        return reinterpret_cast<const uint32_t*>(page + HASH_BUCKET_HEADER_SIZE + i * HASH_ENTRY_SIZE);
+    }
+
+    // Ids are often sequential, and buckets are picked by the low bits
+    uint32_t hashKey(uint32_t key) {
+        key ^= key >> 16;
+        key *= 0x7feb352dU;
+        key ^= key >> 15;
+        key *= 0x846ca68bU;
+        key ^= key >> 16;
+        return key;
+    }
+
+    void initializePage(uint8_t* page, NodeType type) {
+        std::memset(page, 0, PAGE_SIZE);
+        page[NODE_TYPE_OFFSET] = static_cast<uint8_t>(type);
+    }
+}
+
+HashIndex::HashIndex(Table& table, uint32_t headerPageNum) : table(table), headerPageNum(headerPageNum) {
+    const uint8_t* header = table.getPageAddress(headerPageNum);
+    level = read(header, HASH_LEVEL_OFFSET);
+    splitPointer = read(header, HASH_SPLIT_OFFSET);
+    entryCount = read(header, HASH_ENTRIES_OFFSET);
+    uint32_t buckets = read(header, HASH_BUCKETS_OFFSET);
+    bucketPages.reserve(buckets);
+    for (uint32_t pageNum = headerPageNum; pageNum != 0 && bucketPages.size() < buckets;) {
+        const uint8_t* directory = table.getPageAddress(pageNum);
+        directoryPages.push_back(pageNum);
+        for (uint32_t i = 0; i < HASH_DIRECTORY_MAX_BUCKETS && bucketPages.size() < buckets; i++) {
+            bucketPages.push_back(read(directory, HASH_DIRECTORY_HEADER_SIZE + i * sizeof(uint32_t)));
+        }
+        pageNum = read(directory, HASH_NEXT_DIRECTORY_OFFSET);
+    }
+}
+
+void HashIndex::initialize(Table& table, uint32_t pageNum) {
+    uint8_t* header = table.getPageForWrite(pageNum);
+    initializePage(header, NodeType::NODE_HASH_DIRECTORY);
+    uint32_t bucketPageNum = table.getUnusedPageNum();
+    initializePage(table.getPageForWrite(bucketPageNum), NodeType::NODE_HASH_BUCKET);
+    *field(header, HASH_BUCKETS_OFFSET) = 1;
+    *field(header, HASH_DIRECTORY_HEADER_SIZE) = bucketPageNum;
+}
+
+uint32_t HashIndex::bucketOf(uint32_t key) const {
+    uint32_t hash = hashKey(key);
+    uint32_t bucket = hash & ((1u << level) - 1);
+    if (bucket < splitPointer) {
+        bucket = hash & ((2u << level) - 1);
+    }
+    return bucket;
+}
+
+bool HashIndex::find(uint32_t key, uint32_t& leafPageNum) const {
+    for (uint32_t pageNum = bucketPages[bucketOf(key)]; pageNum != 0;) {
+        const uint8_t* page = table.getPageAddress(pageNum);
+        uint32_t count = read(page, HASH_BUCKET_COUNT_OFFSET);
+        for (uint32_t i = 0; i < count; i++) {
+            if (entry(page, i)[0] == key) {
+                leafPageNum = entry(page, i)[1];
+                return true;
+            }
+        }
+        pageNum = read(page, HASH_BUCKET_OVERFLOW_OFFSET);
+    }
+    return false;
+}
+
+void HashIndex::put(uint32_t key, uint32_t leafPageNum) {
+    uint32_t bucket = bucketOf(key);
+    for (uint32_t pageNum = bucketPages[bucket]; pageNum != 0;) {
+        const uint8_t* page = table.getPageAddress(pageNum);
+        uint32_t count = read(page, HASH_BUCKET_COUNT_OFFSET);
+        for (uint32_t i = 0; i < count; i++) {
+            if (entry(page, i)[0] == key) {
+                if (entry(page, i)[1] != leafPageNum) {
+                    entry(table.getPageForWrite(pageNum), i)[1] = leafPageNum;
+                }
+                return;
+            }
+        }
+        pageNum = read(page, HASH_BUCKET_OVERFLOW_OFFSET);
+    }
+    addToBucket(bucket, key, leafPageNum);
+    entryCount++;
+    if (entryCount > HASH_MAX_LOAD * HASH_BUCKET_MAX_ENTRIES * bucketPages.size()) {
+        splitBucket();
+    }
+    saveState();
+}
+
+bool HashIndex::remove(uint32_t key) {
+    for (uint32_t pageNum = bucketPages[bucketOf(key)]; pageNum != 0;) {
+        const uint8_t* page = table.getPageAddress(pageNum);
+        uint32_t count = read(page, HASH_BUCKET_COUNT_OFFSET);
+        for (uint32_t i = 0; i < count; i++) {
+            if (entry(page, i)[0] == key) {
+                // entries are unordered: the page's last one fills the hole
+                uint8_t* writable = table.getPageForWrite(pageNum);
+                std::memcpy(entry(writable, i), entry(writable, count - 1), HASH_ENTRY_SIZE);
+                *field(writable, HASH_BUCKET_COUNT_OFFSET) = count - 1;
+                entryCount--;
+                saveState();
+                return true;
+            }
+        }
+        pageNum = read(page, HASH_BUCKET_OVERFLOW_OFFSET);
+    }
+    return false;
+}
+
+void HashIndex::addToBucket(uint32_t bucket, uint32_t key, uint32_t leafPageNum) {
+    uint32_t pageNum = bucketPages[bucket];
+    while (true) {
+        const uint8_t* page = table.getPageAddress(pageNum);
+        if (read(page, HASH_BUCKET_COUNT_OFFSET) < HASH_BUCKET_MAX_ENTRIES) {
+            break;
+        }
+        uint32_t overflow = read(page, HASH_BUCKET_OVERFLOW_OFFSET);
+        if (overflow == 0) {
+            overflow = table.getUnusedPageNum();
+            initializePage(table.getPageForWrite(overflow), NodeType::NODE_HASH_BUCKET);
+            *field(table.getPageForWrite(pageNum), HASH_BUCKET_OVERFLOW_OFFSET) = overflow;
+        }
+        pageNum = overflow;
+    }
+    uint8_t* page = table.getPageForWrite(pageNum);
+    uint32_t* count = field(page, HASH_BUCKET_COUNT_OFFSET);
+    entry(page, *count)[0] = key;
+    entry(page, *count)[1] = leafPageNum;
+    (*count)++;
+}
+
+// Allocates a page for a new last bucket and records it in the directory
+void HashIndex::appendBucket() {
+    uint32_t bucketPageNum = table.getUnusedPageNum();
+    initializePage(table.getPageForWrite(bucketPageNum), NodeType::NODE_HASH_BUCKET);
+    uint32_t bucket = static_cast<uint32_t>(bucketPages.size());
+    uint32_t directory = bucket / HASH_DIRECTORY_MAX_BUCKETS;
+    if (directory == directoryPages.size()) {
+        uint32_t directoryPageNum = table.getUnusedPageNum();
+        initializePage(table.getPageForWrite(directoryPageNum), NodeType::NODE_HASH_DIRECTORY);
+        *field(table.getPageForWrite(directoryPages.back()), HASH_NEXT_DIRECTORY_OFFSET) = directoryPageNum;
+        directoryPages.push_back(directoryPageNum);
+    }
+    uint8_t* page = table.getPageForWrite(directoryPages[directory]);
+    *field(page, HASH_DIRECTORY_HEADER_SIZE + (bucket % HASH_DIRECTORY_MAX_BUCKETS) * sizeof(uint32_t)) = bucketPageNum;
+    bucketPages.push_back(bucketPageNum);
+}
+
+// Splits the bucket at the split pointer: its entries are redistributed
+// between it and a new bucket by one more bit of their hash. The old chain's
+// pages are kept for reuse.
+void HashIndex::splitBucket() {
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    for (uint32_t pageNum = bucketPages[splitPointer]; pageNum != 0;) {
+        uint8_t* page = table.getPageForWrite(pageNum);
+        uint32_t* count = field(page, HASH_BUCKET_COUNT_OFFSET);
+        for (uint32_t i = 0; i < *count; i++) {
+            entries.emplace_back(entry(page, i)[0], entry(page, i)[1]);
+        }
+        *count = 0;
+        pageNum = read(page, HASH_BUCKET_OVERFLOW_OFFSET);
+    }
+    appendBucket();
+    splitPointer++;
+    if (splitPointer == 1u << level) {
+        level++;
+        splitPointer = 0;
+    }
+    for (const auto& [key, leafPageNum] : entries) {
+        addToBucket(bucketOf(key), key, leafPageNum);
+    }
+}
+
+void HashIndex::saveState() {
+    uint8_t* header = table.getPageForWrite(headerPageNum);
+    *field(header, HASH_LEVEL_OFFSET) = level;
+    *field(header, HASH_SPLIT_OFFSET) = splitPointer;
+    *field(header, HASH_ENTRIES_OFFSET) = entryCount;
+    *field(header, HASH_BUCKETS_OFFSET) = static_cast<uint32_t>(bucketPages.size());
+}
@@ -0,0 +1,309 @@
+#include "index_node.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace {
+    constexpr uint32_t KEY_LENGTH_SIZE = sizeof(uint16_t);
+    constexpr uint32_t PAYLOAD_LENGTH_SIZE = sizeof(uint16_t);
+
+    uint32_t load32(const uint8_t* bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    void store32(uint8_t* bytes, uint32_t value) {
+        std::memcpy(bytes, &value, sizeof(value));
+    }
+
+    uint16_t load16(const uint8_t* bytes) {
+        uint16_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    void store16(uint8_t* bytes, uint16_t value) {
+        std::memcpy(bytes, &value, sizeof(value));
+    }
+
+    // Offset of the field after the row id: the payload length in a leaf cell,
+    // the child page in an internal one
+    uint32_t afterId(const uint8_t* cell) {
+        return KEY_LENGTH_SIZE + load16(cell) + sizeof(uint32_t);
+    }
+
+    uint32_t sharedLength(std::string_view a, std::string_view b) {
+        uint32_t length = 0;
+        uint32_t limit = static_cast<uint32_t>(std::min(a.size(), b.size()));
+        while (length < limit && a[length] == b[length]) {
+            length++;
+        }
+        return length;
+    }
+}
+
+int compareIndexEntries(std::string_view keyA, uint32_t idA, std::string_view keyB, uint32_t idB) {
+    int result = keyA.compare(keyB);
+    if (result != 0) {
+        return result;
+    }
+    return (idA > idB) - (idA < idB);
+}
+
+uint32_t IndexNode::prefixLength() const {
+    return load32(data + INDEX_NODE_PREFIX_LENGTH_OFFSET);
+}
+
+// Padded so the slots stay 2-byte aligned
+uint32_t IndexNode::prefixSpace(uint32_t prefixLength) {
+    return (prefixLength + 1) & ~1u;
+}
+
+uint32_t IndexNode::slotsStart() const {
+    return INDEX_NODE_HEADER_SIZE + prefixSpace(prefixLength());
+}
+
+uint16_t* IndexNode::slot(uint32_t cellNum) const {
+    return reinterpret_cast<uint16_t*>(data + slotsStart() + cellNum * INDEX_NODE_SLOT_SIZE);
+}
+
+const uint8_t* IndexNode::cell(uint32_t cellNum) const {
+    return data + *slot(cellNum);
+}
+
+void IndexNode::initialize(bool leaf, std::string_view keyPrefix) {
+    data[NODE_TYPE_OFFSET] = static_cast<uint8_t>(leaf ? NodeType::NODE_INDEX_LEAF : NodeType::NODE_INDEX_INTERNAL);
+    data[IS_ROOT_OFFSET] = 0;
+    store32(data + INDEX_NODE_NUM_CELLS_OFFSET, 0);
+    store32(data + INDEX_NODE_LINK_OFFSET, leaf ? 0 : INVALID_PAGE_NUM);
+    store32(data + INDEX_NODE_CELLS_START_OFFSET, PAGE_SIZE);
+    store32(data + INDEX_NODE_PREFIX_LENGTH_OFFSET, static_cast<uint32_t>(keyPrefix.size()));
+    std::memcpy(data + INDEX_NODE_HEADER_SIZE, keyPrefix.data(), keyPrefix.size());
+}
+
+bool IndexNode::isLeaf() const {
+    return data[NODE_TYPE_OFFSET] == static_cast<uint8_t>(NodeType::NODE_INDEX_LEAF);
+}
+
+uint32_t IndexNode::numCells() const {
+    return load32(data + INDEX_NODE_NUM_CELLS_OFFSET);
+}
+
+uint32_t* IndexNode::link() {
+    return reinterpret_cast<uint32_t*>(data + INDEX_NODE_LINK_OFFSET);
+}
+
+uint32_t* IndexNode::parent() {
+    return reinterpret_cast<uint32_t*>(data + PARENT_POINTER_OFFSET);
+}
+
+bool IndexNode::isRoot() const {
+    return data[IS_ROOT_OFFSET] != 0;
+}
+
+void IndexNode::setRoot(bool root) {
+    data[IS_ROOT_OFFSET] = root ? 1 : 0;
+}
+
+std::string_view IndexNode::prefix() const {
+    return std::string_view(reinterpret_cast<const char*>(data + INDEX_NODE_HEADER_SIZE), prefixLength());
+}
+
+std::string_view IndexNode::key(uint32_t cellNum) const {
+    const uint8_t* bytes = cell(cellNum);
+    return std::string_view(reinterpret_cast<const char*>(bytes + KEY_LENGTH_SIZE), load16(bytes));
+}
+
+uint32_t IndexNode::id(uint32_t cellNum) const {
+    const uint8_t* bytes = cell(cellNum);
+    return load32(bytes + KEY_LENGTH_SIZE + load16(bytes));
+}
+
+uint32_t IndexNode::child(uint32_t cellNum) const {
+    const uint8_t* bytes = cell(cellNum);
+    return load32(bytes + afterId(bytes));
+}
+
+void IndexNode::setChild(uint32_t cellNum, uint32_t pageNum) {
+    uint8_t* bytes = data + *slot(cellNum);
+    store32(bytes + afterId(bytes), pageNum);
+}
+
+std::string_view IndexNode::payload(uint32_t cellNum) const {
+    const uint8_t* bytes = cell(cellNum);
+    const uint8_t* length = bytes + afterId(bytes);
+    return std::string_view(reinterpret_cast<const char*>(length + PAYLOAD_LENGTH_SIZE), load16(length));
+}
+
+uint32_t IndexNode::childAt(uint32_t childNum) {
+    return childNum == numCells() ? *link() : child(childNum);
+}
+
+uint32_t IndexNode::findChild(uint32_t pageNum) {
+    uint32_t count = numCells();
+    for (uint32_t i = 0; i < count; i++) {
+        if (child(i) == pageNum) {
+            return i;
+        }
+    }
+    return count;
+}
+
+template <typename Keys>
+uint32_t IndexNode::lowerBound(std::string_view searchKey, uint32_t searchId) const {
+    uint32_t low = 0;
+    uint32_t high = numCells();
+    std::string_view keyPrefix = prefix();
+    if (!keyPrefix.empty()) {
+        // a key that does not start with the prefix sorts before or after all of them
+        int result = searchKey.substr(0, keyPrefix.size()).compare(keyPrefix);
+        if (result != 0) {
+            return result < 0 ? low : high;
+        }
+        searchKey.remove_prefix(keyPrefix.size());
+    }
+    typename Keys::Probe probe(searchKey);
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int result = probe.compare(key(middle));
+        if (result == 0) {
+            uint32_t middleId = id(middle);
+            result = (middleId > searchId) - (middleId < searchId);
+        }
+        if (result < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+template uint32_t IndexNode::lowerBound<ByteKeys>(std::string_view, uint32_t) const;
+template uint32_t IndexNode::lowerBound<Fixed8Keys>(std::string_view, uint32_t) const;
+template uint32_t IndexNode::lowerBound<Fixed16Keys>(std::string_view, uint32_t) const;
+
+uint32_t IndexNode::cellSize(bool leaf, uint32_t keyLength, uint32_t payloadLength) {
+    uint32_t base = KEY_LENGTH_SIZE + keyLength + sizeof(uint32_t);
+    return leaf ? base + PAYLOAD_LENGTH_SIZE + payloadLength : base + sizeof(uint32_t);
+}
+
+uint32_t IndexNode::storedSize(const uint8_t* bytes, bool leaf) {
+    return cellSize(leaf, load16(bytes), leaf ? load16(bytes + afterId(bytes)) : 0);
+}
+
+uint32_t IndexNode::usedBytes() const {
+    uint32_t used = 0;
+    uint32_t count = numCells();
+    bool leaf = isLeaf();
+    for (uint32_t i = 0; i < count; i++) {
+        used += storedSize(cell(i), leaf);
+    }
+    return used;
+}
+
+uint32_t IndexNode::freeSpace() const {
+    return PAGE_SIZE - slotsStart() - numCells() * INDEX_NODE_SLOT_SIZE - usedBytes();
+}
+
+// Rewrites the cells back to back at the end of the page, dropping the holes
+void IndexNode::compact() {
+    uint8_t copy[PAGE_SIZE];
+    std::memcpy(copy, data, PAGE_SIZE);
+    uint32_t count = numCells();
+    bool leaf = isLeaf();
+    uint32_t start = PAGE_SIZE;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* source = copy + *slot(i);
+        uint32_t size = storedSize(source, leaf);
+        start -= size;
+        std::memcpy(data + start, source, size);
+        *slot(i) = static_cast<uint16_t>(start);
+    }
+    store32(data + INDEX_NODE_CELLS_START_OFFSET, start);
+}
+
+// Rewrites the cells with the prefix cut to its first length bytes, moving the
+// rest onto each stored key
+void IndexNode::shortenPrefix(uint32_t length) {
+    uint8_t copy[PAGE_SIZE];
+    std::memcpy(copy, data, PAGE_SIZE);
+    IndexNode old(copy);
+    std::string_view oldPrefix = old.prefix();
+    initialize(false, oldPrefix.substr(0, length));
+    setRoot(old.isRoot());
+    *link() = *old.link();
+    std::string storedKey;
+    for (uint32_t i = 0; i < old.numCells(); i++) {
+        storedKey.assign(oldPrefix.substr(length)).append(old.key(i));
+        placeCell(i, storedKey, old.id(i), old.child(i), std::string_view());
+    }
+}
+
+bool IndexNode::insertCell(uint32_t cellNum, std::string_view cellKey, uint32_t cellId, uint32_t cellChild,
+                           std::string_view cellPayload) {
+    bool leaf = isLeaf();
+    uint32_t count = numCells();
+    if (!leaf && count == 0 && prefixLength() == 0) {
+        // a node given no prefix starts from its first key; later keys shorten it
+        store32(data + INDEX_NODE_PREFIX_LENGTH_OFFSET, static_cast<uint32_t>(cellKey.size()));
+        std::memcpy(data + INDEX_NODE_HEADER_SIZE, cellKey.data(), cellKey.size());
+    }
+    if (!leaf) {
+        uint32_t current = prefixLength();
+        uint32_t shared = sharedLength(cellKey, prefix());
+        if (shared < current) {
+            // every stored key grows by what the prefix loses
+            uint32_t size = cellSize(false, static_cast<uint32_t>(cellKey.size()) - shared);
+            uint32_t available = freeSpace() + prefixSpace(current) - prefixSpace(shared);
+            if (size + INDEX_NODE_SLOT_SIZE + count * (current - shared) > available) {
+                return false;
+            }
+            shortenPrefix(shared);
+        }
+        cellKey.remove_prefix(shared);
+    }
+    return placeCell(cellNum, cellKey, cellId, cellChild, cellPayload);
+}
+
+// Writes a cell whose key is already stripped of the prefix
+bool IndexNode::placeCell(uint32_t cellNum, std::string_view cellKey, uint32_t cellId, uint32_t cellChild,
+                          std::string_view cellPayload) {
+    bool leaf = isLeaf();
+    uint32_t count = numCells();
+    uint32_t size = cellSize(leaf, static_cast<uint32_t>(cellKey.size()), static_cast<uint32_t>(cellPayload.size()));
+    if (size + INDEX_NODE_SLOT_SIZE > freeSpace()) {
+        return false;
+    }
+    uint32_t slotsEnd = slotsStart() + (count + 1) * INDEX_NODE_SLOT_SIZE;
+    if (load32(data + INDEX_NODE_CELLS_START_OFFSET) < slotsEnd + size) {
+        compact();
+    }
+    uint32_t start = load32(data + INDEX_NODE_CELLS_START_OFFSET) - size;
+    uint8_t* bytes = data + start;
+    uint16_t keyLength = static_cast<uint16_t>(cellKey.size());
+    std::memcpy(bytes, &keyLength, KEY_LENGTH_SIZE);
+    std::memcpy(bytes + KEY_LENGTH_SIZE, cellKey.data(), cellKey.size());
+    store32(bytes + KEY_LENGTH_SIZE + keyLength, cellId);
+    uint8_t* rest = bytes + afterId(bytes);
+    if (leaf) {
+        store16(rest, static_cast<uint16_t>(cellPayload.size()));
+        std::memcpy(rest + PAYLOAD_LENGTH_SIZE, cellPayload.data(), cellPayload.size());
+    } else {
+        store32(rest, cellChild);
+    }
+    store32(data + INDEX_NODE_CELLS_START_OFFSET, start);
+
+    std::memmove(slot(cellNum + 1), slot(cellNum), (count - cellNum) * INDEX_NODE_SLOT_SIZE);
+    *slot(cellNum) = static_cast<uint16_t>(start);
+    store32(data + INDEX_NODE_NUM_CELLS_OFFSET, count + 1);
+    return true;
+}
+
+void IndexNode::removeCell(uint32_t cellNum) {
+    uint32_t count = numCells();
+    std::memmove(slot(cellNum), slot(cellNum + 1), (count - cellNum - 1) * INDEX_NODE_SLOT_SIZE);
+    store32(data + INDEX_NODE_NUM_CELLS_OFFSET, count - 1);
+}
@@ -0,0 +1,56 @@
+#include "leaf_filter.hpp"
+
+namespace {
+    // One 64-bit mix of the key; each probe takes 7 bits of it
+    uint64_t hashKey(uint32_t key) {
+        uint64_t hash = key;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    constexpr uint32_t BITS = LEAF_FILTER_WORDS * 64;
+}
+
+void LeafFilters::clear() {
+    filters.clear();
+    leaves.clear();
+}
+
+void LeafFilters::reset(uint32_t pageNum, bool isLeaf) {
+    if (pageNum >= leaves.size()) {
+        filters.resize(pageNum + 1);
+        leaves.resize(pageNum + 1);
+    }
+    filters[pageNum].fill(0);
+    leaves[pageNum] = isLeaf;
+}
+
+void LeafFilters::add(uint32_t pageNum, uint32_t key) {
+    uint64_t hash = hashKey(key);
+    for (uint32_t i = 0; i < LEAF_FILTER_HASHES; i++, hash >>= 16) {
+        uint32_t bit = static_cast<uint32_t>(hash % BITS);
+        filters[pageNum][bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+bool LeafFilters::mayContain(uint32_t pageNum, uint32_t key) {
+    probes.fetch_add(1, std::memory_order_relaxed);
+    uint64_t hash = hashKey(key);
+    for (uint32_t i = 0; i < LEAF_FILTER_HASHES; i++, hash >>= 16) {
+        uint32_t bit = static_cast<uint32_t>(hash % BITS);
+        if ((filters[pageNum][bit / 64] & (1ULL << (bit % 64))) == 0) {
+            negatives.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+LeafFilters::Stats LeafFilters::getStats() const {
+    return Stats{probes.load(std::memory_order_relaxed), negatives.load(std::memory_order_relaxed),
+                 falsePositives.load(std::memory_order_relaxed)};
+}
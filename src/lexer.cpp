@@ -0,0 +1,163 @@
+#include "lexer.hpp"
+
+#include <cstring>
+
+namespace {
+    struct Keyword {
+        std::string_view text;
+        TokenType type;
+    };
+
+    // Bucketed by length so a lookup compares against a handful of candidates
+    constexpr Keyword KEYWORDS_2[] = {{"BY", TokenType::KW_BY}, {"OR", TokenType::KW_OR}, {"ON", TokenType::KW_ON}};
+    constexpr Keyword KEYWORDS_3[] = {{"ASC", TokenType::KW_ASC}, {"KEY", TokenType::KW_KEY},
+                                      {"SET", TokenType::KW_SET}, {"AND", TokenType::KW_AND},
+                                      {"NOT", TokenType::KW_NOT}};
+    constexpr Keyword KEYWORDS_4[] = {{"FROM", TokenType::KW_FROM}, {"DESC", TokenType::KW_DESC},
+                                      {"INTO", TokenType::KW_INTO}, {"LIKE", TokenType::KW_LIKE}};
+    constexpr Keyword KEYWORDS_5[] = {{"WHERE", TokenType::KW_WHERE}, {"ORDER", TokenType::KW_ORDER},
+                                      {"LIMIT", TokenType::KW_LIMIT}, {"TABLE", TokenType::KW_TABLE},
+                                      {"BEGIN", TokenType::KW_BEGIN}, {"GROUP", TokenType::KW_GROUP},
+                                      {"INDEX", TokenType::KW_INDEX}, {"USING", TokenType::KW_USING}};
+    constexpr Keyword KEYWORDS_6[] = {{"SELECT", TokenType::KW_SELECT}, {"OFFSET", TokenType::KW_OFFSET},
+                                      {"INSERT", TokenType::KW_INSERT}, {"VALUES", TokenType::KW_VALUES},
+                                      {"UPDATE", TokenType::KW_UPDATE}, {"DELETE", TokenType::KW_DELETE},
+                                      {"CREATE", TokenType::KW_CREATE}, {"COMMIT", TokenType::KW_COMMIT}};
+    constexpr Keyword KEYWORDS_7[] = {{"PRIMARY", TokenType::KW_PRIMARY}, {"INCLUDE", TokenType::KW_INCLUDE}};
+    constexpr Keyword KEYWORDS_8[] = {{"ROLLBACK", TokenType::KW_ROLLBACK}};
+    constexpr Keyword KEYWORDS_11[] = {{"TRANSACTION", TokenType::KW_TRANSACTION}};
+
+    template <size_t N>
+    TokenType findKeyword(const Keyword (&keywords)[N], const char* upper) {
+        for (const Keyword& keyword : keywords) {
+            if (std::memcmp(keyword.text.data(), upper, keyword.text.size()) == 0) {
+                return keyword.type;
+            }
+        }
+        return TokenType::IDENTIFIER;
+    }
+
+    bool isIdentifierStart(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    char toUpper(char c) {
+        return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+}
+
+Lexer::Lexer(std::string_view input) : input(input), position(0) {}
+
+TokenType Lexer::keywordType(std::string_view word) {
+    char upper[12];
+    if (word.size() < 2 || word.size() > 11) {
+        return TokenType::IDENTIFIER;
+    }
+    for (size_t i = 0; i < word.size(); i++) {
+        upper[i] = toUpper(word[i]);
+    }
+    switch (word.size()) {
+        case 2: return findKeyword(KEYWORDS_2, upper);
+        case 3: return findKeyword(KEYWORDS_3, upper);
+        case 4: return findKeyword(KEYWORDS_4, upper);
+        case 5: return findKeyword(KEYWORDS_5, upper);
+        case 6: return findKeyword(KEYWORDS_6, upper);
+        case 7: return findKeyword(KEYWORDS_7, upper);
+        case 8: return findKeyword(KEYWORDS_8, upper);
+        case 11: return findKeyword(KEYWORDS_11, upper);
+        default: return TokenType::IDENTIFIER;
+    }
+}
+
+Token Lexer::make(TokenType type, size_t start, size_t length) {
+    position = start + length;
+    return Token{type, input.substr(start, length), static_cast<uint32_t>(start)};
+}
+
+// 'text' or "text"; a doubled quote inside stands for one quote character
+Token Lexer::lexQuoted(TokenType type, char quote) {
+    size_t start = position;
+    size_t i = start + 1;
+    while (i < input.size()) {
+        if (input[i] == quote) {
+            if (i + 1 < input.size() && input[i + 1] == quote) {
+                i += 2;
+                continue;
+            }
+            position = i + 1;
+            return Token{type, input.substr(start + 1, i - start - 1), static_cast<uint32_t>(start)};
+        }
+        i++;
+    }
+    // unterminated
+    return make(TokenType::ERROR, start, input.size() - start);
+}
+
+Token Lexer::next() {
+    while (position < input.size() && (input[position] == ' ' || input[position] == '\t' ||
+                                       input[position] == '\n' || input[position] == '\r')) {
+        position++;
+    }
+    if (position >= input.size()) {
+        return Token{TokenType::END, std::string_view(), static_cast<uint32_t>(position)};
+    }
+
+    size_t start = position;
+    char c = input[start];
+    if (isIdentifierStart(c)) {
+        size_t end = start + 1;
+        while (end < input.size() && (isIdentifierStart(input[end]) || isDigit(input[end]))) {
+            end++;
+        }
+        std::string_view word = input.substr(start, end - start);
+        return make(keywordType(word), start, end - start);
+    }
+    if (isDigit(c)) {
+        size_t end = start + 1;
+        while (end < input.size() && isDigit(input[end])) {
+            end++;
+        }
+        return make(TokenType::INTEGER, start, end - start);
+    }
+
+    char following = start + 1 < input.size() ? input[start + 1] : '\0';
+    switch (c) {
+        case '\'': return lexQuoted(TokenType::STRING, '\'');
+        case '"': return lexQuoted(TokenType::IDENTIFIER, '"');
+        case '?': return make(TokenType::PARAMETER, start, 1);
+        case ',': return make(TokenType::COMMA, start, 1);
+        case '(': return make(TokenType::LEFT_PAREN, start, 1);
+        case ')': return make(TokenType::RIGHT_PAREN, start, 1);
+        case ';': return make(TokenType::SEMICOLON, start, 1);
+        case '*': return make(TokenType::STAR, start, 1);
+        case '+': return make(TokenType::PLUS, start, 1);
+        case '-': return make(TokenType::MINUS, start, 1);
+        case '/': return make(TokenType::SLASH, start, 1);
+        case '=': return make(TokenType::EQUAL, start, following == '=' ? 2 : 1);
+        case '!':
+            if (following == '=') {
+                return make(TokenType::NOT_EQUAL, start, 2);
+            }
+            break;
+        case '<':
+            if (following == '=') {
+                return make(TokenType::LESS_EQUAL, start, 2);
+            }
+            if (following == '>') {
+                return make(TokenType::NOT_EQUAL, start, 2);
+            }
+            return make(TokenType::LESS, start, 1);
+        case '>':
+            if (following == '=') {
+                return make(TokenType::GREATER_EQUAL, start, 2);
+            }
+            return make(TokenType::GREATER, start, 1);
+        default:
+            break;
+    }
+    return make(TokenType::ERROR, start, 1);
+}
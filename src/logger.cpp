@@ -0,0 +1,36 @@
+#include "logger.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace {
+    std::atomic<LogLevel> currentLevel{LogLevel::OFF};
+    std::mutex sinkMutex;
+    LogSink currentSink;
+}
+
+void setLogLevel(LogLevel level) {
+    currentLevel.store(level, std::memory_order_relaxed);
+}
+
+LogLevel getLogLevel() {
+    return currentLevel.load(std::memory_order_relaxed);
+}
+
+void setLogSink(LogSink sink) {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    currentSink = std::move(sink);
+}
+
+void logMessage(LogLevel level, const std::string& message) {
+    if (!logEnabled(level)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (currentSink) {
+        currentSink(level, message);
+    } else {
+        std::cerr << message << "\n";
+    }
+}
@@ -1,7 +1,14 @@
 #include <iostream>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "database.hpp"
 #include "enums.hpp"
 #include "input_buffer.hpp"
+#include "logger.hpp"
 #include "meta_command_processor.hpp"
+#include "script_runner.hpp"
 #include "statement_processor.hpp"
 #include "table.hpp"
 #include "utils.hpp"
@@ -11,11 +18,49 @@ int main(int argc, char* argv[]) {
         std::cerr << "Must supply database file name\n";
         exit(EXIT_FAILURE);
     }
+    DatabaseOptions options;
+    std::string batchFile;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-workers") == 0 && i + 1 < argc) {
+            options.maxWorkerThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (std::strcmp(argv[i], "--cache-pages") == 0 && i + 1 < argc) {
+            options.cachePages = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (std::strcmp(argv[i], "--compress") == 0) {
+            options.compressPages = true;
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchFile = argv[++i];
+        } else {
+            std::cerr << "Unknown option '" << argv[i] << "'\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    // the library is silent by default; the REPL shows the engine's errors
+    setLogLevel(LogLevel::ERROR);
     InputBuffer inputBuffer;
     MetaCommandProcessor metaProcessor;
-    Table db_table(argv[1]);
+    std::unique_ptr<Database> database;
+    try {
+        database = std::make_unique<Database>(argv[1], options);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        exit(EXIT_FAILURE);
+    }
+    Table& db_table = database->getTable();
     StatementProcessor statementProcessor = StatementProcessor(db_table);
-    
+
+    if (!batchFile.empty()) {
+        ScriptResult result;
+        try {
+            result = runScript(db_table, statementProcessor, metaProcessor, batchFile);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            exit(EXIT_FAILURE);
+        }
+        database.reset();
+        std::cout << describeScriptResult(result) << "\n";
+        return result.errors == 0 ? 0 : EXIT_FAILURE;
+    }
+
     while (true) {
         printPrompt();
         inputBuffer.readInput();
@@ -29,7 +74,11 @@ int main(int argc, char* argv[]) {
                 case MetaCommandResult::META_COMMAND_UNRECOGNIZED_COMMAND:
                     std::cout << "Unrecognized command at start of '" << inputBuffer.getBuffer() << "'.\n";
                     break;
+                case MetaCommandResult::META_COMMAND_FAILURE:
+                    break;
                 case MetaCommandResult::META_COMMAND_EXIT:
+                    database.reset();  // the last checkpoint: everything is in the file after this
+                    std::cout << "Done! Program safe for termination.\n";
                     return 0;
             }
             continue;
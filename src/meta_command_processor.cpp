@@ -1,10 +1,21 @@
 #include "meta_command_processor.hpp"
 #include "table.hpp"
 #include "node.hpp"
+#include "csv_import.hpp"
+#include "result_sink.hpp"
+#include "script_runner.hpp"
+#include "statement_processor.hpp"
+#include "tokenizer.hpp"
+#include <chrono>
+#include <exception>
 #include <unordered_map>
 #include <functional>
 #include <iostream>
 #include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 MetaCommandProcessor::MetaCommandProcessor() {
     commands[".exit"] = [](Table* table) {
@@ -12,12 +23,14 @@ MetaCommandProcessor::MetaCommandProcessor() {
     };
 
     commands[".help"] = [](Table* table) {
-        std::cout << "Available commands: .exit, .help, .tables\n";
+        std::cout << "Available commands: .exit, .help, .tables, .import FILE TABLE, .export FILE TABLE [csv|tsv|binary], .read FILE\n";
         return MetaCommandResult::META_COMMAND_SUCCESS;
     };
 
     commands[".tables"] = [](Table* table) {
-        std::cout << "No tables yet!\n";
+        for (const std::string& name : table->getTableNames()) {
+            std::cout << name << "\n";
+        }
         return MetaCommandResult::META_COMMAND_SUCCESS;
     };
 
@@ -39,6 +52,80 @@ MetaCommandProcessor::MetaCommandProcessor() {
         node.printTree(*table, table->getRootPageNum());
         return MetaCommandResult::META_COMMAND_SUCCESS;
     };
+
+    argumentCommands[".import"] = [](Table* table, const std::vector<std::string>& args) {
+        if (args.size() != 2) {
+            std::cout << "Usage: .import FILE TABLE, .export FILE TABLE [csv|tsv|binary], .read FILE\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        try {
+            auto start = std::chrono::steady_clock::now();
+            ImportResult result = importCsv(*table, args[0], args[1]);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Imported " << result.rows << " rows (" << result.bytes / 1000000.0 << " MB) in "
+                      << seconds * 1e3 << " ms\n";
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        return MetaCommandResult::META_COMMAND_SUCCESS;
+    };
+
+    argumentCommands[".export"] = [](Table* table, const std::vector<std::string>& args) {
+        ExportFormat format = ExportFormat::CSV;
+        if ((args.size() != 2 && args.size() != 3) || (args.size() == 3 && !parseExportFormat(args[2], format))) {
+            std::cout << "Usage: .export FILE TABLE [csv|tsv|binary], .read FILE\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        // "-" writes to standard output, after whatever std::cout still holds
+        bool toStdout = args[0] == "-";
+        int fd = STDOUT_FILENO;
+        if (toStdout) {
+            std::cout.flush();
+        } else {
+            fd = open(args[0].c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                std::cout << "Error: Cannot open '" << args[0] << "': " << std::strerror(errno) << "\n";
+                return MetaCommandResult::META_COMMAND_FAILURE;
+            }
+        }
+        try {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t rows = exportTable(*table, args[1], fd, format);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!toStdout) {
+                close(fd);
+                std::cout << "Exported " << rows << " rows in " << seconds * 1e3 << " ms\n";
+            }
+        } catch (const std::exception& e) {
+            if (!toStdout) {
+                close(fd);
+            }
+            std::cout << "Error: " << e.what() << "\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        return MetaCommandResult::META_COMMAND_SUCCESS;
+    };
+
+    argumentCommands[".read"] = [this](Table* table, const std::vector<std::string>& args) {
+        if (args.size() != 1) {
+            std::cout << "Usage: .read FILE\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        StatementProcessor statements(*table);
+        ScriptResult result;
+        try {
+            result = runScript(*table, statements, *this, args[0]);
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+            return MetaCommandResult::META_COMMAND_FAILURE;
+        }
+        std::cout << describeScriptResult(result) << "\n";
+        if (result.exitRequested) {
+            return MetaCommandResult::META_COMMAND_EXIT;
+        }
+        return result.errors == 0 ? MetaCommandResult::META_COMMAND_SUCCESS : MetaCommandResult::META_COMMAND_FAILURE;
+    };
 }
 
 MetaCommandResult MetaCommandProcessor::execute(const std::string& command, Table* table) {
@@ -46,5 +133,10 @@ MetaCommandResult MetaCommandProcessor::execute(const std::string& command, Tabl
     if (it != commands.end()) {
         return it->second(table);
     }
+    std::vector<std::string> words = tokenize(command);
+    auto withArguments = words.empty() ? argumentCommands.end() : argumentCommands.find(words[0]);
+    if (withArguments != argumentCommands.end()) {
+        return withArguments->second(table, std::vector<std::string>(words.begin() + 1, words.end()));
+    }
     return MetaCommandResult::META_COMMAND_UNRECOGNIZED_COMMAND;
 }
\ No newline at end of file
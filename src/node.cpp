@@ -3,6 +3,7 @@
 #include "table.hpp"
 #include "cursor.hpp"
 #include <iostream>
+#include <cstring>
 
 uint32_t* Node::leafNodeNumCells() {
     return reinterpret_cast<uint32_t*>(static_cast<char*>(data) + LEAF_NODE_NUM_CELLS_OFFSET);
@@ -48,6 +49,33 @@ void Node::leafNodeInsert(uint32_t key, const Row* value, uint32_t cellNum) {
     *leafNodeNumCells() = numCells + 1;
 }
 
+// Ids are usually handed out in order, so a leaf's keys are often a dense run
+// and a key's cell is its distance from the first key: one probe instead of a
+// binary search. Keys with gaps fall back to the binary search.
+uint32_t Node::leafNodeFind(uint32_t key) {
+    uint32_t numCells = *leafNodeNumCells();
+    if (numCells > 0 && key >= *leafNodeKey(0)) {
+        uint32_t offset = key - *leafNodeKey(0);
+        if (offset < numCells && *leafNodeKey(offset) == key) {
+            return offset;
+        }
+    }
+    uint32_t minIndex = 0;
+    uint32_t onePastMaxIndex = numCells;
+    while (minIndex < onePastMaxIndex) {
+        uint32_t currentIndex = (minIndex + onePastMaxIndex) / 2;
+        uint32_t currentKey = *leafNodeKey(currentIndex);
+        if (currentKey == key) {
+            return currentIndex;
+        } else if (currentKey < key) {
+            minIndex = currentIndex + 1;
+        } else {
+            onePastMaxIndex = currentIndex;
+        }
+    }
+    return minIndex;
+}
+
 // delete later 
 void Node::printLeafNode() {
     uint32_t numCells = *leafNodeNumCells();
@@ -108,6 +136,14 @@ void Node::printTree(Table& table, uint32_t rootPageNum, uint32_t indentationLev
             node.printTree(table, rightChildPageNum, indentationLevel + 2);
             break;
         }
+        case NodeType::NODE_INDEX_INTERNAL:
+        case NodeType::NODE_INDEX_LEAF:
+        case NodeType::NODE_HASH_DIRECTORY:
+        case NodeType::NODE_HASH_BUCKET:
+        case NodeType::NODE_ZONE_DIRECTORY:
+        case NodeType::NODE_ZONE_PAGE:
+            // index pages are never reachable from the table tree
+            break;
     }
 }
 
@@ -166,6 +202,13 @@ uint32_t* Node::internalNodeKey(uint32_t keyNum) {
     return reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(internalNodeCell(keyNum)) + INTERNAL_NODE_CHILD_SIZE);
 }
 
+uint32_t* Node::internalNodeChildRows(uint32_t childNum) {
+    if (childNum == *internalNodeNumKeys()) {
+        return reinterpret_cast<uint32_t*>(static_cast<char*>(data) + INTERNAL_NODE_RIGHT_CHILD_ROWS_OFFSET);
+    }
+    return reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(internalNodeCell(childNum)) + INTERNAL_NODE_ROWS_OFFSET);
+}
+
 // Searches parent for index of child by page number
 // Returns the index where the child page number is stored, or UINT32_MAX if not found
 uint32_t Node::internalNodeFindChild(uint32_t childPageNum) {
@@ -190,6 +233,7 @@ void Node::initializeInternalNode() {
     setNodeType(NodeType::NODE_INTERNAL);
     *internalNodeNumKeys() = 0;
     *internalNodeRightChild() = INVALID_PAGE_NUM;
+    *internalNodeChildRows(0) = 0;
     setNodeRoot(false);
 }
 
@@ -198,6 +242,10 @@ uint32_t Node::getNodeMaxKey() {
         case NodeType::NODE_INTERNAL:
             return *internalNodeKey(*internalNodeNumKeys() - 1);
         case NodeType::NODE_LEAF:
+            // empty leaf (fresh root) has no max key yet
+            if (*leafNodeNumCells() == 0) {
+                return 0;
+            }
             return *leafNodeKey(*leafNodeNumCells() - 1);
         default:
             throw std::logic_error("Unknown node type");
@@ -217,5 +265,9 @@ void Node::internalNodeUpdateMaxKey(uint32_t childPageNum, uint32_t newNodeMax)
     if (oldChildIndex == UINT32_MAX) {
         throw std::runtime_error("Child not found in parent node");
     }
+    // the right child has no key slot; writing one would run past the last cell
+    if (oldChildIndex == *internalNodeNumKeys()) {
+        return;
+    }
     *internalNodeKey(oldChildIndex) = newNodeMax;
 }
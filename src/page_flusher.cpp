@@ -0,0 +1,104 @@
+#include "page_flusher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include "logger.hpp"
+
+struct PageFlusher::State {
+    Pager& pager;
+    Scheduler& scheduler;
+    FlusherOptions options;
+
+    std::mutex mutex;  // held for a whole pass; stop() takes it to wait one out
+    bool running;
+    uint64_t generation;  // bumped by start() so a stale timer chain from before a stop() ends
+    double budgetPages;
+    std::chrono::steady_clock::time_point lastRefill;
+    uint64_t runs;
+    uint64_t pagesWritten;
+
+    State(Pager& pager, Scheduler& scheduler, const FlusherOptions& options)
+        : pager(pager), scheduler(scheduler), options(options), running(false), generation(0), budgetPages(0),
+          lastRefill(std::chrono::steady_clock::now()), runs(0), pagesWritten(0) {}
+};
+
+PageFlusher::PageFlusher(Pager& pager, Scheduler& scheduler, const FlusherOptions& options)
+    : state(std::make_shared<State>(pager, scheduler, options)) {}
+
+PageFlusher::~PageFlusher() {
+    stop();
+}
+
+void PageFlusher::start() {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->running || !state->options.enabled) {
+            return;
+        }
+        state->running = true;
+        state->generation++;
+    }
+    scheduleNext(state, state->generation);
+}
+
+void PageFlusher::stop() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->running = false;
+}
+
+uint32_t PageFlusher::flushNow() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return runOnce(*state);
+}
+
+PageFlusher::Stats PageFlusher::getStats() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return Stats{state->runs, state->pagesWritten};
+}
+
+void PageFlusher::scheduleNext(const std::shared_ptr<State>& state, uint64_t generation) {
+    std::weak_ptr<State> weak = state;
+    state->scheduler.submitAfter(std::chrono::milliseconds(state->options.intervalMs), [weak, generation]() {
+        std::shared_ptr<State> locked = weak.lock();
+        if (!locked) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(locked->mutex);
+            if (!locked->running || locked->generation != generation) {
+                return;
+            }
+            try {
+                runOnce(*locked);
+            } catch (const std::exception& e) {
+                // pages stay dirty; eviction or the checkpoint writes them instead
+                logMessage(LogLevel::ERROR, std::string("Error: background flush failed: ") + e.what());
+            }
+        }
+        scheduleNext(locked, generation);
+    }, TaskPriority::MAINTENANCE);
+}
+
+// Refills the token bucket, then writes enough dirty pages to get back to the
+// clean-frame target, as far as the budget allows. Caller holds state.mutex.
+uint32_t PageFlusher::runOnce(State& state) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - state.lastRefill).count();
+    double pagesPerSecond = static_cast<double>(state.options.maxBytesPerSecond) / PAGE_SIZE;
+    state.budgetPages = std::min(pagesPerSecond, state.budgetPages + elapsed * pagesPerSecond);
+    state.lastRefill = now;
+    state.runs++;
+
+    double maxDirty = state.pager.getCacheCapacity() * (1.0 - state.options.targetCleanFraction);
+    double excess = state.pager.getDirtyCount() - maxDirty;
+    uint32_t toWrite = static_cast<uint32_t>(std::max(0.0, std::min(excess, state.budgetPages)));
+    if (toWrite == 0) {
+        return 0;
+    }
+    uint32_t written = state.pager.flushColdPages(toWrite);
+    state.budgetPages -= written;
+    state.pagesWritten += written;
+    return written;
+}
@@ -1,160 +1,661 @@
 #include "pager.hpp"
+#include "compressed_file.hpp"
+#include "logger.hpp"
 #include <string>
+#include <cerrno>
 #include <cstring>
 #include "constants.hpp"
-#include <iostream>
-#include <fstream>
- 
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
-Pager::Pager(const std::string& filename) {
-    fileDescriptor.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+namespace {
+    // WAL record layout: header | frames (pageNum + page image) | trailer
+    constexpr uint32_t WAL_RECORD_MAGIC = 0x57414C52; // "WALR"
+    constexpr uint32_t WAL_COMMIT_MAGIC = 0x434D4954; // "CMIT"
+    constexpr uint32_t WAL_HEADER_SIZE = 3 * sizeof(uint32_t);  // magic, numFrames, dbNumPages
+    constexpr uint32_t WAL_FRAME_SIZE = sizeof(uint32_t) + PAGE_SIZE;
+    constexpr uint32_t WAL_TRAILER_SIZE = 2 * sizeof(uint32_t); // checksum, commit magic
 
-    // open without read mode, then reopen
-    if (!fileDescriptor.is_open()) {
-        fileDescriptor.clear(); // Clear any error flags
-        fileDescriptor.open(filename, std::ios::out | std::ios::binary);
-        fileDescriptor.close();
-        fileDescriptor.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    constexpr uint32_t WAL_CHECKSUM_SEED = 2166136261u;
+
+    // FNV-1a, enough to detect a torn record tail; pass the previous result as
+    // hash to checksum a record piece by piece
+    uint32_t walChecksum(const uint8_t* data, size_t length, uint32_t hash = WAL_CHECKSUM_SEED) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void writeFully(int fd, const uint8_t* data, size_t length, off_t offset) {
+        while (length > 0) {
+            ssize_t written = pwrite(fd, data, length, offset);
+            if (written < 0) {
+                throw std::runtime_error("Failed to write page to file");
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+            offset += written;
+        }
+    }
+
+    bool readFully(int fd, uint8_t* data, size_t length, off_t offset) {
+        while (length > 0) {
+            ssize_t bytesRead = pread(fd, data, length, offset);
+            if (bytesRead <= 0) {
+                return false;
+            }
+            data += bytesRead;
+            length -= static_cast<size_t>(bytesRead);
+            offset += bytesRead;
+        }
+        return true;
     }
+}
+
+Pager::Pager(const std::string& filename, uint32_t cachePages, bool compressPages)
+    : walDescriptor(-1), walFilename(filename + "-wal"), walBytes(0),
+      checkpointBytes(PAGER_DEFAULT_CHECKPOINT_BYTES), cacheCapacity(cachePages == 0 ? 1 : cachePages),
+      cachedCount(0), dirtyCount(0), clockHand(0), evictionBlocked(false), pageReads(0), pageWrites(0), writeCalls(0),
+      evictions(0), dirtyEvictions(0), backgroundWrites(0), fileBytesRead(0), fileBytesWritten(0),
+      checkpoints(0) {
+    fileDescriptor = open(filename.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
 
-    if (!fileDescriptor.is_open()) {
-        std::cerr << "Error: could not open file." << std::endl;
-        exit(EXIT_FAILURE);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("Cannot open '" + filename + "': " + std::strerror(errno));
     }
 
-    fileDescriptor.seekg(0, std::ios::end);
-    fileLength = static_cast<uint32_t>(fileDescriptor.tellg());
-    fileDescriptor.seekg(0, std::ios::beg);
+    struct stat fileStat;
+    fstat(fileDescriptor, &fileStat);
+    if (CompressedPageFile::detect(fileDescriptor)) {
+        compressedFile = std::make_unique<CompressedPageFile>(fileDescriptor, false);
+    } else if (fileStat.st_size == 0 && compressPages) {
+        compressedFile = std::make_unique<CompressedPageFile>(fileDescriptor, true);
+    }
+
+    // replay transactions committed to the WAL but not yet checkpointed
+    walRecover();
+
+    fstat(fileDescriptor, &fileStat);
+    fileLength = static_cast<uint32_t>(fileStat.st_size);
 
-    numPages = fileLength / PAGE_SIZE;      
-    if (fileLength % PAGE_SIZE) {
-        std::cerr <<"Error: File size is not a multiple of page size. Corrupt File\n";
-        exit(EXIT_FAILURE);
+    if (compressedFile) {
+        numPages = compressedFile->getNumPages();
+    } else {
+        numPages = fileLength / PAGE_SIZE;
+        if (fileLength % PAGE_SIZE) {
+            close(fileDescriptor);
+            throw std::runtime_error("File size is not a multiple of page size. Corrupt file");
+        }
+    }
+
+    for (uint32_t i = 0; i < TABLE_MAX_PAGES; i++) {
+        pages[i] = nullptr;
+        dirtyPages[i] = false;
+        referencedPages[i] = false;
+        flushingPages[i] = false;
     }
-    
-    for (int i = 0; i < TABLE_MAX_PAGES; i++) {
-        pages[i] = nullptr;    
-    } 
 }
 
 Pager::~Pager() {
-    if (fileDescriptor.is_open()) {
-        fileDescriptor.close();
+    if (walDescriptor >= 0) {
+        close(walDescriptor);
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
     }
 
-    for (int i = 0; i < TABLE_MAX_PAGES; i++) {
+    for (uint32_t i = 0; i < TABLE_MAX_PAGES; i++) {
        delete[] pages[i];
     }
+    for (uint8_t* frame : freeFrames) {
+        delete[] frame;
+    }
 }
 
-void Pager::getFdStatus(const std::string& context) {
-    std::streampos currentPos = fileDescriptor.tellp();
-    std::cout << "DEBUG " << context << " - File position: " << currentPos 
-              << ", EOF?: " << fileDescriptor.eof() << "\n";
-}
-
-/* 
+/*
 Tries to locate page
-if page already cached, we can return it 
+if page already cached, we can return it
 else, need to allocate memory for it, and retrieve it from the file
 */
 uint8_t* Pager::getPage(uint32_t pageNum) {
     if (pageNum >= TABLE_MAX_PAGES) {
         throw std::out_of_range("Page number exceeds maximum pages (inside getPage)");
     }
+    std::lock_guard<std::mutex> lock(cacheMutex);
 
     uint8_t* page = pages[pageNum];
-    if (page == nullptr) { 
-        // Not cached - this is where pages get allocated!
-        page = pages[pageNum] = new uint8_t[PAGE_SIZE];
+    if (page == nullptr) {
+        // Not cached - reuse an evicted frame if there is one
+        if (!freeFrames.empty()) {
+            page = freeFrames.back();
+            freeFrames.pop_back();
+        } else {
+            page = new uint8_t[PAGE_SIZE];
+        }
+        pages[pageNum] = page;
         std::memset(page, 0, PAGE_SIZE);
-        
+
         // Check if page_num is in range of numPages. If it is, we need to read from file
-        // else, just return page pointer. Read from it later. 
+        // else, just return page pointer. Read from it later.
         if (pageNum < numPages) {
-            // Reads file and stores into page ptr 
-            fileDescriptor.seekg(pageNum * PAGE_SIZE, std::ios::beg);
-            fileDescriptor.read(reinterpret_cast<char*>(page), PAGE_SIZE);
-
-            if (fileDescriptor.fail()) {
-                if (fileDescriptor.eof()) {
-                    fileDescriptor.clear();
-                } else {
-                    std::cerr << "Error reading page " << pageNum << std::endl;
-                    delete[] page;
-                    pages[pageNum] = nullptr;
-                    throw std::runtime_error("Failed to read page from file");
-                }                
+            // Reads file and stores into page ptr
+            try {
+                readPageFromFile(pageNum, page);
+            } catch (const std::runtime_error&) {
+                logMessage(LogLevel::ERROR, "Error reading page " + std::to_string(pageNum));
+                freeFrames.push_back(page);
+                pages[pageNum] = nullptr;
+                throw;
             }
-        } 
+            pageReads.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // brand new page; must reach the file even if nobody writes to it
+            markDirty(pageNum);
+        }
+        cachedCount.fetch_add(1, std::memory_order_relaxed);
+        // a page read from the file is evictable; a new one only outside a transaction
+        if (pageNum < numPages || undoLevels.empty()) {
+            evictionBlocked.store(false, std::memory_order_relaxed);
+        }
     }
-    // do after file reading incase of fail 
+    referencedPages[pageNum] = true;
+    // do after file reading incase of fail
     if (pageNum >= numPages) {
         numPages = pageNum + 1;
     }
-    
+
+    return page;
+}
+
+// Same as getPage, but records the page's before-image in the innermost open
+// transaction level (first write only) and marks it dirty
+uint8_t* Pager::getPageForWrite(uint32_t pageNum) {
+    uint8_t* page = getPage(pageNum);
+
+    if (!undoLevels.empty()) {
+        UndoLevel& level = undoLevels.back();
+        if (level.beforeImages.find(pageNum) == level.beforeImages.end()) {
+            std::vector<uint8_t>& image = level.beforeImages[pageNum];
+            if (pageNum < level.numPagesAtStart) {
+                image.assign(page, page + PAGE_SIZE);
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    markDirty(pageNum);
     return page;
 }
 
+void Pager::markDirty(uint32_t pageNum) {
+    if (!dirtyPages[pageNum]) {
+        dirtyPages[pageNum] = true;
+        dirtyCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Pager::markClean(uint32_t pageNum) {
+    if (dirtyPages[pageNum]) {
+        dirtyPages[pageNum] = false;
+        dirtyCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Returns the frame to the free list; the page must already be clean or disposable
+void Pager::dropFrame(uint32_t pageNum) {
+    freeFrames.push_back(pages[pageNum]);
+    pages[pageNum] = nullptr;
+    referencedPages[pageNum] = false;
+    cachedCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Pages that must stay in memory: journaled or allocated by the open transaction
+// (their cached image is uncommitted), or being written by flushColdPages
+bool Pager::isPinned(uint32_t pageNum) const {
+    if (flushingPages[pageNum]) {
+        return true;
+    }
+    if (undoLevels.empty()) {
+        return false;
+    }
+    if (pageNum >= undoLevels.front().numPagesAtStart) {
+        return true;
+    }
+    for (const UndoLevel& level : undoLevels) {
+        if (level.beforeImages.count(pageNum) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pager::evictToCapacity() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cachedCount <= cacheCapacity || numPages == 0 || evictionBlocked.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // two full sweeps: the first may only clear reference bits
+    uint64_t budget = 2ull * numPages;
+    while (cachedCount > cacheCapacity) {
+        if (budget-- == 0) {
+            // whatever is still cached is pinned
+            evictionBlocked.store(true, std::memory_order_relaxed);
+            return;
+        }
+        if (clockHand >= numPages) {
+            clockHand = 0;
+        }
+        uint32_t pageNum = clockHand++;
+        if (pages[pageNum] == nullptr || isPinned(pageNum)) {
+            continue;
+        }
+        if (referencedPages[pageNum]) {
+            referencedPages[pageNum] = false;
+            continue;
+        }
+        if (dirtyPages[pageNum]) {
+            pagerFlush(pageNum);
+            dirtyEvictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        dropFrame(pageNum);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t Pager::flushColdPages(uint32_t maxPages) {
+    std::vector<uint32_t> chosen;
+    std::vector<uint8_t> staging;
+    std::lock_guard<std::mutex> guard(checkpointMutex);
+    {
+        std::lock_guard<std::mutex> latch(writeLatch);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        // pass 0 takes pages not referenced since the clock last passed them,
+        // pass 1 tops up with recently used ones
+        for (int pass = 0; pass < 2 && chosen.size() < maxPages; pass++) {
+            for (uint32_t i = 0; i < numPages && chosen.size() < maxPages; i++) {
+                if (pages[i] == nullptr || !dirtyPages[i] || isPinned(i) || referencedPages[i] != (pass == 1)) {
+                    continue;
+                }
+                chosen.push_back(i);
+            }
+        }
+        if (chosen.empty()) {
+            return 0;
+        }
+        std::sort(chosen.begin(), chosen.end());
+        staging.resize(chosen.size() * PAGE_SIZE);
+        for (size_t k = 0; k < chosen.size(); k++) {
+            std::memcpy(staging.data() + k * PAGE_SIZE, pages[chosen[k]], PAGE_SIZE);
+            // cleared now: a write after the snapshot dirties the page again
+            markClean(chosen[k]);
+            flushingPages[chosen[k]] = true;
+        }
+    }
+
+    bool failed = false;
+    size_t runStart = 0;
+    for (size_t k = 1; k <= chosen.size() && !failed; k++) {
+        // compressed pages have their own slots, so each is written on its own
+        if (k < chosen.size() && chosen[k] == chosen[k - 1] + 1 && !compressedFile) {
+            continue;
+        }
+        try {
+            if (compressedFile) {
+                fileBytesWritten.fetch_add(
+                    compressedFile->writePage(chosen[runStart], staging.data() + runStart * PAGE_SIZE),
+                    std::memory_order_relaxed);
+            } else {
+                writeFully(fileDescriptor, staging.data() + runStart * PAGE_SIZE, (k - runStart) * PAGE_SIZE,
+                           static_cast<off_t>(chosen[runStart]) * PAGE_SIZE);
+                fileBytesWritten.fetch_add((k - runStart) * PAGE_SIZE, std::memory_order_relaxed);
+            }
+            writeCalls.fetch_add(1, std::memory_order_relaxed);
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        runStart = k;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    evictionBlocked.store(false, std::memory_order_relaxed);
+    for (uint32_t pageNum : chosen) {
+        flushingPages[pageNum] = false;
+        if (failed) {
+            markDirty(pageNum);
+        }
+    }
+    if (failed) {
+        throw std::runtime_error("Failed to write pages in background flush");
+    }
+    uint32_t written = static_cast<uint32_t>(chosen.size());
+    pageWrites.fetch_add(written, std::memory_order_relaxed);
+    backgroundWrites.fetch_add(written, std::memory_order_relaxed);
+    return written;
+}
+
+Pager::Stats Pager::getStats() const {
+    return Stats{pageReads.load(),       pageWrites.load(),    writeCalls.load(),
+                 evictions.load(),       dirtyEvictions.load(), backgroundWrites.load(),
+                 fileBytesRead.load(),   fileBytesWritten.load(), checkpoints.load()};
+}
+
 uint32_t Pager::getFileLength() const {
-    return fileLength; 
+    return fileLength;
+}
+
+// A short read past the end of a plain file leaves the rest of the page zeroed
+void Pager::readPageFromFile(uint32_t pageNum, uint8_t* page) {
+    if (compressedFile) {
+        fileBytesRead.fetch_add(compressedFile->readPage(pageNum, page), std::memory_order_relaxed);
+        return;
+    }
+    ssize_t bytesRead = pread(fileDescriptor, page, PAGE_SIZE, static_cast<off_t>(pageNum) * PAGE_SIZE);
+    if (bytesRead < 0) {
+        throw std::runtime_error("Failed to read page from file");
+    }
+    fileBytesRead.fetch_add(static_cast<uint64_t>(bytesRead), std::memory_order_relaxed);
+}
+
+void Pager::writePageToFile(uint32_t pageNum, const uint8_t* page) {
+    try {
+        if (compressedFile) {
+            fileBytesWritten.fetch_add(compressedFile->writePage(pageNum, page), std::memory_order_relaxed);
+            return;
+        }
+        writeFully(fileDescriptor, page, PAGE_SIZE, static_cast<off_t>(pageNum) * PAGE_SIZE);
+        fileBytesWritten.fetch_add(PAGE_SIZE, std::memory_order_relaxed);
+    } catch (const std::runtime_error&) {
+        logMessage(LogLevel::ERROR, "Error flushing page " + std::to_string(pageNum) + ": " + std::strerror(errno));
+        throw;
+    }
 }
 
-// size = bytes to write (PAGE_SIZE for full page, or calculated size for partial page)
 void Pager::pagerFlush(uint32_t pageNum) {
     if (pageNum >= TABLE_MAX_PAGES) {
         throw std::out_of_range("Page number exceeds maximum pages");
     }
-    
+
     uint8_t* page = pages[pageNum];
     if (page == nullptr) {
         return; // Nothing to flush
     }
-    // Optional: could validate page contents here if needed
-    uint32_t targetPos = pageNum * PAGE_SIZE;
-    // Seek to write position
-    fileDescriptor.seekp(targetPos, std::ios::beg);
-    
-    // Show file descriptor position after seeking
-    std::streampos afterSeekPos = fileDescriptor.tellp();
-    
-    // Verify seek was successful
-    if (afterSeekPos != targetPos) {
-        std::cerr << "WARNING: Seek position mismatch! Expected: " << targetPos 
-                  << ", Actual: " << afterSeekPos << "\n";
-    }
-    
-    // Perform the write
-    fileDescriptor.write(reinterpret_cast<const char*>(page), PAGE_SIZE);
-    
-    if (fileDescriptor.fail()) {
-        if (fileDescriptor.bad()) {
-            std::cerr << "A severe, non-recoverable error occurred." << std::endl;
-        } else if (fileDescriptor.eof()) {
-            std::cerr << "End of file reached during an operation." << std::endl;
-        } else {
-            std::cerr << "A logical error occurred during file operation." << std::endl;
+    writePageToFile(pageNum, page);
+    pageWrites.fetch_add(1, std::memory_order_relaxed);
+    writeCalls.fetch_add(1, std::memory_order_relaxed);
+    markClean(pageNum);
+}
+
+void Pager::writeDirtyPages() {
+    for (uint32_t i = 0; i < numPages; i++) {
+        if (dirtyPages[i]) {
+            pagerFlush(i);
         }
-        std::cerr << "Error flushing page " << pageNum << std::endl;
-        throw std::runtime_error("Failed to write page to file");
     }
-    
-    fileDescriptor.flush();
 }
 
+// Checkpoint: write every dirty page to the database file, fsync it, then the
+// WAL is no longer needed. An open (uncommitted) transaction is discarded.
 void Pager::flushAllPages() {
 
-    try {        
-        for (uint32_t i = 0; i < numPages; i++) {
-            pagerFlush(i);
+    try {
+        while (inTransaction()) {
+            rollbackTransaction();
         }
+        std::lock_guard<std::mutex> guard(checkpointMutex);
+        writeDirtyPages();
+        syncFile();
+        checkpoints.fetch_add(1, std::memory_order_relaxed);
 
-        std::cout << "Done! Program safe for termination.\n";
+        if (walDescriptor >= 0) {
+            close(walDescriptor);
+            walDescriptor = -1;
+            unlink(walFilename.c_str());
+        }
     } catch(const std::exception& e) {
-        std::cerr << "FATAL ERROR: Failed to flush data to disk - DATA MAY BE LOST!\n";
-        std::cerr << "Error details: " << e.what() << "\n";
-        std::cerr << "Database file may be corrupted. Check disk space and permissions.\n";
+        logMessage(LogLevel::ERROR, std::string("FATAL ERROR: Failed to flush data to disk - DATA MAY BE LOST!\n") +
+                                        "Error details: " + e.what() + "\n" +
+                                        "Database file may be corrupted. Check disk space and permissions.");
+
+        std::abort();          // Since this is called from destructor, we can't throw
+    }
+}
+
+// Committed pages are either still dirty in the cache or already written by
+// flushColdPages, so once the dirty ones are written and synced every commit in
+// the WAL is in the file. The WAL is truncated in place and synced, so a crash
+// cannot bring its old records back over newer pages.
+void Pager::checkpoint() {
+    std::lock_guard<std::mutex> guard(checkpointMutex);
+    std::lock_guard<std::mutex> latch(writeLatch);
+    if (inTransaction()) {
+        return;
+    }
+    writeDirtyPages();
+    syncFile();
+    if (walDescriptor >= 0) {
+        if (ftruncate(walDescriptor, 0) != 0 || fsync(walDescriptor) != 0) {
+            throw std::runtime_error("Failed to reset write-ahead log");
+        }
+    }
+    walBytes = 0;
+    checkpoints.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Pager::beginTransaction() {
+    std::lock_guard<std::mutex> latch(writeLatch);
+    if (inTransaction()) {
+        throw std::logic_error("Transaction already open");
+    }
+    undoLevels.push_back(UndoLevel{{}, numPages});
+}
+
+// Pages stay dirty in the cache after commit; they reach the database file at
+// the next checkpoint, and the WAL covers them until then.
+void Pager::commitTransaction() {
+    {
+        std::lock_guard<std::mutex> latch(writeLatch);
+        if (undoLevels.size() != 1) {
+            throw std::logic_error("Commit requires exactly one open transaction level");
+        }
+        std::vector<uint32_t> changedPages;
+        for (const auto& entry : undoLevels.back().beforeImages) {
+            uint32_t pageNum = entry.first;
+            const std::vector<uint8_t>& image = entry.second;
+            // skip pages that were fetched for write but ended up unchanged
+            if (image.empty() || std::memcmp(image.data(), pages[pageNum], PAGE_SIZE) != 0) {
+                changedPages.push_back(pageNum);
+            }
+        }
+        if (!changedPages.empty()) {
+            walAppendCommit(changedPages);
+        }
+        undoLevels.clear();
+        evictionBlocked.store(false, std::memory_order_relaxed);
+    }
+    // checkpoint takes checkpointMutex before writeLatch, so not under the latch
+    if (walBytes >= checkpointBytes) {
+        checkpoint();
+    }
+}
+
+std::vector<uint32_t> Pager::rollbackTransaction() {
+    std::lock_guard<std::mutex> latch(writeLatch);
+    std::vector<uint32_t> changedPages;
+    while (!undoLevels.empty()) {
+        restoreLevel(undoLevels.back(), changedPages);
+        undoLevels.pop_back();
+    }
+    evictionBlocked.store(false, std::memory_order_relaxed);
+    return changedPages;
+}
+
+void Pager::savepoint() {
+    std::lock_guard<std::mutex> latch(writeLatch);
+    if (!inTransaction()) {
+        throw std::logic_error("Savepoint requires an open transaction");
+    }
+    undoLevels.push_back(UndoLevel{{}, numPages});
+}
+
+// Folds the savepoint's before-images into the enclosing level, keeping the
+// older image where both levels touched the same page
+void Pager::releaseSavepoint() {
+    std::lock_guard<std::mutex> latch(writeLatch);
+    if (undoLevels.size() < 2) {
+        throw std::logic_error("No savepoint to release");
+    }
+    UndoLevel top = std::move(undoLevels.back());
+    undoLevels.pop_back();
+    UndoLevel& parent = undoLevels.back();
+    for (auto& entry : top.beforeImages) {
+        parent.beforeImages.emplace(entry.first, std::move(entry.second));
+    }
+}
+
+std::vector<uint32_t> Pager::rollbackToSavepoint() {
+    std::lock_guard<std::mutex> latch(writeLatch);
+    if (undoLevels.size() < 2) {
+        throw std::logic_error("No savepoint to roll back to");
+    }
+    std::vector<uint32_t> changedPages;
+    restoreLevel(undoLevels.back(), changedPages);
+    undoLevels.pop_back();
+    evictionBlocked.store(false, std::memory_order_relaxed);
+    return changedPages;
+}
+
+void Pager::restoreLevel(UndoLevel& level, std::vector<uint32_t>& changedPages) {
+    for (const auto& entry : level.beforeImages) {
+        if (!entry.second.empty()) {
+            std::memcpy(pages[entry.first], entry.second.data(), PAGE_SIZE);
+            changedPages.push_back(entry.first);
+        }
+    }
+    // drop pages allocated after the level opened
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (uint32_t i = level.numPagesAtStart; i < numPages; i++) {
+        if (pages[i] != nullptr) {
+            markClean(i);
+            dropFrame(i);
+        }
+        changedPages.push_back(i);
+    }
+    numPages = level.numPagesAtStart;
+}
+
+// For a compressed file this also writes the page map, without which the
+// pages written since the last sync would not be found again
+void Pager::syncFile() {
+    if (compressedFile) {
+        compressedFile->checkpoint();
+    } else {
+        fsync(fileDescriptor);
+    }
+}
+
+// One write + one fsync per commit, no matter how many pages changed
+void Pager::walAppendCommit(const std::vector<uint32_t>& pageNums) {
+    if (walDescriptor < 0) {
+        walDescriptor = open(walFilename.c_str(), O_RDWR | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+        if (walDescriptor < 0) {
+            throw std::runtime_error("Failed to open write-ahead log");
+        }
+    }
+
+    uint32_t numFrames = static_cast<uint32_t>(pageNums.size());
+    std::vector<uint8_t> record(WAL_HEADER_SIZE + numFrames * WAL_FRAME_SIZE + WAL_TRAILER_SIZE);
+    uint8_t* cursor = record.data();
+    uint32_t header[3] = {WAL_RECORD_MAGIC, numFrames, numPages};
+    std::memcpy(cursor, header, WAL_HEADER_SIZE);
+    cursor += WAL_HEADER_SIZE;
+    for (uint32_t pageNum : pageNums) {
+        std::memcpy(cursor, &pageNum, sizeof(uint32_t));
+        std::memcpy(cursor + sizeof(uint32_t), pages[pageNum], PAGE_SIZE);
+        cursor += WAL_FRAME_SIZE;
+    }
+    uint32_t trailer[2] = {walChecksum(record.data(), cursor - record.data()), WAL_COMMIT_MAGIC};
+    std::memcpy(cursor, trailer, WAL_TRAILER_SIZE);
+
+    size_t remaining = record.size();
+    const uint8_t* data = record.data();
+    while (remaining > 0) {
+        ssize_t written = write(walDescriptor, data, remaining);
+        if (written < 0) {
+            throw std::runtime_error("Failed to append to write-ahead log");
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    if (fsync(walDescriptor) != 0) {
+        throw std::runtime_error("Failed to sync write-ahead log");
+    }
+    walBytes += record.size();
+}
+
+// Applies every complete commit record from the WAL to the database file.
+// A torn or corrupt tail (crash mid-commit) ends replay; that transaction never committed.
+// Records are read one frame at a time: a first pass checks the checksum, a
+// second applies the frames, so memory does not grow with the log.
+void Pager::walRecover() {
+    int fd = open(walFilename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat walStat;
+    fstat(fd, &walStat);
+    uint64_t logSize = static_cast<uint64_t>(walStat.st_size);
+
+    std::vector<uint8_t> frame(WAL_FRAME_SIZE);
+    uint64_t offset = 0;
+    try {
+        while (offset + WAL_HEADER_SIZE <= logSize) {
+            uint32_t header[3];
+            if (!readFully(fd, reinterpret_cast<uint8_t*>(header), WAL_HEADER_SIZE, static_cast<off_t>(offset))) {
+                throw std::runtime_error("Failed to read write-ahead log");
+            }
+            if (header[0] != WAL_RECORD_MAGIC) {
+                break;
+            }
+            uint64_t bodySize = WAL_HEADER_SIZE + static_cast<uint64_t>(header[1]) * WAL_FRAME_SIZE;
+            if (offset + bodySize + WAL_TRAILER_SIZE > logSize) {
+                break;
+            }
+            uint32_t checksum = walChecksum(reinterpret_cast<const uint8_t*>(header), WAL_HEADER_SIZE);
+            off_t framesStart = static_cast<off_t>(offset + WAL_HEADER_SIZE);
+            for (uint32_t i = 0; i < header[1]; i++) {
+                if (!readFully(fd, frame.data(), WAL_FRAME_SIZE, framesStart + static_cast<off_t>(i) * WAL_FRAME_SIZE)) {
+                    throw std::runtime_error("Failed to read write-ahead log");
+                }
+                checksum = walChecksum(frame.data(), WAL_FRAME_SIZE, checksum);
+            }
+            uint32_t trailer[2];
+            if (!readFully(fd, reinterpret_cast<uint8_t*>(trailer), WAL_TRAILER_SIZE,
+                           static_cast<off_t>(offset + bodySize))) {
+                throw std::runtime_error("Failed to read write-ahead log");
+            }
+            if (trailer[1] != WAL_COMMIT_MAGIC || trailer[0] != checksum) {
+                break;
+            }
+            for (uint32_t i = 0; i < header[1]; i++) {
+                if (!readFully(fd, frame.data(), WAL_FRAME_SIZE, framesStart + static_cast<off_t>(i) * WAL_FRAME_SIZE)) {
+                    throw std::runtime_error("Failed to read write-ahead log");
+                }
+                uint32_t pageNum;
+                std::memcpy(&pageNum, frame.data(), sizeof(uint32_t));
+                writePageToFile(pageNum, frame.data() + sizeof(uint32_t));
+            }
+            offset += bodySize + WAL_TRAILER_SIZE;
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
 
-        std::abort();          // Since this is called from destructor, we can't throw   
-    }   
+    syncFile();
+    unlink(walFilename.c_str());
 }
@@ -0,0 +1,53 @@
+#include "parallel_scan.hpp"
+
+namespace {
+    // A subtree and the largest key that can route into it
+    struct Subtree {
+        uint32_t pageNum;
+        uint32_t upperKey;
+    };
+}
+
+std::vector<ScanMorsel> ParallelScan::planMorsels(uint32_t targetMorsels) const {
+    std::vector<Subtree> level = {{table.getRootPageNum(), UINT32_MAX}};
+
+    while (level.size() < targetMorsels) {
+        std::vector<Subtree> nextLevel;
+        bool expanded = false;
+        for (const Subtree& subtree : level) {
+            Node node(table.getPageAddress(subtree.pageNum));
+            if (node.getNodeType() == NodeType::NODE_LEAF || *node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+                nextLevel.push_back(subtree);
+                continue;
+            }
+            expanded = true;
+            uint32_t numKeys = *node.internalNodeNumKeys();
+            for (uint32_t i = 0; i < numKeys; i++) {
+                nextLevel.push_back({*node.internalNodeCell(i), *node.internalNodeKey(i)});
+            }
+            nextLevel.push_back({*node.internalNodeRightChild(), subtree.upperKey});
+        }
+        level.swap(nextLevel);
+        if (!expanded) {
+            break;
+        }
+    }
+
+    // child i holds keys in (separator[i-1], separator[i]]
+    std::vector<ScanMorsel> morsels;
+    uint32_t lowKey = 0;
+    for (const Subtree& subtree : level) {
+        if (subtree.upperKey < lowKey) {
+            continue;
+        }
+        morsels.push_back({lowKey, subtree.upperKey});
+        if (subtree.upperKey == UINT32_MAX) {
+            break;
+        }
+        lowKey = subtree.upperKey + 1;
+    }
+    if (morsels.empty() || morsels.back().highKey != UINT32_MAX) {
+        morsels.push_back({lowKey, UINT32_MAX});
+    }
+    return morsels;
+}
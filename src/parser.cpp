@@ -0,0 +1,493 @@
+#include "parser.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace {
+    // Internal unwinding only; parse() turns it into PREPARE_SYNTAX_ERROR
+    struct SyntaxError {
+        const char* message;
+        uint32_t offset;
+    };
+
+    Expr* newExpr(Arena& arena, ExprKind kind, uint32_t offset) {
+        Expr* expr = arena.make<Expr>();
+        expr->kind = kind;
+        expr->op = Operator::EQUAL;
+        expr->integer = 0;
+        expr->parameter = 0;
+        expr->aggregate = AggregateFunction::COUNT;
+        expr->column = UINT32_MAX;
+        expr->left = nullptr;
+        expr->right = nullptr;
+        expr->offset = offset;
+        return expr;
+    }
+}
+
+Parser::Parser(std::string_view sql, Arena& arena) : lexer(sql), arena(arena), parameterCount(0) {
+    current = lexer.next();
+}
+
+void Parser::advance() {
+    current = lexer.next();
+}
+
+bool Parser::accept(TokenType type) {
+    if (current.type != type) {
+        return false;
+    }
+    advance();
+    return true;
+}
+
+void Parser::fail(const char* message) {
+    throw SyntaxError{message, current.offset};
+}
+
+Token Parser::expect(TokenType type, const char* what) {
+    if (current.type != type) {
+        fail(what);
+    }
+    Token token = current;
+    advance();
+    return token;
+}
+
+std::string_view Parser::expectIdentifier(const char* what) {
+    return expect(TokenType::IDENTIFIER, what).text;
+}
+
+PrepareResult Parser::parse(const Statement*& statement) {
+    statement = nullptr;
+    Statement* result = arena.make<Statement>();
+    *result = Statement{StatementKind::SELECT, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    try {
+        switch (current.type) {
+            case TokenType::KW_SELECT:
+                result->kind = StatementKind::SELECT;
+                result->select = parseSelect();
+                break;
+            case TokenType::KW_INSERT:
+                result->kind = StatementKind::INSERT;
+                result->insert = parseInsert();
+                break;
+            case TokenType::KW_UPDATE:
+                result->kind = StatementKind::UPDATE;
+                result->update = parseUpdate();
+                break;
+            case TokenType::KW_DELETE:
+                result->kind = StatementKind::DELETE;
+                result->remove = parseDelete();
+                break;
+            case TokenType::KW_CREATE:
+                advance();
+                if (current.type == TokenType::KW_INDEX) {
+                    result->kind = StatementKind::CREATE_INDEX;
+                    result->createIndex = parseCreateIndex();
+                } else {
+                    result->kind = StatementKind::CREATE_TABLE;
+                    result->createTable = parseCreateTable();
+                }
+                break;
+            case TokenType::KW_BEGIN:
+                advance();
+                accept(TokenType::KW_TRANSACTION);
+                result->kind = StatementKind::BEGIN;
+                break;
+            case TokenType::KW_COMMIT:
+                advance();
+                result->kind = StatementKind::COMMIT;
+                break;
+            case TokenType::KW_ROLLBACK:
+                advance();
+                result->kind = StatementKind::ROLLBACK;
+                break;
+            default:
+                return PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT;
+        }
+        accept(TokenType::SEMICOLON);
+        if (current.type != TokenType::END) {
+            fail("unexpected text after end of statement");
+        }
+    } catch (const SyntaxError& syntaxError) {
+        error = std::string(syntaxError.message) + " at offset " + std::to_string(syntaxError.offset);
+        return PrepareResult::PREPARE_SYNTAX_ERROR;
+    }
+    statement = result;
+    return PrepareResult::PREPARE_SUCCESS;
+}
+
+const SelectStatement* Parser::parseSelect() {
+    expect(TokenType::KW_SELECT, "expected SELECT");
+    SelectStatement* select = arena.make<SelectStatement>();
+    select->star = false;
+    select->where = nullptr;
+    select->limit = nullptr;
+    select->offset = nullptr;
+
+    if (accept(TokenType::STAR)) {
+        select->star = true;
+    } else {
+        do {
+            select->columns.push(arena, parseExpression());
+        } while (accept(TokenType::COMMA));
+    }
+
+    expect(TokenType::KW_FROM, "expected FROM");
+    select->table = expectIdentifier("expected table name");
+
+    if (accept(TokenType::KW_WHERE)) {
+        select->where = parseExpression();
+    }
+    if (accept(TokenType::KW_GROUP)) {
+        expect(TokenType::KW_BY, "expected BY after GROUP");
+        do {
+            select->groupBy.push(arena, expectIdentifier("expected column in GROUP BY"));
+        } while (accept(TokenType::COMMA));
+    }
+    if (accept(TokenType::KW_ORDER)) {
+        expect(TokenType::KW_BY, "expected BY after ORDER");
+        do {
+            OrderTerm term{expectIdentifier("expected column in ORDER BY"), false};
+            if (accept(TokenType::KW_DESC)) {
+                term.descending = true;
+            } else {
+                accept(TokenType::KW_ASC);
+            }
+            select->orderBy.push(arena, term);
+        } while (accept(TokenType::COMMA));
+    }
+    if (accept(TokenType::KW_LIMIT)) {
+        select->limit = parseExpression();
+        if (accept(TokenType::KW_OFFSET)) {
+            select->offset = parseExpression();
+        }
+    }
+    return select;
+}
+
+const InsertStatement* Parser::parseInsert() {
+    expect(TokenType::KW_INSERT, "expected INSERT");
+    expect(TokenType::KW_INTO, "expected INTO");
+    InsertStatement* insert = arena.make<InsertStatement>();
+    insert->table = expectIdentifier("expected table name");
+
+    if (accept(TokenType::LEFT_PAREN)) {
+        do {
+            insert->columns.push(arena, expectIdentifier("expected column name"));
+        } while (accept(TokenType::COMMA));
+        expect(TokenType::RIGHT_PAREN, "expected ')' after column list");
+    }
+
+    expect(TokenType::KW_VALUES, "expected VALUES");
+    do {
+        expect(TokenType::LEFT_PAREN, "expected '(' before row values");
+        ArenaList<const Expr*> values;
+        do {
+            values.push(arena, parseExpression());
+        } while (accept(TokenType::COMMA));
+        expect(TokenType::RIGHT_PAREN, "expected ')' after row values");
+        insert->rows.push(arena, values);
+    } while (accept(TokenType::COMMA));
+    return insert;
+}
+
+const UpdateStatement* Parser::parseUpdate() {
+    expect(TokenType::KW_UPDATE, "expected UPDATE");
+    UpdateStatement* update = arena.make<UpdateStatement>();
+    update->table = expectIdentifier("expected table name");
+    update->where = nullptr;
+
+    expect(TokenType::KW_SET, "expected SET");
+    do {
+        Assignment assignment;
+        assignment.column = expectIdentifier("expected column name");
+        expect(TokenType::EQUAL, "expected '=' in SET");
+        assignment.value = parseExpression();
+        update->assignments.push(arena, assignment);
+    } while (accept(TokenType::COMMA));
+
+    if (accept(TokenType::KW_WHERE)) {
+        update->where = parseExpression();
+    }
+    return update;
+}
+
+const DeleteStatement* Parser::parseDelete() {
+    expect(TokenType::KW_DELETE, "expected DELETE");
+    expect(TokenType::KW_FROM, "expected FROM");
+    DeleteStatement* remove = arena.make<DeleteStatement>();
+    remove->table = expectIdentifier("expected table name");
+    remove->where = nullptr;
+    if (accept(TokenType::KW_WHERE)) {
+        remove->where = parseExpression();
+    }
+    return remove;
+}
+
+// CREATE has already been consumed
+const CreateTableStatement* Parser::parseCreateTable() {
+    expect(TokenType::KW_TABLE, "expected TABLE");
+    CreateTableStatement* create = arena.make<CreateTableStatement>();
+    create->table = expectIdentifier("expected table name");
+
+    expect(TokenType::LEFT_PAREN, "expected '(' before column definitions");
+    do {
+        if (accept(TokenType::KW_PRIMARY)) {
+            // the table's key, listed after its columns
+            expect(TokenType::KW_KEY, "expected KEY after PRIMARY");
+            expect(TokenType::LEFT_PAREN, "expected '(' before key columns");
+            do {
+                create->primaryKey.push(arena, expectIdentifier("expected column name"));
+            } while (accept(TokenType::COMMA));
+            expect(TokenType::RIGHT_PAREN, "expected ')' after key columns");
+            break;
+        }
+        ColumnDefinition column;
+        column.name = expectIdentifier("expected column name");
+        column.typeName = expectIdentifier("expected column type");
+        column.size = 0;
+        column.primaryKey = false;
+        if (accept(TokenType::LEFT_PAREN)) {
+            Token size = expect(TokenType::INTEGER, "expected column size");
+            for (char digit : size.text) {
+                column.size = column.size * 10 + static_cast<uint32_t>(digit - '0');
+            }
+            expect(TokenType::RIGHT_PAREN, "expected ')' after column size");
+        }
+        if (accept(TokenType::KW_PRIMARY)) {
+            expect(TokenType::KW_KEY, "expected KEY after PRIMARY");
+            column.primaryKey = true;
+        }
+        create->columns.push(arena, column);
+    } while (accept(TokenType::COMMA));
+    expect(TokenType::RIGHT_PAREN, "expected ')' after column definitions");
+    return create;
+}
+
+// CREATE has already been consumed
+const CreateIndexStatement* Parser::parseCreateIndex() {
+    expect(TokenType::KW_INDEX, "expected INDEX");
+    CreateIndexStatement* create = arena.make<CreateIndexStatement>();
+    create->name = current.type == TokenType::KW_ON ? std::string_view() : expectIdentifier("expected index name");
+    expect(TokenType::KW_ON, "expected ON");
+    create->table = expectIdentifier("expected table name");
+    expect(TokenType::LEFT_PAREN, "expected '(' before indexed column");
+    create->column = expectIdentifier("expected column name");
+    expect(TokenType::RIGHT_PAREN, "expected ')' after indexed column");
+    if (accept(TokenType::KW_USING)) {
+        create->method = expectIdentifier("expected index method");
+    }
+    if (accept(TokenType::KW_INCLUDE)) {
+        expect(TokenType::LEFT_PAREN, "expected '(' before included columns");
+        do {
+            create->include.push(arena, expectIdentifier("expected column name"));
+        } while (accept(TokenType::COMMA));
+        expect(TokenType::RIGHT_PAREN, "expected ')' after included columns");
+    }
+    return create;
+}
+
+// Precedence, loosest first: OR, AND, NOT, comparison, + -, * /, unary minus
+const Expr* Parser::parseExpression() {
+    return parseOr();
+}
+
+const Expr* Parser::makeBinary(Operator op, const Expr* left, const Expr* right, uint32_t offset) {
+    Expr* expr = newExpr(arena, ExprKind::BINARY, offset);
+    expr->op = op;
+    expr->left = left;
+    expr->right = right;
+    return expr;
+}
+
+const Expr* Parser::parseOr() {
+    const Expr* left = parseAnd();
+    while (current.type == TokenType::KW_OR) {
+        uint32_t offset = current.offset;
+        advance();
+        left = makeBinary(Operator::OR, left, parseAnd(), offset);
+    }
+    return left;
+}
+
+const Expr* Parser::parseAnd() {
+    const Expr* left = parseNot();
+    while (current.type == TokenType::KW_AND) {
+        uint32_t offset = current.offset;
+        advance();
+        left = makeBinary(Operator::AND, left, parseNot(), offset);
+    }
+    return left;
+}
+
+const Expr* Parser::parseNot() {
+    if (current.type == TokenType::KW_NOT) {
+        Expr* expr = newExpr(arena, ExprKind::UNARY, current.offset);
+        advance();
+        expr->op = Operator::NOT;
+        expr->left = parseNot();
+        return expr;
+    }
+    return parseComparison();
+}
+
+const Expr* Parser::parseComparison() {
+    const Expr* left = parseAdditive();
+    Operator op;
+    switch (current.type) {
+        case TokenType::EQUAL: op = Operator::EQUAL; break;
+        case TokenType::NOT_EQUAL: op = Operator::NOT_EQUAL; break;
+        case TokenType::LESS: op = Operator::LESS; break;
+        case TokenType::LESS_EQUAL: op = Operator::LESS_EQUAL; break;
+        case TokenType::GREATER: op = Operator::GREATER; break;
+        case TokenType::GREATER_EQUAL: op = Operator::GREATER_EQUAL; break;
+        case TokenType::KW_LIKE: op = Operator::LIKE; break;
+        default: return left;
+    }
+    uint32_t offset = current.offset;
+    advance();
+    return makeBinary(op, left, parseAdditive(), offset);
+}
+
+const Expr* Parser::parseAdditive() {
+    const Expr* left = parseMultiplicative();
+    while (current.type == TokenType::PLUS || current.type == TokenType::MINUS) {
+        Operator op = current.type == TokenType::PLUS ? Operator::ADD : Operator::SUBTRACT;
+        uint32_t offset = current.offset;
+        advance();
+        left = makeBinary(op, left, parseMultiplicative(), offset);
+    }
+    return left;
+}
+
+const Expr* Parser::parseMultiplicative() {
+    const Expr* left = parseUnary();
+    while (current.type == TokenType::STAR || current.type == TokenType::SLASH) {
+        Operator op = current.type == TokenType::STAR ? Operator::MULTIPLY : Operator::DIVIDE;
+        uint32_t offset = current.offset;
+        advance();
+        left = makeBinary(op, left, parseUnary(), offset);
+    }
+    return left;
+}
+
+const Expr* Parser::parseUnary() {
+    if (current.type == TokenType::MINUS) {
+        uint32_t offset = current.offset;
+        advance();
+        const Expr* operand = parseUnary();
+        // fold -<literal> so negative numbers stay plain literals
+        if (operand->kind == ExprKind::INTEGER) {
+            Expr* literal = newExpr(arena, ExprKind::INTEGER, offset);
+            literal->integer = -operand->integer;
+            return literal;
+        }
+        Expr* expr = newExpr(arena, ExprKind::UNARY, offset);
+        expr->op = Operator::NEGATE;
+        expr->left = operand;
+        return expr;
+    }
+    return parsePrimary();
+}
+
+// name(*) or name(expr); name is COUNT, SUM, MIN or MAX in any case, and only
+// COUNT takes *
+const Expr* Parser::parseAggregate(Expr* call) {
+    static constexpr std::pair<std::string_view, AggregateFunction> FUNCTIONS[] = {
+        {"COUNT", AggregateFunction::COUNT},
+        {"SUM", AggregateFunction::SUM},
+        {"MIN", AggregateFunction::MIN},
+        {"MAX", AggregateFunction::MAX}};
+    bool known = false;
+    for (const auto& function : FUNCTIONS) {
+        if (call->text.size() != function.first.size()) {
+            continue;
+        }
+        known = true;
+        for (size_t i = 0; i < call->text.size() && known; i++) {
+            char c = call->text[i];
+            known = (c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c) == function.first[i];
+        }
+        if (known) {
+            call->aggregate = function.second;
+            break;
+        }
+    }
+    if (!known) {
+        fail("unknown function");
+    }
+    call->kind = ExprKind::AGGREGATE;
+    expect(TokenType::LEFT_PAREN, "expected '('");
+    if (call->aggregate == AggregateFunction::COUNT && accept(TokenType::STAR)) {
+        call->left = nullptr;
+    } else {
+        call->left = parseExpression();
+    }
+    expect(TokenType::RIGHT_PAREN, "expected ')' after function argument");
+    return call;
+}
+
+const Expr* Parser::parsePrimary() {
+    switch (current.type) {
+        case TokenType::INTEGER: {
+            Expr* expr = newExpr(arena, ExprKind::INTEGER, current.offset);
+            int64_t value = 0;
+            for (char digit : current.text) {
+                if (value > (INT64_MAX - (digit - '0')) / 10) {
+                    fail("integer literal out of range");
+                }
+                value = value * 10 + (digit - '0');
+            }
+            expr->integer = value;
+            advance();
+            return expr;
+        }
+        case TokenType::STRING: {
+            Expr* expr = newExpr(arena, ExprKind::STRING, current.offset);
+            std::string_view raw = current.text;
+            if (raw.find("''") == std::string_view::npos) {
+                expr->text = raw;
+            } else {
+                // collapse '' escapes into a copy in the arena
+                char* unescaped = static_cast<char*>(arena.allocate(raw.size(), 1));
+                size_t length = 0;
+                for (size_t i = 0; i < raw.size(); i++) {
+                    unescaped[length++] = raw[i];
+                    if (raw[i] == '\'') {
+                        i++;
+                    }
+                }
+                expr->text = std::string_view(unescaped, length);
+            }
+            advance();
+            return expr;
+        }
+        case TokenType::PARAMETER: {
+            Expr* expr = newExpr(arena, ExprKind::PARAMETER, current.offset);
+            expr->parameter = parameterCount++;
+            advance();
+            return expr;
+        }
+        case TokenType::IDENTIFIER: {
+            Expr* expr = newExpr(arena, ExprKind::COLUMN, current.offset);
+            expr->text = current.text;
+            advance();
+            if (current.type == TokenType::LEFT_PAREN) {
+                return parseAggregate(expr);
+            }
+            return expr;
+        }
+        case TokenType::LEFT_PAREN: {
+            advance();
+            const Expr* inner = parseExpression();
+            expect(TokenType::RIGHT_PAREN, "expected ')'");
+            return inner;
+        }
+        case TokenType::ERROR:
+            fail("unexpected character");
+        default:
+            fail("expected expression");
+    }
+}
@@ -0,0 +1,70 @@
+#include "plan_cache.hpp"
+
+#include "lexer.hpp"
+
+PlanCache::PlanCache(uint32_t capacity) : capacity(capacity), hits(0), misses(0) {}
+
+void PlanCache::normalize(std::string_view sql, std::string& out) {
+    out.clear();
+    Lexer lexer(sql);
+    for (Token token = lexer.next(); token.type != TokenType::END; token = lexer.next()) {
+        if (!out.empty()) {
+            out += ' ';
+        }
+        if (token.type == TokenType::ERROR) {
+            out.append(sql.substr(token.offset));
+            return;
+        }
+        if (token.type == TokenType::STRING || sql[token.offset] == '"') {
+            // quoted: keep the quotes so 'x' and "x" and x stay distinct
+            out.append(sql.substr(token.offset, token.text.size() + 2));
+        } else if (token.type == TokenType::IDENTIFIER) {
+            for (char c : token.text) {
+                out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+        } else if (token.type >= TokenType::KW_SELECT) {
+            for (char c : token.text) {
+                out += (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+            }
+        } else {
+            out.append(token.text);
+        }
+    }
+}
+
+PrepareResult PlanCache::lookup(std::string_view sql, std::shared_ptr<const CompiledStatement>& compiled,
+                                std::string& error, const Table* table) {
+    normalize(sql, keyBuffer);
+    auto found = index.find(keyBuffer);
+    if (found != index.end()) {
+        const CompiledStatement& cached = *found->second->second;
+        if (table == nullptr || !cached.schemaTable || cached.schemaVersion == table->getSchemaVersion()) {
+            hits++;
+            entries.splice(entries.begin(), entries, found->second);
+            compiled = found->second->second;
+            return PrepareResult::PREPARE_SUCCESS;
+        }
+        // stale: drop it and compile again below
+        auto entry = found->second;
+        index.erase(found);
+        entries.erase(entry);
+    }
+
+    misses++;
+    PrepareResult result = CompiledStatement::compile(std::string(sql), compiled, error, table);
+    if (result != PrepareResult::PREPARE_SUCCESS || capacity == 0) {
+        return result;
+    }
+    entries.emplace_front(keyBuffer, compiled);
+    index.emplace(entries.front().first, entries.begin());
+    if (entries.size() > capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    return result;
+}
+
+void PlanCache::clear() {
+    index.clear();
+    entries.clear();
+}
@@ -0,0 +1,1306 @@
+#include "prepared_statement.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+#include "parallel_scan.hpp"
+#include "parser.hpp"
+
+namespace {
+    constexpr std::string_view TABLE_NAME = "users";
+    constexpr uint32_t NUM_COLUMNS = NUM_TABLE_COLUMNS;
+    constexpr std::string_view COLUMN_NAMES[NUM_COLUMNS] = {"id", "username", "email"};
+    constexpr size_t COLUMN_MAX_LENGTH[NUM_COLUMNS] = {0, COLUMN_USERNAME_SIZE - 1, COLUMN_EMAIL_SIZE - 1};
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = (a[i] >= 'A' && a[i] <= 'Z') ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            char y = (b[i] >= 'A' && b[i] <= 'Z') ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+            if (x != y) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Points compiled at the table a statement names: users, or one of table's
+    // CREATE TABLE tables
+    void resolveTable(CompiledStatement& compiled, std::string_view name, const Table* table) {
+        if (equalsIgnoreCase(name, TABLE_NAME)) {
+            compiled.tableName = std::string(TABLE_NAME);
+            compiled.columnNames.assign(std::begin(COLUMN_NAMES), std::end(COLUMN_NAMES));
+            compiled.keyColumns = {COLUMN_ID};
+            return;
+        }
+        const SchemaTable* schemaTable = table == nullptr ? nullptr : table->getSchemaTable(name);
+        if (schemaTable == nullptr) {
+            throw ExecutionError("no such table: " + std::string(name));
+        }
+        compiled.tableName = schemaTable->getName();
+        compiled.schemaTable = true;
+        compiled.schemaVersion = table->getSchemaVersion();
+        for (const ColumnSchema& column : schemaTable->getSchema().getColumns()) {
+            compiled.columnNames.push_back(column.name);
+        }
+        compiled.keyColumns = schemaTable->getSchema().getPrimaryKey();
+    }
+
+    uint32_t findColumn(const CompiledStatement& compiled, std::string_view name) {
+        for (uint32_t i = 0; i < compiled.columnNames.size(); i++) {
+            if (equalsIgnoreCase(name, compiled.columnNames[i])) {
+                return i;
+            }
+        }
+        throw ExecutionError("no such column: " + std::string(name));
+    }
+
+    // Planning: resolve every column reference once so evaluation never compares names
+    void resolveColumns(const CompiledStatement& compiled, const Expr* expr, bool columnsAllowed) {
+        if (expr == nullptr) {
+            return;
+        }
+        if (expr->kind == ExprKind::AGGREGATE) {
+            throw ExecutionError("aggregate functions are only allowed in the SELECT list");
+        }
+        if (expr->kind == ExprKind::COLUMN) {
+            if (!columnsAllowed) {
+                throw ExecutionError("column " + std::string(expr->text) + " is not allowed here");
+            }
+            expr->column = findColumn(compiled, expr->text);
+        }
+        resolveColumns(compiled, expr->left, columnsAllowed);
+        resolveColumns(compiled, expr->right, columnsAllowed);
+    }
+
+    uint32_t allColumns(const CompiledStatement& compiled) {
+        return compiled.columnNames.size() == 32 ? UINT32_MAX : (1u << compiled.columnNames.size()) - 1;
+    }
+
+    // Adds the (resolved) columns expr reads to columns
+    void collectColumns(const Expr* expr, uint32_t& columns) {
+        if (expr == nullptr) {
+            return;
+        }
+        if (expr->kind == ExprKind::COLUMN) {
+            columns |= 1u << expr->column;
+        }
+        collectColumns(expr->left, columns);
+        collectColumns(expr->right, columns);
+    }
+
+    bool containsAggregate(const Expr* expr) {
+        return expr != nullptr && (expr->kind == ExprKind::AGGREGATE || containsAggregate(expr->left) ||
+                                   containsAggregate(expr->right));
+    }
+
+    // A grouped SELECT list is evaluated over the aggregated rows: group
+    // columns first, then one column per aggregate call
+    void resolveGrouped(const Expr* expr, CompiledStatement& compiled) {
+        if (expr == nullptr) {
+            return;
+        }
+        if (expr->kind == ExprKind::COLUMN) {
+            uint32_t column = findColumn(compiled, expr->text);
+            auto found = std::find(compiled.groupColumns.begin(), compiled.groupColumns.end(), column);
+            if (found == compiled.groupColumns.end()) {
+                throw ExecutionError("column " + std::string(expr->text) +
+                                     " must appear in GROUP BY or inside an aggregate");
+            }
+            expr->column = static_cast<uint32_t>(found - compiled.groupColumns.begin());
+            return;
+        }
+        if (expr->kind == ExprKind::AGGREGATE) {
+            const Expr* argument = expr->left;
+            AggregateSpec spec{expr->aggregate, COLUMN_ID};
+            if (argument != nullptr) {
+                if (argument->kind != ExprKind::COLUMN) {
+                    throw ExecutionError("aggregate arguments must be a column");
+                }
+                spec.column = findColumn(compiled, argument->text);
+                argument->column = spec.column;
+            }
+            expr->column = static_cast<uint32_t>(compiled.groupColumns.size() + compiled.aggregates.size());
+            compiled.aggregates.push_back(spec);
+            return;
+        }
+        resolveGrouped(expr->left, compiled);
+        resolveGrouped(expr->right, compiled);
+    }
+
+    void planGroupedSelect(CompiledStatement& compiled) {
+        const SelectStatement& select = *compiled.statement->select;
+        if (select.star) {
+            throw ExecutionError("SELECT * cannot be combined with aggregates or GROUP BY");
+        }
+        for (std::string_view name : select.groupBy) {
+            compiled.groupColumns.push_back(findColumn(compiled, name));
+        }
+        for (const Expr* column : select.columns) {
+            resolveGrouped(column, compiled);
+        }
+        for (const OrderTerm& term : select.orderBy) {
+            uint32_t column = findColumn(compiled, term.column);
+            auto found = std::find(compiled.groupColumns.begin(), compiled.groupColumns.end(), column);
+            if (found == compiled.groupColumns.end()) {
+                throw ExecutionError("ORDER BY column " + std::string(term.column) + " must appear in GROUP BY");
+            }
+            compiled.orderColumns.push_back(static_cast<uint32_t>(found - compiled.groupColumns.begin()));
+        }
+        // groups come out in order of first appearance, which is no promised order
+        compiled.keyOrder = compiled.orderColumns.empty();
+        for (uint32_t column : compiled.groupColumns) {
+            compiled.scanColumns |= 1u << column;
+        }
+        for (const AggregateSpec& spec : compiled.aggregates) {
+            compiled.scanColumns |= 1u << spec.column;
+        }
+    }
+
+    void plan(CompiledStatement& compiled, const Table* table) {
+        const Statement& statement = *compiled.statement;
+        switch (statement.kind) {
+            case StatementKind::SELECT: {
+                const SelectStatement& select = *statement.select;
+                resolveTable(compiled, select.table, table);
+                resolveColumns(compiled, select.where, true);
+                resolveColumns(compiled, select.limit, false);
+                resolveColumns(compiled, select.offset, false);
+                collectColumns(select.where, compiled.scanColumns);
+                compiled.grouped = !select.groupBy.empty();
+                for (const Expr* column : select.columns) {
+                    compiled.grouped = compiled.grouped || containsAggregate(column);
+                }
+                if (compiled.grouped) {
+                    planGroupedSelect(compiled);
+                    break;
+                }
+                for (const Expr* column : select.columns) {
+                    resolveColumns(compiled, column, true);
+                    collectColumns(column, compiled.scanColumns);
+                }
+                for (const OrderTerm& term : select.orderBy) {
+                    compiled.orderColumns.push_back(findColumn(compiled, term.column));
+                    compiled.scanColumns |= 1u << compiled.orderColumns.back();
+                }
+                if (select.star) {
+                    compiled.scanColumns = allColumns(compiled);
+                }
+                // every table is scanned in primary key order, which sorts
+                // by each leading key column in turn
+                compiled.keyOrder = compiled.orderColumns.size() <= compiled.keyColumns.size();
+                for (uint32_t i = 0; i < compiled.orderColumns.size() && compiled.keyOrder; i++) {
+                    compiled.keyOrder = compiled.orderColumns[i] == compiled.keyColumns[i] &&
+                                        !select.orderBy[i].descending;
+                }
+                break;
+            }
+            case StatementKind::INSERT: {
+                const InsertStatement& insert = *statement.insert;
+                resolveTable(compiled, insert.table, table);
+                if (insert.columns.empty()) {
+                    for (uint32_t column = 0; column < compiled.columnNames.size(); column++) {
+                        compiled.insertTargets.push_back(column);
+                    }
+                }
+                for (std::string_view name : insert.columns) {
+                    uint32_t column = findColumn(compiled, name);
+                    if (std::find(compiled.insertTargets.begin(), compiled.insertTargets.end(), column) !=
+                        compiled.insertTargets.end()) {
+                        throw ExecutionError("column " + std::string(name) + " listed twice");
+                    }
+                    compiled.insertTargets.push_back(column);
+                }
+                for (const ArenaList<const Expr*>& values : insert.rows) {
+                    if (values.size() != compiled.insertTargets.size()) {
+                        throw ExecutionError("expected " + std::to_string(compiled.insertTargets.size()) +
+                                             " values, got " + std::to_string(values.size()));
+                    }
+                    for (const Expr* value : values) {
+                        resolveColumns(compiled, value, false);
+                    }
+                }
+                break;
+            }
+            case StatementKind::UPDATE: {
+                const UpdateStatement& update = *statement.update;
+                resolveTable(compiled, update.table, table);
+                for (const Assignment& assignment : update.assignments) {
+                    compiled.assignedColumns.push_back(findColumn(compiled, assignment.column));
+                    resolveColumns(compiled, assignment.value, true);
+                }
+                resolveColumns(compiled, update.where, true);
+                compiled.scanColumns = allColumns(compiled);  // the new rows are built from whole old ones
+                break;
+            }
+            case StatementKind::DELETE:
+                resolveTable(compiled, statement.remove->table, table);
+                resolveColumns(compiled, statement.remove->where, true);
+                compiled.scanColumns = 0;
+                for (uint32_t column : compiled.keyColumns) {
+                    compiled.scanColumns |= 1u << column;
+                }
+                collectColumns(statement.remove->where, compiled.scanColumns);
+                break;
+            case StatementKind::CREATE_TABLE: {
+                const CreateTableStatement& create = *statement.createTable;
+                if (equalsIgnoreCase(create.table, TABLE_NAME)) {
+                    throw ExecutionError("table users already exists");
+                }
+                std::vector<ColumnSchema> columns;
+                std::vector<uint32_t> primaryKey;
+                for (const ColumnDefinition& definition : create.columns) {
+                    ColumnType type;
+                    if (!Schema::parseType(definition.typeName, type)) {
+                        throw ExecutionError("unknown column type: " + std::string(definition.typeName));
+                    }
+                    if (definition.primaryKey) {
+                        if (!primaryKey.empty()) {
+                            throw ExecutionError("a table has only one PRIMARY KEY column");
+                        }
+                        primaryKey.push_back(static_cast<uint32_t>(columns.size()));
+                    }
+                    columns.push_back(ColumnSchema{std::string(definition.name), type, definition.size});
+                }
+                if (!create.primaryKey.empty() && !primaryKey.empty()) {
+                    throw ExecutionError("a table has only one PRIMARY KEY");
+                }
+                for (std::string_view name : create.primaryKey) {
+                    auto found = std::find_if(columns.begin(), columns.end(), [name](const ColumnSchema& column) {
+                        return equalsIgnoreCase(name, column.name);
+                    });
+                    if (found == columns.end()) {
+                        throw ExecutionError("no such column: " + std::string(name));
+                    }
+                    primaryKey.push_back(static_cast<uint32_t>(found - columns.begin()));
+                }
+                // without a PRIMARY KEY the first column is the key
+                if (primaryKey.empty()) {
+                    primaryKey.push_back(0);
+                }
+                try {
+                    compiled.newSchema = std::make_unique<const Schema>(create.table, std::move(columns),
+                                                                        std::move(primaryKey));
+                } catch (const std::invalid_argument& e) {
+                    throw ExecutionError(e.what());
+                }
+                compiled.tableName = compiled.newSchema->getName();
+                break;
+            }
+            case StatementKind::CREATE_INDEX: {
+                const CreateIndexStatement& create = *statement.createIndex;
+                resolveTable(compiled, create.table, table);
+                if (compiled.schemaTable) {
+                    throw ExecutionError("indexes are only supported on the users table");
+                }
+                compiled.indexColumn = findColumn(compiled, create.column);
+                compiled.indexColumnar = equalsIgnoreCase(create.method, "columnar");
+                if (equalsIgnoreCase(create.method, "zonemap")) {
+                    // one map summarizes both text columns; naming either creates it
+                    if (compiled.indexColumn == COLUMN_ID || !create.include.empty()) {
+                        throw ExecutionError("a zone map is on username or email, without INCLUDE");
+                    }
+                    compiled.indexZoneMap = true;
+                    break;
+                }
+                if (!create.method.empty() && !compiled.indexColumnar) {
+                    if (!equalsIgnoreCase(create.method, "hash")) {
+                        throw ExecutionError("unknown index method: " + std::string(create.method));
+                    }
+                    if (compiled.indexColumn != COLUMN_ID || !create.include.empty()) {
+                        throw ExecutionError("hash indexes are only supported on id, without INCLUDE");
+                    }
+                    compiled.indexHash = true;
+                    break;
+                }
+                if (compiled.indexColumn == COLUMN_ID) {
+                    throw ExecutionError(compiled.indexColumnar
+                                             ? "a columnar index is on username or email; it holds the ids anyway"
+                                             : "id is the primary key and needs no index");
+                }
+                for (std::string_view name : create.include) {
+                    uint32_t column = findColumn(compiled, name);
+                    if (column == compiled.indexColumn) {
+                        throw ExecutionError("the indexed column " + std::string(name) + " cannot also be included");
+                    }
+                    // every entry holds the id already
+                    if (column != COLUMN_ID) {
+                        compiled.indexIncludes |= 1u << column;
+                    }
+                }
+                // a column store is one set of columns, the indexed one among them
+                if (compiled.indexColumnar) {
+                    compiled.indexIncludes |= 1u << compiled.indexColumn;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    int64_t expectInteger(const Value& value, const char* context) {
+        if (value.isText) {
+            throw ExecutionError(std::string(context) + " needs an integer, not text");
+        }
+        return value.integer;
+    }
+
+    // Inclusive id range a WHERE clause can possibly match
+    struct KeyRange {
+        int64_t low = 0;
+        int64_t high = UINT32_MAX;
+    };
+
+    // The top-level AND operands of where, in order
+    void collectConjuncts(const Expr* where, std::vector<const Expr*>& conjuncts) {
+        if (where == nullptr) {
+            return;
+        }
+        if (where->kind == ExprKind::BINARY && where->op == Operator::AND) {
+            collectConjuncts(where->left, conjuncts);
+            collectConjuncts(where->right, conjuncts);
+            return;
+        }
+        conjuncts.push_back(where);
+    }
+
+    // The value a "column = constant" conjunct of where fixes for the column
+    // of a CREATE TABLE table, as the column holds it; false if no conjunct
+    // fixes one it can hold
+    bool fieldFromWhere(const std::vector<const Expr*>& conjuncts, const std::vector<Value>& bindings,
+                        uint32_t keyColumn, const ColumnSchema& definition, Field& field) {
+        bool textKey = definition.type == ColumnType::TEXT || definition.type == ColumnType::BLOB;
+        for (const Expr* conjunct : conjuncts) {
+            if (conjunct->kind != ExprKind::BINARY || conjunct->op != Operator::EQUAL) {
+                continue;
+            }
+            const Expr* column = conjunct->left;
+            const Expr* constant = conjunct->right;
+            if (column->kind != ExprKind::COLUMN) {
+                std::swap(column, constant);
+            }
+            if (column->kind != ExprKind::COLUMN || column->column != keyColumn) {
+                continue;
+            }
+            Value value;
+            if (constant->kind == ExprKind::INTEGER) {
+                value = Value{false, constant->integer, std::string_view()};
+            } else if (constant->kind == ExprKind::STRING) {
+                value = Value{true, 0, constant->text};
+            } else if (constant->kind == ExprKind::PARAMETER) {
+                value = bindings[constant->parameter];
+            } else {
+                continue;
+            }
+            // a value no key can hold is left to the evaluator
+            if (value.isText != textKey || value.text.size() > SCHEMA_KEY_MAX_SIZE) {
+                continue;
+            }
+            field.integer = value.integer;
+            field.bytes.assign(value.text);
+            return true;
+        }
+        return false;
+    }
+
+    // The encoded key of the leading primary key columns that "column =
+    // constant" conjuncts of where fix, on a CREATE TABLE table (all of them:
+    // wholeKey); false if they do not fix the first
+    bool keyFromWhere(const Expr* where, const std::vector<Value>& bindings, const Schema& schema, std::string& key,
+                      bool& wholeKey) {
+        std::vector<const Expr*> conjuncts;
+        collectConjuncts(where, conjuncts);
+        const std::vector<uint32_t>& keyColumns = schema.getPrimaryKey();
+        std::vector<Field> keyValues;
+        for (uint32_t keyColumn : keyColumns) {
+            Field field;
+            if (!fieldFromWhere(conjuncts, bindings, keyColumn, schema.getColumns()[keyColumn], field)) {
+                break;
+            }
+            keyValues.push_back(std::move(field));
+        }
+        if (keyValues.empty()) {
+            return false;
+        }
+        try {
+            key = encodeKey(keyValues, schema);
+        } catch (const std::invalid_argument&) {
+            return false;  // longer than any stored key, so it matches nothing; the filter says so
+        }
+        wholeKey = keyValues.size() == keyColumns.size();
+        return true;
+    }
+
+    // Tightens range from an "id <op> constant" conjunct, where the constant may
+    // be a bound parameter. Returns false for anything else.
+    bool narrowRange(const Expr* conjunct, KeyRange& range, const std::vector<Value>& bindings) {
+        if (conjunct->kind != ExprKind::BINARY) {
+            return false;
+        }
+        const Expr* column = conjunct->left;
+        const Expr* constant = conjunct->right;
+        Operator op = conjunct->op;
+        if (column->kind != ExprKind::COLUMN) {
+            std::swap(column, constant);
+            // mirror the comparison: 5 < id  ==  id > 5
+            switch (op) {
+                case Operator::LESS: op = Operator::GREATER; break;
+                case Operator::LESS_EQUAL: op = Operator::GREATER_EQUAL; break;
+                case Operator::GREATER: op = Operator::LESS; break;
+                case Operator::GREATER_EQUAL: op = Operator::LESS_EQUAL; break;
+                default: break;
+            }
+        }
+        if (column->kind != ExprKind::COLUMN || column->column != COLUMN_ID) {
+            return false;
+        }
+        int64_t value;
+        if (constant->kind == ExprKind::INTEGER) {
+            value = constant->integer;
+        } else if (constant->kind == ExprKind::PARAMETER && !bindings[constant->parameter].isText) {
+            value = bindings[constant->parameter].integer;
+        } else {
+            return false;
+        }
+        switch (op) {
+            case Operator::EQUAL:
+                range.low = std::max(range.low, value);
+                range.high = std::min(range.high, value);
+                break;
+            case Operator::LESS: range.high = std::min(range.high, value - 1); break;
+            case Operator::LESS_EQUAL: range.high = std::min(range.high, value); break;
+            case Operator::GREATER: range.low = std::max(range.low, value + 1); break;
+            case Operator::GREATER_EQUAL: range.low = std::max(range.low, value); break;
+            default: return false;
+        }
+        return true;
+    }
+
+    // A text conjunct a secondary index on its column could answer instead
+    struct IndexProbe {
+        uint32_t column;
+        FieldMatch match;
+        std::string_view literal;
+        size_t filterIndex;  // the same conjunct in ScanPlan::filters
+    };
+
+    // Turns "username|email = text" and "username|email LIKE pattern" into a
+    // scan filter when one kernel answers it exactly, describing it in probe
+    // too. Returns false otherwise, leaving the conjunct to the evaluator.
+    bool makeScanFilter(const Expr* conjunct, const std::vector<Value>& bindings, FieldFilter& filter,
+                        IndexProbe& probe) {
+        if (conjunct->kind != ExprKind::BINARY ||
+            (conjunct->op != Operator::EQUAL && conjunct->op != Operator::LIKE)) {
+            return false;
+        }
+        const Expr* column = conjunct->left;
+        const Expr* constant = conjunct->right;
+        if (conjunct->op == Operator::EQUAL && column->kind != ExprKind::COLUMN) {
+            std::swap(column, constant);
+        }
+        if (column->kind != ExprKind::COLUMN || column->column == COLUMN_ID) {
+            return false;
+        }
+        std::string_view text;
+        if (constant->kind == ExprKind::STRING) {
+            text = constant->text;
+        } else if (constant->kind == ExprKind::PARAMETER && bindings[constant->parameter].isText) {
+            text = bindings[constant->parameter].text;
+        } else {
+            return false;
+        }
+        // stored text ends at its first zero byte, so the kernels would disagree
+        // with the evaluator on a pattern containing one
+        if (text.find('\0') != std::string_view::npos) {
+            return false;
+        }
+        FieldMatch match = FieldMatch::EQUALS;
+        if (conjunct->op == Operator::LIKE && !classifyLike(text, match, text)) {
+            return false;
+        }
+        probe = IndexProbe{column->column, match, text, 0};
+        bool isUsername = column->column == COLUMN_USERNAME;
+        return makeFieldFilter(match, isUsername ? Row::getUsernameOffset() : Row::getEmailOffset(),
+                               isUsername ? COLUMN_USERNAME_SIZE : COLUMN_EMAIL_SIZE, text, filter);
+    }
+
+    // The zone range of "username|email <op> text" for <, <=, > and >=; the
+    // conjunct itself is still left to the evaluator. False for anything else.
+    bool makeZoneRange(const Expr* conjunct, const std::vector<Value>& bindings, ZoneRange& range) {
+        if (conjunct->kind != ExprKind::BINARY) {
+            return false;
+        }
+        const Expr* column = conjunct->left;
+        const Expr* constant = conjunct->right;
+        Operator op = conjunct->op;
+        if (column->kind != ExprKind::COLUMN) {
+            std::swap(column, constant);
+            switch (op) {
+                case Operator::LESS: op = Operator::GREATER; break;
+                case Operator::LESS_EQUAL: op = Operator::GREATER_EQUAL; break;
+                case Operator::GREATER: op = Operator::LESS; break;
+                case Operator::GREATER_EQUAL: op = Operator::LESS_EQUAL; break;
+                default: break;
+            }
+        }
+        if (column->kind != ExprKind::COLUMN || column->column == COLUMN_ID) {
+            return false;
+        }
+        std::string_view text;
+        if (constant->kind == ExprKind::STRING) {
+            text = constant->text;
+        } else if (constant->kind == ExprKind::PARAMETER && bindings[constant->parameter].isText) {
+            text = bindings[constant->parameter].text;
+        } else {
+            return false;
+        }
+        switch (op) {
+            case Operator::LESS:
+            case Operator::LESS_EQUAL: range = ZoneMap::rangeUpTo(column->column, text); return true;
+            case Operator::GREATER:
+            case Operator::GREATER_EQUAL: range = ZoneMap::rangeFrom(column->column, text); return true;
+            default: return false;
+        }
+    }
+
+    // A WHERE clause taken apart by what enforces each top-level conjunct: a
+    // bound on the scanned key range, a filter run on the leaf cells before
+    // they are decoded, or failing both a residual predicate for the evaluator.
+    // probes lists the filters an index lookup could replace; zoneRanges holds
+    // what residual text comparisons tell a zone map.
+    struct ScanPlan {
+        KeyRange range;
+        std::vector<FieldFilter> filters;
+        std::vector<IndexProbe> probes;
+        std::vector<const Expr*> residual;
+        std::vector<ZoneRange> zoneRanges;
+    };
+
+    // Reads bindings, so it runs once per execution
+    void splitWhere(const Expr* where, const std::vector<Value>& bindings, ScanPlan& plan) {
+        std::vector<const Expr*> conjuncts;
+        collectConjuncts(where, conjuncts);
+        for (const Expr* conjunct : conjuncts) {
+            FieldFilter filter;
+            IndexProbe probe;
+            if (narrowRange(conjunct, plan.range, bindings)) {
+                continue;
+            }
+            if (makeScanFilter(conjunct, bindings, filter, probe)) {
+                bool indexable = probe.match == FieldMatch::EQUALS ||
+                                 (probe.match == FieldMatch::PREFIX && !probe.literal.empty());
+                if (indexable) {
+                    probe.filterIndex = plan.filters.size();
+                    plan.probes.push_back(probe);
+                }
+                plan.filters.push_back(std::move(filter));
+            } else {
+                ZoneRange zoneRange;
+                if (makeZoneRange(conjunct, bindings, zoneRange)) {
+                    plan.zoneRanges.push_back(zoneRange);
+                }
+                plan.residual.push_back(conjunct);
+            }
+        }
+    }
+
+    // The probe to answer through an index: equality before prefix, and none
+    // when the key range alone leaves no more than a leaf or so of rows to scan
+    const IndexProbe* chooseIndex(Table& table, const ScanPlan& plan) {
+        const IndexProbe* chosen = nullptr;
+        for (const IndexProbe& probe : plan.probes) {
+            if (table.getIndex(probe.column) != nullptr &&
+                (chosen == nullptr || (chosen->match != FieldMatch::EQUALS && probe.match == FieldMatch::EQUALS))) {
+                chosen = &probe;
+            }
+        }
+        if (chosen == nullptr || plan.range.low > plan.range.high) {
+            return nullptr;
+        }
+        uint32_t begin = table.countRowsBelow(static_cast<uint64_t>(std::max<int64_t>(plan.range.low, 0)));
+        uint32_t end = table.countRowsBelow(static_cast<uint64_t>(plan.range.high) + 1);
+        return end - begin > LEAF_NODE_MAX_CELLS ? chosen : nullptr;
+    }
+
+    template <typename Scan>
+    std::unique_ptr<BatchOperator> finishScan(std::unique_ptr<Scan> scan, ScanPlan& plan, VectorEvaluator& evaluator) {
+        for (FieldFilter& filter : plan.filters) {
+            scan->pushFilter(std::move(filter));
+        }
+        if (plan.residual.empty()) {
+            return scan;
+        }
+        return std::make_unique<FilterOperator>(std::move(scan), std::move(plan.residual), evaluator);
+    }
+
+    // A scan of the tree, which the zone map can narrow, counting into stats
+    std::unique_ptr<TableScan> makeTableScan(Table& table, const ScanPlan& plan, ScanStats& stats,
+                                             bool evicts = true) {
+        auto scan = std::make_unique<TableScan>(table, plan.range.low, plan.range.high, evicts);
+        for (const ZoneRange& range : plan.zoneRanges) {
+            scan->pushZoneRange(range);
+        }
+        scan->countInto(&stats);
+        return scan;
+    }
+
+    // columns: what the rest of the plan reads from the scanned rows (bit per
+    // column); an index or column store that holds them all is read without
+    // touching the table
+    std::unique_ptr<BatchOperator> buildScan(Table& table, ScanPlan& plan, VectorEvaluator& evaluator,
+                                             uint32_t columns, ScanStats& stats) {
+        if (const IndexProbe* probe = chooseIndex(table, plan)) {
+            // the index enforces this conjunct; the scan filters on the rest
+            const SecondaryIndex& index = *table.getIndex(probe->column);
+            auto scan = std::make_unique<IndexScan>(table, index, probe->match, probe->literal, plan.range.low,
+                                                    plan.range.high, index.covers(columns));
+            plan.filters.erase(plan.filters.begin() + static_cast<std::ptrdiff_t>(probe->filterIndex));
+            return finishScan(std::move(scan), plan, evaluator);
+        }
+        // a range whose rows are read only for columns the column store holds is
+        // read from there; a point read stays a tree lookup
+        uint32_t stored = table.getColumnStoreColumns();
+        if (stored != 0 && (columns & ~(stored | (1u << COLUMN_ID))) == 0 && plan.range.low < plan.range.high) {
+            auto scan = std::make_unique<ColumnStoreScan>(*table.getColumnStore(), plan.range.low, plan.range.high);
+            return finishScan(std::move(scan), plan, evaluator);
+        }
+        return finishScan(makeTableScan(table, plan, stats), plan, evaluator);
+    }
+
+    // Builds a row from column values, checking types and sizes against the table
+    Row buildRow(const Value (&values)[NUM_COLUMNS], const bool (&present)[NUM_COLUMNS]) {
+        if (!present[COLUMN_ID]) {
+            throw ExecutionError("id is required");
+        }
+        int64_t id = expectInteger(values[COLUMN_ID], "id");
+        if (id < 0) {
+            throw ExecutionError("Row ID cannot be negative");
+        }
+        if (id > UINT32_MAX) {
+            throw ExecutionError("Row ID is too large");
+        }
+        std::string text[NUM_COLUMNS];
+        for (uint32_t column = COLUMN_USERNAME; column < NUM_COLUMNS; column++) {
+            if (!present[column]) {
+                continue;
+            }
+            if (!values[column].isText) {
+                throw ExecutionError(std::string(COLUMN_NAMES[column]) + " needs text, not an integer");
+            }
+            if (values[column].text.size() > COLUMN_MAX_LENGTH[column]) {
+                throw ExecutionError(std::string(COLUMN_NAMES[column]) + " is longer than " +
+                                     std::to_string(COLUMN_MAX_LENGTH[column]) + " characters");
+            }
+            text[column] = std::string(values[column].text);
+        }
+        return Row(static_cast<uint32_t>(id), text[COLUMN_USERNAME], text[COLUMN_EMAIL]);
+    }
+
+    void insertOrFail(Table& table, const Row& row) {
+        try {
+            table.insertRow(row);
+        } catch (const std::invalid_argument&) {
+            throw ExecutionError("Duplicate key " + std::to_string(row.getId()));
+        }
+    }
+
+    // A value for a column of a CREATE TABLE table, checked against its type
+    // and size. DOUBLE takes an integer or text that reads as a number, which
+    // is how scans return DOUBLE values.
+    Field toField(const Value& value, const ColumnSchema& column) {
+        Field field;
+        switch (column.type) {
+            case ColumnType::INT:
+            case ColumnType::BIGINT:
+                field.integer = expectInteger(value, column.name.c_str());
+                if (column.type == ColumnType::INT && (field.integer < INT32_MIN || field.integer > INT32_MAX)) {
+                    throw ExecutionError(column.name + " is out of range for an INT column");
+                }
+                break;
+            case ColumnType::DOUBLE: {
+                if (!value.isText) {
+                    field.real = static_cast<double>(value.integer);
+                    break;
+                }
+                std::string text(value.text);
+                char* end = nullptr;
+                field.real = std::strtod(text.c_str(), &end);
+                if (text.empty() || *end != '\0') {
+                    throw ExecutionError(column.name + " needs a number, not '" + text + "'");
+                }
+                break;
+            }
+            default:
+                if (!value.isText) {
+                    throw ExecutionError(column.name + " needs text, not an integer");
+                }
+                if (column.size != 0 && value.text.size() > column.size) {
+                    throw ExecutionError(column.name + " is longer than " + std::to_string(column.size) + " bytes");
+                }
+                field.bytes.assign(value.text);
+        }
+        return field;
+    }
+
+    void insertOrFail(SchemaTable& table, const std::vector<Field>& row) {
+        try {
+            table.insertRow(row);
+        } catch (const std::invalid_argument& e) {
+            throw ExecutionError(e.what());
+        }
+    }
+}
+
+CompiledStatement::CompiledStatement(std::string text)
+    : sql(std::move(text)), statement(nullptr), parameterCount(0), keyOrder(true), grouped(false),
+      indexColumn(COLUMN_ID), indexIncludes(0), indexHash(false), indexColumnar(false), indexZoneMap(false),
+      scanColumns(0), schemaTable(false),
+      schemaVersion(0) {}
+
+PrepareResult CompiledStatement::compile(std::string sql, std::shared_ptr<const CompiledStatement>& compiled,
+                                         std::string& error, const Table* table) {
+    std::shared_ptr<CompiledStatement> result = std::make_shared<CompiledStatement>(std::move(sql));
+    Parser parser(result->sql, result->arena);
+    PrepareResult parsed = parser.parse(result->statement);
+    if (parsed != PrepareResult::PREPARE_SUCCESS) {
+        error = parser.getError();
+        return parsed;
+    }
+    result->parameterCount = parser.getParameterCount();
+    try {
+        plan(*result, table);
+    } catch (const ExecutionError& e) {
+        error = e.what();
+        return PrepareResult::PREPARE_INTERNAL_FAILURE;
+    }
+    compiled = std::move(result);
+    return PrepareResult::PREPARE_SUCCESS;
+}
+
+PreparedStatement::PreparedStatement(Table& table, std::shared_ptr<const CompiledStatement> compiled)
+    : table(table), compiled(std::move(compiled)), evaluator(bindings), started(false), finished(false),
+      outputPosition(0) {
+    uint32_t count = this->compiled->parameterCount;
+    bindings.assign(count, Value{false, 0, std::string_view()});
+    bound.assign(count, false);
+    boundText.resize(count);
+}
+
+PreparedStatement::~PreparedStatement() = default;
+
+void PreparedStatement::bindInteger(uint32_t index, int64_t value) {
+    if (index == 0 || index > bindings.size()) {
+        throw std::out_of_range("Parameter index out of range");
+    }
+    bindings[index - 1] = Value{false, value, std::string_view()};
+    bound[index - 1] = true;
+}
+
+void PreparedStatement::bindText(uint32_t index, std::string_view value) {
+    if (index == 0 || index > bindings.size()) {
+        throw std::out_of_range("Parameter index out of range");
+    }
+    boundText[index - 1].assign(value.data(), value.size());
+    bindings[index - 1] = Value{true, 0, boundText[index - 1]};
+    bound[index - 1] = true;
+}
+
+void PreparedStatement::clearBindings() {
+    bound.assign(bound.size(), false);
+}
+
+void PreparedStatement::checkBindings() const {
+    for (size_t i = 0; i < bound.size(); i++) {
+        if (!bound[i]) {
+            throw ExecutionError("parameter ?" + std::to_string(i + 1) + " is not bound");
+        }
+    }
+}
+
+void PreparedStatement::reset() {
+    scanStats.leavesRead = 0;
+    scanStats.leavesSkipped = 0;
+    started = false;
+    finished = false;
+    pipeline.reset();
+    output.selectedCount = 0;
+    outputPosition = 0;
+    currentValues.clear();
+    error.clear();
+}
+
+PrepareResult PreparedStatement::runAtomically(Table& table, const std::function<PrepareResult()>& body) {
+    bool autocommit = !table.inTransaction();
+    if (autocommit) {
+        table.beginTransaction();
+    } else {
+        table.savepoint();
+    }
+
+    PrepareResult result;
+    try {
+        result = body();
+    } catch (...) {
+        autocommit ? table.rollbackTransaction() : table.rollbackToSavepoint();
+        throw;
+    }
+
+    if (result != PrepareResult::PREPARE_SUCCESS) {
+        autocommit ? table.rollbackTransaction() : table.rollbackToSavepoint();
+    } else {
+        autocommit ? table.commitTransaction() : table.releaseSavepoint();
+    }
+    return result;
+}
+
+StepResult PreparedStatement::step() {
+    if (finished) {
+        return StepResult::DONE;
+    }
+    currentValues.clear();
+    try {
+        // a SELECT's pipeline points into its plan, so only before it starts
+        if (!started) {
+            refreshPlan();
+        }
+        checkBindings();
+        switch (compiled->statement->kind) {
+            case StatementKind::SELECT:
+                if (nextSelectRow()) {
+                    return StepResult::ROW;
+                }
+                break;
+            case StatementKind::BEGIN:
+                if (table.inTransaction()) {
+                    throw ExecutionError("transaction already active");
+                }
+                table.beginTransaction();
+                break;
+            case StatementKind::COMMIT:
+            case StatementKind::ROLLBACK:
+                if (!table.inTransaction()) {
+                    throw ExecutionError("no transaction is active");
+                }
+                compiled->statement->kind == StatementKind::COMMIT ? table.commitTransaction()
+                                                                   : table.rollbackTransaction();
+                break;
+            default:
+                runAtomically(table, [this]() {
+                    runChange();
+                    return PrepareResult::PREPARE_SUCCESS;
+                });
+                break;
+        }
+    } catch (const ExecutionError& e) {
+        error = e.what();
+        finished = true;
+        return StepResult::ERROR;
+    }
+    finished = true;
+    return StepResult::DONE;
+}
+
+// A plan for a CREATE TABLE table holds that table's columns; once a CREATE
+// TABLE or a rollback has changed the schema it is compiled again, as SQLite
+// prepares a statement again after a schema change
+void PreparedStatement::refreshPlan() {
+    if (!compiled->schemaTable || compiled->schemaVersion == table.getSchemaVersion()) {
+        return;
+    }
+    std::shared_ptr<const CompiledStatement> fresh;
+    std::string message;
+    if (CompiledStatement::compile(compiled->sql, fresh, message, &table) != PrepareResult::PREPARE_SUCCESS) {
+        throw ExecutionError(message);
+    }
+    compiled = std::move(fresh);
+}
+
+// Rows the WHERE clause matches, from the cheapest scan that enforces it
+std::unique_ptr<BatchOperator> PreparedStatement::scanMatching(const Expr* where, uint32_t columns) {
+    if (compiled->schemaTable) {
+        return scanSchemaTable(where);
+    }
+    ScanPlan plan;
+    splitWhere(where, bindings, plan);
+    return buildScan(table, plan, evaluator, columns, scanStats);
+}
+
+// The rows of a CREATE TABLE table that where matches: one point read when
+// conjuncts fix the whole primary key, the rows under a key prefix when they
+// fix its leading columns, else the whole tree, with the evaluator checking
+// the clause either way
+std::unique_ptr<BatchOperator> PreparedStatement::scanSchemaTable(const Expr* where) {
+    const SchemaTable& target = *table.getSchemaTable(compiled->tableName);
+    std::unique_ptr<BatchOperator> scan;
+    std::string key;
+    bool wholeKey;
+    if (keyFromWhere(where, bindings, target.getSchema(), key, wholeKey)) {
+        scan = std::make_unique<SchemaTableScan>(target, std::move(key), wholeKey);
+    } else {
+        scan = std::make_unique<SchemaTableScan>(target);
+    }
+    if (where == nullptr) {
+        return scan;
+    }
+    return std::make_unique<FilterOperator>(std::move(scan), std::vector<const Expr*>{where}, evaluator);
+}
+
+// Ungrouped COUNT(*) and MIN/MAX(id) over a key range (the whole WHERE
+// absorbed into it) come from the row counts in the tree: O(height) instead
+// of a scan. Null when the query needs rows read.
+std::unique_ptr<BatchOperator> PreparedStatement::answerFromTree(const Expr* where) {
+    if (!compiled->groupColumns.empty()) {
+        return nullptr;
+    }
+    for (const AggregateSpec& spec : compiled->aggregates) {
+        if (spec.function == AggregateFunction::SUM ||
+            (spec.function != AggregateFunction::COUNT && spec.column != COLUMN_ID)) {
+            return nullptr;
+        }
+    }
+    ScanPlan plan;
+    splitWhere(where, bindings, plan);
+    if (!plan.filters.empty() || !plan.residual.empty()) {
+        return nullptr;
+    }
+
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    if (plan.range.low <= plan.range.high && plan.range.high >= 0 && plan.range.low <= UINT32_MAX) {
+        begin = table.countRowsBelow(static_cast<uint64_t>(std::max<int64_t>(plan.range.low, 0)));
+        end = table.countRowsBelow(static_cast<uint64_t>(plan.range.high) + 1);
+    }
+    std::vector<Value> values;
+    for (const AggregateSpec& spec : compiled->aggregates) {
+        uint32_t key = 0;
+        if (spec.function == AggregateFunction::COUNT) {
+            values.push_back(Value{false, static_cast<int64_t>(end - begin), std::string_view()});
+            continue;
+        }
+        if (begin == end) {
+            // MIN/MAX of no rows: no result row, as from AggregateOperator
+            return std::make_unique<SingleRowOperator>(std::vector<Value>());
+        }
+        table.keyAtRank(spec.function == AggregateFunction::MIN ? begin : end - 1, key);
+        values.push_back(Value{false, key, std::string_view()});
+    }
+    return std::make_unique<SingleRowOperator>(std::move(values));
+}
+
+// A grouped SELECT whose rows come from a table scan of at least
+// PARALLEL_SCAN_MIN_ROWS rows, aggregated per morsel on the table's scheduler
+// and merged in key order. Null when there is no scheduler, an index serves
+// the WHERE clause, or the range is too small to be worth splitting.
+std::unique_ptr<BatchOperator> PreparedStatement::aggregateInParallel(const Expr* where) {
+    Scheduler* scheduler = table.getScheduler();
+    if (scheduler == nullptr) {
+        return nullptr;
+    }
+    ScanPlan plan;
+    splitWhere(where, bindings, plan);
+    if (plan.range.low > plan.range.high || plan.range.high < 0 || plan.range.low > UINT32_MAX ||
+        chooseIndex(table, plan) != nullptr) {
+        return nullptr;
+    }
+    uint32_t begin = table.countRowsBelow(static_cast<uint64_t>(std::max<int64_t>(plan.range.low, 0)));
+    uint32_t end = table.countRowsBelow(static_cast<uint64_t>(plan.range.high) + 1);
+    if (end - begin < PARALLEL_SCAN_MIN_ROWS) {
+        return nullptr;
+    }
+
+    std::unique_ptr<AggregateOperator> result = ParallelScan(table, *scheduler).reduceMorsels(
+        [&](const ScanMorsel& morsel) {
+            ScanPlan part = plan;
+            part.range.low = std::max<int64_t>(plan.range.low, morsel.lowKey);
+            part.range.high = std::min<int64_t>(plan.range.high, morsel.highKey);
+            // the evaluator keeps scratch columns, so each morsel needs its own
+            VectorEvaluator morselEvaluator(bindings);
+            auto scan = makeTableScan(table, part, scanStats, false);
+            auto aggregate = std::make_unique<AggregateOperator>(finishScan(std::move(scan), part, morselEvaluator),
+                                                                 compiled->groupColumns, compiled->aggregates);
+            aggregate->foldInput();
+            return aggregate;
+        },
+        [](std::unique_ptr<AggregateOperator>& into, std::unique_ptr<AggregateOperator>& from) {
+            into->merge(*from);
+        });
+    table.getPager().evictToCapacity();
+    return result;
+}
+
+// scan -> filter -> [aggregate] -> sort (unless the input order already
+// satisfies ORDER BY) -> limit -> project
+void PreparedStatement::buildSelectPipeline() {
+    const SelectStatement& select = *compiled->statement->select;
+    int64_t limit = evaluateCount(select.limit, INT64_MAX, "LIMIT");
+    int64_t offset = evaluateCount(select.offset, 0, "OFFSET");
+    std::unique_ptr<BatchOperator> root;
+    if (compiled->grouped) {
+        // the row counts and morsels are those of the users tree
+        if (!compiled->schemaTable) {
+            root = answerFromTree(select.where);
+        }
+        if (root == nullptr && !compiled->schemaTable) {
+            root = aggregateInParallel(select.where);
+        }
+        if (root == nullptr) {
+            root = std::make_unique<AggregateOperator>(scanMatching(select.where, compiled->scanColumns),
+                                                       compiled->groupColumns, compiled->aggregates);
+        }
+    } else if (compiled->schemaTable) {
+        root = scanSchemaTable(select.where);
+    } else {
+        ScanPlan plan;
+        splitWhere(select.where, bindings, plan);
+        if (offset > 0 && compiled->keyOrder && plan.filters.empty() && plan.residual.empty()) {
+            // every row in the range is output, so OFFSET is a rank: jump straight to it
+            uint32_t start = table.countRowsBelow(static_cast<uint64_t>(std::max<int64_t>(plan.range.low, 0)));
+            uint32_t key;
+            if (plan.range.low <= UINT32_MAX && offset <= static_cast<int64_t>(UINT32_MAX - start) &&
+                table.keyAtRank(start + static_cast<uint32_t>(offset), key)) {
+                plan.range.low = key;
+            } else {
+                plan.range.low = plan.range.high + 1;
+            }
+            offset = 0;
+        }
+        root = buildScan(table, plan, evaluator, compiled->scanColumns, scanStats);
+    }
+    if (!compiled->keyOrder) {
+        std::vector<SortKey> keys;
+        for (uint32_t i = 0; i < compiled->orderColumns.size(); i++) {
+            keys.push_back(SortKey{compiled->orderColumns[i], select.orderBy[i].descending});
+        }
+        // a LIMIT bounds how many sorted rows are ever needed
+        uint64_t needed = limit == INT64_MAX ? UINT64_MAX : static_cast<uint64_t>(offset) + static_cast<uint64_t>(limit);
+        root = std::make_unique<SortOperator>(std::move(root), std::move(keys), needed);
+    }
+    if (limit != INT64_MAX || offset != 0) {
+        root = std::make_unique<LimitOperator>(std::move(root), offset, limit);
+    }
+    if (!select.star) {
+        std::vector<const Expr*> columns(select.columns.begin(), select.columns.end());
+        root = std::make_unique<ProjectOperator>(std::move(root), std::move(columns), evaluator, projectInput);
+    }
+    pipeline = std::move(root);
+}
+
+int64_t PreparedStatement::evaluateCount(const Expr* expr, int64_t fallback, const char* clause) {
+    if (expr == nullptr) {
+        return fallback;
+    }
+    int64_t count = expectInteger(evaluator.evaluateConstant(*expr), clause);
+    if (count < 0) {
+        throw ExecutionError(std::string(clause) + " must not be negative");
+    }
+    return count;
+}
+
+bool PreparedStatement::nextSelectRow() {
+    if (!started) {
+        started = true;
+        buildSelectPipeline();
+    }
+    while (outputPosition >= output.selectedCount) {
+        if (!pipeline->next(output)) {
+            return false;
+        }
+        outputPosition = 0;
+    }
+    uint32_t row = output.selection[outputPosition++];
+    for (const ColumnVector& column : output.columns) {
+        currentValues.push_back(column.get(row));
+    }
+    return true;
+}
+
+void PreparedStatement::runChange() {
+    const Statement& statement = *compiled->statement;
+    if (statement.kind == StatementKind::CREATE_TABLE) {
+        if (table.getSchemaTable(compiled->tableName) != nullptr) {
+            throw ExecutionError("table " + compiled->tableName + " already exists");
+        }
+        table.createTable(*compiled->newSchema);
+        return;
+    }
+    if (compiled->schemaTable) {
+        runSchemaChange(*table.getSchemaTable(compiled->tableName));
+        return;
+    }
+    if (statement.kind == StatementKind::CREATE_INDEX) {
+        if (compiled->indexHash) {
+            if (table.getHashIndex() != nullptr) {
+                throw ExecutionError("a hash index on id already exists");
+            }
+            table.createHashIndex();
+            return;
+        }
+        if (compiled->indexZoneMap) {
+            if (table.getZoneMap() != nullptr) {
+                throw ExecutionError("a zone map already exists");
+            }
+            table.createZoneMap();
+            return;
+        }
+        if (compiled->indexColumnar) {
+            if (table.getColumnStoreColumns() != 0) {
+                throw ExecutionError("a columnar index already exists");
+            }
+            table.createColumnStore(compiled->indexIncludes);
+            return;
+        }
+        if (table.getIndex(compiled->indexColumn) != nullptr) {
+            throw ExecutionError("an index on " + std::string(COLUMN_NAMES[compiled->indexColumn]) + " already exists");
+        }
+        table.createIndex(compiled->indexColumn, compiled->indexIncludes);
+        return;
+    }
+    if (statement.kind == StatementKind::INSERT) {
+        const std::vector<uint32_t>& targets = compiled->insertTargets;
+        for (const ArenaList<const Expr*>& values : statement.insert->rows) {
+            Value rowValues[NUM_COLUMNS] = {};
+            bool present[NUM_COLUMNS] = {};
+            for (uint32_t i = 0; i < targets.size(); i++) {
+                rowValues[targets[i]] = evaluator.evaluateConstant(*values[i]);
+                present[targets[i]] = true;
+            }
+            insertOrFail(table, buildRow(rowValues, present));
+        }
+        return;
+    }
+
+    if (statement.kind == StatementKind::UPDATE) {
+        const UpdateStatement& update = *statement.update;
+        const std::vector<uint32_t>& assignedColumns = compiled->assignedColumns;
+        // compute every new row before changing anything; the scan must not see its own writes
+        std::vector<std::pair<uint32_t, Row>> changes;
+        std::vector<ColumnVector> assigned(assignedColumns.size());
+        std::unique_ptr<BatchOperator> scan = scanMatching(update.where, compiled->scanColumns);
+        Batch batch;
+        while (scan->next(batch)) {
+            for (uint32_t i = 0; i < assignedColumns.size(); i++) {
+                evaluator.evaluate(*update.assignments[i].value, batch, batch.selection.data(), batch.selectedCount,
+                                   assigned[i]);
+            }
+            for (uint32_t s = 0; s < batch.selectedCount; s++) {
+                uint32_t row = batch.selection[s];
+                Value values[NUM_COLUMNS];
+                bool present[NUM_COLUMNS] = {true, true, true};
+                for (uint32_t column = 0; column < NUM_COLUMNS; column++) {
+                    values[column] = batch.columns[column].get(row);
+                }
+                for (uint32_t i = 0; i < assignedColumns.size(); i++) {
+                    values[assignedColumns[i]] = assigned[i].get(row);
+                }
+                changes.emplace_back(static_cast<uint32_t>(batch.columns[COLUMN_ID].integers[row]),
+                                     buildRow(values, present));
+            }
+        }
+
+        // rows whose id changes are removed first, so SET id = id + 1 cannot collide with itself
+        for (const auto& change : changes) {
+            if (change.second.getId() != change.first) {
+                table.deleteRow(change.first);
+            }
+        }
+        for (const auto& change : changes) {
+            if (change.second.getId() == change.first) {
+                table.updateRow(change.second);
+            } else {
+                insertOrFail(table, change.second);
+            }
+        }
+        return;
+    }
+
+    std::vector<uint32_t> keys;
+    std::unique_ptr<BatchOperator> scan = scanMatching(statement.remove->where, compiled->scanColumns);
+    Batch batch;
+    while (scan->next(batch)) {
+        const ColumnVector& ids = batch.columns[COLUMN_ID];
+        for (uint32_t s = 0; s < batch.selectedCount; s++) {
+            keys.push_back(static_cast<uint32_t>(ids.integers[batch.selection[s]]));
+        }
+    }
+    for (uint32_t key : keys) {
+        table.deleteRow(key);
+    }
+}
+
+// INSERT, UPDATE and DELETE on a CREATE TABLE table
+void PreparedStatement::runSchemaChange(SchemaTable& target) {
+    const Statement& statement = *compiled->statement;
+    const std::vector<ColumnSchema>& columns = target.getSchema().getColumns();
+    const std::vector<uint32_t>& keyColumns = compiled->keyColumns;
+    if (statement.kind == StatementKind::INSERT) {
+        const std::vector<uint32_t>& targets = compiled->insertTargets;
+        for (uint32_t keyColumn : keyColumns) {
+            if (std::find(targets.begin(), targets.end(), keyColumn) == targets.end()) {
+                throw ExecutionError(columns[keyColumn].name + " is required");
+            }
+        }
+        for (const ArenaList<const Expr*>& values : statement.insert->rows) {
+            // columns left out are 0 or empty
+            std::vector<Field> row(columns.size());
+            for (uint32_t i = 0; i < targets.size(); i++) {
+                row[targets[i]] = toField(evaluator.evaluateConstant(*values[i]), columns[targets[i]]);
+            }
+            insertOrFail(target, row);
+        }
+        return;
+    }
+
+    // the scan must not see its own writes: collect first, then change
+    std::vector<std::vector<Field>> oldKeys;
+    std::vector<std::vector<Field>> newRows;
+    const Expr* where = statement.kind == StatementKind::UPDATE ? statement.update->where : statement.remove->where;
+    std::vector<ColumnVector> assigned(compiled->assignedColumns.size());
+    std::unique_ptr<BatchOperator> scan = scanSchemaTable(where);
+    Batch batch;
+    while (scan->next(batch)) {
+        if (statement.kind == StatementKind::DELETE) {
+            for (uint32_t s = 0; s < batch.selectedCount; s++) {
+                std::vector<Field> key;
+                for (uint32_t keyColumn : keyColumns) {
+                    key.push_back(toField(batch.columns[keyColumn].get(batch.selection[s]), columns[keyColumn]));
+                }
+                oldKeys.push_back(std::move(key));
+            }
+            continue;
+        }
+        for (uint32_t i = 0; i < assigned.size(); i++) {
+            evaluator.evaluate(*statement.update->assignments[i].value, batch, batch.selection.data(),
+                               batch.selectedCount, assigned[i]);
+        }
+        for (uint32_t s = 0; s < batch.selectedCount; s++) {
+            uint32_t row = batch.selection[s];
+            std::vector<Field> fields(columns.size());
+            for (uint32_t column = 0; column < columns.size(); column++) {
+                fields[column] = toField(batch.columns[column].get(row), columns[column]);
+            }
+            std::vector<Field> key;
+            for (uint32_t keyColumn : keyColumns) {
+                key.push_back(fields[keyColumn]);
+            }
+            oldKeys.push_back(std::move(key));
+            for (uint32_t i = 0; i < assigned.size(); i++) {
+                uint32_t column = compiled->assignedColumns[i];
+                fields[column] = toField(assigned[i].get(row), columns[column]);
+            }
+            newRows.push_back(std::move(fields));
+        }
+    }
+    // every old row goes before any new one is added, so a changed key cannot
+    // collide with a row that is about to move
+    for (const std::vector<Field>& key : oldKeys) {
+        target.deleteRow(key);
+    }
+    for (const std::vector<Field>& row : newRows) {
+        insertOrFail(target, row);
+    }
+}
@@ -0,0 +1,331 @@
+#include "result_sink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <sys/uio.h>
+
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "table.hpp"
+
+namespace {
+    constexpr std::string_view USERS_TABLE_NAME = "users";
+    // Most bytes std::to_chars takes for an int64_t
+    constexpr size_t INTEGER_MAX_CHARS = 20;
+    constexpr size_t PAGE_ALIGNMENT = 4096;
+    constexpr uint8_t BINARY_INTEGER = 0;
+    constexpr uint8_t BINARY_TEXT = 1;
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = (a[i] >= 'A' && a[i] <= 'Z') ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            char y = (b[i] >= 'A' && b[i] <= 'Z') ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+            if (x != y) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool needsQuotes(std::string_view text) {
+        for (char c : text) {
+            if (c == ',' || c == '"' || c == '\n' || c == '\r') {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The escape letter for a byte TSV cannot hold as it is, or 0
+    char tsvEscape(char c) {
+        switch (c) {
+            case '\t': return 't';
+            case '\n': return 'n';
+            case '\r': return 'r';
+            case '\\': return '\\';
+            default: return 0;
+        }
+    }
+}
+
+ResultSink::ResultSink(int fd, ExportFormat format)
+    : fileDescriptor(fd), format(format), used(SINK_BLOCKS, 0), current(0), rowsWritten(0), bytesWritten(0) {
+    for (uint32_t i = 0; i < SINK_BLOCKS; i++) {
+        void* block = std::aligned_alloc(PAGE_ALIGNMENT, SINK_BLOCK_BYTES);
+        if (block == nullptr) {
+            for (char* allocated : blocks) {
+                std::free(allocated);
+            }
+            throw std::bad_alloc();
+        }
+        blocks.push_back(static_cast<char*>(block));
+    }
+}
+
+ResultSink::~ResultSink() {
+    try {
+        writeBlocks();
+    } catch (const std::runtime_error&) {
+        // a destructor cannot report it; flush() does
+    }
+    for (char* block : blocks) {
+        std::free(block);
+    }
+}
+
+void ResultSink::writeBlocks() {
+    struct iovec iov[SINK_BLOCKS];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i <= current && i < SINK_BLOCKS; i++) {
+        if (used[i] > 0) {
+            iov[count].iov_base = blocks[i];
+            iov[count].iov_len = used[i];
+            count++;
+        }
+    }
+    uint32_t first = 0;
+    while (first < count) {
+        ssize_t written = writev(fileDescriptor, iov + first, static_cast<int>(count - first));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write export: ") + std::strerror(errno));
+        }
+        bytesWritten += static_cast<uint64_t>(written);
+        // a short write leaves the rest of the blocks for the next call
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining > 0 && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            first++;
+        }
+        if (remaining > 0) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    std::fill(used.begin(), used.end(), 0);
+    current = 0;
+}
+
+char* ResultSink::reserve(size_t bytes) {
+    if (SINK_BLOCK_BYTES - used[current] < bytes) {
+        if (current + 1 == SINK_BLOCKS) {
+            writeBlocks();
+        } else {
+            current++;
+        }
+    }
+    return blocks[current] + used[current];
+}
+
+void ResultSink::append(const char* data, size_t length) {
+    while (length > 0) {
+        if (used[current] == SINK_BLOCK_BYTES) {
+            reserve(1);
+        }
+        size_t chunk = std::min(length, SINK_BLOCK_BYTES - used[current]);
+        std::memcpy(blocks[current] + used[current], data, chunk);
+        used[current] += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+void ResultSink::writeText(std::string_view text) {
+    switch (format) {
+        case ExportFormat::CSV:
+            if (!needsQuotes(text)) {
+                append(text.data(), text.size());
+                return;
+            }
+            append("\"", 1);
+            for (size_t quote; (quote = text.find('"')) != std::string_view::npos; text.remove_prefix(quote + 1)) {
+                append(text.data(), quote + 1);
+                append("\"", 1);
+            }
+            append(text.data(), text.size());
+            append("\"", 1);
+            return;
+        case ExportFormat::TSV: {
+            size_t start = 0;
+            for (size_t i = 0; i < text.size(); i++) {
+                char escape = tsvEscape(text[i]);
+                if (escape != 0) {
+                    append(text.data() + start, i - start);
+                    char escaped[2] = {'\\', escape};
+                    append(escaped, 2);
+                    start = i + 1;
+                }
+            }
+            append(text.data() + start, text.size() - start);
+            return;
+        }
+        case ExportFormat::BINARY: {
+            char* header = reserve(1 + sizeof(uint32_t));
+            header[0] = static_cast<char>(BINARY_TEXT);
+            uint32_t length = static_cast<uint32_t>(text.size());
+            std::memcpy(header + 1, &length, sizeof(length));
+            used[current] += 1 + sizeof(uint32_t);
+            append(text.data(), text.size());
+            return;
+        }
+    }
+}
+
+void ResultSink::writeValue(const Value& value) {
+    if (value.isText) {
+        writeText(value.text);
+        return;
+    }
+    if (format == ExportFormat::BINARY) {
+        char* out = reserve(1 + sizeof(int64_t));
+        out[0] = static_cast<char>(BINARY_INTEGER);
+        std::memcpy(out + 1, &value.integer, sizeof(int64_t));
+        used[current] += 1 + sizeof(int64_t);
+        return;
+    }
+    char* out = reserve(INTEGER_MAX_CHARS);
+    used[current] += static_cast<size_t>(std::to_chars(out, out + INTEGER_MAX_CHARS, value.integer).ptr - out);
+}
+
+void ResultSink::writeHeader(const std::vector<std::string>& columnNames) {
+    if (format == ExportFormat::BINARY) {
+        uint32_t count = static_cast<uint32_t>(columnNames.size());
+        append(SINK_BINARY_MAGIC, sizeof(SINK_BINARY_MAGIC));
+        append(reinterpret_cast<const char*>(&count), sizeof(count));
+        return;
+    }
+    std::vector<Value> names;
+    for (const std::string& name : columnNames) {
+        names.push_back(Value{true, 0, name});
+    }
+    writeFields(names.data(), static_cast<uint32_t>(names.size()));
+}
+
+void ResultSink::writeFields(const Value* values, uint32_t count) {
+    char separator = format == ExportFormat::TSV ? '\t' : ',';
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0 && format != ExportFormat::BINARY) {
+            append(&separator, 1);
+        }
+        writeValue(values[i]);
+    }
+    if (format != ExportFormat::BINARY) {
+        append("\n", 1);
+    }
+}
+
+void ResultSink::writeRow(const Value* values, uint32_t count) {
+    writeFields(values, count);
+    rowsWritten++;
+}
+
+void ResultSink::writeBatch(const Batch& batch) {
+    char separator = format == ExportFormat::TSV ? '\t' : ',';
+    uint32_t numColumns = static_cast<uint32_t>(batch.columns.size());
+    for (uint32_t s = 0; s < batch.selectedCount; s++) {
+        uint32_t row = batch.selection[s];
+        for (uint32_t c = 0; c < numColumns; c++) {
+            if (c > 0 && format != ExportFormat::BINARY) {
+                append(&separator, 1);
+            }
+            writeValue(batch.columns[c].get(row));
+        }
+        if (format != ExportFormat::BINARY) {
+            append("\n", 1);
+        }
+    }
+    rowsWritten += batch.selectedCount;
+}
+
+void ResultSink::flush() {
+    writeBlocks();
+}
+
+std::vector<std::vector<Value>> ResultSink::decodeBinary(std::string_view data) {
+    auto take = [&](size_t bytes) {
+        if (data.size() < bytes) {
+            throw std::invalid_argument("Binary export ends in the middle of a value");
+        }
+        const char* start = data.data();
+        data.remove_prefix(bytes);
+        return start;
+    };
+    if (std::memcmp(take(sizeof(SINK_BINARY_MAGIC)), SINK_BINARY_MAGIC, sizeof(SINK_BINARY_MAGIC)) != 0) {
+        throw std::invalid_argument("Not a binary export");
+    }
+    uint32_t numColumns;
+    std::memcpy(&numColumns, take(sizeof(numColumns)), sizeof(numColumns));
+    std::vector<std::vector<Value>> rows;
+    while (!data.empty()) {
+        if (numColumns == 0) {
+            throw std::invalid_argument("Binary export of no columns has rows");
+        }
+        std::vector<Value>& row = rows.emplace_back();
+        for (uint32_t c = 0; c < numColumns; c++) {
+            uint8_t type = static_cast<uint8_t>(*take(1));
+            if (type == BINARY_INTEGER) {
+                int64_t integer;
+                std::memcpy(&integer, take(sizeof(integer)), sizeof(integer));
+                row.push_back(Value{false, integer, {}});
+            } else if (type == BINARY_TEXT) {
+                uint32_t length;
+                std::memcpy(&length, take(sizeof(length)), sizeof(length));
+                row.push_back(Value{true, 0, std::string_view(take(length), length)});
+            } else {
+                throw std::invalid_argument("Unknown value type " + std::to_string(type) + " in binary export");
+            }
+        }
+    }
+    return rows;
+}
+
+bool parseExportFormat(std::string_view name, ExportFormat& format) {
+    if (equalsIgnoreCase(name, "csv")) {
+        format = ExportFormat::CSV;
+    } else if (equalsIgnoreCase(name, "tsv")) {
+        format = ExportFormat::TSV;
+    } else if (equalsIgnoreCase(name, "binary")) {
+        format = ExportFormat::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+uint64_t exportTable(Table& table, std::string_view tableName, int fd, ExportFormat format) {
+    ResultSink sink(fd, format);
+    Batch batch;
+    if (equalsIgnoreCase(tableName, USERS_TABLE_NAME)) {
+        sink.writeHeader({"id", "username", "email"});
+        TableScan scan(table);
+        while (scan.next(batch)) {
+            sink.writeBatch(batch);
+        }
+    } else {
+        const SchemaTable* schemaTable = table.getSchemaTable(tableName);
+        if (schemaTable == nullptr) {
+            throw std::invalid_argument("No such table: " + std::string(tableName));
+        }
+        std::vector<std::string> names;
+        for (const ColumnSchema& column : schemaTable->getSchema().getColumns()) {
+            names.push_back(column.name);
+        }
+        sink.writeHeader(names);
+        SchemaTableScan scan(*schemaTable);
+        while (scan.next(batch)) {
+            sink.writeBatch(batch);
+        }
+    }
+    sink.flush();
+    return sink.getRowsWritten();
+}
@@ -11,9 +11,10 @@ Row::Row(uint32_t rowId, const std::string& user, const std::string& emailAddr)
     email[COLUMN_EMAIL_SIZE - 1] = '\0';
 }
 
+// Zero-filled, like the padding strncpy leaves: scan filters compare whole fields
 Row::Row() : id(0) {
-    username[0] = '\0';
-    email[0] = '\0';
+    std::memset(username, 0, sizeof(username));
+    std::memset(email, 0, sizeof(email));
 }
 
 void Row::serialize(void* destination) const {
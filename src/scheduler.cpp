@@ -0,0 +1,248 @@
+#include "scheduler.hpp"
+
+#include <chrono>
+#include <exception>
+#include <limits>
+
+namespace {
+    // lets submit() from inside a task push to the running worker's own deque
+    thread_local const Scheduler* currentScheduler = nullptr;
+    thread_local uint32_t currentQueueIndex = 0;
+    // class of the task running on this thread; NUM_TASK_PRIORITIES = none
+    thread_local uint32_t currentTaskPriority = NUM_TASK_PRIORITIES;
+
+    constexpr int64_t NO_TIMER_DUE = std::numeric_limits<int64_t>::max();
+}
+
+Scheduler::Scheduler(uint32_t maxWorkers) : nextQueue(0), tasksRun(0), tasksStolen(0), stopping(false), nextTimerDue(NO_TIMER_DUE) {
+    uint32_t numWorkers = std::thread::hardware_concurrency();
+    if (maxWorkers != 0 && (numWorkers == 0 || maxWorkers < numWorkers)) {
+        numWorkers = maxWorkers;
+    }
+    if (numWorkers == 0) {
+        numWorkers = 1;
+    }
+    for (uint32_t p = 0; p < NUM_TASK_PRIORITIES; p++) {
+        queuedTasks[p] = 0;
+    }
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        workers.emplace_back(&Scheduler::workerLoop, this, i);
+    }
+}
+
+Scheduler::~Scheduler() {
+    shutdown();
+}
+
+void Scheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+        timers.clear();
+        nextTimerDue.store(NO_TIMER_DUE, std::memory_order_release);
+    }
+    wakeUp.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void Scheduler::submit(std::function<void()> task, TaskPriority priority) {
+    uint32_t priorityIndex = static_cast<uint32_t>(priority);
+    uint32_t queueIndex;
+    if (currentScheduler == this) {
+        queueIndex = currentQueueIndex;
+    } else {
+        queueIndex = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->tasks[priorityIndex].push_back(std::move(task));
+    }
+    {
+        // taken so a worker cannot miss the count change between its check and its wait
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks[priorityIndex].fetch_add(1, std::memory_order_release);
+    }
+    wakeUp.notify_one();
+}
+
+bool Scheduler::submitAfter(std::chrono::milliseconds delay, std::function<void()> task, TaskPriority priority) {
+    std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now() + delay;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (stopping) {
+            return false;
+        }
+        timers.emplace(due, TimedTask{std::move(task), priority});
+        nextTimerDue.store(timers.begin()->first.time_since_epoch().count(), std::memory_order_release);
+    }
+    // a sleeping worker has to recompute its wake-up deadline
+    wakeUp.notify_one();
+    return true;
+}
+
+// Moves every timer that has come due into the normal queues
+void Scheduler::promoteDueTimers() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now.time_since_epoch().count() < nextTimerDue.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<TimedTask> due;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        while (!timers.empty() && timers.begin()->first <= now) {
+            due.push_back(std::move(timers.begin()->second));
+            timers.erase(timers.begin());
+        }
+        nextTimerDue.store(timers.empty() ? NO_TIMER_DUE : timers.begin()->first.time_since_epoch().count(),
+                           std::memory_order_release);
+    }
+    for (TimedTask& timed : due) {
+        submit(std::move(timed.task), timed.priority);
+    }
+}
+
+bool Scheduler::popOwn(uint32_t queueIndex, uint32_t priority, std::function<void()>& task) {
+    WorkerQueue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    std::deque<std::function<void()>>& tasks = queue.tasks[priority];
+    if (tasks.empty()) {
+        return false;
+    }
+    task = std::move(tasks.back());
+    tasks.pop_back();
+    return true;
+}
+
+// Steals the oldest task of one class, starting with the thief's neighbour
+bool Scheduler::steal(uint32_t thiefIndex, uint32_t priority, std::function<void()>& task) {
+    uint32_t numQueues = static_cast<uint32_t>(queues.size());
+    for (uint32_t offset = 1; offset <= numQueues; offset++) {
+        WorkerQueue& victim = *queues[(thiefIndex + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        std::deque<std::function<void()>>& tasks = victim.tasks[priority];
+        if (!tasks.empty()) {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            tasksStolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs the most urgent available task no less urgent than leastUrgentPriority.
+// queueIndex == queues.size() means "not a worker": only steal.
+bool Scheduler::tryRunOne(uint32_t queueIndex, uint32_t leastUrgentPriority) {
+    std::function<void()> task;
+    for (uint32_t priority = 0; priority <= leastUrgentPriority && priority < NUM_TASK_PRIORITIES; priority++) {
+        if (queuedTasks[priority].load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        bool found = (queueIndex < queues.size() && popOwn(queueIndex, priority, task)) ||
+                     steal(queueIndex, priority, task);
+        if (!found) {
+            continue;
+        }
+        queuedTasks[priority].fetch_sub(1, std::memory_order_acq_rel);
+        uint32_t outerPriority = currentTaskPriority;
+        currentTaskPriority = priority;
+        task();
+        currentTaskPriority = outerPriority;
+        tasksRun.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool Scheduler::hasQueuedTasks() const {
+    for (uint32_t p = 0; p < NUM_TASK_PRIORITIES; p++) {
+        if (queuedTasks[p].load(std::memory_order_acquire) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::workerLoop(uint32_t queueIndex) {
+    currentScheduler = this;
+    currentQueueIndex = queueIndex;
+    while (true) {
+        promoteDueTimers();
+        if (tryRunOne(queueIndex, NUM_TASK_PRIORITIES - 1)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (timers.empty()) {
+            wakeUp.wait(lock, [this]() { return stopping || hasQueuedTasks() || !timers.empty(); });
+        } else {
+            // re-arm when submitAfter adds a timer due before the current deadline
+            std::chrono::steady_clock::time_point deadline = timers.begin()->first;
+            wakeUp.wait_until(lock, deadline, [this, deadline]() {
+                return stopping || hasQueuedTasks() || timers.empty() || timers.begin()->first < deadline;
+            });
+        }
+        // drain before exiting so queued maintenance still runs at shutdown
+        if (stopping && !hasQueuedTasks()) {
+            return;
+        }
+    }
+}
+
+void Scheduler::yieldPoint() {
+    uint32_t runningPriority = currentTaskPriority;
+    if (runningPriority == 0 || runningPriority >= NUM_TASK_PRIORITIES) {
+        return;
+    }
+    uint32_t queueIndex = (currentScheduler == this) ? currentQueueIndex : static_cast<uint32_t>(queues.size());
+    while (tryRunOne(queueIndex, runningPriority - 1)) {
+    }
+}
+
+void Scheduler::parallelFor(uint32_t count, const std::function<void(uint32_t)>& body, TaskPriority priority) {
+    if (count == 0) {
+        return;
+    }
+    std::atomic<uint32_t> remaining(count);
+    std::mutex doneMutex;
+    std::condition_variable done;
+    std::exception_ptr firstError;
+
+    for (uint32_t i = 0; i < count; i++) {
+        submit([&, i]() {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+            }
+            // decrement under the lock: once the caller has seen zero and taken the
+            // lock itself, no task touches this stack frame again
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                done.notify_all();
+            }
+        }, priority);
+    }
+
+    uint32_t callerIndex = (currentScheduler == this) ? currentQueueIndex : static_cast<uint32_t>(queues.size());
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne(callerIndex, static_cast<uint32_t>(priority))) {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait_for(lock, std::chrono::milliseconds(1), [&]() { return remaining.load() == 0; });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(doneMutex);
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
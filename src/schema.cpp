@@ -0,0 +1,408 @@
+#include "schema.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    std::string lowerCase(std::string_view text) {
+        std::string lowered(text);
+        for (char& c : lowered) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return lowered;
+    }
+
+    bool isText(ColumnType type) {
+        return type == ColumnType::TEXT || type == ColumnType::BLOB;
+    }
+
+    // Bytes a value of the column takes in a fixed-width row
+    uint32_t fixedWidthOf(const ColumnSchema& column) {
+        switch (column.type) {
+            case ColumnType::INT:
+                return sizeof(int32_t);
+            case ColumnType::BIGINT:
+            case ColumnType::DOUBLE:
+                return sizeof(int64_t);
+            default:
+                return sizeof(uint16_t) + column.size;
+        }
+    }
+
+    uint16_t readLength(const char* data) {
+        uint16_t length;
+        std::memcpy(&length, data, sizeof(length));
+        return length;
+    }
+
+    // Serialized schema: first primary key column, column count, then per
+    // column the type, the size and the name's length and bytes; a composite
+    // key follows with its column count and every key column
+    void appendU32(std::string& out, uint32_t value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    uint32_t takeU32(std::string_view data, size_t& position) {
+        if (position + sizeof(uint32_t) > data.size()) {
+            throw std::runtime_error("Corrupt table catalog: truncated schema");
+        }
+        uint32_t value;
+        std::memcpy(&value, data.data() + position, sizeof(value));
+        position += sizeof(value);
+        return value;
+    }
+}
+
+Schema::Schema(std::string_view tableName, std::vector<ColumnSchema> tableColumns,
+               std::vector<uint32_t> primaryKeyColumns)
+    : name(lowerCase(tableName)), columns(std::move(tableColumns)), primaryKey(std::move(primaryKeyColumns)) {
+    if (name.empty() || name.size() > INDEX_KEY_MAX_SIZE) {
+        throw std::invalid_argument("Table names must be 1 to " + std::to_string(INDEX_KEY_MAX_SIZE) + " characters");
+    }
+    if (columns.empty() || columns.size() > SCHEMA_MAX_COLUMNS) {
+        throw std::invalid_argument("A table has 1 to " + std::to_string(SCHEMA_MAX_COLUMNS) + " columns");
+    }
+    for (uint32_t i = 0; i < columns.size(); i++) {
+        columns[i].name = lowerCase(columns[i].name);
+        if (columns[i].name.empty() || columns[i].name.size() > UINT8_MAX) {
+            throw std::invalid_argument("Column names must be 1 to " + std::to_string(UINT8_MAX) + " characters");
+        }
+        if (!isText(columns[i].type)) {
+            columns[i].size = 0;
+        } else if (columns[i].size > SCHEMA_ROW_MAX_SIZE) {
+            throw std::invalid_argument("Column " + columns[i].name + " is longer than a row may be");
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (columns[j].name == columns[i].name) {
+                throw std::invalid_argument("Duplicate column " + columns[i].name);
+            }
+        }
+    }
+    if (primaryKey.empty()) {
+        throw std::invalid_argument("A table needs a primary key");
+    }
+    // the longest encoded key, as encodeKey writes it
+    uint32_t keySize = 0;
+    for (uint32_t k = 0; k < primaryKey.size(); k++) {
+        if (primaryKey[k] >= columns.size()) {
+            throw std::invalid_argument("The primary key is not a column of the table");
+        }
+        const ColumnSchema& key = columns[primaryKey[k]];
+        if (std::find(primaryKey.begin(), primaryKey.begin() + k, primaryKey[k]) != primaryKey.begin() + k) {
+            throw std::invalid_argument("Column " + key.name + " is in the primary key twice");
+        }
+        if (key.type == ColumnType::DOUBLE) {
+            throw std::invalid_argument("A DOUBLE column cannot be in the primary key");
+        }
+        if (!isText(key.type)) {
+            keySize += SCHEMA_INTEGER_KEY_SIZE;
+        } else if (key.size == 0) {
+            throw std::invalid_argument("A " + std::string(typeName(key.type)) + " primary key column needs a size");
+        } else {
+            keySize += k + 1 < primaryKey.size() ? 2 * key.size + 2 : key.size;
+        }
+    }
+    if (keySize > SCHEMA_KEY_MAX_SIZE) {
+        throw std::invalid_argument("The primary key may take " + std::to_string(keySize) + " bytes; the most is " +
+                                    std::to_string(SCHEMA_KEY_MAX_SIZE));
+    }
+    // the catalog keeps the definition in one index entry
+    if (serialize().size() > SCHEMA_ROW_MAX_SIZE) {
+        throw std::invalid_argument("Table definition too long; use fewer or shorter column names");
+    }
+    if (isFixedWidth()) {
+        uint32_t rowSize = 0;
+        for (const ColumnSchema& column : columns) {
+            rowSize += fixedWidthOf(column);
+        }
+        if (rowSize > SCHEMA_ROW_MAX_SIZE) {
+            throw std::invalid_argument("Rows would take " + std::to_string(rowSize) + " bytes; the most is " +
+                                        std::to_string(SCHEMA_ROW_MAX_SIZE));
+        }
+    }
+}
+
+bool Schema::parseType(std::string_view typeName, ColumnType& type) {
+    std::string lowered = lowerCase(typeName);
+    if (lowered == "int" || lowered == "integer") {
+        type = ColumnType::INT;
+    } else if (lowered == "bigint") {
+        type = ColumnType::BIGINT;
+    } else if (lowered == "double" || lowered == "real") {
+        type = ColumnType::DOUBLE;
+    } else if (lowered == "text" || lowered == "varchar") {
+        type = ColumnType::TEXT;
+    } else if (lowered == "blob") {
+        type = ColumnType::BLOB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Schema::typeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT:
+            return "INT";
+        case ColumnType::BIGINT:
+            return "BIGINT";
+        case ColumnType::DOUBLE:
+            return "DOUBLE";
+        case ColumnType::TEXT:
+            return "TEXT";
+        default:
+            return "BLOB";
+    }
+}
+
+uint32_t Schema::findColumn(std::string_view columnName) const {
+    std::string lowered = lowerCase(columnName);
+    for (uint32_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == lowered) {
+            return i;
+        }
+    }
+    return getNumColumns();
+}
+
+KeyFormat Schema::getKeyFormat() const {
+    for (uint32_t column : primaryKey) {
+        if (isText(columns[column].type)) {
+            return KeyFormat::BYTES;
+        }
+    }
+    if (primaryKey.size() == 1) {
+        return KeyFormat::FIXED_8;
+    }
+    return primaryKey.size() == 2 ? KeyFormat::FIXED_16 : KeyFormat::BYTES;
+}
+
+bool Schema::isFixedWidth() const {
+    for (const ColumnSchema& column : columns) {
+        if (isText(column.type) && column.size == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Schema::serialize() const {
+    std::string out;
+    appendU32(out, primaryKey[0]);
+    appendU32(out, getNumColumns());
+    for (const ColumnSchema& column : columns) {
+        out.push_back(static_cast<char>(column.type));
+        appendU32(out, column.size);
+        out.push_back(static_cast<char>(column.name.size()));
+        out.append(column.name);
+    }
+    // one-column keys are written as before composite keys existed
+    if (primaryKey.size() > 1) {
+        appendU32(out, static_cast<uint32_t>(primaryKey.size()));
+        for (uint32_t column : primaryKey) {
+            appendU32(out, column);
+        }
+    }
+    return out;
+}
+
+Schema Schema::deserialize(std::string_view tableName, std::string_view data) {
+    size_t position = 0;
+    std::vector<uint32_t> primaryKey{takeU32(data, position)};
+    uint32_t count = takeU32(data, position);
+    if (count > SCHEMA_MAX_COLUMNS) {
+        throw std::runtime_error("Corrupt table catalog: too many columns");
+    }
+    std::vector<ColumnSchema> columns;
+    for (uint32_t i = 0; i < count; i++) {
+        if (position >= data.size() || static_cast<uint8_t>(data[position]) > static_cast<uint8_t>(ColumnType::BLOB)) {
+            throw std::runtime_error("Corrupt table catalog: bad column type");
+        }
+        ColumnType type = static_cast<ColumnType>(data[position++]);
+        uint32_t size = takeU32(data, position);
+        if (position >= data.size()) {
+            throw std::runtime_error("Corrupt table catalog: truncated schema");
+        }
+        size_t nameLength = static_cast<uint8_t>(data[position++]);
+        if (position + nameLength > data.size()) {
+            throw std::runtime_error("Corrupt table catalog: truncated schema");
+        }
+        columns.push_back(ColumnSchema{std::string(data.substr(position, nameLength)), type, size});
+        position += nameLength;
+    }
+    if (position < data.size()) {
+        uint32_t keyColumns = takeU32(data, position);
+        if (keyColumns < 2 || keyColumns > count) {
+            throw std::runtime_error("Corrupt table catalog: bad primary key");
+        }
+        primaryKey.clear();
+        for (uint32_t k = 0; k < keyColumns; k++) {
+            primaryKey.push_back(takeU32(data, position));
+        }
+    }
+    try {
+        return Schema(tableName, std::move(columns), primaryKey);
+    } catch (const std::invalid_argument& error) {
+        throw std::runtime_error(std::string("Corrupt table catalog: ") + error.what());
+    }
+}
+
+RowCodec::RowCodec(const Schema& schema) : fixedWidth(schema.isFixedWidth()), fixedSize(0) {
+    for (const ColumnSchema& column : schema.getColumns()) {
+        plan.push_back(ColumnPlan{column.type, column.size, fixedSize});
+        if (fixedWidth) {
+            fixedSize += fixedWidthOf(column);
+        }
+    }
+}
+
+// Where a column starts: planned for fixed-width rows, else found by stepping
+// over the columns before it
+uint32_t RowCodec::offsetOf(std::string_view row, uint32_t column) const {
+    if (fixedWidth) {
+        return plan[column].offset;
+    }
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < column; i++) {
+        switch (plan[i].type) {
+            case ColumnType::INT:
+                offset += sizeof(int32_t);
+                break;
+            case ColumnType::BIGINT:
+            case ColumnType::DOUBLE:
+                offset += sizeof(int64_t);
+                break;
+            default:
+                offset += sizeof(uint16_t) + readLength(row.data() + offset);
+        }
+    }
+    return offset;
+}
+
+void RowCodec::encode(const std::vector<Field>& row, std::string& out) const {
+    if (row.size() != plan.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(plan.size()) + " values, got " +
+                                    std::to_string(row.size()));
+    }
+    out.clear();
+    if (fixedWidth) {
+        out.reserve(fixedSize);
+    }
+    for (uint32_t i = 0; i < plan.size(); i++) {
+        const Field& field = row[i];
+        switch (plan[i].type) {
+            case ColumnType::INT: {
+                if (field.integer < INT32_MIN || field.integer > INT32_MAX) {
+                    throw std::invalid_argument("Value out of range for an INT column");
+                }
+                int32_t value = static_cast<int32_t>(field.integer);
+                out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+                break;
+            }
+            case ColumnType::BIGINT:
+                out.append(reinterpret_cast<const char*>(&field.integer), sizeof(field.integer));
+                break;
+            case ColumnType::DOUBLE:
+                out.append(reinterpret_cast<const char*>(&field.real), sizeof(field.real));
+                break;
+            default: {
+                if ((plan[i].size != 0 && field.bytes.size() > plan[i].size) ||
+                    field.bytes.size() > SCHEMA_ROW_MAX_SIZE) {
+                    throw std::invalid_argument("Value too long for a " + std::string(Schema::typeName(plan[i].type)) +
+                                                "(" + std::to_string(plan[i].size) + ") column");
+                }
+                uint16_t length = static_cast<uint16_t>(field.bytes.size());
+                out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+                out.append(field.bytes);
+                if (fixedWidth) {
+                    out.append(plan[i].size - length, '\0');
+                }
+            }
+        }
+    }
+    if (out.size() > SCHEMA_ROW_MAX_SIZE) {
+        throw std::invalid_argument("Row too long: " + std::to_string(out.size()) + " bytes, the most is " +
+                                    std::to_string(SCHEMA_ROW_MAX_SIZE));
+    }
+}
+
+void RowCodec::decode(std::string_view data, std::vector<Field>& row) const {
+    row.resize(plan.size());
+    for (uint32_t i = 0; i < plan.size(); i++) {
+        switch (plan[i].type) {
+            case ColumnType::INT:
+            case ColumnType::BIGINT:
+                row[i].integer = integerAt(data, i);
+                break;
+            case ColumnType::DOUBLE:
+                row[i].real = realAt(data, i);
+                break;
+            default:
+                row[i].bytes.assign(bytesAt(data, i));
+        }
+    }
+}
+
+int64_t RowCodec::integerAt(std::string_view row, uint32_t column) const {
+    const char* data = row.data() + offsetOf(row, column);
+    if (plan[column].type == ColumnType::INT) {
+        int32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    int64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+double RowCodec::realAt(std::string_view row, uint32_t column) const {
+    double value;
+    std::memcpy(&value, row.data() + offsetOf(row, column), sizeof(value));
+    return value;
+}
+
+std::string_view RowCodec::bytesAt(std::string_view row, uint32_t column) const {
+    uint32_t offset = offsetOf(row, column);
+    return row.substr(offset + sizeof(uint16_t), readLength(row.data() + offset));
+}
+
+std::string encodeKey(const Field& value, ColumnType type) {
+    if (isText(type)) {
+        if (value.bytes.size() > SCHEMA_KEY_MAX_SIZE) {
+            throw std::invalid_argument("Primary key longer than " + std::to_string(SCHEMA_KEY_MAX_SIZE) + " bytes");
+        }
+        return value.bytes;
+    }
+    uint64_t bits = static_cast<uint64_t>(value.integer) ^ (uint64_t(1) << 63);
+    std::string key(sizeof(bits), '\0');
+    for (int i = 7; i >= 0; i--) {
+        key[i] = static_cast<char>(bits & 0xFF);
+        bits >>= 8;
+    }
+    return key;
+}
+
+std::string encodeKey(const std::vector<Field>& keyValues, const Schema& schema) {
+    const std::vector<uint32_t>& keyColumns = schema.getPrimaryKey();
+    std::string key;
+    for (uint32_t k = 0; k < keyValues.size(); k++) {
+        ColumnType type = schema.getColumns()[keyColumns[k]].type;
+        if (!isText(type) || k + 1 == keyColumns.size()) {
+            key.append(encodeKey(keyValues[k], type));
+        } else {
+            for (char byte : keyValues[k].bytes) {
+                key.push_back(byte);
+                if (byte == '\0') {
+                    key.push_back('\1');
+                }
+            }
+            key.append(2, '\0');
+        }
+    }
+    if (key.size() > SCHEMA_KEY_MAX_SIZE) {
+        throw std::invalid_argument("Primary key longer than " + std::to_string(SCHEMA_KEY_MAX_SIZE) + " bytes");
+    }
+    return key;
+}
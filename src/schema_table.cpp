@@ -0,0 +1,66 @@
+#include "schema_table.hpp"
+
+#include <mutex>
+#include <stdexcept>
+
+#include "table.hpp"
+
+SchemaTable::SchemaTable(Table& table, Schema tableSchema, uint32_t rootPageNum)
+    : table(table), schema(std::move(tableSchema)), codec(schema),
+      tree(table, INDEX_NO_COLUMN, rootPageNum, 0, schema.getKeyFormat()) {}
+
+std::string SchemaTable::keyOf(const std::vector<Field>& row) const {
+    std::vector<Field> keyValues;
+    for (uint32_t column : schema.getPrimaryKey()) {
+        keyValues.push_back(row.at(column));
+    }
+    return encodeKey(keyValues, schema);
+}
+
+std::string SchemaTable::wholeKey(const std::vector<Field>& key) const {
+    if (key.size() != schema.getPrimaryKey().size()) {
+        throw std::invalid_argument("Expected " + std::to_string(schema.getPrimaryKey().size()) + " key values");
+    }
+    return encodeKey(key, schema);
+}
+
+void SchemaTable::insertRow(const std::vector<Field>& row) {
+    std::string encoded;
+    codec.encode(row, encoded);
+    std::string key = keyOf(row);
+    // safe point: no page pointers are live between operations
+    table.getPager().evictToCapacity();
+    std::lock_guard<std::mutex> latch(table.getPager().getWriteLatch());
+    IndexCursor existing(tree, key);
+    if (!existing.isEnd() && existing.key() == key) {
+        throw std::invalid_argument("Duplicate key");
+    }
+    tree.insert(key, 0, encoded);
+}
+
+bool SchemaTable::getRow(const std::vector<Field>& key, std::vector<Field>& row) const {
+    std::string encodedKey = wholeKey(key);
+    table.getPager().evictToCapacity();
+    IndexCursor cursor(tree, encodedKey);
+    if (cursor.isEnd() || cursor.key() != encodedKey) {
+        return false;
+    }
+    codec.decode(cursor.payload(), row);
+    return true;
+}
+
+bool SchemaTable::deleteRow(const std::vector<Field>& key) {
+    std::string encodedKey = wholeKey(key);
+    table.getPager().evictToCapacity();
+    std::lock_guard<std::mutex> latch(table.getPager().getWriteLatch());
+    return tree.remove(encodedKey, 0);
+}
+
+uint64_t SchemaTable::getNumRows() const {
+    table.getPager().evictToCapacity();
+    uint64_t rows = 0;
+    for (IndexCursor cursor(tree, std::string_view()); !cursor.isEnd(); cursor.advance()) {
+        rows++;
+    }
+    return rows;
+}
@@ -0,0 +1,105 @@
+#include "script_runner.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+#include "mapped_file.hpp"
+
+namespace {
+    std::string_view trim(std::string_view text) {
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos) {
+            return std::string_view();
+        }
+        return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+    }
+
+    // Runs one line; false if it failed (after printing why)
+    bool runLine(Table& table, StatementProcessor& statements, MetaCommandProcessor& metaCommands,
+                 const std::string& line, bool& exitRequested) {
+        if (line[0] == '.') {
+            switch (metaCommands.execute(line, &table)) {
+                case MetaCommandResult::META_COMMAND_SUCCESS:
+                    return true;
+                case MetaCommandResult::META_COMMAND_EXIT:
+                    exitRequested = true;
+                    return true;
+                case MetaCommandResult::META_COMMAND_UNRECOGNIZED_COMMAND:
+                    std::cout << "Unrecognized command at start of '" << line << "'.\n";
+                    return false;
+                case MetaCommandResult::META_COMMAND_FAILURE:
+                    return false;
+            }
+        }
+        switch (statements.execute(line)) {
+            case PrepareResult::PREPARE_SUCCESS:
+                return true;
+            case PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT:
+                std::cout << "Unrecognized keyword at start of '" << line << "'.\n";
+                return false;
+            case PrepareResult::PREPARE_SYNTAX_ERROR:
+                std::cout << "Invalid syntax\n";
+                return false;
+            case PrepareResult::PREPARE_INTERNAL_FAILURE:
+                return false;
+        }
+        return false;
+    }
+}
+
+ScriptResult runScript(Table& table, StatementProcessor& statements, MetaCommandProcessor& metaCommands,
+                       const std::string& path) {
+    MappedFile file(path);
+    auto start = std::chrono::steady_clock::now();
+    ScriptResult result{0, 0, 0, false};
+    bool ownTransaction = !table.inTransaction();
+    if (ownTransaction) {
+        table.beginTransaction();
+    }
+
+    bool quiet = statements.isQuiet();
+    statements.setQuiet(true);
+    std::string_view text = file.getText();
+    std::string line;
+    uint64_t lineNumber = 0;
+    try {
+        while (!text.empty() && !result.exitRequested) {
+            size_t end = text.find('\n');
+            std::string_view current = trim(text.substr(0, end));
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            lineNumber++;
+            if (current.empty() || current.substr(0, 2) == "--") {
+                continue;
+            }
+            line.assign(current.data(), current.size());
+            result.statements++;
+            if (!runLine(table, statements, metaCommands, line, result.exitRequested)) {
+                result.errors++;
+                std::cout << "  at " << path << ":" << lineNumber << "\n";
+            }
+        }
+    } catch (...) {
+        statements.setQuiet(quiet);
+        if (ownTransaction && table.inTransaction()) {
+            table.rollbackTransaction();
+        }
+        throw;
+    }
+    statements.setQuiet(quiet);
+    // a COMMIT or ROLLBACK in the script may have ended it already
+    if (ownTransaction && table.inTransaction()) {
+        table.commitTransaction();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::string describeScriptResult(const ScriptResult& result) {
+    std::ostringstream text;
+    text << "Ran " << result.statements << " statements (" << result.errors << " errors) in "
+         << result.seconds * 1e3 << " ms, "
+         << static_cast<uint64_t>(result.seconds > 0 ? result.statements / result.seconds : 0) << " statements/s";
+    return text.str();
+}
@@ -0,0 +1,330 @@
+#include "secondary_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    std::string_view sharedPrefix(std::string_view a, std::string_view b) {
+        size_t length = 0;
+        while (length < a.size() && length < b.size() && a[length] == b[length]) {
+            length++;
+        }
+        return a.substr(0, length);
+    }
+}
+
+SecondaryIndex::SecondaryIndex(Table& table, uint32_t column, uint32_t rootPageNum, uint32_t includedColumns,
+                               KeyFormat keyFormat)
+    : table(table), column(column), rootPageNum(rootPageNum), includedColumns(includedColumns), keyFormat(keyFormat) {}
+
+void SecondaryIndex::initializeRoot(Table& table, uint32_t pageNum) {
+    IndexNode root(table.getPageForWrite(pageNum));
+    root.initialize(true);
+    root.setRoot(true);
+}
+
+std::string_view SecondaryIndex::valueOf(const Row& row, uint32_t column) {
+    if (column == COLUMN_USERNAME) {
+        return std::string_view(row.getUsername(), strnlen(row.getUsername(), COLUMN_USERNAME_SIZE));
+    }
+    return std::string_view(row.getEmail(), strnlen(row.getEmail(), COLUMN_EMAIL_SIZE));
+}
+
+bool SecondaryIndex::covers(uint32_t columnMask) const {
+    uint32_t available = (1u << COLUMN_ID) | (1u << column) | includedColumns;
+    return (columnMask & ~available) == 0;
+}
+
+std::string SecondaryIndex::payloadOf(const Row& row) const {
+    std::string payload;
+    for (uint32_t included = 0; included < NUM_TABLE_COLUMNS; included++) {
+        if (includedColumns & (1u << included)) {
+            std::string_view value = valueOf(row, included);
+            payload.push_back(static_cast<char>(value.size()));
+            payload.append(value);
+        }
+    }
+    return payload;
+}
+
+std::string_view SecondaryIndex::includedValue(std::string_view payload, uint32_t wanted) const {
+    size_t position = 0;
+    for (uint32_t included = 0; included < NUM_TABLE_COLUMNS; included++) {
+        if (includedColumns & (1u << included)) {
+            size_t length = static_cast<uint8_t>(payload[position]);
+            if (included == wanted) {
+                return payload.substr(position + 1, length);
+            }
+            position += 1 + length;
+        }
+    }
+    return std::string_view();
+}
+
+template <typename Keys>
+uint32_t SecondaryIndex::findLeaf(std::string_view key, uint32_t id) const {
+    uint32_t pageNum = rootPageNum;
+    while (true) {
+        IndexNode node(table.getPageAddress(pageNum));
+        if (node.isLeaf()) {
+            return pageNum;
+        }
+        pageNum = node.childAt(node.lowerBound<Keys>(key, id));
+    }
+}
+
+void SecondaryIndex::insert(std::string_view key, uint32_t id, std::string_view payload) {
+    switch (keyFormat) {
+        case KeyFormat::FIXED_8: return insertWith<Fixed8Keys>(key, id, payload);
+        case KeyFormat::FIXED_16: return insertWith<Fixed16Keys>(key, id, payload);
+        default: return insertWith<ByteKeys>(key, id, payload);
+    }
+}
+
+template <typename Keys>
+void SecondaryIndex::insertWith(std::string_view key, uint32_t id, std::string_view payload) {
+    uint32_t leafPageNum = findLeaf<Keys>(key, id);
+    IndexNode leaf(table.getPageAddress(leafPageNum));
+    insertEntry<Keys>(leafPageNum, leaf.lowerBound<Keys>(key, id),
+                      Entry{std::string(key), id, 0, std::string(payload)});
+}
+
+bool SecondaryIndex::remove(std::string_view key, uint32_t id) {
+    switch (keyFormat) {
+        case KeyFormat::FIXED_8: return removeWith<Fixed8Keys>(key, id);
+        case KeyFormat::FIXED_16: return removeWith<Fixed16Keys>(key, id);
+        default: return removeWith<ByteKeys>(key, id);
+    }
+}
+
+template <typename Keys>
+bool SecondaryIndex::removeWith(std::string_view key, uint32_t id) {
+    uint32_t leafPageNum = findLeaf<Keys>(key, id);
+    IndexNode leaf(table.getPageAddress(leafPageNum));
+    uint32_t cellNum = leaf.lowerBound<Keys>(key, id);
+    if (cellNum >= leaf.numCells() || leaf.id(cellNum) != id || leaf.key(cellNum) != key) {
+        return false;
+    }
+    IndexNode(table.getPageForWrite(leafPageNum)).removeCell(cellNum);
+    return true;
+}
+
+void SecondaryIndex::seek(std::string_view key, uint32_t id, uint32_t& pageNum, uint32_t& cellNum) const {
+    switch (keyFormat) {
+        case KeyFormat::FIXED_8: return seekWith<Fixed8Keys>(key, id, pageNum, cellNum);
+        case KeyFormat::FIXED_16: return seekWith<Fixed16Keys>(key, id, pageNum, cellNum);
+        default: return seekWith<ByteKeys>(key, id, pageNum, cellNum);
+    }
+}
+
+template <typename Keys>
+void SecondaryIndex::seekWith(std::string_view key, uint32_t id, uint32_t& pageNum, uint32_t& cellNum) const {
+    pageNum = findLeaf<Keys>(key, id);
+    cellNum = IndexNode(table.getPageAddress(pageNum)).lowerBound<Keys>(key, id);
+}
+
+template <typename Keys>
+void SecondaryIndex::insertEntry(uint32_t pageNum, uint32_t cellNum, const Entry& entry) {
+    IndexNode node(table.getPageForWrite(pageNum));
+    if (node.insertCell(cellNum, entry.key, entry.id, entry.child, entry.payload)) {
+        return;
+    }
+    std::vector<Entry> entries;
+    entries.reserve(node.numCells() + 1);
+    for (uint32_t i = 0; i < node.numCells(); i++) {
+        if (node.isLeaf()) {
+            entries.push_back(Entry{std::string(node.key(i)), node.id(i), 0, std::string(node.payload(i))});
+        } else {
+            entries.push_back(Entry{std::string(node.prefix()).append(node.key(i)), node.id(i), node.child(i),
+                                    std::string()});
+        }
+    }
+    entries.insert(entries.begin() + cellNum, entry);
+    splitNode<Keys>(pageNum, entries);
+}
+
+// Copies the root into a new page that becomes its only child, so the root
+// page number never changes; returns the new page
+uint32_t SecondaryIndex::moveRootDown() {
+    uint8_t* rootData = table.getPageForWrite(rootPageNum);
+    uint32_t childPageNum = table.getUnusedPageNum();
+    uint8_t* childData = table.getPageForWrite(childPageNum);
+    std::memcpy(childData, rootData, PAGE_SIZE);
+    IndexNode child(childData);
+    child.setRoot(false);
+    *child.parent() = rootPageNum;
+    if (!child.isLeaf()) {
+        for (uint32_t i = 0; i <= child.numCells(); i++) {
+            *IndexNode(table.getPageForWrite(child.childAt(i))).parent() = childPageNum;
+        }
+    }
+    IndexNode root(rootData);
+    root.initialize(false);
+    root.setRoot(true);
+    *root.link() = childPageNum;
+    return childPageNum;
+}
+
+// The separator the parent keeps for a leaf ending in left when the next leaf
+// starts with right: the shortest key (with an id) at or after left and before
+// right, usually a few bytes of right. Falls back to left itself, which is
+// always what fixed-width keys get.
+template <typename Keys>
+SecondaryIndex::Entry SecondaryIndex::separatorBetween(const Entry& left, const Entry& right) {
+    if (!Keys::SHORT_SEPARATORS) {
+        return Entry{left.key, left.id, 0, std::string()};
+    }
+    size_t shared = sharedPrefix(left.key, right.key).size();
+    if (shared + 1 < right.key.size()) {
+        // longer than shared, so past left; a proper prefix of right, so before it
+        return Entry{right.key.substr(0, shared + 1), 0, 0, std::string()};
+    }
+    return Entry{left.key, left.id, 0, std::string()};
+}
+
+// entries is the node's content plus the entry that did not fit. The lower
+// half (by bytes) stays in pageNum, the upper half moves to a new page that
+// takes pageNum's place in the parent, and pageNum is re-inserted in the
+// parent under a separator: for a leaf the shortest one near the middle, for
+// an internal node the middle entry, which moves up. Each half of an internal
+// node is given the prefix its keys share.
+template <typename Keys>
+void SecondaryIndex::splitNode(uint32_t pageNum, std::vector<Entry>& entries) {
+    if (IndexNode(table.getPageAddress(pageNum)).isRoot()) {
+        pageNum = moveRootDown();
+        // the entry that did not fit was never on the root page; moveRootDown
+        // could not re-parent its child
+        for (const Entry& entry : entries) {
+            if (entry.child != 0) {
+                *IndexNode(table.getPageForWrite(entry.child)).parent() = pageNum;
+            }
+        }
+    }
+    IndexNode node(table.getPageForWrite(pageNum));
+    bool leaf = node.isLeaf();
+    uint32_t parentPageNum = *node.parent();
+    uint32_t oldLink = *node.link();
+
+    // entries are sorted, so the first and last share what all of them do
+    auto prefixOf = [&entries, leaf](uint32_t first, uint32_t last) {
+        return leaf ? std::string_view() : sharedPrefix(entries[first].key, entries[last].key);
+    };
+    // before[i]: bytes entries[0, i) take with whole keys, slots included
+    std::vector<uint32_t> before(entries.size() + 1, 0);
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        before[i + 1] = before[i] + INDEX_NODE_SLOT_SIZE +
+                        IndexNode::cellSize(leaf, static_cast<uint32_t>(entries[i].key.size()),
+                                            static_cast<uint32_t>(entries[i].payload.size()));
+    }
+    // Bytes entries[first, last] take in a node of their own, under their prefix
+    auto weight = [&](uint32_t first, uint32_t last) {
+        uint32_t length = static_cast<uint32_t>(prefixOf(first, last).size());
+        return before[last + 1] - before[first] - (last - first + 1) * length + IndexNode::prefixSpace(length);
+    };
+    // leaf: [0, middle) stays, the separator falls between the halves.
+    // internal: entries[middle] moves up, its child becomes the left node's right child.
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    uint32_t lastMiddle = leaf ? count - 1 : count - 2;
+    auto heavierHalf = [&](uint32_t middle) {
+        return std::max(weight(0, middle - 1), weight(leaf ? middle : middle + 1, count - 1));
+    };
+    // Balance by stored bytes. A key that shortens a node's prefix can make
+    // the others much longer, but it sorts before or after all of them, so
+    // splitting next to it always leaves two halves that fit.
+    uint32_t middle = 1;
+    for (uint32_t candidate = 2; candidate <= lastMiddle; candidate++) {
+        if (heavierHalf(candidate) < heavierHalf(middle)) {
+            middle = candidate;
+        }
+    }
+    if (leaf && Keys::SHORT_SEPARATORS) {
+        // give up a little balance for a shorter separator
+        uint32_t slack = count / 16;
+        uint32_t best = middle;
+        size_t bestLength = separatorBetween<Keys>(entries[middle - 1], entries[middle]).key.size();
+        for (uint32_t candidate = std::max<uint32_t>(middle - std::min(middle, slack), 1);
+             candidate <= lastMiddle && candidate <= middle + slack; candidate++) {
+            size_t length = separatorBetween<Keys>(entries[candidate - 1], entries[candidate]).key.size();
+            if (length < bestLength && heavierHalf(candidate) <= PAGE_SIZE - INDEX_NODE_HEADER_SIZE) {
+                best = candidate;
+                bestLength = length;
+            }
+        }
+        middle = best;
+    }
+    uint32_t rightStart = leaf ? middle : middle + 1;
+
+    uint32_t newPageNum = table.getUnusedPageNum();
+    IndexNode sibling(table.getPageForWrite(newPageNum));
+    sibling.initialize(leaf, prefixOf(rightStart, count - 1));
+    *sibling.parent() = parentPageNum;
+    node.initialize(leaf, prefixOf(0, middle - 1));
+    *node.parent() = parentPageNum;
+
+    for (uint32_t i = 0; i < middle; i++) {
+        node.insertCell(i, entries[i].key, entries[i].id, entries[i].child, entries[i].payload);
+    }
+    for (uint32_t i = rightStart; i < entries.size(); i++) {
+        sibling.insertCell(i - rightStart, entries[i].key, entries[i].id, entries[i].child, entries[i].payload);
+    }
+    *sibling.link() = oldLink;
+    Entry separator = leaf ? separatorBetween<Keys>(entries[middle - 1], entries[middle]) : entries[middle];
+    if (leaf) {
+        *node.link() = newPageNum;
+    } else {
+        *node.link() = separator.child;
+        for (uint32_t i = 0; i <= sibling.numCells(); i++) {
+            *IndexNode(table.getPageForWrite(sibling.childAt(i))).parent() = newPageNum;
+        }
+    }
+
+    IndexNode parent(table.getPageForWrite(parentPageNum));
+    uint32_t slot = parent.findChild(pageNum);
+    if (slot < parent.numCells()) {
+        parent.setChild(slot, newPageNum);
+    } else {
+        *parent.link() = newPageNum;
+    }
+    insertEntry<Keys>(parentPageNum, slot, Entry{separator.key, separator.id, pageNum, std::string()});
+}
+
+IndexCursor::IndexCursor(const SecondaryIndex& index, std::string_view key)
+    : index(index), endOfIndex(false) {
+    index.seek(key, 0, pageNum, cellNum);
+    skipExhaustedLeaves();
+}
+
+void IndexCursor::skipExhaustedLeaves() {
+    while (true) {
+        IndexNode leaf(index.getTable().getPageAddress(pageNum));
+        if (cellNum < leaf.numCells()) {
+            return;
+        }
+        if (*leaf.link() == 0) {
+            endOfIndex = true;
+            return;
+        }
+        pageNum = *leaf.link();
+        cellNum = 0;
+    }
+}
+
+std::string_view IndexCursor::key() const {
+    return IndexNode(index.getTable().getPageAddress(pageNum)).key(cellNum);
+}
+
+uint32_t IndexCursor::id() const {
+    return IndexNode(index.getTable().getPageAddress(pageNum)).id(cellNum);
+}
+
+std::string_view IndexCursor::payload() const {
+    return IndexNode(index.getTable().getPageAddress(pageNum)).payload(cellNum);
+}
+
+void IndexCursor::advance() {
+    cellNum++;
+    skipExhaustedLeaves();
+}
@@ -0,0 +1,89 @@
+#include "sql_liter.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+Query::Query(std::unique_ptr<PreparedStatement> statement) : statement(std::move(statement)) {}
+
+bool Query::step() {
+    switch (statement->step()) {
+        case StepResult::ROW:
+            return true;
+        case StepResult::DONE:
+            return false;
+        case StepResult::ERROR:
+            break;
+    }
+    throw ExecutionError(statement->getError());
+}
+
+Connection::Connection(const std::string& filename, const DatabaseOptions& options)
+    : database(std::make_unique<Database>(filename, options)) {}
+
+Connection::~Connection() = default;
+
+void Connection::close() {
+    database.reset();
+    planCache.clear();
+}
+
+Table& Connection::table() {
+    return getDatabase().getTable();
+}
+
+Database& Connection::getDatabase() {
+    if (database == nullptr) {
+        throw std::logic_error("Connection is closed");
+    }
+    return *database;
+}
+
+Query Connection::prepare(std::string_view sql) {
+    Table& target = table();
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    PrepareResult result = planCache.lookup(sql, compiled, error, &target);
+    if (result == PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT) {
+        throw std::invalid_argument("Unrecognized statement: " + std::string(sql));
+    }
+    if (result != PrepareResult::PREPARE_SUCCESS) {
+        throw std::invalid_argument(error);
+    }
+    return Query(std::make_unique<PreparedStatement>(target, std::move(compiled)));
+}
+
+uint64_t Connection::execute(std::string_view sql) {
+    Query query = prepare(sql);
+    uint64_t rows = 0;
+    while (query.step()) {
+        rows++;
+    }
+    return rows;
+}
+
+uint64_t Connection::insertBatch(std::string_view insertSql, const std::vector<std::vector<Value>>& rows) {
+    Query query = prepare(insertSql);
+    if (query.getKind() != StatementKind::INSERT) {
+        throw std::invalid_argument("insertBatch needs an INSERT statement");
+    }
+    uint32_t width = query.getParameterCount();
+    PreparedStatement::runAtomically(table(), [&]() {
+        for (const std::vector<Value>& row : rows) {
+            if (row.size() != width) {
+                throw std::invalid_argument("Row of " + std::to_string(row.size()) + " values for " +
+                                            std::to_string(width) + " parameters");
+            }
+            for (uint32_t i = 0; i < width; i++) {
+                if (row[i].isText) {
+                    query.bind(i + 1, row[i].text);
+                } else {
+                    query.bind(i + 1, row[i].integer);
+                }
+            }
+            query.step();
+            query.reset();
+        }
+        return PrepareResult::PREPARE_SUCCESS;
+    });
+    return rows.size();
+}
@@ -4,12 +4,30 @@
 #include <functional>
 #include <iostream>
 
+#include "lexer.hpp"
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
 #include "tokenizer.hpp"
 
 class StatementProcessor::Impl {
 public:
+    // legacy whitespace-separated forms: insert <id> <user> <email>, insert_multiple, bare select
     std::unordered_map<std::string, std::function<PrepareResult(const std::string&)>> statements;
     Table& table;
+    PlanCache planCache;
+    bool quiet = false;
+
+    // "insert 1 a b" is legacy, "insert into ..." is SQL
+    static bool isLegacyForm(const std::string& statement, const std::string& commandType) {
+        if (commandType == "insert_multiple" || statement == "select") {
+            return true;
+        }
+        if (commandType != "insert") {
+            return false;
+        }
+        Lexer lexer(std::string_view(statement).substr(commandType.size()));
+        return lexer.next().type != TokenType::KW_INTO;
+    }
 
     explicit Impl(Table& db_table) : table(db_table) {
         statements["insert"] = [this](const std::string& fullCommand) {
@@ -25,7 +43,9 @@ public:
                     std::cout << "Duplicate key error\n";
                     return PrepareResult::PREPARE_INTERNAL_FAILURE;
                 }
-                std::cout << "Table: " << tokens[2] << "\n";
+                if (!quiet) {
+                    std::cout << "Table: " << tokens[2] << "\n";
+                }
             } else {
                 std::cout << "exiting";
                 return PrepareResult::PREPARE_SYNTAX_ERROR;
@@ -59,15 +79,67 @@ public:
         };
     }
 
+    PrepareResult prepare(const std::string& sql, std::unique_ptr<PreparedStatement>& prepared) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        PrepareResult result = planCache.lookup(sql, compiled, error, &table);
+        if (result != PrepareResult::PREPARE_SUCCESS) {
+            // unrecognized statements are reported by the REPL itself
+            if (result != PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT) {
+                std::cout << "Error: " << error << "\n";
+            }
+            return result;
+        }
+        prepared = std::make_unique<PreparedStatement>(table, std::move(compiled));
+        return PrepareResult::PREPARE_SUCCESS;
+    }
+
+    static void printValue(const Value& value) {
+        if (value.isText) {
+            std::cout << value.text;
+        } else {
+            std::cout << value.integer;
+        }
+    }
+
     PrepareResult execute(const std::string& statement) {
         size_t spacePos = statement.find(' ');
         std::string commandType = (spacePos != std::string::npos) ? statement.substr(0, spacePos) : statement;
 
-        auto it = statements.find(commandType);
-        if (it != statements.end()) {
+        if (isLegacyForm(statement, commandType)) {
+            auto it = statements.find(commandType);
+            if (commandType == "insert" || commandType == "insert_multiple") {
+                return PreparedStatement::runAtomically(table, [&]() { return it->second(statement); });
+            }
             return it->second(statement);
         }
-        return PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT;
+
+        std::unique_ptr<PreparedStatement> prepared;
+        PrepareResult result = prepare(statement, prepared);
+        if (result != PrepareResult::PREPARE_SUCCESS) {
+            return result;
+        }
+        if (prepared->getParameterCount() > 0) {
+            std::cout << "Error: ? parameters can only be bound through the prepare API\n";
+            return PrepareResult::PREPARE_INTERNAL_FAILURE;
+        }
+
+        StepResult step;
+        while ((step = prepared->step()) == StepResult::ROW) {
+            std::cout << "(";
+            for (uint32_t i = 0; i < prepared->getColumnCount(); i++) {
+                if (i > 0) {
+                    std::cout << ", ";
+                }
+                printValue(prepared->getColumn(i));
+            }
+            std::cout << ")\n";
+        }
+        if (step == StepResult::ERROR) {
+            std::cout << "Error: " << prepared->getError() << "\n";
+            return PrepareResult::PREPARE_INTERNAL_FAILURE;
+        }
+        return PrepareResult::PREPARE_SUCCESS;
     }
 };
 
@@ -77,3 +149,15 @@ StatementProcessor::~StatementProcessor() { delete pimpl; }
 PrepareResult StatementProcessor::execute(const std::string& statement) {
     return pimpl->execute(statement);
 }
+
+PrepareResult StatementProcessor::prepare(const std::string& sql, std::unique_ptr<PreparedStatement>& prepared) {
+    return pimpl->prepare(sql, prepared);
+}
+
+void StatementProcessor::setQuiet(bool quiet) {
+    pimpl->quiet = quiet;
+}
+
+bool StatementProcessor::isQuiet() const {
+    return pimpl->quiet;
+}
@@ -2,12 +2,20 @@
 #include "pager.hpp"
 #include "cursor.hpp"
 #include "node.hpp"
+#include "vector_executor.hpp"
+#include "secondary_index.hpp"
+#include "hash_index.hpp"
+#include "parallel_scan.hpp"
+#include "schema_table.hpp"
+#include "column_store.hpp"
+#include "zone_map.hpp"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
 
-Table::Table(std::string filename) {
-    pager = new Pager(filename);
+Table::Table(std::string filename, uint32_t cachePages, bool compressPages) : columnStoreStale(false), scheduler(nullptr), schemaVersion(0) {
+    pager = new Pager(filename, cachePages, compressPages);
     rootPageNum = 0;
 
     // Empty file ?
@@ -16,7 +24,60 @@ Table::Table(std::string filename) {
         Node node(node_data);
         node.initializeLeafNode();
         node.setNodeRoot(true);
+        *reinterpret_cast<uint32_t*>(node_data + ROOT_PAGE_FORMAT_OFFSET) = DATABASE_FORMAT_STAMP;
+    } else {
+        // descending a root this code did not write could loop forever
+        std::string problem = rootProblem();
+        if (!problem.empty()) {
+            delete pager;
+            throw std::runtime_error(problem);
+        }
     }
+    try {
+        loadIndexes();
+    } catch (...) {
+        delete pager;
+        throw;
+    }
+    rebuildLeafFilters();
+}
+
+// Why page 0 cannot be opened, or empty if it can. Checks page 0 only: the
+// format stamp, the root flag, a table node type, a cell count that fits the
+// page and, for an internal root, children inside the file other than itself.
+std::string Table::rootProblem() {
+    uint8_t* rootData = pager->getPage(rootPageNum);
+    uint32_t stamp = *reinterpret_cast<uint32_t*>(rootData + ROOT_PAGE_FORMAT_OFFSET);
+    if ((stamp & 0xFFFF0000u) != DATABASE_FORMAT_MAGIC) {
+        return "Not a database file, or one from before format versions";
+    }
+    uint32_t version = stamp & 0xFFFFu;
+    if (version < DATABASE_FORMAT_MIN_VERSION || version > DATABASE_FORMAT_VERSION) {
+        return "Unsupported database format version " + std::to_string(version) + " (this build reads versions " +
+               std::to_string(DATABASE_FORMAT_MIN_VERSION) + " to " + std::to_string(DATABASE_FORMAT_VERSION) + ")";
+    }
+    const std::string corrupt = "Corrupt database file: page 0 is not a valid root node";
+    Node root(rootData);
+    if (!root.isRootNode()) {
+        return corrupt;
+    }
+    if (root.getNodeType() == NodeType::NODE_LEAF) {
+        return *root.leafNodeNumCells() <= LEAF_NODE_MAX_CELLS ? std::string() : corrupt;
+    }
+    if (root.getNodeType() != NodeType::NODE_INTERNAL) {
+        return corrupt;
+    }
+    uint32_t numKeys = *root.internalNodeNumKeys();
+    if (numKeys > INTERNAL_NODE_MAX_KEYS) {
+        return corrupt;
+    }
+    for (uint32_t i = 0; i <= numKeys; i++) {
+        uint32_t child = i == numKeys ? *root.internalNodeRightChild() : *root.internalNodeCell(i);
+        if (child == rootPageNum || child >= pager->getNumPages()) {
+            return corrupt;
+        }
+    }
+    return std::string();
 }
 
 Table::~Table() {     
@@ -33,24 +94,41 @@ uint8_t* Table::getPageAddress(uint32_t pageNum) const{
     return pager->getPage(pageNum);
 }
 
+// Like getPageAddress, for pages about to be modified (journals the before-image)
+uint8_t* Table::getPageForWrite(uint32_t pageNum) {
+    if (pageNum >= TABLE_MAX_PAGES) {
+        throw std::out_of_range("Page number exceeds maximum pages");
+    }
+    return pager->getPageForWrite(pageNum);
+}
+
 void Table::insertRow(const Row& row) {
+    // safe point: no page pointers are live between operations
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    // the tree rejects duplicate ids, so index entries are only added for rows it took
+    insertIntoTree(row);
+    for (auto& index : indexes) {
+        index->insert(SecondaryIndex::valueOf(row, index->getColumn()), row.getId(), index->payloadOf(row));
+    }
+    if (columnStore && !columnStoreStale) {
+        columnStore->insert(row);
+    }
+}
+
+void Table::insertIntoTree(const Row& row) {
     // should get insertion position for new node 
     // cursor will point to correct node AND cell position
-    std::cout << "Executing internalNodefind for key: " << row.getId() << "\n";
     Cursor cursor(*this, row.getId());
 
     // then we create a node from the page data for node operations
-    uint8_t* nodeData = getPageAddress(cursor.getPageNum());
+    uint8_t* nodeData = getPageForWrite(cursor.getPageNum());
     Node node(nodeData);
     // numCells will include the new node to be inserted 
     uint32_t numCells = *node.leafNodeNumCells();
 
-    if (numCells >= LEAF_NODE_MAX_CELLS) {
-        leafNodeSplitAndInsert(row.getId(), &row, cursor.getCellNum(), cursor.getPageNum()); 
-    }
-    
     // Check if we're inserting at a position with existing cells
-    // duplicate key check
+    // duplicate key check (before any split, so a rejected row changes nothing)
     if (cursor.getCellNum() < numCells) {
         uint32_t keyAtPosition = *node.leafNodeKey(cursor.getCellNum());
         if (keyAtPosition == row.getId()) {
@@ -58,48 +136,626 @@ void Table::insertRow(const Row& row) {
             return;
         }        
     } 
+
+    if (numCells >= LEAF_NODE_MAX_CELLS) {
+        leafNodeSplitAndInsert(row.getId(), &row, cursor.getCellNum(), cursor.getPageNum()); 
+        return;
+    }
     
     uint32_t oldMax = node.getNodeMaxKey();
     node.leafNodeInsert(row.getId(), &row, cursor.getCellNum()); 
+    leafFilters.add(cursor.getPageNum(), row.getId());
+    if (hashIndex) {
+        hashIndex->put(row.getId(), cursor.getPageNum());
+    }
+    if (zoneMap) {
+        zoneMap->widen(cursor.getPageNum(), static_cast<const uint8_t*>(node.leafNodeValue(cursor.getCellNum())));
+    }
     
     // Update parent key if this node is not root and the max key changed
     if (!node.isRootNode() && oldMax != node.getNodeMaxKey()) {
         uint32_t parentPageNum = *node.nodeParent();
-        uint8_t* parentData = getPageAddress(parentPageNum);
+        uint8_t* parentData = getPageForWrite(parentPageNum);
         Node parent(parentData);
         parent.internalNodeUpdateMaxKey(cursor.getPageNum(), node.getNodeMaxKey());
     }
+    adjustRowCounts(cursor.getPageNum(), 1);
+}
+
+bool Table::bulkLoad(const std::vector<const uint8_t*>& rows) {
+    if (rows.empty()) {
+        return false;
+    }
+    Node root(getPageAddress(rootPageNum));
+    if (root.getNodeType() != NodeType::NODE_LEAF || *root.leafNodeNumCells() != 0) {
+        for (const uint8_t* row : rows) {
+            insertRow(Row::deserialize(row));
+        }
+        return false;
+    }
+
+    // level 0 is the leaves; the root, page 0, sits above the last level
+    uint64_t numRows = rows.size();
+    std::vector<uint32_t> counts;
+    if (numRows > LEAF_NODE_MAX_CELLS) {
+        counts.push_back(static_cast<uint32_t>((numRows + LEAF_NODE_MAX_CELLS - 1) / LEAF_NODE_MAX_CELLS));
+        while (counts.back() > INTERNAL_NODE_MAX_CHILDREN) {
+            counts.push_back((counts.back() + INTERNAL_NODE_MAX_CHILDREN - 1) / INTERNAL_NODE_MAX_CHILDREN);
+        }
+    }
+    std::vector<uint32_t> firstPages;
+    uint64_t nextPageNum = getUnusedPageNum();
+    for (uint32_t count : counts) {
+        firstPages.push_back(static_cast<uint32_t>(nextPageNum));
+        nextPageNum += count;
+    }
+    if (nextPageNum > TABLE_MAX_PAGES) {
+        throw std::out_of_range("Table full: " + std::to_string(numRows) + " rows need more than " +
+                                std::to_string(TABLE_MAX_PAGES) + " pages");
+    }
+    // parent p of a level takes its nodes floor(count * p / groups) up to
+    // floor(count * (p + 1) / groups), as leaves take their rows
+    auto parentOf = [&](uint32_t level, uint32_t j) {
+        if (level + 1 == counts.size()) {
+            return rootPageNum;
+        }
+        uint64_t groups = counts[level + 1];
+        return static_cast<uint32_t>(firstPages[level + 1] + ((j + 1) * groups - 1) / counts[level]);
+    };
+
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    // a child's max key and row count, for the level above
+    std::vector<uint32_t> maxKeys;
+    std::vector<uint32_t> rowCounts;
+    uint32_t numLeaves = counts.empty() ? 1 : counts[0];
+    for (uint32_t j = 0; j < numLeaves; j++) {
+        uint32_t pageNum = counts.empty() ? rootPageNum : firstPages[0] + j;
+        Node leaf(getPageForWrite(pageNum));
+        if (!counts.empty()) {
+            leaf.initializeLeafNode();
+            *leaf.nodeParent() = parentOf(0, j);
+            *leaf.leafNodeRightSibling() = j + 1 < numLeaves ? pageNum + 1 : 0;
+        }
+        uint64_t begin = numRows * j / numLeaves;
+        uint64_t end = numRows * (j + 1) / numLeaves;
+        leafFilters.reset(pageNum, true);
+        for (uint64_t r = begin; r < end; r++) {
+            uint32_t cellNum = static_cast<uint32_t>(r - begin);
+            std::memcpy(leaf.leafNodeKey(cellNum), rows[r], sizeof(uint32_t));
+            std::memcpy(leaf.leafNodeValue(cellNum), rows[r], ROW_SIZE_BYTES);
+            leafFilters.add(pageNum, *leaf.leafNodeKey(cellNum));
+        }
+        *leaf.leafNodeNumCells() = static_cast<uint32_t>(end - begin);
+        maxKeys.push_back(*leaf.leafNodeKey(static_cast<uint32_t>(end - begin - 1)));
+        rowCounts.push_back(static_cast<uint32_t>(end - begin));
+        // no page pointer is held across leaves; keep the cache bounded
+        if ((j + 1) % 1024 == 0) {
+            pager->evictToCapacity();
+        }
+    }
+
+    for (uint32_t level = 1; level <= counts.size(); level++) {
+        uint32_t numChildren = counts[level - 1];
+        uint32_t numNodes = level < counts.size() ? counts[level] : 1;
+        std::vector<uint32_t> levelMaxKeys;
+        std::vector<uint32_t> levelRowCounts;
+        for (uint32_t p = 0; p < numNodes; p++) {
+            uint32_t pageNum = level < counts.size() ? firstPages[level] + p : rootPageNum;
+            Node node(getPageForWrite(pageNum));
+            node.initializeInternalNode();
+            if (pageNum == rootPageNum) {
+                node.setNodeRoot(true);
+            } else {
+                *node.nodeParent() = parentOf(level, p);
+            }
+            uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(numChildren) * p / numNodes);
+            uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(numChildren) * (p + 1) / numNodes);
+            uint32_t numKeys = end - begin - 1;
+            *node.internalNodeNumKeys() = numKeys;
+            uint32_t rowsUnder = 0;
+            for (uint32_t c = 0; c <= numKeys; c++) {
+                uint32_t childPageNum = firstPages[level - 1] + begin + c;
+                if (c < numKeys) {
+                    *node.internalNodeCell(c) = childPageNum;
+                    *node.internalNodeKey(c) = maxKeys[begin + c];
+                } else {
+                    *node.internalNodeRightChild() = childPageNum;
+                }
+                *node.internalNodeChildRows(c) = rowCounts[begin + c];
+                rowsUnder += rowCounts[begin + c];
+            }
+            levelMaxKeys.push_back(maxKeys[end - 1]);
+            levelRowCounts.push_back(rowsUnder);
+        }
+        maxKeys = std::move(levelMaxKeys);
+        rowCounts = std::move(levelRowCounts);
+    }
+    if (!counts.empty()) {
+        leafFilters.reset(rootPageNum, false);
+    }
+
+    // only now: the hash index and zone map take new pages from the end of the file
+    for (uint32_t j = 0; j < numLeaves && (hashIndex || zoneMap); j++) {
+        uint32_t pageNum = counts.empty() ? rootPageNum : firstPages[0] + j;
+        for (uint64_t r = numRows * j / numLeaves; hashIndex && r < numRows * (j + 1) / numLeaves; r++) {
+            uint32_t key;
+            std::memcpy(&key, rows[r], sizeof(key));
+            hashIndex->put(key, pageNum);
+        }
+        if (zoneMap) {
+            zoneMap->recompute(pageNum);
+        }
+    }
+
+    for (auto& index : indexes) {
+        for (const uint8_t* data : rows) {
+            Row row = Row::deserialize(data);
+            index->insert(SecondaryIndex::valueOf(row, index->getColumn()), row.getId(), index->payloadOf(row));
+        }
+    }
+    // rebuilt from the tree when next scanned
+    columnStoreStale = columnStore != nullptr;
+    return true;
 }
 
 Row Table::getRow(uint32_t key) {    
-    Cursor cursor(*this, key);
-    
-    // Check if the key actually exists - use the page where cursor landed, not root
-    uint8_t* nodeData = getPageAddress(cursor.getPageNum());
-    Node node(nodeData);
-    uint32_t numCells = *node.leafNodeNumCells();
-    
-    // If cursor position is beyond valid cells, key doesn't exist
-    if (cursor.getCellNum() >= numCells) {
-        std::cout << "throwing at cell num: " << cursor.getCellNum() << "\n";
+    pager->evictToCapacity();
+    uint32_t pageNum;
+    uint32_t cellNum;
+    if (!findRow(key, pageNum, cellNum)) {
         throw std::out_of_range("Key not found");
     }
-    
-    // Check if the key at cursor position matches the requested key
-    uint32_t keyAtPosition = *node.leafNodeKey(cursor.getCellNum());
-    if (keyAtPosition != key) {
-        std::cout <<"throwing at key position: " << keyAtPosition << "\n";
+    return Row::deserialize(Node(getPageAddress(pageNum)).leafNodeValue(cellNum));
+} 
+
+bool Table::findRow(uint32_t key, uint32_t& leafPageNum, uint32_t& cellNum) {
+    if (hashIndex) {
+        // exact: an id it does not hold is not in the table
+        if (!hashIndex->find(key, leafPageNum)) {
+            return false;
+        }
+    } else {
+        // descend the internal nodes only; the filters know which pages are leaves
+        leafPageNum = rootPageNum;
+        while (!leafFilters.isLeaf(leafPageNum)) {
+            Node node(getPageAddress(leafPageNum));
+            if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+                return false;
+            }
+            uint32_t minIndex = 0;
+            uint32_t maxIndex = *node.internalNodeNumKeys();
+            while (minIndex < maxIndex) {
+                uint32_t currentIndex = (minIndex + maxIndex) / 2;
+                if (*node.internalNodeKey(currentIndex) >= key) {
+                    maxIndex = currentIndex;
+                } else {
+                    minIndex = currentIndex + 1;
+                }
+            }
+            leafPageNum = *node.internalNodeChild(minIndex);
+        }
+        if (!leafFilters.mayContain(leafPageNum, key)) {
+            return false;
+        }
+    }
+
+    Node leaf(getPageAddress(leafPageNum));
+    cellNum = leaf.leafNodeFind(key);
+    if (cellNum < *leaf.leafNodeNumCells() && *leaf.leafNodeKey(cellNum) == key) {
+        return true;
+    }
+    if (!hashIndex) {
+        leafFilters.recordFalsePositive();
+    }
+    return false;
+}
+
+void Table::updateRow(const Row& row) {
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    uint32_t pageNum;
+    uint32_t cellNum;
+    if (!findRow(row.getId(), pageNum, cellNum)) {
         throw std::out_of_range("Key not found");
     }
-    
-    void* rowAddress = cursor.cursorSlot();        
-    return Row::deserialize(rowAddress);
-} 
+    Row oldRow = Row::deserialize(Node(getPageAddress(pageNum)).leafNodeValue(cellNum));
+    Node node(getPageForWrite(pageNum));
+    row.serialize(node.leafNodeValue(cellNum));
+    // a zone need only hold its leaf's values, so one the old value widened stays as it is
+    if (zoneMap) {
+        zoneMap->widen(pageNum, static_cast<const uint8_t*>(node.leafNodeValue(cellNum)));
+    }
+    for (auto& index : indexes) {
+        std::string_view oldValue = SecondaryIndex::valueOf(oldRow, index->getColumn());
+        std::string_view newValue = SecondaryIndex::valueOf(row, index->getColumn());
+        std::string newPayload = index->payloadOf(row);
+        if (oldValue != newValue || index->payloadOf(oldRow) != newPayload) {
+            index->remove(oldValue, row.getId());
+            index->insert(newValue, row.getId(), newPayload);
+        }
+    }
+    if (columnStore && !columnStoreStale) {
+        columnStore->update(row);
+    }
+}
+
+bool Table::deleteRow(uint32_t key) {
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    uint32_t pageNum;
+    uint32_t cellNum;
+    if (!findRow(key, pageNum, cellNum)) {
+        return false;
+    }
+    Node node(getPageForWrite(pageNum));
+    uint32_t numCells = *node.leafNodeNumCells();
+    Row oldRow = Row::deserialize(node.leafNodeValue(cellNum));
+    if (cellNum + 1 < numCells) {
+        std::memmove(node.leafNodeCell(cellNum), node.leafNodeCell(cellNum + 1),
+                     static_cast<size_t>(numCells - cellNum - 1) * LEAF_NODE_CELL_SIZE);
+    }
+    *node.leafNodeNumCells() = numCells - 1;
+    rebuildLeafFilter(pageNum);
+    if (zoneMap) {
+        zoneMap->recompute(pageNum);
+    }
+    adjustRowCounts(pageNum, -1);
+    for (auto& index : indexes) {
+        index->remove(SecondaryIndex::valueOf(oldRow, index->getColumn()), key);
+    }
+    if (hashIndex) {
+        hashIndex->remove(key);
+    }
+    if (columnStore && !columnStoreStale) {
+        columnStore->remove(key);
+    }
+    return true;
+}
+
+namespace {
+    // Catalog page: index count, then (column, root page, included columns) per
+    // index; the hash index is recorded as an index on COLUMN_ID with its header
+    // page, the table catalog as CATALOG_TABLES_ENTRY with its root, and the
+    // column store as CATALOG_COLUMNS_ENTRY with no page and its columns, and
+    // the zone map as CATALOG_ZONES_ENTRY with its header page
+    constexpr uint32_t CATALOG_COUNT_OFFSET = 0;
+    constexpr uint32_t CATALOG_ENTRIES_OFFSET = sizeof(uint32_t);
+    constexpr uint32_t CATALOG_ENTRY_SIZE = 3 * sizeof(uint32_t);
+    constexpr uint32_t CATALOG_TABLES_ENTRY = INDEX_NO_COLUMN;
+    constexpr uint32_t CATALOG_COLUMNS_ENTRY = INDEX_NO_COLUMN - 1;
+    constexpr uint32_t CATALOG_ZONES_ENTRY = INDEX_NO_COLUMN - 2;
+    constexpr std::string_view USERS_TABLE_NAME = "users";
+
+    uint32_t* catalogPageNum(uint8_t* rootData) {
+        return reinterpret_cast<uint32_t*>(rootData + ROOT_PAGE_CATALOG_OFFSET);
+    }
+}
+
+// Rebuilds the index handles from the catalog; also called after a rollback,
+// which may have undone a CREATE INDEX. A column store that is still listed
+// keeps its object, so scans holding it stay valid, but goes stale.
+void Table::loadIndexes() {
+    indexes.clear();
+    hashIndex.reset();
+    zoneMap.reset();
+    uint32_t tablesRoot = 0;
+    uint32_t storeColumns = 0;
+    uint32_t catalog = *catalogPageNum(getPageAddress(rootPageNum));
+    if (catalog != 0) {
+        uint8_t* catalogData = getPageAddress(catalog);
+        uint32_t count = *reinterpret_cast<uint32_t*>(catalogData + CATALOG_COUNT_OFFSET);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t* entry =
+                reinterpret_cast<uint32_t*>(catalogData + CATALOG_ENTRIES_OFFSET + i * CATALOG_ENTRY_SIZE);
+            if (entry[0] == CATALOG_TABLES_ENTRY) {
+                tablesRoot = entry[1];
+            } else if (entry[0] == CATALOG_COLUMNS_ENTRY) {
+                storeColumns = entry[2];
+            } else if (entry[0] == CATALOG_ZONES_ENTRY) {
+                zoneMap = std::make_unique<ZoneMap>(*this, entry[1]);
+            } else if (entry[0] == COLUMN_ID) {
+                hashIndex = std::make_unique<HashIndex>(*this, entry[1]);
+            } else {
+                indexes.push_back(std::make_unique<SecondaryIndex>(*this, entry[0], entry[1], entry[2]));
+            }
+        }
+    }
+    if (storeColumns == 0) {
+        columnStore.reset();
+    } else if (!columnStore || columnStore->getColumns() != storeColumns) {
+        columnStore = std::make_unique<ColumnStore>(storeColumns);
+    }
+    columnStoreStale = columnStore != nullptr;
+    loadTables(tablesRoot);
+}
+
+// Rebuilds the CREATE TABLE handles from the table catalog (tablesRoot 0 =
+// none). Handles whose table kept its root are kept, so pointers to them
+// survive a rollback that did not undo their CREATE TABLE; the schema version
+// moves on whenever the set of tables changes.
+void Table::loadTables(uint32_t tablesRoot) {
+    std::vector<std::unique_ptr<SchemaTable>> loaded;
+    bool changed = false;
+    tableCatalog.reset();
+    if (tablesRoot != 0) {
+        tableCatalog = std::make_unique<SecondaryIndex>(*this, INDEX_NO_COLUMN, tablesRoot);
+        for (IndexCursor cursor(*tableCatalog, std::string_view()); !cursor.isEnd(); cursor.advance()) {
+            std::string name(cursor.key());
+            std::string_view entry = cursor.payload();
+            if (entry.size() < sizeof(uint32_t)) {
+                throw std::runtime_error("Corrupt table catalog: entry for " + name + " is too short");
+            }
+            uint32_t root;
+            std::memcpy(&root, entry.data(), sizeof(root));
+            auto existing = std::find_if(schemaTables.begin(), schemaTables.end(), [&](const auto& schemaTable) {
+                return schemaTable != nullptr && schemaTable->getName() == name;
+            });
+            if (existing != schemaTables.end() && (*existing)->getRootPageNum() == root) {
+                loaded.push_back(std::move(*existing));
+            } else {
+                loaded.push_back(std::make_unique<SchemaTable>(
+                    *this, Schema::deserialize(name, entry.substr(sizeof(root))), root));
+                changed = true;
+            }
+        }
+    }
+    for (const auto& dropped : schemaTables) {
+        changed = changed || dropped != nullptr;
+    }
+    schemaTables = std::move(loaded);
+    if (changed) {
+        schemaVersion++;
+    }
+}
+
+// Records an index in the catalog page, allocating that on first use
+void Table::addCatalogEntry(uint32_t column, uint32_t pageNum, uint32_t includedColumns) {
+    uint32_t catalog = *catalogPageNum(getPageAddress(rootPageNum));
+    if (catalog == 0) {
+        catalog = getUnusedPageNum();
+        *reinterpret_cast<uint32_t*>(getPageForWrite(catalog) + CATALOG_COUNT_OFFSET) = 0;
+        *catalogPageNum(getPageForWrite(rootPageNum)) = catalog;
+    }
+    uint8_t* catalogData = getPageForWrite(catalog);
+    uint32_t* count = reinterpret_cast<uint32_t*>(catalogData + CATALOG_COUNT_OFFSET);
+    uint32_t* entry = reinterpret_cast<uint32_t*>(catalogData + CATALOG_ENTRIES_OFFSET + *count * CATALOG_ENTRY_SIZE);
+    entry[0] = column;
+    entry[1] = pageNum;
+    entry[2] = includedColumns;
+    (*count)++;
+}
+
+void Table::createIndex(uint32_t column, uint32_t includedColumns) {
+    if (column != COLUMN_USERNAME && column != COLUMN_EMAIL) {
+        throw std::invalid_argument("Only username and email can be indexed");
+    }
+    uint32_t textColumns = (1u << COLUMN_USERNAME) | (1u << COLUMN_EMAIL);
+    if ((includedColumns & ~textColumns) != 0 || (includedColumns & (1u << column)) != 0) {
+        throw std::invalid_argument("Only the other text column can be included");
+    }
+    if (getIndex(column) != nullptr) {
+        throw std::invalid_argument("Index already exists");
+    }
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    uint32_t indexRoot = getUnusedPageNum();
+    SecondaryIndex::initializeRoot(*this, indexRoot);
+    addCatalogEntry(column, indexRoot, includedColumns);
+
+    auto index = std::make_unique<SecondaryIndex>(*this, column, indexRoot, includedColumns);
+    Cursor cursor(*this);
+    while (!cursor.isEndOfTable()) {
+        Row row = Row::deserialize(cursor.cursorSlot());
+        index->insert(SecondaryIndex::valueOf(row, column), row.getId(), index->payloadOf(row));
+        cursor.cursorAdvance();
+    }
+    indexes.push_back(std::move(index));
+}
+
+void Table::createHashIndex() {
+    if (hashIndex) {
+        throw std::invalid_argument("Hash index already exists");
+    }
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    uint32_t header = getUnusedPageNum();
+    HashIndex::initialize(*this, header);
+    addCatalogEntry(COLUMN_ID, header, 0);
+    hashIndex = std::make_unique<HashIndex>(*this, header);
+    for (Cursor cursor(*this); !cursor.isEndOfTable(); cursor.cursorAdvance()) {
+        hashIndex->put(*Node(getPageAddress(cursor.getPageNum())).leafNodeKey(cursor.getCellNum()), cursor.getPageNum());
+    }
+}
+
+void Table::stampFormat() {
+    if (*reinterpret_cast<uint32_t*>(getPageAddress(rootPageNum) + ROOT_PAGE_FORMAT_OFFSET) != DATABASE_FORMAT_STAMP) {
+        *reinterpret_cast<uint32_t*>(getPageForWrite(rootPageNum) + ROOT_PAGE_FORMAT_OFFSET) = DATABASE_FORMAT_STAMP;
+    }
+}
+
+void Table::createColumnStore(uint32_t columnMask) {
+    uint32_t textColumns = (1u << COLUMN_USERNAME) | (1u << COLUMN_EMAIL);
+    if (columnMask == 0 || (columnMask & ~textColumns) != 0) {
+        throw std::invalid_argument("A column store holds username, email or both");
+    }
+    if (columnStore) {
+        throw std::invalid_argument("Column store already exists");
+    }
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    // older builds would read the store's entry as an index
+    stampFormat();
+    addCatalogEntry(CATALOG_COLUMNS_ENTRY, 0, columnMask);
+    columnStore = std::make_unique<ColumnStore>(columnMask);
+    columnStore->rebuild(*this);
+    columnStoreStale = false;
+}
+
+const ColumnStore* Table::getColumnStore() {
+    if (columnStore && columnStoreStale) {
+        pager->evictToCapacity();
+        std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+        columnStore->rebuild(*this);
+        columnStoreStale = false;
+    }
+    return columnStore.get();
+}
+
+uint32_t Table::getColumnStoreColumns() const {
+    return columnStore ? columnStore->getColumns() : 0;
+}
+
+void Table::createZoneMap() {
+    if (zoneMap) {
+        throw std::invalid_argument("Zone map already exists");
+    }
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    // older builds would read the map's entry as an index
+    stampFormat();
+    uint32_t header = getUnusedPageNum();
+    ZoneMap::initialize(*this, header);
+    addCatalogEntry(CATALOG_ZONES_ENTRY, header, 0);
+    zoneMap = std::make_unique<ZoneMap>(*this, header);
+    // the leaf chain, as rebuildLeafFilters walks it
+    uint32_t pageNum = rootPageNum;
+    while (!leafFilters.isLeaf(pageNum)) {
+        Node node(getPageAddress(pageNum));
+        if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+            return;
+        }
+        pageNum = *node.internalNodeChild(0);
+    }
+    do {
+        zoneMap->recompute(pageNum);
+        pageNum = *Node(getPageAddress(pageNum)).leafNodeRightSibling();
+    } while (pageNum != 0);
+}
+
+void Table::createTable(const Schema& schema) {
+    if (schema.getName() == USERS_TABLE_NAME || getSchemaTable(schema.getName()) != nullptr) {
+        throw std::invalid_argument("Table " + schema.getName() + " already exists");
+    }
+    pager->evictToCapacity();
+    std::lock_guard<std::mutex> latch(pager->getWriteLatch());
+    // older builds would read the table catalog's entry as an index
+    stampFormat();
+    if (!tableCatalog) {
+        uint32_t tablesRoot = getUnusedPageNum();
+        SecondaryIndex::initializeRoot(*this, tablesRoot);
+        addCatalogEntry(CATALOG_TABLES_ENTRY, tablesRoot, 0);
+        tableCatalog = std::make_unique<SecondaryIndex>(*this, INDEX_NO_COLUMN, tablesRoot);
+    }
+    uint32_t tableRoot = getUnusedPageNum();
+    SecondaryIndex::initializeRoot(*this, tableRoot);
+    std::string entry(reinterpret_cast<const char*>(&tableRoot), sizeof(tableRoot));
+    entry += schema.serialize();
+    tableCatalog->insert(schema.getName(), 0, entry);
+
+    auto position = std::lower_bound(schemaTables.begin(), schemaTables.end(), schema.getName(),
+                                     [](const auto& schemaTable, const std::string& name) {
+                                         return schemaTable->getName() < name;
+                                     });
+    schemaTables.insert(position, std::make_unique<SchemaTable>(*this, schema, tableRoot));
+    schemaVersion++;
+}
+
+SchemaTable* Table::getSchemaTable(std::string_view name) const {
+    std::string lowered(name);
+    for (char& c : lowered) {
+        c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    auto found = std::lower_bound(schemaTables.begin(), schemaTables.end(), lowered,
+                                  [](const auto& schemaTable, const std::string& wanted) {
+                                      return schemaTable->getName() < wanted;
+                                  });
+    return found != schemaTables.end() && (*found)->getName() == lowered ? found->get() : nullptr;
+}
+
+std::vector<std::string> Table::getTableNames() const {
+    std::vector<std::string> names{std::string(USERS_TABLE_NAME)};
+    for (const auto& schemaTable : schemaTables) {
+        names.push_back(schemaTable->getName());
+    }
+    return names;
+}
+
+void Table::rehashLeaf(uint32_t pageNum) {
+    Node leaf(getPageAddress(pageNum));
+    uint32_t numCells = *leaf.leafNodeNumCells();
+    for (uint32_t i = 0; i < numCells; i++) {
+        hashIndex->put(*leaf.leafNodeKey(i), pageNum);
+    }
+}
+
+void Table::rebuildLeafFilter(uint32_t pageNum) {
+    Node node(getPageAddress(pageNum));
+    bool isLeaf = node.getNodeType() == NodeType::NODE_LEAF;
+    leafFilters.reset(pageNum, isLeaf);
+    uint32_t numCells = isLeaf ? *node.leafNodeNumCells() : 0;
+    for (uint32_t i = 0; i < numCells; i++) {
+        leafFilters.add(pageNum, *node.leafNodeKey(i));
+    }
+}
+
+// Walks the leaf chain, which reads every leaf once
+void Table::rebuildLeafFilters() {
+    leafFilters.clear();
+    uint32_t pageNum = rootPageNum;
+    while (Node(getPageAddress(pageNum)).getNodeType() != NodeType::NODE_LEAF) {
+        Node node(getPageAddress(pageNum));
+        if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+            return;
+        }
+        pageNum = *node.internalNodeChild(0);
+    }
+    // the root may be the only leaf; no other leaf is page 0
+    uint32_t leavesVisited = 0;
+    do {
+        rebuildLeafFilter(pageNum);
+        pageNum = *Node(getPageAddress(pageNum)).leafNodeRightSibling();
+        // no page pointer is held across iterations; keep the cache bounded
+        if (++leavesVisited % 1024 == 0) {
+            pager->evictToCapacity();
+        }
+    } while (pageNum != 0);
+}
+
+const SecondaryIndex* Table::getIndex(uint32_t column) const {
+    for (const auto& index : indexes) {
+        if (index->getColumn() == column) {
+            return index.get();
+        }
+    }
+    return nullptr;
+}
+
+void Table::rollbackTransaction() {
+    rebuildLeafFilters(pager->rollbackTransaction());
+    loadIndexes();
+}
+
+void Table::rollbackToSavepoint() {
+    rebuildLeafFilters(pager->rollbackToSavepoint());
+    loadIndexes();
+}
+
+// After a rollback only the pages it changed back can have stale filters.
+// Those include index and catalog pages; of the table's pages that survive,
+// only the root can have changed its type, so the rest keep their leaf flag.
+void Table::rebuildLeafFilters(const std::vector<uint32_t>& changedPages) {
+    for (uint32_t pageNum : changedPages) {
+        if (pageNum >= pager->getNumPages()) {
+            leafFilters.reset(pageNum, false);
+        } else if (pageNum == rootPageNum || leafFilters.isLeaf(pageNum)) {
+            rebuildLeafFilter(pageNum);
+        }
+    }
+}
 
 ExecuteResult Table::execute_insert(const std::vector<std::string> tokens) {
     uint8_t* node_data = getPageAddress(rootPageNum);
     Node node(node_data);
-    std::cout << "num cells: " << *node.leafNodeNumCells() << "\n";
     // delete below soon 
     // if (*node.leafNodeNumCells() == LEAF_NODE_MAX_CELLS) {
     //     return ExecuteResult::EXECUTE_TABLE_FULL;
@@ -114,7 +770,6 @@ ExecuteResult Table::execute_insert(const std::vector<std::string> tokens) {
             return ExecuteResult::EXECUTE_FAILURE;
         }
         uint32_t rowNum = static_cast<uint32_t>(std::stoul(tokens[1]));
-        std::cout << "row num: " << rowNum << "\n";
         std::string username = tokens[2];
         std::string email = tokens[3];
 
@@ -178,17 +833,36 @@ ExecuteResult Table::execute_insert_multiple(const std::vector<std::string> toke
 
 ExecuteResult Table::execute_select_all() {
     try {
-        Cursor cursor(*this);  // Use table start constructor
-        if (cursor.isEndOfTable()) {
-            std::cout << "No rows in table.\n";
+        if (scheduler != nullptr && getNumRows() >= PARALLEL_SCAN_MIN_ROWS) {
+            // each morsel formats its rows into its own buffer; buffers are joined in key order
+            std::string output = ParallelScan(*this, *scheduler).reduce(
+                std::string(),
+                [](std::string& text, uint32_t, const void* cell) {
+                    Row row = Row::deserialize(cell);
+                    text += "(" + std::to_string(row.getId()) + ", " + row.getEmail() + ", " + row.getUsername() + ")\n";
+                },
+                [](std::string& into, const std::string& from) { into += from; });
+            pager->evictToCapacity();
+            std::cout << output;
             return ExecuteResult::EXECUTE_SUCCESS;
         }
-        while (!cursor.isEndOfTable()) {
-            Row row = Row::deserialize(cursor.cursorSlot());
-            row.printRow();
-            cursor.cursorAdvance();
+        TableScan scan(*this);
+        Batch batch;
+        bool empty = true;
+        while (scan.next(batch)) {
+            empty = false;
+            const ColumnVector& ids = batch.columns[COLUMN_ID];
+            const ColumnVector& usernames = batch.columns[COLUMN_USERNAME];
+            const ColumnVector& emails = batch.columns[COLUMN_EMAIL];
+            for (uint32_t i = 0; i < batch.selectedCount; i++) {
+                uint32_t row = batch.selection[i];
+                // same layout as Row::printRow
+                std::cout << "(" << ids.integers[row] << ", " << emails.texts[row] << ", " << usernames.texts[row] << ")\n";
+            }
+        }
+        if (empty) {
+            std::cout << "No rows in table.\n";
         }
-
         return ExecuteResult::EXECUTE_SUCCESS;
     } catch (const std::out_of_range& e) {
         throw std::out_of_range("Failed to retrivew a row.\n");
@@ -204,20 +878,171 @@ ExecuteResult Table::execute_select(const std::vector<std::string>&) {
 }
 
 uint32_t Table::getNumRows() const {
-    uint8_t* node_data = getPageAddress(rootPageNum);
-    Node node(node_data);
-    return *node.leafNodeNumCells();
+    return subtreeRows(rootPageNum);
+}
+
+// Leaf: its cell count. Internal: the sum of the counts kept for its children.
+uint32_t Table::subtreeRows(uint32_t pageNum) const {
+    Node node(getPageAddress(pageNum));
+    if (node.getNodeType() == NodeType::NODE_LEAF) {
+        return *node.leafNodeNumCells();
+    }
+    uint32_t rows = 0;
+    uint32_t numKeys = *node.internalNodeNumKeys();
+    for (uint32_t i = 0; i <= numKeys; i++) {
+        rows += *node.internalNodeChildRows(i);
+    }
+    return rows;
+}
+
+// A row was added to or removed from the leaf at pageNum: every ancestor's
+// count for the path down to it changes by delta
+void Table::adjustRowCounts(uint32_t pageNum, int32_t delta) {
+    Node node(getPageAddress(pageNum));
+    while (!node.isRootNode()) {
+        uint32_t parentPageNum = *node.nodeParent();
+        Node parent(getPageForWrite(parentPageNum));
+        uint32_t index = parent.internalNodeFindChild(pageNum);
+        if (index == UINT32_MAX) {
+            return;
+        }
+        *parent.internalNodeChildRows(index) += delta;
+        pageNum = parentPageNum;
+        node = parent;
+    }
+}
+
+// Recomputes the counts on the path from pageNum to the root, after a split
+// moved rows or children around
+void Table::refreshRowCounts(uint32_t pageNum) {
+    Node node(getPageAddress(pageNum));
+    while (!node.isRootNode()) {
+        uint32_t parentPageNum = *node.nodeParent();
+        Node parent(getPageForWrite(parentPageNum));
+        uint32_t index = parent.internalNodeFindChild(pageNum);
+        if (index == UINT32_MAX) {
+            return;
+        }
+        *parent.internalNodeChildRows(index) = subtreeRows(pageNum);
+        pageNum = parentPageNum;
+        node = parent;
+    }
+}
+
+// Descends by key like Cursor does, adding up the counts of the subtrees that
+// lie entirely to the left of the path
+// Descends as countRowsBelow does; child i of an internal node holds keys up
+// to its separator, the right child up to the node's own bound
+bool Table::leafCovering(uint32_t key, LeafPosition& position) const {
+    position = LeafPosition{rootPageNum, UINT32_MAX, INVALID_PAGE_NUM, 0, UINT32_MAX};
+    // the filters know which pages are leaves, so the leaf itself is not read
+    while (!leafFilters.isLeaf(position.pageNum)) {
+        Node node(getPageAddress(position.pageNum));
+        if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+            return false;
+        }
+        uint32_t minIndex = 0;
+        uint32_t numKeys = *node.internalNodeNumKeys();
+        uint32_t maxIndex = numKeys;
+        while (minIndex < maxIndex) {
+            uint32_t index = (minIndex + maxIndex) / 2;
+            if (*node.internalNodeKey(index) >= key) {
+                maxIndex = index;
+            } else {
+                minIndex = index + 1;
+            }
+        }
+        position.parentPageNum = position.pageNum;
+        position.parentUpperBound = position.upperBound;
+        position.childIndex = minIndex;
+        if (minIndex < numKeys) {
+            position.upperBound = *node.internalNodeKey(minIndex);
+        }
+        position.pageNum = *node.internalNodeChild(minIndex);
+    }
+    return true;
+}
+
+bool Table::nextLeaf(LeafPosition& position) const {
+    if (position.parentPageNum != INVALID_PAGE_NUM) {
+        Node parent(getPageAddress(position.parentPageNum));
+        uint32_t numKeys = *parent.internalNodeNumKeys();
+        if (position.childIndex < numKeys) {
+            position.childIndex++;
+            position.pageNum = *parent.internalNodeChild(position.childIndex);
+            position.upperBound = position.childIndex < numKeys ? *parent.internalNodeKey(position.childIndex)
+                                                                : position.parentUpperBound;
+            return true;
+        }
+    }
+    return position.upperBound != UINT32_MAX && leafCovering(position.upperBound + 1, position);
+}
+
+uint32_t Table::countRowsBelow(uint64_t key) const {
+    if (key > UINT32_MAX) {
+        return getNumRows();
+    }
+    uint32_t rows = 0;
+    Node node(getPageAddress(rootPageNum));
+    while (node.getNodeType() == NodeType::NODE_INTERNAL) {
+        if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+            return rows;
+        }
+        uint32_t minIndex = 0;
+        uint32_t maxIndex = *node.internalNodeNumKeys();
+        while (minIndex < maxIndex) {
+            uint32_t index = (minIndex + maxIndex) / 2;
+            if (*node.internalNodeKey(index) >= key) {
+                maxIndex = index;
+            } else {
+                minIndex = index + 1;
+            }
+        }
+        for (uint32_t i = 0; i < minIndex; i++) {
+            rows += *node.internalNodeChildRows(i);
+        }
+        node = Node(getPageAddress(*node.internalNodeChild(minIndex)));
+    }
+    uint32_t numCells = *node.leafNodeNumCells();
+    uint32_t below = 0;
+    while (below < numCells && *node.leafNodeKey(below) < key) {
+        below++;
+    }
+    return rows + below;
+}
+
+bool Table::keyAtRank(uint32_t rank, uint32_t& key) const {
+    Node node(getPageAddress(rootPageNum));
+    while (node.getNodeType() == NodeType::NODE_INTERNAL) {
+        uint32_t numKeys = *node.internalNodeNumKeys();
+        if (*node.internalNodeRightChild() == INVALID_PAGE_NUM) {
+            return false;
+        }
+        uint32_t child = 0;
+        while (child <= numKeys && rank >= *node.internalNodeChildRows(child)) {
+            rank -= *node.internalNodeChildRows(child);
+            child++;
+        }
+        if (child > numKeys) {
+            return false;
+        }
+        node = Node(getPageAddress(*node.internalNodeChild(child)));
+    }
+    if (rank >= *node.leafNodeNumCells()) {
+        return false;
+    }
+    key = *node.leafNodeKey(rank);
+    return true;
 }
 
 void Table::leafNodeSplitAndInsert(uint32_t key, const Row* value, uint32_t cellNumToInsertAt, uint32_t oldNodePageNum) {
-    std::cout << "Executing leafNodeSplitAndInsert for key: " << key << "\n";
     // left node
-    uint8_t* oldNodeData = getPageAddress(oldNodePageNum);
+    uint8_t* oldNodeData = getPageForWrite(oldNodePageNum);
     Node oldNode(oldNodeData);
     uint32_t oldNodeMax = oldNode.getNodeMaxKey();
     // right node 
     uint32_t newPageNum = getUnusedPageNum();
-    uint8_t* newNodeData = getPageAddress(newPageNum);
+    uint8_t* newNodeData = getPageForWrite(newPageNum);
     Node newNode(newNodeData);
     newNode.initializeLeafNode();
     *newNode.nodeParent() = *oldNode.nodeParent();
@@ -235,9 +1060,6 @@ void Table::leafNodeSplitAndInsert(uint32_t key, const Row* value, uint32_t cell
     // insert new cell
     allCells.emplace(allCells.begin() + cellNumToInsertAt, key, *value);
 
-    for (uint32_t i = 0; i < allCells.size(); i++) {
-        std::cout << "key: " << allCells[i].first << "\n";
-    }
     // fill left node
     for (uint32_t i = 0; i < LEAF_NODE_LEFT_SPLIT_COUNT; i++) {
         *oldNode.leafNodeKey(i) = allCells[i].first;
@@ -257,18 +1079,35 @@ void Table::leafNodeSplitAndInsert(uint32_t key, const Row* value, uint32_t cell
     *newNode.leafNodeRightSibling() = *oldNode.leafNodeRightSibling();      
     *oldNode.leafNodeRightSibling() = newPageNum;
 
+    uint32_t leftPageNum = oldNodePageNum;
     if (oldNode.isRootNode()) {
-        return createNewRoot(newPageNum);
+        createNewRoot(newPageNum);
+        // the root's cells moved to a fresh left child
+        leftPageNum = *Node(getPageAddress(rootPageNum)).internalNodeChild(0);
     } else {
         // reassign parent pointer to new max of node 
         uint32_t parentPageNum = *oldNode.nodeParent();
         uint32_t newNodeMax = oldNode.getNodeMaxKey();        
-        uint8_t* parentData = getPageAddress(parentPageNum);
+        uint8_t* parentData = getPageForWrite(parentPageNum);
         Node parent(parentData);
 
-        std::cout << "Updating max key to " << newNodeMax << "\n";
         parent.internalNodeUpdateMaxKey(oldNodePageNum, newNodeMax);
         internalNodeInsert(parentPageNum, newPageNum);
+        // the parent may itself have split; both halves' paths now end at the root
+        refreshRowCounts(oldNodePageNum);
+        refreshRowCounts(newPageNum);
+    }
+    // a root split turns page 0 into an internal node
+    rebuildLeafFilter(oldNodePageNum);
+    rebuildLeafFilter(leftPageNum);
+    rebuildLeafFilter(newPageNum);
+    if (hashIndex) {
+        rehashLeaf(leftPageNum);
+        rehashLeaf(newPageNum);
+    }
+    if (zoneMap) {
+        zoneMap->recompute(leftPageNum);
+        zoneMap->recompute(newPageNum);
     }
 }
 
@@ -278,23 +1117,15 @@ void Table::leafNodeSplitAndInsert(uint32_t key, const Row* value, uint32_t cell
 // should this be switched to non sequential storage?
 void Table::createNewRoot(uint32_t rightChildPageNum) {
     // Get the old root (which will become the left child)
-    uint8_t* rootData = getPageAddress(rootPageNum);
+    uint8_t* rootData = getPageForWrite(rootPageNum);
     Node root(rootData);
     
-    uint8_t* rightChildData = getPageAddress(rightChildPageNum);
+    uint8_t* rightChildData = getPageForWrite(rightChildPageNum);
     Node rightChild(rightChildData);
     
     // Allocate a new page for the left child
     uint32_t leftChildPageNum = getUnusedPageNum();
-    std::cout << "leftChildPageNum given in createNewRoot: " << leftChildPageNum << "\n";
-    uint8_t* leftChildData = getPageAddress(leftChildPageNum);
-    
-    std::cout << "--------------------------\n";
-    std::cout << "All page nums: \n";
-    std::cout << "rootPageNum: " << rootPageNum << "\n";
-    std::cout << "leftChildPageNum: " << leftChildPageNum << "\n";
-    std::cout << "rightChildPageNum: " << rightChildPageNum << "\n";
-    std::cout << "--------------------------\n";
+    uint8_t* leftChildData = getPageForWrite(leftChildPageNum);
 
     // Copy the old root's entire page to the left child
     memcpy(leftChildData, rootData, PAGE_SIZE);
@@ -309,34 +1140,50 @@ void Table::createNewRoot(uint32_t rightChildPageNum) {
     
     // Set up the internal node structure
     *root.internalNodeChild(0) = leftChildPageNum;
-    uint32_t leftChildMaxKey = leftChild.getNodeMaxKey();
-    *root.internalNodeKey(0) = leftChildMaxKey;  // ← Fixed: dereference
+    uint32_t leftChildMaxKey = getMaxKey(leftChildPageNum);
+    *root.internalNodeKey(0) = leftChildMaxKey;
     *root.internalNodeRightChild() = rightChildPageNum;
-    
-    std::cout << "Root internalNodeChildren: " << *root.internalNodeChild(0) << "\n";
-    std::cout << "Root internalNodeKeys: " << *root.internalNodeKey(0) << "\n";
-    std::cout << "Root internalNodeRightChild: " << *root.internalNodeKey(1) << "\n";
-    std::cout << "--------------------------\n"; 
+    *root.internalNodeChildRows(0) = subtreeRows(leftChildPageNum);
+    *root.internalNodeChildRows(1) = subtreeRows(rightChildPageNum);
 
-    for(uint32_t i = 0; i < *root.internalNodeNumKeys(); i++) {
-        std::cout << "parent key (inside createNewRoot): " << *root.internalNodeKey(i) << std::endl;
-    }
     *leftChild.nodeParent() = rootPageNum;
     *rightChild.nodeParent() = rootPageNum;
+
+    // an internal left child took over the old root's children; re-point them at it
+    if (leftChild.getNodeType() == NodeType::NODE_INTERNAL) {
+        uint32_t numKeys = *leftChild.internalNodeNumKeys();
+        for (uint32_t i = 0; i < numKeys; i++) {
+            Node grandchild(getPageForWrite(*leftChild.internalNodeCell(i)));
+            *grandchild.nodeParent() = leftChildPageNum;
+        }
+        Node rightmost(getPageForWrite(*leftChild.internalNodeRightChild()));
+        *rightmost.nodeParent() = leftChildPageNum;
+    }
+}
+
+// Largest key stored anywhere under pageNum. For internal nodes this follows
+// the right child, since Node::getNodeMaxKey only sees the last separator.
+uint32_t Table::getMaxKey(uint32_t pageNum) const {
+    Node node(getPageAddress(pageNum));
+    while (node.getNodeType() == NodeType::NODE_INTERNAL) {
+        uint32_t rightChildPageNum = *node.internalNodeRightChild();
+        if (rightChildPageNum == INVALID_PAGE_NUM) {
+            return node.getNodeMaxKey();
+        }
+        node = Node(getPageAddress(rightChildPageNum));
+    }
+    return node.getNodeMaxKey();
 }
 
 void Table::internalNodeInsert(uint32_t parentPageNum, uint32_t childPageNum) {
-    uint8_t* parentData = getPageAddress(parentPageNum);
+    uint8_t* parentData = getPageForWrite(parentPageNum);
     Node parent(parentData);
 
-    uint8_t* childData = getPageAddress(childPageNum);
-    Node child(childData);
-    uint32_t childMaxKey = child.getNodeMaxKey();
+    uint32_t childMaxKey = getMaxKey(childPageNum);
 
     uint32_t numKeys = *parent.internalNodeNumKeys();
 
     if (numKeys >= INTERNAL_NODE_MAX_KEYS) {
-        std::cout << "TODO: Split internal node\n";
         internalNodeSplitAndInsert(parentPageNum, childPageNum);
         return;
     }
@@ -347,18 +1194,20 @@ void Table::internalNodeInsert(uint32_t parentPageNum, uint32_t childPageNum) {
     // checks if right child is invalid - Means node is empty 
     if (rightChildPageNum == INVALID_PAGE_NUM) {
         *parent.internalNodeRightChild() = childPageNum;
+        *parent.internalNodeChildRows(numKeys) = subtreeRows(childPageNum);
         return;
     }
-    uint8_t* rightChildData = getPageAddress(rightChildPageNum);
-    Node rightChild(rightChildData);
-    uint32_t rightChildMaxKey = rightChild.getNodeMaxKey();
+    uint32_t rightChildMaxKey = getMaxKey(rightChildPageNum);
 
     if (rightChildMaxKey < childMaxKey) {
         // New child becomes the rightmost child
+        uint32_t rightChildRows = *parent.internalNodeChildRows(numKeys);
         *parent.internalNodeNumKeys() = numKeys + 1;
-        *parent.internalNodeChild(numKeys) = rightChildPageNum;
+        *parent.internalNodeCell(numKeys) = rightChildPageNum;
         *parent.internalNodeKey(numKeys) = rightChildMaxKey;
+        *parent.internalNodeChildRows(numKeys) = rightChildRows;
         *parent.internalNodeRightChild() = childPageNum;
+        *parent.internalNodeChildRows(numKeys + 1) = subtreeRows(childPageNum);
 
     } else {
         // Find the correct position and shift elements
@@ -367,121 +1216,78 @@ void Table::internalNodeInsert(uint32_t parentPageNum, uint32_t childPageNum) {
             i--;
         }
         
-        // Shift elements from position i to the right
-        std::cout << "Shifting elements from position i to the right\n";
-        std::cout << "numKeys: " << numKeys << "\n";
-        std::cout << "i: " << i << "\n";
+        // Shift cells from position i to the right (raw cells: internalNodeChild(numKeys)
+        // would hand back the right child pointer)
         for (uint32_t j = numKeys; j > i; j--) {
-            *parent.internalNodeChild(j) = *parent.internalNodeChild(j - 1);
-            *parent.internalNodeKey(j) = *parent.internalNodeKey(j - 1);
-            uint32_t childPageNum = *parent.internalNodeChild(j);
-            std::cout << "childPageNum inside loop: " << childPageNum << "\n"; 
+            std::memcpy(parent.internalNodeCell(j), parent.internalNodeCell(j - 1), INTERNAL_NODE_CELL_SIZE);
         }
         
-        *parent.internalNodeChild(i) = childPageNum;
+        *parent.internalNodeCell(i) = childPageNum;
         *parent.internalNodeKey(i) = childMaxKey;
         *parent.internalNodeNumKeys() = numKeys + 1;
+        *parent.internalNodeChildRows(i) = subtreeRows(childPageNum);
     }
 }
 
+/*
+Splits the full internal node oldPageNum and inserts childPageNum into whichever
+half it belongs to. The upper half of the old node's children move to a new
+internal node, which is then inserted into the parent (creating a new root when
+the old node was the root).
+*/
 void Table::internalNodeSplitAndInsert(uint32_t oldPageNum, uint32_t childPageNum) {
-    uint8_t* oldNodeData = getPageAddress(oldPageNum);
-    Node oldNode(oldNodeData);
-    uint32_t oldNodeMax = oldNode.getNodeMaxKey();
-    
-    uint8_t* childNodedata = getPageAddress(childPageNum);
-    Node childNode(childNodedata);
-    uint32_t childNodeMax = childNode.getNodeMaxKey();
-    
+    Node oldNode(getPageForWrite(oldPageNum));
+    uint32_t childNodeMax = getMaxKey(childPageNum);
+
     uint32_t newPageNum = getUnusedPageNum();
-    uint8_t* newNodeData = getPageAddress(newPageNum);
-    Node newNode(newNodeData);
+    Node newNode(getPageForWrite(newPageNum));
     newNode.initializeInternalNode();
 
     bool splittingRoot = oldNode.isRootNode();
-    
-    uint8_t* grandparentData;
     if (splittingRoot) {
+        // root's contents move to a fresh left page; root points at it and at newNode
         createNewRoot(newPageNum);
-        grandparentData = getPageAddress(rootPageNum);
-        
-        // refetch old node and new node after root creation
-        uint32_t leftChildPageNum = *Node(grandparentData).internalNodeChild(0);
-        oldPageNum = leftChildPageNum;
-        oldNodeData = getPageAddress(leftChildPageNum);
-        oldNode = Node(oldNodeData);
-        newNodeData = getPageAddress(newPageNum);
-        newNode = Node(newNodeData);  // Reassign, don't redeclare
-    } else {
-        grandparentData = getPageAddress(*oldNode.nodeParent());
-    }
-    // create reference to grandparent 
-    Node grandparent(grandparentData);
-
-    // copy all keys to vector
-    std::vector<uint32_t> allKeys;
-    std::vector<uint32_t> allChildren;
-    uint32_t numExistingKeys = *oldNode.internalNodeNumKeys();
-    if (numExistingKeys != INTERNAL_NODE_MAX_KEYS) {
-        throw std::runtime_error("internalNodeSplitAndInsert called when node not full");
-    }
-    // populate vectors and insert new key/child 
-    for (uint32_t i = 0; i < numExistingKeys; i++) {
-        allKeys.push_back(*oldNode.internalNodeKey(i));
-        allChildren.push_back(*oldNode.internalNodeChild(i));
-    }
-    allChildren.push_back(*oldNode.internalNodeRightChild());
-    // insertion pos for new child 
-    uint32_t insertPos = 0;
-    while (insertPos < allKeys.size() && allKeys[insertPos] < childNodeMax) {
-        insertPos++;
-    }
-    allKeys.insert(allKeys.begin() + insertPos, childNodeMax);
-    allChildren.insert(allChildren.begin() + insertPos + 1, childPageNum);  
-    
-    uint32_t middleIndex = (INTERNAL_NODE_MAX_KEYS + 1) / 2;  // or allKeys.size() / 2
-    uint32_t middleKey = allKeys[middleIndex];
-
-    for (uint32_t i = 0; i < middleIndex; i++) {
-        *oldNode.internalNodeKey(i) = allKeys[i];
-        *oldNode.internalNodeChild(i) = allChildren[i];
+        oldPageNum = *Node(getPageAddress(rootPageNum)).internalNodeChild(0);
+        oldNode = Node(getPageForWrite(oldPageNum));
     }
 
-    *oldNode.internalNodeRightChild() = allChildren[middleIndex];
-    *oldNode.internalNodeNumKeys() = middleIndex - 1;
+    // the old node's right child is the first to move
+    uint32_t movedPageNum = *oldNode.internalNodeRightChild();
+    internalNodeInsert(newPageNum, movedPageNum);
+    *Node(getPageForWrite(movedPageNum)).nodeParent() = newPageNum;
+    *oldNode.internalNodeRightChild() = INVALID_PAGE_NUM;
+    *oldNode.internalNodeChildRows(*oldNode.internalNodeNumKeys()) = 0;
 
-    uint32_t newNodeKeyCount = allKeys.size() - middleIndex - 1;
-    for (uint32_t i = 0; i < newNodeKeyCount; i++) {
-        *newNode.internalNodeKey(i) = allKeys[middleIndex + 1 + i];
-        *newNode.internalNodeChild(i) = allChildren[middleIndex + 1 + i];
+    // then the upper half of its keyed children, right to left
+    for (uint32_t i = INTERNAL_NODE_MAX_KEYS - 1; i > INTERNAL_NODE_MAX_KEYS / 2; i--) {
+        movedPageNum = *oldNode.internalNodeCell(i);
+        internalNodeInsert(newPageNum, movedPageNum);
+        *Node(getPageForWrite(movedPageNum)).nodeParent() = newPageNum;
+        (*oldNode.internalNodeNumKeys())--;
     }
 
-    *newNode.internalNodeRightChild() = allChildren[allChildren.size() - 1];
-    *newNode.internalNodeNumKeys() = newNodeKeyCount;
+    // the last remaining keyed child becomes the old node's right child
+    uint32_t remainingKeys = *oldNode.internalNodeNumKeys() - 1;
+    uint32_t remainingRows = *oldNode.internalNodeChildRows(remainingKeys);
+    *oldNode.internalNodeRightChild() = *oldNode.internalNodeCell(remainingKeys);
+    *oldNode.internalNodeNumKeys() = remainingKeys;
+    *oldNode.internalNodeChildRows(remainingKeys) = remainingRows;
+
+    // now there is room for the child in the half it belongs to
+    uint32_t maxAfterSplit = getMaxKey(oldPageNum);
+    uint32_t destinationPageNum = (childNodeMax < maxAfterSplit) ? oldPageNum : newPageNum;
+    internalNodeInsert(destinationPageNum, childPageNum);
+    *Node(getPageForWrite(childPageNum)).nodeParent() = destinationPageNum;
+
+    uint32_t parentPageNum = *oldNode.nodeParent();
+    Node parent(getPageForWrite(parentPageNum));
+    parent.internalNodeUpdateMaxKey(oldPageNum, getMaxKey(oldPageNum));
 
-    // update child pointers for right child 
-    for (uint32_t i = 0; i <= newNodeKeyCount; i++) {
-        uint32_t movedChildPageNum = *newNode.internalNodeChild(i);
-        uint8_t* childData = getPageAddress(movedChildPageNum);
-        Node child(childData);
-        *child.nodeParent() = newPageNum;
-    }
-    
-    // Update child's parent pointer
-    uint8_t* insertedChildData = getPageAddress(childPageNum);
-    Node insertedChild(insertedChildData);
-    uint32_t insertedChildDest = (insertPos <= middleIndex) ? oldPageNum : newPageNum;
-    *insertedChild.nodeParent() = insertedChildDest;
-    
-    // Update parent with old node's new max key
-    uint8_t* parentData = getPageAddress(*oldNode.nodeParent());
-    Node parent(parentData);
-    parent.internalNodeUpdateMaxKey(oldPageNum, oldNode.getNodeMaxKey());
-    
-    // If not splitting root, insert new node into parent now
     if (!splittingRoot) {
-        internalNodeInsert(*oldNode.nodeParent(), newPageNum);
-        *newNode.nodeParent() = *oldNode.nodeParent();
+        // set first: if the parent splits in turn, it re-points the new node at its half
+        *newNode.nodeParent() = parentPageNum;
+        internalNodeInsert(parentPageNum, newPageNum);
     }
-
+    refreshRowCounts(oldPageNum);
+    refreshRowCounts(newPageNum);
 }
@@ -0,0 +1,1217 @@
+#include "vector_executor.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#include "cursor.hpp"
+#include "node.hpp"
+
+namespace {
+    // scans copy username and email with one memcpy
+    static_assert(Row::getEmailOffset() == Row::getUsernameOffset() + COLUMN_USERNAME_SIZE,
+                  "username and email must be adjacent in the serialized row");
+
+    // Rows an evaluation over selection writes to (selections are ascending)
+    uint32_t rowsSpanned(const uint32_t* selection, uint32_t count) {
+        return count == 0 ? 0 : selection[count - 1] + 1;
+    }
+
+    void requireIntegers(const ColumnVector& column, uint32_t count, const char* context) {
+        if (count > 0 && column.isText) {
+            throw ExecutionError(std::string(context) + " needs an integer, not text");
+        }
+    }
+
+    constexpr uint32_t TEXT_BYTES_PER_ROW = COLUMN_USERNAME_SIZE + COLUMN_EMAIL_SIZE;
+
+    // Points the text columns at rows [0, rows) of textStorage, once it has
+    // stopped growing
+    void setTextColumns(Batch& batch, uint32_t rows) {
+        ColumnVector& usernames = batch.columns[COLUMN_USERNAME];
+        ColumnVector& emails = batch.columns[COLUMN_EMAIL];
+        usernames.setType(true, rows);
+        emails.setType(true, rows);
+        for (uint32_t row = 0; row < rows; row++) {
+            const char* username = batch.textStorage.data() + row * TEXT_BYTES_PER_ROW;
+            const char* email = username + COLUMN_USERNAME_SIZE;
+            usernames.texts[row] = std::string_view(username, fieldLength(username, COLUMN_USERNAME_SIZE));
+            emails.texts[row] = std::string_view(email, fieldLength(email, COLUMN_EMAIL_SIZE));
+        }
+    }
+
+    // The shortest of %.15g..%.17g that reads back as value
+    int formatReal(double value, char* out, size_t size) {
+        int length = 0;
+        for (int digits = 15; digits <= 17; digits++) {
+            length = std::snprintf(out, size, "%.*g", digits, value);
+            if (std::strtod(out, nullptr) == value) {
+                break;
+            }
+        }
+        return length;
+    }
+
+    // Room for any formatReal output
+    constexpr uint32_t REAL_TEXT_MAX_SIZE = 32;
+
+    int compareText(std::string_view a, std::string_view b) {
+        int result = a.compare(b);
+        return (result > 0) - (result < 0);
+    }
+
+    // out[row] = test(compare(left[row], right[row])) for each selected row.
+    // out may alias left: each row is read before it is written.
+    template <typename Test>
+    void compareLoop(bool text, const ColumnVector& left, const ColumnVector& right, const uint32_t* selection,
+                     uint32_t count, ColumnVector& out, Test test) {
+        if (text) {
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t row = selection[i];
+                out.integers[row] = test(compareText(left.texts[row], right.texts[row]));
+            }
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t row = selection[i];
+                int64_t a = left.integers[row];
+                int64_t b = right.integers[row];
+                out.integers[row] = test((a > b) - (a < b));
+            }
+        }
+    }
+
+    template <typename Apply>
+    void arithmeticLoop(const ColumnVector& right, const uint32_t* selection, uint32_t count, ColumnVector& out,
+                        Apply apply) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t row = selection[i];
+            out.integers[row] = apply(out.integers[row], right.integers[row]);
+        }
+    }
+}
+
+void ColumnVector::setType(bool text, uint32_t rows) {
+    isText = text;
+    if (text && texts.size() < rows) {
+        texts.resize(rows);
+    } else if (!text && integers.size() < rows) {
+        integers.resize(rows);
+    }
+}
+
+void Batch::setColumnCount(uint32_t count) {
+    columns.resize(count);
+}
+
+void Batch::selectAll(uint32_t rows) {
+    if (selection.size() < rows) {
+        selection.resize(rows);
+    }
+    std::iota(selection.begin(), selection.begin() + rows, 0u);
+    size = rows;
+    selectedCount = rows;
+}
+
+ColumnVector& VectorEvaluator::scratchAt(uint32_t depth) {
+    while (scratch.size() <= depth) {
+        scratch.emplace_back();
+    }
+    return scratch[depth];
+}
+
+std::vector<uint32_t>& VectorEvaluator::narrowedAt(uint32_t depth) {
+    while (narrowed.size() <= depth) {
+        narrowed.emplace_back();
+    }
+    return narrowed[depth];
+}
+
+void VectorEvaluator::evaluate(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count,
+                               ColumnVector& out) {
+    evaluateAt(expr, batch, selection, count, out, 0);
+}
+
+Value VectorEvaluator::evaluateConstant(const Expr& expr) {
+    static const uint32_t firstRow = 0;
+    ColumnVector& out = scratchAt(0);
+    evaluateAt(expr, noColumns, &firstRow, 1, out, 1);
+    return out.get(0);
+}
+
+// Scratch level depth holds the right operand of a node evaluated at depth;
+// operands are evaluated at depth + 1, so they never overwrite it.
+void VectorEvaluator::evaluateAt(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count,
+                                 ColumnVector& out, uint32_t depth) {
+    uint32_t rows = rowsSpanned(selection, count);
+    switch (expr.kind) {
+        case ExprKind::INTEGER:
+            out.setType(false, rows);
+            for (uint32_t i = 0; i < count; i++) {
+                out.integers[selection[i]] = expr.integer;
+            }
+            return;
+        case ExprKind::STRING:
+            out.setType(true, rows);
+            for (uint32_t i = 0; i < count; i++) {
+                out.texts[selection[i]] = expr.text;
+            }
+            return;
+        case ExprKind::PARAMETER: {
+            const Value& value = bindings[expr.parameter];
+            out.setType(value.isText, rows);
+            for (uint32_t i = 0; i < count; i++) {
+                if (value.isText) {
+                    out.texts[selection[i]] = value.text;
+                } else {
+                    out.integers[selection[i]] = value.integer;
+                }
+            }
+            return;
+        }
+        case ExprKind::COLUMN:
+        case ExprKind::AGGREGATE: {  // over aggregated rows, a call reads its result column
+            const ColumnVector& column = batch.columns[expr.column];
+            out.setType(column.isText, rows);
+            if (column.isText) {
+                for (uint32_t i = 0; i < count; i++) {
+                    out.texts[selection[i]] = column.texts[selection[i]];
+                }
+            } else {
+                for (uint32_t i = 0; i < count; i++) {
+                    out.integers[selection[i]] = column.integers[selection[i]];
+                }
+            }
+            return;
+        }
+        case ExprKind::UNARY:
+            evaluateAt(*expr.left, batch, selection, count, out, depth + 1);
+            requireIntegers(out, count, "operator");
+            for (uint32_t i = 0; i < count; i++) {
+                int64_t operand = out.integers[selection[i]];
+                out.integers[selection[i]] = expr.op == Operator::NOT ? !operand : -operand;
+            }
+            return;
+        case ExprKind::BINARY:
+            break;
+    }
+
+    if (expr.op == Operator::AND || expr.op == Operator::OR) {
+        evaluateLogical(expr, batch, selection, count, out, depth);
+        return;
+    }
+
+    evaluateAt(*expr.left, batch, selection, count, out, depth + 1);
+    ColumnVector& right = scratchAt(depth);
+    evaluateAt(*expr.right, batch, selection, count, right, depth + 1);
+
+    switch (expr.op) {
+        case Operator::EQUAL:
+        case Operator::NOT_EQUAL:
+        case Operator::LESS:
+        case Operator::LESS_EQUAL:
+        case Operator::GREATER:
+        case Operator::GREATER_EQUAL: {
+            if (count > 0 && out.isText != right.isText) {
+                throw ExecutionError("cannot compare text with an integer");
+            }
+            bool text = out.isText;
+            out.setType(false, rows);  // a text operand keeps its texts; results go to integers
+            switch (expr.op) {
+                case Operator::EQUAL: compareLoop(text, out, right, selection, count, out, [](int c) { return c == 0; }); break;
+                case Operator::NOT_EQUAL: compareLoop(text, out, right, selection, count, out, [](int c) { return c != 0; }); break;
+                case Operator::LESS: compareLoop(text, out, right, selection, count, out, [](int c) { return c < 0; }); break;
+                case Operator::LESS_EQUAL: compareLoop(text, out, right, selection, count, out, [](int c) { return c <= 0; }); break;
+                case Operator::GREATER: compareLoop(text, out, right, selection, count, out, [](int c) { return c > 0; }); break;
+                default: compareLoop(text, out, right, selection, count, out, [](int c) { return c >= 0; }); break;
+            }
+            return;
+        }
+        case Operator::LIKE:
+            if (count > 0 && !(out.isText && right.isText)) {
+                throw ExecutionError("LIKE needs text operands");
+            }
+            out.setType(false, rows);
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t row = selection[i];
+                out.integers[row] = likeMatch(out.texts[row], right.texts[row]);
+            }
+            return;
+        default:
+            break;
+    }
+
+    requireIntegers(out, count, "arithmetic");
+    requireIntegers(right, count, "arithmetic");
+    switch (expr.op) {
+        case Operator::ADD: arithmeticLoop(right, selection, count, out, [](int64_t a, int64_t b) { return a + b; }); break;
+        case Operator::SUBTRACT: arithmeticLoop(right, selection, count, out, [](int64_t a, int64_t b) { return a - b; }); break;
+        case Operator::MULTIPLY: arithmeticLoop(right, selection, count, out, [](int64_t a, int64_t b) { return a * b; }); break;
+        default:
+            for (uint32_t i = 0; i < count; i++) {
+                if (right.integers[selection[i]] == 0) {
+                    throw ExecutionError("division by zero");
+                }
+            }
+            arithmeticLoop(right, selection, count, out, [](int64_t a, int64_t b) { return a / b; });
+            break;
+    }
+}
+
+// The right side only runs on the rows the left side leaves undecided
+void VectorEvaluator::evaluateLogical(const Expr& expr, const Batch& batch, const uint32_t* selection, uint32_t count,
+                                      ColumnVector& out, uint32_t depth) {
+    evaluateAt(*expr.left, batch, selection, count, out, depth + 1);
+    requireIntegers(out, count, "AND/OR");
+    bool isAnd = expr.op == Operator::AND;
+    std::vector<uint32_t>& undecided = narrowedAt(depth);
+    if (undecided.size() < count) {
+        undecided.resize(count);
+    }
+    uint32_t undecidedCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t row = selection[i];
+        bool left = out.integers[row] != 0;
+        out.integers[row] = left;
+        if (left == isAnd) {
+            undecided[undecidedCount++] = row;
+        }
+    }
+
+    ColumnVector& right = scratchAt(depth);
+    evaluateAt(*expr.right, batch, undecided.data(), undecidedCount, right, depth + 1);
+    requireIntegers(right, undecidedCount, "AND/OR");
+    for (uint32_t i = 0; i < undecidedCount; i++) {
+        out.integers[undecided[i]] = right.integers[undecided[i]] != 0;
+    }
+}
+
+uint32_t VectorEvaluator::filter(const Expr& predicate, const Batch& batch, uint32_t* selection, uint32_t count) {
+    return filterAt(predicate, batch, selection, count, 0);
+}
+
+// Top-level AND narrows the selection conjunct by conjunct, so later
+// conjuncts only see rows that passed the earlier ones
+uint32_t VectorEvaluator::filterAt(const Expr& predicate, const Batch& batch, uint32_t* selection, uint32_t count,
+                                   uint32_t depth) {
+    if (predicate.kind == ExprKind::BINARY && predicate.op == Operator::AND) {
+        count = filterAt(*predicate.left, batch, selection, count, depth);
+        return filterAt(*predicate.right, batch, selection, count, depth);
+    }
+    ColumnVector& result = scratchAt(depth);
+    evaluateAt(predicate, batch, selection, count, result, depth + 1);
+    requireIntegers(result, count, "WHERE");
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t row = selection[i];
+        selection[kept] = row;
+        kept += result.integers[row] != 0;
+    }
+    return kept;
+}
+
+TableScan::TableScan(Table& table, int64_t low, int64_t high, bool evicts)
+    : table(table), low(low), high(high), pageNum(0), cellNum(0), started(false), done(false), evicts(evicts),
+      zones(nullptr), leaf(), stats(nullptr), rowsExamined(0), rowsMaterialized(0), leavesRead(0),
+      leavesSkipped(0) {}
+
+void TableScan::pushFilter(FieldFilter filter) {
+    ZoneRange range;
+    if (ZoneMap::rangeOf(filter, range)) {
+        zoneRanges.push_back(range);
+    }
+    filters.push_back(std::move(filter));
+}
+
+void TableScan::pushZoneRange(ZoneRange range) {
+    zoneRanges.push_back(range);
+}
+
+void TableScan::countLeafRead() {
+    leavesRead++;
+    if (stats != nullptr) {
+        stats->leavesRead.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Moves to the first leaf from the current one (or, with advance, the one
+// after it) whose zone admits the ranges. False if none starts by high.
+bool TableScan::nextZoneLeaf(bool advance) {
+    int64_t last = std::min<int64_t>(high, UINT32_MAX);
+    while (true) {
+        if (advance && (leaf.upperBound >= last || !table.nextLeaf(leaf))) {
+            return false;
+        }
+        advance = true;
+        if (zones->mayMatch(leaf.pageNum, zoneRanges)) {
+            pageNum = leaf.pageNum;
+            cellNum = 0;
+            countLeafRead();
+            return true;
+        }
+        leavesSkipped++;
+        if (stats != nullptr) {
+            stats->leavesSkipped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TableScan::next(Batch& batch) {
+    // between batches no page pointer is live, so this is a safe point to evict
+    if (evicts) {
+        table.getPager().evictToCapacity();
+    }
+    if (!started) {
+        started = true;
+        if (low > high) {
+            done = true;
+        } else if (low == high) {
+            // a point scan: an absent id is usually answered by a leaf filter
+            done = low < 0 || low > UINT32_MAX || !table.findRow(static_cast<uint32_t>(low), pageNum, cellNum);
+        } else if (!zoneRanges.empty() && table.getZoneMap() != nullptr) {
+            zones = table.getZoneMap();
+            uint32_t first = static_cast<uint32_t>(std::clamp<int64_t>(low, 0, UINT32_MAX));
+            done = high < 0 || !table.leafCovering(first, leaf) || !nextZoneLeaf(false);
+            if (!done) {
+                // later leaves hold only keys past this one's bound, so they start at their first cell
+                Node start(table.getPageAddress(pageNum));
+                uint32_t numCells = *start.leafNodeNumCells();
+                while (cellNum < numCells && *start.leafNodeKey(cellNum) < first) {
+                    cellNum++;
+                }
+            }
+        } else {
+            Cursor cursor(table, static_cast<uint32_t>(low));
+            cursor.skipExhaustedLeaves();
+            done = cursor.isEndOfTable();
+            pageNum = cursor.getPageNum();
+            cellNum = cursor.getCellNum();
+        }
+        if (!done && zones == nullptr) {
+            countLeafRead();
+        }
+    }
+    if (done) {
+        return false;
+    }
+
+    batch.setColumnCount(NUM_TABLE_COLUMNS);
+    ColumnVector& ids = batch.columns[COLUMN_ID];
+
+    uint32_t rows = 0;
+    uint32_t leavesVisited = 0;
+    while (rows < BATCH_SIZE) {
+        // a selective filter can walk many leaves per batch; nothing points into
+        // the previous leaf any more, so keep the cache bounded as we go
+        if (++leavesVisited % 64 == 0 && evicts) {
+            table.getPager().evictToCapacity();
+        }
+        Node leaf(table.getPageAddress(pageNum));
+        uint32_t numCells = *leaf.leafNodeNumCells();
+        uint32_t end = numCells;
+        bool pastHigh = false;
+
+        // ids are unique, so a leaf ending at high is the last one (a point scan
+        // on a leaf's last key need not read its sibling)
+        if (cellNum < numCells && *leaf.leafNodeKey(numCells - 1) >= high) {
+            end = cellNum;
+            while (end < numCells && *leaf.leafNodeKey(end) <= high) {
+                end++;
+            }
+            pastHigh = true;
+        }
+
+        uint32_t selection[LEAF_NODE_MAX_CELLS];
+        uint32_t count = end - cellNum;
+        std::iota(selection, selection + count, cellNum);
+        rowsExamined += count;
+        const uint8_t* cells = static_cast<const uint8_t*>(leaf.leafNodeValue(0));
+        for (const FieldFilter& filter : filters) {
+            count = applyFieldFilter(filter, cells, LEAF_NODE_CELL_SIZE, selection, count);
+        }
+
+        uint32_t taken = std::min(count, BATCH_SIZE - rows);
+        // grown a leaf at a time, so a point lookup does not pay for a full batch
+        uint32_t needed = (rows + taken) * TEXT_BYTES_PER_ROW;
+        if (batch.textStorage.size() < needed) {
+            batch.textStorage.resize(std::max<size_t>(needed, batch.textStorage.size() * 2));
+        }
+        ids.setType(false, rows + taken);
+        for (uint32_t i = 0; i < taken; i++) {
+            // fixed-width fields: copy them into the column storage as they are
+            const char* cell = static_cast<const char*>(leaf.leafNodeValue(selection[i]));
+            std::memcpy(batch.textStorage.data() + rows * TEXT_BYTES_PER_ROW, cell + Row::getUsernameOffset(),
+                        TEXT_BYTES_PER_ROW);
+            ids.integers[rows] = *leaf.leafNodeKey(selection[i]);
+            rows++;
+        }
+        if (taken < count) {
+            cellNum = selection[taken];  // the batch is full; resume at the first row not taken
+            break;
+        }
+        if (pastHigh) {
+            done = true;
+            break;
+        }
+        if (zones != nullptr) {
+            if (!nextZoneLeaf(true)) {
+                done = true;
+                break;
+            }
+            continue;
+        }
+        uint32_t rightSibling = *leaf.leafNodeRightSibling();
+        if (rightSibling == 0) {
+            done = true;
+            break;
+        }
+        pageNum = rightSibling;
+        cellNum = 0;
+        countLeafRead();
+    }
+    rowsMaterialized += rows;
+
+    // storage may have moved while growing, so views are taken once it is final
+    setTextColumns(batch, rows);
+    batch.selectAll(rows);
+    return rows > 0;
+}
+
+IndexScan::IndexScan(Table& table, const SecondaryIndex& index, FieldMatch match, std::string_view value,
+                     int64_t low, int64_t high, bool covering)
+    : table(table), index(index), match(match), value(value), low(low), high(high), covering(covering), position(0),
+      started(false), rowsExamined(0), tableLookups(0) {}
+
+void IndexScan::pushFilter(FieldFilter filter) {
+    filters.push_back(std::move(filter));
+}
+
+// Appends the row an index entry describes to coveredRows, keeping it if it
+// passes the pushed filters
+bool IndexScan::coverEntry(uint32_t id, std::string_view key, std::string_view payload) {
+    size_t start = coveredRows.size();
+    coveredRows.resize(start + ROW_SIZE_BYTES);
+    char* row = coveredRows.data() + start;
+    std::memcpy(row, &id, sizeof(id));
+    auto place = [&](uint32_t column, std::string_view text) {
+        uint32_t offset = column == COLUMN_USERNAME ? Row::getUsernameOffset() : Row::getEmailOffset();
+        std::memcpy(row + offset, text.data(), text.size());
+    };
+    place(index.getColumn(), key);
+    for (uint32_t column : {COLUMN_USERNAME, COLUMN_EMAIL}) {
+        if (index.getIncludedColumns() & (1u << column)) {
+            place(column, index.includedValue(payload, column));
+        }
+    }
+    uint32_t selection[1] = {0};
+    uint32_t count = 1;
+    for (const FieldFilter& filter : filters) {
+        count = applyFieldFilter(filter, reinterpret_cast<const uint8_t*>(row), ROW_SIZE_BYTES, selection, count);
+    }
+    if (count == 0) {
+        coveredRows.resize(start);
+    }
+    return count == 1;
+}
+
+void IndexScan::collectMatches() {
+    uint32_t visited = 0;
+    for (IndexCursor cursor(index, value); !cursor.isEnd(); cursor.advance()) {
+        std::string_view key = cursor.key();
+        if (match == FieldMatch::EQUALS ? key != value : key.substr(0, value.size()) != value) {
+            break;
+        }
+        uint32_t id = cursor.id();
+        if (id >= low && id <= high) {
+            rowsExamined++;
+            uint32_t rowNum = static_cast<uint32_t>(coveredRows.size() / ROW_SIZE_BYTES);
+            if (!covering || coverEntry(id, key, cursor.payload())) {
+                matches.emplace_back(id, rowNum);
+            }
+        }
+        // the cursor re-reads its page on every call, so it survives eviction
+        if (++visited % 4096 == 0) {
+            table.getPager().evictToCapacity();
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+}
+
+bool IndexScan::next(Batch& batch) {
+    table.getPager().evictToCapacity();
+    if (!started) {
+        started = true;
+        if (low <= high) {
+            collectMatches();
+        }
+    }
+
+    batch.setColumnCount(NUM_TABLE_COLUMNS);
+    ColumnVector& idColumn = batch.columns[COLUMN_ID];
+    idColumn.setType(false);
+    uint32_t rows = 0;
+    while (rows < BATCH_SIZE && position < matches.size()) {
+        uint32_t id = matches[position].first;
+        const char* cell;
+        if (covering) {
+            cell = coveredRows.data() + static_cast<size_t>(matches[position].second) * ROW_SIZE_BYTES;
+            position++;
+        } else {
+            position++;
+            Cursor cursor(table, id);
+            Node leaf(table.getPageAddress(cursor.getPageNum()));
+            uint32_t cellNum = cursor.getCellNum();
+            if (cellNum >= *leaf.leafNodeNumCells() || *leaf.leafNodeKey(cellNum) != id) {
+                throw ExecutionError("index entry for id " + std::to_string(id) + " has no row");
+            }
+            tableLookups++;
+            uint32_t selection[1] = {cellNum};
+            uint32_t count = 1;
+            const uint8_t* cells = static_cast<const uint8_t*>(leaf.leafNodeValue(0));
+            for (const FieldFilter& filter : filters) {
+                count = applyFieldFilter(filter, cells, LEAF_NODE_CELL_SIZE, selection, count);
+            }
+            if (count == 0) {
+                continue;
+            }
+            cell = static_cast<const char*>(leaf.leafNodeValue(cellNum));
+        }
+        if (batch.textStorage.size() < (rows + 1) * TEXT_BYTES_PER_ROW) {
+            batch.textStorage.resize(std::max<size_t>((rows + 1) * TEXT_BYTES_PER_ROW, batch.textStorage.size() * 2));
+        }
+        std::memcpy(batch.textStorage.data() + rows * TEXT_BYTES_PER_ROW, cell + Row::getUsernameOffset(),
+                    TEXT_BYTES_PER_ROW);
+        idColumn.integers[rows] = id;
+        rows++;
+    }
+
+    setTextColumns(batch, rows);
+    batch.selectAll(rows);
+    return rows > 0;
+}
+
+ColumnStoreScan::ColumnStoreScan(const ColumnStore& store, int64_t low, int64_t high)
+    : store(store), nextId(std::max<int64_t>(low, 0)), high(std::min<int64_t>(high, UINT32_MAX)), done(false),
+      rowsExamined(0), segmentsSkipped(0), lastSkipped(nullptr) {}
+
+void ColumnStoreScan::pushFilter(FieldFilter filter) {
+    uint32_t column = filter.fieldOffset == Row::getUsernameOffset() ? COLUMN_USERNAME : COLUMN_EMAIL;
+    filters.emplace_back(column, std::move(filter));
+}
+
+bool ColumnStoreScan::mayMatch(const ColumnStore::Segment& segment) const {
+    for (const auto& entry : filters) {
+        const ColumnStore::TextColumn& column = segment.columns[entry.first];
+        if (!textRangeMayMatch(entry.second, column.min, column.max)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColumnStoreScan::deltaMatches(const ColumnStore::DeltaRow& values) const {
+    for (const auto& entry : filters) {
+        const std::string& text = values.values[entry.first];
+        uint32_t end = static_cast<uint32_t>(text.size());
+        uint32_t row = 0;
+        if (applyTextFilter(entry.second, text.data(), &end, &row, 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ColumnStoreScan::copyText(Batch& batch, uint32_t column, std::string_view text) {
+    if (store.projects(column)) {
+        batch.textStorage.insert(batch.textStorage.end(), text.begin(), text.end());
+    }
+    textEnds.push_back(static_cast<uint32_t>(batch.textStorage.size()));
+}
+
+bool ColumnStoreScan::next(Batch& batch) {
+    if (done) {
+        return false;
+    }
+    batch.setColumnCount(NUM_TABLE_COLUMNS);
+    ColumnVector& ids = batch.columns[COLUMN_ID];
+    ids.setType(false);
+    batch.textStorage.clear();
+    textEnds.clear();
+    const std::vector<ColumnStore::Segment>& segments = store.getSegments();
+    const std::map<uint32_t, ColumnStore::DeltaRow>& delta = store.getDelta();
+
+    uint32_t rows = 0;
+    while (rows < BATCH_SIZE) {
+        if (nextId > high) {
+            done = true;
+            break;
+        }
+        // found again every time round, so nothing here outlives a change to the store
+        uint32_t from = static_cast<uint32_t>(nextId);
+        auto pending = delta.lower_bound(from);
+        int64_t deltaId = pending == delta.end() ? INT64_MAX : pending->first;
+        auto segment = std::lower_bound(segments.begin(), segments.end(), from,
+                                        [](const ColumnStore::Segment& s, uint32_t id) { return s.ids.back() < id; });
+        uint32_t position = 0;
+        int64_t segmentId = INT64_MAX;
+        if (segment != segments.end()) {
+            position = static_cast<uint32_t>(std::lower_bound(segment->ids.begin(), segment->ids.end(), from) -
+                                             segment->ids.begin());
+            segmentId = segment->ids[position];
+        }
+
+        // an updated row is in both, deleted from its segment
+        if (deltaId <= segmentId) {
+            if (deltaId > high) {
+                done = true;
+                break;
+            }
+            rowsExamined++;
+            if (deltaMatches(pending->second)) {
+                ids.integers[rows] = pending->first;
+                copyText(batch, COLUMN_USERNAME, pending->second.values[COLUMN_USERNAME]);
+                copyText(batch, COLUMN_EMAIL, pending->second.values[COLUMN_EMAIL]);
+                rows++;
+            }
+            nextId = deltaId + 1;
+            continue;
+        }
+        if (segmentId > high) {
+            done = true;
+            break;
+        }
+
+        // the segment's rows up to the next delta row, past high or filling the batch
+        int64_t stop = std::min(high + 1, deltaId);
+        if (!mayMatch(*segment)) {
+            if (&*segment != lastSkipped) {
+                segmentsSkipped++;
+                lastSkipped = &*segment;
+            }
+            nextId = std::min<int64_t>(stop, static_cast<int64_t>(segment->ids.back()) + 1);
+            continue;
+        }
+        uint32_t end = static_cast<uint32_t>(
+            std::lower_bound(segment->ids.begin() + position, segment->ids.end(), stop,
+                             [](uint32_t id, int64_t bound) { return id < bound; }) -
+            segment->ids.begin());
+        end = std::min(end, position + (BATCH_SIZE - rows));
+        selection.clear();
+        for (uint32_t i = position; i < end; i++) {
+            if (!segment->deleted[i]) {
+                selection.push_back(i);
+            }
+        }
+        uint32_t count = static_cast<uint32_t>(selection.size());
+        rowsExamined += count;
+        for (const auto& entry : filters) {
+            const ColumnStore::TextColumn& column = segment->columns[entry.first];
+            count = applyTextFilter(entry.second, column.bytes.data(), column.ends.data(), selection.data(), count);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t row = selection[i];
+            ids.integers[rows] = segment->ids[row];
+            for (uint32_t column : {COLUMN_USERNAME, COLUMN_EMAIL}) {
+                copyText(batch, column,
+                         store.projects(column) ? segment->columns[column].value(row) : std::string_view());
+            }
+            rows++;
+        }
+        nextId = static_cast<int64_t>(segment->ids[end - 1]) + 1;
+    }
+
+    // storage may have moved while growing, so views are taken once it is final
+    ColumnVector& usernames = batch.columns[COLUMN_USERNAME];
+    ColumnVector& emails = batch.columns[COLUMN_EMAIL];
+    usernames.setType(true, rows);
+    emails.setType(true, rows);
+    for (uint32_t row = 0; row < rows; row++) {
+        uint32_t begin = row == 0 ? 0 : textEnds[2 * row - 1];
+        uint32_t middle = textEnds[2 * row];
+        usernames.texts[row] = std::string_view(batch.textStorage.data() + begin, middle - begin);
+        emails.texts[row] = std::string_view(batch.textStorage.data() + middle, textEnds[2 * row + 1] - middle);
+    }
+    batch.selectAll(rows);
+    return rows > 0;
+}
+
+SchemaTableScan::SchemaTableScan(const SchemaTable& table)
+    : table(table), keyed(false), wholeKey(false), done(false) {}
+
+SchemaTableScan::SchemaTableScan(const SchemaTable& table, std::string key, bool wholeKey)
+    : table(table), key(std::move(key)), keyed(true), wholeKey(wholeKey), done(false) {}
+
+bool SchemaTableScan::next(Batch& batch) {
+    // between batches no page pointer is live, so this is a safe point to evict
+    table.getTable().getPager().evictToCapacity();
+    if (!cursor) {
+        cursor = std::make_unique<IndexCursor>(table.getTree(), key);
+    }
+
+    // copy the encoded rows out of the pages first: the cursor fetches pages per
+    // call, so nothing points into the cache once the batch is built
+    rowEnds.clear();
+    size_t used = 0;
+    while (!done && rowEnds.size() < BATCH_SIZE && !cursor->isEnd()) {
+        if (keyed) {
+            std::string_view found = cursor->key();
+            if (wholeKey ? found != key : found.substr(0, key.size()) != key) {
+                done = true;
+                break;
+            }
+        }
+        std::string_view payload = cursor->payload();
+        if (batch.textStorage.size() < used + payload.size()) {
+            batch.textStorage.resize(std::max(used + payload.size(), batch.textStorage.size() * 2));
+        }
+        std::memcpy(batch.textStorage.data() + used, payload.data(), payload.size());
+        used += payload.size();
+        rowEnds.push_back(static_cast<uint32_t>(used));
+        done = wholeKey;
+        cursor->advance();
+    }
+    uint32_t rows = static_cast<uint32_t>(rowEnds.size());
+    if (rows == 0) {
+        done = true;
+        return false;
+    }
+
+    const RowCodec& codec = table.getCodec();
+    const std::vector<ColumnSchema>& columns = table.getSchema().getColumns();
+    auto rowAt = [&](uint32_t row) {
+        uint32_t start = row == 0 ? 0 : rowEnds[row - 1];
+        return std::string_view(batch.textStorage.data() + start, rowEnds[row] - start);
+    };
+    // DOUBLE values are formatted behind the rows
+    realText.clear();
+    for (uint32_t column = 0; column < columns.size(); column++) {
+        if (columns[column].type != ColumnType::DOUBLE) {
+            continue;
+        }
+        for (uint32_t row = 0; row < rows; row++) {
+            if (batch.textStorage.size() < used + REAL_TEXT_MAX_SIZE) {
+                batch.textStorage.resize(std::max<size_t>(used + REAL_TEXT_MAX_SIZE, batch.textStorage.size() * 2));
+            }
+            double value = codec.realAt(rowAt(row), column);
+            int length = formatReal(value, batch.textStorage.data() + used, REAL_TEXT_MAX_SIZE);
+            realText.emplace_back(static_cast<uint32_t>(used), static_cast<uint32_t>(length));
+            used += static_cast<size_t>(length);
+        }
+    }
+
+    // storage may have moved while growing, so views are taken once it is final
+    batch.setColumnCount(static_cast<uint32_t>(columns.size()));
+    size_t real = 0;
+    for (uint32_t column = 0; column < columns.size(); column++) {
+        ColumnVector& out = batch.columns[column];
+        switch (columns[column].type) {
+            case ColumnType::INT:
+            case ColumnType::BIGINT:
+                out.setType(false, rows);
+                for (uint32_t row = 0; row < rows; row++) {
+                    out.integers[row] = codec.integerAt(rowAt(row), column);
+                }
+                break;
+            case ColumnType::DOUBLE:
+                out.setType(true, rows);
+                for (uint32_t row = 0; row < rows; row++, real++) {
+                    out.texts[row] = std::string_view(batch.textStorage.data() + realText[real].first,
+                                                      realText[real].second);
+                }
+                break;
+            default:
+                out.setType(true, rows);
+                for (uint32_t row = 0; row < rows; row++) {
+                    out.texts[row] = codec.bytesAt(rowAt(row), column);
+                }
+        }
+    }
+    batch.selectAll(rows);
+    return true;
+}
+
+FilterOperator::FilterOperator(std::unique_ptr<BatchOperator> child, std::vector<const Expr*> predicates,
+                               VectorEvaluator& evaluator)
+    : child(std::move(child)), predicates(std::move(predicates)), evaluator(evaluator) {}
+
+bool FilterOperator::next(Batch& batch) {
+    while (child->next(batch)) {
+        for (const Expr* predicate : predicates) {
+            batch.selectedCount = evaluator.filter(*predicate, batch, batch.selection.data(), batch.selectedCount);
+        }
+        if (batch.selectedCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ProjectOperator::ProjectOperator(std::unique_ptr<BatchOperator> child, std::vector<const Expr*> expressions,
+                                 VectorEvaluator& evaluator, Batch& input)
+    : child(std::move(child)), expressions(std::move(expressions)), evaluator(evaluator), input(input) {}
+
+bool ProjectOperator::next(Batch& batch) {
+    if (!child->next(input)) {
+        return false;
+    }
+    batch.setColumnCount(static_cast<uint32_t>(expressions.size()));
+    for (size_t i = 0; i < expressions.size(); i++) {
+        evaluator.evaluate(*expressions[i], input, input.selection.data(), input.selectedCount, batch.columns[i]);
+    }
+    if (batch.selection.size() < input.selectedCount) {
+        batch.selection.resize(input.selectedCount);
+    }
+    std::copy(input.selection.begin(), input.selection.begin() + input.selectedCount, batch.selection.begin());
+    batch.size = input.size;
+    batch.selectedCount = input.selectedCount;
+    return true;
+}
+
+SortOperator::SortOperator(std::unique_ptr<BatchOperator> child, std::vector<SortKey> keys, uint64_t limit,
+                           size_t memoryBudget)
+    : child(std::move(child)), keys(std::move(keys)), sorted(false), sorter(memoryBudget, limit) {}
+
+// Payload layout per column: an integer as 8 bytes, text as a 4-byte length and its bytes
+void SortOperator::collect() {
+    Batch input;
+    try {
+        while (child->next(input)) {
+            if (textColumns.empty()) {
+                for (const ColumnVector& column : input.columns) {
+                    textColumns.push_back(column.isText);
+                }
+            }
+            for (uint32_t i = 0; i < input.selectedCount; i++) {
+                uint32_t row = input.selection[i];
+                key.clear();
+                for (const SortKey& sortKey : keys) {
+                    const ColumnVector& column = input.columns[sortKey.column];
+                    column.isText ? appendSortKey(key, column.texts[row], sortKey.descending)
+                                  : appendSortKey(key, column.integers[row], sortKey.descending);
+                }
+                payload.clear();
+                for (size_t c = 0; c < textColumns.size(); c++) {
+                    const ColumnVector& column = input.columns[c];
+                    if (textColumns[c]) {
+                        uint32_t length = static_cast<uint32_t>(column.texts[row].size());
+                        payload.append(reinterpret_cast<const char*>(&length), sizeof(length));
+                        payload.append(column.texts[row]);
+                    } else {
+                        payload.append(reinterpret_cast<const char*>(&column.integers[row]), sizeof(int64_t));
+                    }
+                }
+                sorter.add(key, payload);
+            }
+        }
+        sorter.finish();
+    } catch (const ExecutionError&) {
+        throw;
+    } catch (const std::runtime_error& e) {
+        // spill file trouble fails the statement like any other execution error
+        throw ExecutionError(e.what());
+    }
+}
+
+bool SortOperator::next(Batch& batch) {
+    if (!sorted) {
+        collect();
+        sorted = true;
+    }
+    batchText.reset();
+    batch.setColumnCount(static_cast<uint32_t>(textColumns.size()));
+    for (size_t c = 0; c < textColumns.size(); c++) {
+        batch.columns[c].setType(textColumns[c]);
+    }
+    uint32_t count = 0;
+    std::string_view sortKey;
+    std::string_view record;
+    try {
+        while (count < BATCH_SIZE && sorter.next(sortKey, record)) {
+            const char* field = record.data();
+            for (size_t c = 0; c < textColumns.size(); c++) {
+                ColumnVector& column = batch.columns[c];
+                if (textColumns[c]) {
+                    uint32_t length;
+                    std::memcpy(&length, field, sizeof(length));
+                    column.texts[count] = batchText.copyString(std::string_view(field + sizeof(length), length));
+                    field += sizeof(length) + length;
+                } else {
+                    std::memcpy(&column.integers[count], field, sizeof(int64_t));
+                    field += sizeof(int64_t);
+                }
+            }
+            count++;
+        }
+    } catch (const std::runtime_error& e) {
+        throw ExecutionError(e.what());
+    }
+    if (count == 0) {
+        return false;
+    }
+    batch.selectAll(count);
+    return true;
+}
+
+LimitOperator::LimitOperator(std::unique_ptr<BatchOperator> child, int64_t offset, int64_t limit)
+    : child(std::move(child)), toSkip(offset), remaining(limit) {}
+
+bool LimitOperator::next(Batch& batch) {
+    while (remaining > 0 && child->next(batch)) {
+        uint32_t skip = static_cast<uint32_t>(std::min<int64_t>(toSkip, batch.selectedCount));
+        toSkip -= skip;
+        uint32_t keep = static_cast<uint32_t>(std::min<int64_t>(remaining, batch.selectedCount - skip));
+        if (keep == 0) {
+            continue;
+        }
+        if (skip > 0) {
+            std::copy(batch.selection.begin() + skip, batch.selection.begin() + skip + keep, batch.selection.begin());
+        }
+        batch.selectedCount = keep;
+        remaining -= keep;
+        return true;
+    }
+    return false;
+}
+
+AggregateOperator::AggregateOperator(std::unique_ptr<BatchOperator> child, std::vector<AggregateSpec> specs)
+    : AggregateOperator(std::move(child), {}, std::move(specs)) {}
+
+AggregateOperator::AggregateOperator(std::unique_ptr<BatchOperator> child, std::vector<uint32_t> groupColumns,
+                                     std::vector<AggregateSpec> specs)
+    : child(std::move(child)), groupColumns(std::move(groupColumns)), specs(std::move(specs)), folded(false),
+      position(0), textResult(this->specs.size(), false) {}
+
+// Group of input row, creating it on first sight. key is scratch space for the
+// encoded group values: integers as raw bytes, text length-prefixed.
+uint32_t AggregateOperator::findGroup(const Batch& input, uint32_t row, std::string& key) {
+    key.clear();
+    for (uint32_t column : groupColumns) {
+        const ColumnVector& values = input.columns[column];
+        if (values.isText) {
+            std::string_view text = values.texts[row];
+            uint32_t length = static_cast<uint32_t>(text.size());
+            key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            key.append(text.data(), text.size());
+        } else {
+            key.append(reinterpret_cast<const char*>(&values.integers[row]), sizeof(int64_t));
+        }
+    }
+    auto found = groupIndex.find(key);
+    if (found != groupIndex.end()) {
+        return found->second;
+    }
+    for (uint32_t column : groupColumns) {
+        addGroupValue(input.columns[column].get(row));
+    }
+    return addGroup(key);
+}
+
+void AggregateOperator::addGroupValue(Value value) {
+    if (value.isText) {
+        value.text = groupText.copyString(value.text);
+    }
+    groupValues.push_back(value);
+}
+
+// New group under key, once its group column values are in groupValues
+uint32_t AggregateOperator::addGroup(const std::string& key) {
+    uint32_t group = static_cast<uint32_t>(groupRows.size());
+    groupIndex.emplace(key, group);
+    groupRows.push_back(0);
+    integers.resize(integers.size() + specs.size(), 0);
+    texts.resize(texts.size() + specs.size());
+    return group;
+}
+
+void AggregateOperator::fold() {
+    size_t numSpecs = specs.size();
+    std::string key;
+    Batch input;
+    while (child->next(input)) {
+        const uint32_t* selection = input.selection.data();
+        uint32_t count = input.selectedCount;
+        for (size_t s = 0; s < numSpecs; s++) {
+            const AggregateSpec& spec = specs[s];
+            if (spec.function == AggregateFunction::SUM) {
+                requireIntegers(input.columns[spec.column], count, "SUM");
+            } else if (spec.function != AggregateFunction::COUNT) {
+                textResult[s] = input.columns[spec.column].isText;
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t row = selection[i];
+            uint32_t group = groupColumns.empty() && !groupRows.empty() ? 0 : findGroup(input, row, key);
+            bool first = groupRows[group]++ == 0;
+            int64_t* groupIntegers = integers.data() + group * numSpecs;
+            std::string* groupTexts = texts.data() + group * numSpecs;
+            for (size_t s = 0; s < numSpecs; s++) {
+                const AggregateSpec& spec = specs[s];
+                if (spec.function == AggregateFunction::COUNT) {
+                    continue;
+                }
+                const ColumnVector& column = input.columns[spec.column];
+                if (spec.function == AggregateFunction::SUM) {
+                    groupIntegers[s] += column.integers[row];
+                    continue;
+                }
+                bool wantMax = spec.function == AggregateFunction::MAX;
+                if (column.isText) {
+                    std::string_view candidate = column.texts[row];
+                    if (first || (wantMax ? candidate > groupTexts[s] : candidate < groupTexts[s])) {
+                        groupTexts[s].assign(candidate.data(), candidate.size());
+                    }
+                } else {
+                    int64_t candidate = column.integers[row];
+                    if (first || (wantMax ? candidate > groupIntegers[s] : candidate < groupIntegers[s])) {
+                        groupIntegers[s] = candidate;
+                    }
+                }
+            }
+        }
+    }
+
+    // an ungrouped aggregate over no rows still has its one (all-zero) group,
+    // unless MIN/MAX would need a value from it
+    if (groupColumns.empty() && groupRows.empty()) {
+        for (const AggregateSpec& spec : specs) {
+            if (spec.function == AggregateFunction::MIN || spec.function == AggregateFunction::MAX) {
+                return;
+            }
+        }
+        groupRows.push_back(0);
+        integers.assign(numSpecs, 0);
+        texts.resize(numSpecs);
+    }
+}
+
+void AggregateOperator::foldInput() {
+    if (!folded) {
+        fold();
+        folded = true;
+        child.reset();
+    }
+}
+
+void AggregateOperator::merge(AggregateOperator& other) {
+    foldInput();
+    other.foldInput();
+    size_t numSpecs = specs.size();
+    size_t numGroupColumns = groupColumns.size();
+    for (size_t s = 0; s < numSpecs; s++) {
+        textResult[s] = textResult[s] || other.textResult[s];
+    }
+    std::string key;
+    for (uint32_t from = 0; from < other.groupRows.size(); from++) {
+        const Value* values = other.groupValues.data() + from * numGroupColumns;
+        uint32_t group = 0;
+        if (numGroupColumns > 0 || groupRows.empty()) {
+            // the same encoding as findGroup
+            key.clear();
+            for (size_t c = 0; c < numGroupColumns; c++) {
+                if (values[c].isText) {
+                    uint32_t length = static_cast<uint32_t>(values[c].text.size());
+                    key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+                    key.append(values[c].text.data(), values[c].text.size());
+                } else {
+                    key.append(reinterpret_cast<const char*>(&values[c].integer), sizeof(int64_t));
+                }
+            }
+            auto found = groupIndex.find(key);
+            if (found != groupIndex.end()) {
+                group = found->second;
+            } else {
+                for (size_t c = 0; c < numGroupColumns; c++) {
+                    addGroupValue(values[c]);
+                }
+                group = addGroup(key);
+            }
+        }
+        bool first = groupRows[group] == 0;
+        groupRows[group] += other.groupRows[from];
+        int64_t* groupIntegers = integers.data() + group * numSpecs;
+        std::string* groupTexts = texts.data() + group * numSpecs;
+        const int64_t* fromIntegers = other.integers.data() + from * numSpecs;
+        const std::string* fromTexts = other.texts.data() + from * numSpecs;
+        for (size_t s = 0; s < numSpecs; s++) {
+            const AggregateSpec& spec = specs[s];
+            if (spec.function == AggregateFunction::COUNT) {
+                continue;
+            }
+            if (spec.function == AggregateFunction::SUM) {
+                groupIntegers[s] += fromIntegers[s];
+                continue;
+            }
+            bool wantMax = spec.function == AggregateFunction::MAX;
+            if (textResult[s]) {
+                if (first || (wantMax ? fromTexts[s] > groupTexts[s] : fromTexts[s] < groupTexts[s])) {
+                    groupTexts[s] = fromTexts[s];
+                }
+            } else if (first || (wantMax ? fromIntegers[s] > groupIntegers[s] : fromIntegers[s] < groupIntegers[s])) {
+                groupIntegers[s] = fromIntegers[s];
+            }
+        }
+    }
+}
+
+bool AggregateOperator::next(Batch& batch) {
+    foldInput();
+    uint32_t numGroups = static_cast<uint32_t>(groupRows.size());
+    if (position >= numGroups) {
+        return false;
+    }
+    uint32_t count = std::min(BATCH_SIZE, numGroups - position);
+    size_t numGroupColumns = groupColumns.size();
+    size_t numSpecs = specs.size();
+    batch.setColumnCount(static_cast<uint32_t>(numGroupColumns + numSpecs));
+    for (size_t c = 0; c < numGroupColumns; c++) {
+        ColumnVector& column = batch.columns[c];
+        column.setType(groupValues[position * numGroupColumns + c].isText, count);
+        for (uint32_t i = 0; i < count; i++) {
+            const Value& value = groupValues[(position + i) * numGroupColumns + c];
+            if (column.isText) {
+                column.texts[i] = value.text;
+            } else {
+                column.integers[i] = value.integer;
+            }
+        }
+    }
+    for (size_t s = 0; s < numSpecs; s++) {
+        ColumnVector& column = batch.columns[numGroupColumns + s];
+        column.setType(textResult[s], count);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t group = position + i;
+            if (textResult[s]) {
+                column.texts[i] = texts[group * numSpecs + s];
+            } else if (specs[s].function == AggregateFunction::COUNT) {
+                column.integers[i] = static_cast<int64_t>(groupRows[group]);
+            } else {
+                column.integers[i] = integers[group * numSpecs + s];
+            }
+        }
+    }
+    position += count;
+    batch.selectAll(count);
+    return true;
+}
+
+SingleRowOperator::SingleRowOperator(std::vector<Value> values) : values(std::move(values)), done(false) {}
+
+bool SingleRowOperator::next(Batch& batch) {
+    if (done || values.empty()) {
+        return false;
+    }
+    done = true;
+    batch.setColumnCount(static_cast<uint32_t>(values.size()));
+    for (size_t c = 0; c < values.size(); c++) {
+        ColumnVector& column = batch.columns[c];
+        column.setType(values[c].isText, 1);
+        if (values[c].isText) {
+            column.texts[0] = values[c].text;
+        } else {
+            column.integers[0] = values[c].integer;
+        }
+    }
+    batch.selectAll(1);
+    return true;
+}
@@ -0,0 +1,191 @@
+#include "zone_map.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "node.hpp"
+#include "row.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    // An entry is (min, max) of the username prefixes, then of the email prefixes
+    constexpr uint64_t FULL_ZONE[4] = {0, UINT64_MAX, 0, UINT64_MAX};
+    constexpr uint64_t EMPTY_ZONE[4] = {UINT64_MAX, 0, UINT64_MAX, 0};
+
+    uint32_t* field(uint8_t* page, uint32_t offset) {
+        return reinterpret_cast<uint32_t*>(page + offset);
+    }
+
+    uint32_t read(const uint8_t* page, uint32_t offset) {
+        return *reinterpret_cast<const uint32_t*>(page + offset);
+    }
+
+    uint32_t entryOffset(uint32_t pageNum) {
+        return COMMON_NODE_HEADER_SIZE + (pageNum % ZONE_PAGE_MAX_LEAVES) * ZONE_ENTRY_SIZE;
+    }
+
+    void initializePage(uint8_t* page, NodeType type) {
+        std::memset(page, 0, PAGE_SIZE);
+        page[NODE_TYPE_OFFSET] = static_cast<uint8_t>(type);
+    }
+
+    // The first ZONE_PREFIX_SIZE bytes of text, zero-padded, as a big-endian number
+    uint64_t prefixOf(const char* text, size_t length) {
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < ZONE_PREFIX_SIZE; i++) {
+            prefix = (prefix << 8) | (i < length ? static_cast<uint8_t>(text[i]) : 0);
+        }
+        return prefix;
+    }
+
+    // Prefixes of a serialized row's username and email, whose fields are
+    // zero-padded and longer than a prefix
+    void prefixesOf(const uint8_t* cell, uint64_t (&prefixes)[2]) {
+        prefixes[0] = prefixOf(reinterpret_cast<const char*>(cell + Row::getUsernameOffset()), ZONE_PREFIX_SIZE);
+        prefixes[1] = prefixOf(reinterpret_cast<const char*>(cell + Row::getEmailOffset()), ZONE_PREFIX_SIZE);
+    }
+}
+
+ZoneMap::ZoneMap(Table& table, uint32_t headerPageNum) : table(table), headerPageNum(headerPageNum) {
+    uint32_t slots = read(table.getPageAddress(headerPageNum), ZONE_SLOTS_OFFSET);
+    zonePages.reserve(slots);
+    for (uint32_t pageNum = headerPageNum; pageNum != 0;) {
+        const uint8_t* directory = table.getPageAddress(pageNum);
+        directoryPages.push_back(pageNum);
+        for (uint32_t i = 0; i < ZONE_DIRECTORY_MAX_SLOTS && zonePages.size() < slots; i++) {
+            zonePages.push_back(read(directory, ZONE_DIRECTORY_HEADER_SIZE + i * sizeof(uint32_t)));
+        }
+        pageNum = read(directory, ZONE_NEXT_DIRECTORY_OFFSET);
+    }
+}
+
+void ZoneMap::initialize(Table& table, uint32_t pageNum) {
+    initializePage(table.getPageForWrite(pageNum), NodeType::NODE_ZONE_DIRECTORY);
+}
+
+uint32_t ZoneMap::getZonePageCount() const {
+    return static_cast<uint32_t>(std::count_if(zonePages.begin(), zonePages.end(), [](uint32_t p) { return p != 0; }));
+}
+
+uint32_t ZoneMap::zonePageFor(uint32_t pageNum) {
+    uint32_t slot = pageNum / ZONE_PAGE_MAX_LEAVES;
+    if (slot >= zonePages.size()) {
+        // the new slots are zero, so only directory pages need adding
+        while (slot / ZONE_DIRECTORY_MAX_SLOTS >= directoryPages.size()) {
+            uint32_t directoryPageNum = table.getUnusedPageNum();
+            initializePage(table.getPageForWrite(directoryPageNum), NodeType::NODE_ZONE_DIRECTORY);
+            *field(table.getPageForWrite(directoryPages.back()), ZONE_NEXT_DIRECTORY_OFFSET) = directoryPageNum;
+            directoryPages.push_back(directoryPageNum);
+        }
+        zonePages.resize(slot + 1, 0);
+        *field(table.getPageForWrite(headerPageNum), ZONE_SLOTS_OFFSET) = slot + 1;
+    }
+    if (zonePages[slot] == 0) {
+        uint32_t zonePageNum = table.getUnusedPageNum();
+        uint8_t* page = table.getPageForWrite(zonePageNum);
+        initializePage(page, NodeType::NODE_ZONE_PAGE);
+        for (uint32_t i = 0; i < ZONE_PAGE_MAX_LEAVES; i++) {
+            std::memcpy(page + COMMON_NODE_HEADER_SIZE + i * ZONE_ENTRY_SIZE, FULL_ZONE, ZONE_ENTRY_SIZE);
+        }
+        uint8_t* directory = table.getPageForWrite(directoryPages[slot / ZONE_DIRECTORY_MAX_SLOTS]);
+        *field(directory, ZONE_DIRECTORY_HEADER_SIZE + (slot % ZONE_DIRECTORY_MAX_SLOTS) * sizeof(uint32_t)) =
+            zonePageNum;
+        zonePages[slot] = zonePageNum;
+    }
+    return zonePages[slot];
+}
+
+// Only journals the zone page when the entry actually changes
+void ZoneMap::writeEntry(uint32_t pageNum, const uint64_t (&entry)[4]) {
+    uint32_t zonePageNum = zonePageFor(pageNum);
+    if (std::memcmp(table.getPageAddress(zonePageNum) + entryOffset(pageNum), entry, ZONE_ENTRY_SIZE) != 0) {
+        std::memcpy(table.getPageForWrite(zonePageNum) + entryOffset(pageNum), entry, ZONE_ENTRY_SIZE);
+    }
+}
+
+void ZoneMap::widen(uint32_t pageNum, const uint8_t* cell) {
+    uint32_t slot = pageNum / ZONE_PAGE_MAX_LEAVES;
+    if (slot >= zonePages.size() || zonePages[slot] == 0) {
+        return;  // the full range takes in anything
+    }
+    uint64_t entry[4];
+    std::memcpy(entry, table.getPageAddress(zonePages[slot]) + entryOffset(pageNum), ZONE_ENTRY_SIZE);
+    uint64_t prefixes[2];
+    prefixesOf(cell, prefixes);
+    for (uint32_t c = 0; c < 2; c++) {
+        entry[2 * c] = std::min(entry[2 * c], prefixes[c]);
+        entry[2 * c + 1] = std::max(entry[2 * c + 1], prefixes[c]);
+    }
+    writeEntry(pageNum, entry);
+}
+
+void ZoneMap::recompute(uint32_t pageNum) {
+    Node leaf(table.getPageAddress(pageNum));
+    if (leaf.getNodeType() != NodeType::NODE_LEAF) {
+        return;
+    }
+    uint64_t entry[4];
+    std::memcpy(entry, EMPTY_ZONE, ZONE_ENTRY_SIZE);
+    uint32_t numCells = *leaf.leafNodeNumCells();
+    for (uint32_t i = 0; i < numCells; i++) {
+        uint64_t prefixes[2];
+        prefixesOf(static_cast<const uint8_t*>(leaf.leafNodeValue(i)), prefixes);
+        for (uint32_t c = 0; c < 2; c++) {
+            entry[2 * c] = std::min(entry[2 * c], prefixes[c]);
+            entry[2 * c + 1] = std::max(entry[2 * c + 1], prefixes[c]);
+        }
+    }
+    writeEntry(pageNum, entry);
+}
+
+bool ZoneMap::mayMatch(uint32_t pageNum, const std::vector<ZoneRange>& ranges) const {
+    uint32_t slot = pageNum / ZONE_PAGE_MAX_LEAVES;
+    if (slot >= zonePages.size() || zonePages[slot] == 0) {
+        return true;
+    }
+    uint64_t entry[4];
+    std::memcpy(entry, table.getPageAddress(zonePages[slot]) + entryOffset(pageNum), ZONE_ENTRY_SIZE);
+    for (const ZoneRange& range : ranges) {
+        uint32_t c = range.column == COLUMN_USERNAME ? 0 : 1;
+        if (entry[2 * c + 1] < range.low || entry[2 * c] > range.high) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ZoneMap::rangeOf(const FieldFilter& filter, ZoneRange& range) {
+    if (filter.fieldOffset == Row::getUsernameOffset()) {
+        range.column = COLUMN_USERNAME;
+    } else if (filter.fieldOffset == Row::getEmailOffset()) {
+        range.column = COLUMN_EMAIL;
+    } else {
+        return false;
+    }
+    // the pattern is zero-padded past the field's size, so a prefix of it is too
+    uint64_t prefix = prefixOf(filter.pattern.data(), filter.patternLength);
+    switch (filter.match) {
+        case FieldMatch::EQUALS:
+            range.low = prefix;
+            range.high = prefix;
+            return true;
+        case FieldMatch::PREFIX:
+            // a short pattern fixes only the leading bytes; any may follow
+            range.low = prefix;
+            range.high = filter.patternLength >= ZONE_PREFIX_SIZE ? prefix
+                                                                   : prefix | (UINT64_MAX >> (8 * filter.patternLength));
+            return true;
+        default:
+            return false;
+    }
+}
+
+// text < b implies prefix(text) <= prefix(b), and likewise for >
+ZoneRange ZoneMap::rangeUpTo(uint32_t column, std::string_view text) {
+    return ZoneRange{column, 0, prefixOf(text.data(), text.size())};
+}
+
+ZoneRange ZoneMap::rangeFrom(uint32_t column, std::string_view text) {
+    return ZoneRange{column, prefixOf(text.data(), text.size()), UINT64_MAX};
+}
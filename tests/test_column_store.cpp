@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "column_store.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+class ColumnStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("column_test.db");
+        table = std::make_unique<Table>("column_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("column_test.db");
+    }
+
+    static std::string nameOf(uint32_t id) { return "user" + std::to_string(id % 1000); }
+
+    // (id, username, email) of every row a scan returns, in order
+    static std::vector<std::tuple<int64_t, std::string, std::string>> drain(BatchOperator& scan) {
+        std::vector<std::tuple<int64_t, std::string, std::string>> rows;
+        Batch batch;
+        while (scan.next(batch)) {
+            for (uint32_t s = 0; s < batch.selectedCount; s++) {
+                uint32_t row = batch.selection[s];
+                rows.emplace_back(batch.columns[COLUMN_ID].integers[row],
+                                  std::string(batch.columns[COLUMN_USERNAME].texts[row]),
+                                  std::string(batch.columns[COLUMN_EMAIL].texts[row]));
+            }
+        }
+        return rows;
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(ColumnStoreTest, FollowsInsertsUpdatesAndDeletesThroughFolds) {
+    std::vector<uint32_t> ids(3 * COLUMN_SEGMENT_ROWS);
+    std::iota(ids.begin(), ids.end(), 1);
+    for (uint32_t id : ids) {
+        table->insertRow(Row(id * 2, nameOf(id), "e" + std::to_string(id)));
+    }
+    EXPECT_THROW(table->createColumnStore(1u << COLUMN_ID), std::invalid_argument);
+    table->createColumnStore(1u << COLUMN_USERNAME);
+    EXPECT_THROW(table->createColumnStore(1u << COLUMN_USERNAME), std::invalid_argument);
+    const ColumnStore& store = *table->getColumnStore();
+    EXPECT_EQ(store.getSegments().size(), 3u);
+    EXPECT_EQ(store.getNumRows(), ids.size());
+
+    // odd ids between the segments' rows, in random order, then changes to both kinds
+    std::map<uint32_t, std::string> expected;
+    for (uint32_t id : ids) {
+        expected[id * 2] = nameOf(id);
+    }
+    std::mt19937 generator(3);
+    std::shuffle(ids.begin(), ids.end(), generator);
+    for (uint32_t i = 0; i < 2500; i++) {
+        uint32_t id = ids[i] * 2 + 1;
+        table->insertRow(Row(id, "odd" + std::to_string(id), "o"));
+        expected[id] = "odd" + std::to_string(id);
+    }
+    for (uint32_t i = 0; i < 1500; i++) {
+        uint32_t id = ids[i] * 2 + (i % 2);
+        table->updateRow(Row(id, "new" + std::to_string(id), "n"));
+        expected[id] = "new" + std::to_string(id);
+    }
+    for (uint32_t i = 1500; i < 3000; i++) {
+        uint32_t id = ids[i] * 2 + (i % 2);
+        ASSERT_EQ(table->deleteRow(id), expected.erase(id) == 1) << id;
+    }
+    EXPECT_GT(store.getFolds(), 0u);
+    EXPECT_EQ(store.getNumRows(), expected.size());
+    for (const ColumnStore::Segment& segment : store.getSegments()) {
+        EXPECT_LE(segment.ids.size(), COLUMN_SEGMENT_ROWS);
+        EXPECT_TRUE(std::is_sorted(segment.ids.begin(), segment.ids.end()));
+    }
+
+    ColumnStoreScan scan(store);
+    auto rows = drain(scan);
+    ASSERT_EQ(rows.size(), expected.size());
+    auto want = expected.begin();
+    for (const auto& row : rows) {
+        ASSERT_EQ(std::get<0>(row), want->first);
+        EXPECT_EQ(std::get<1>(row), want->second);
+        EXPECT_EQ(std::get<2>(row), "");  // email is not projected
+        ++want;
+    }
+
+    // a range that starts and ends inside segments
+    ColumnStoreScan range(store, 1001, 9000);
+    rows = drain(range);
+    auto first = expected.lower_bound(1001);
+    ASSERT_EQ(rows.size(), static_cast<size_t>(std::distance(first, expected.upper_bound(9000))));
+    EXPECT_EQ(std::get<0>(rows.front()), first->first);
+}
+
+TEST_F(ColumnStoreTest, ZoneMapsSkipSegmentsFiltersCannotMatch) {
+    // usernames rise with the id, so each segment covers its own range of them
+    for (uint32_t id = 1; id <= 4 * COLUMN_SEGMENT_ROWS; id++) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "u%06u", id);
+        table->insertRow(Row(id, name, "e"));
+    }
+    table->createColumnStore((1u << COLUMN_USERNAME) | (1u << COLUMN_EMAIL));
+    const ColumnStore& store = *table->getColumnStore();
+    ASSERT_EQ(store.getSegments().size(), 4u);
+
+    FieldFilter equals;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::EQUALS, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "u010000",
+                                equals));
+    ColumnStoreScan point(store);
+    point.pushFilter(equals);
+    auto rows = drain(point);
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(std::get<0>(rows[0]), 10000);
+    EXPECT_EQ(std::get<2>(rows[0]), "e");
+    EXPECT_EQ(point.getSegmentsSkipped(), 3u);
+    EXPECT_EQ(point.getRowsExamined(), COLUMN_SEGMENT_ROWS);
+
+    // a buffered row outside every zone map is still found
+    table->insertRow(Row(5 * COLUMN_SEGMENT_ROWS, "u010000", "late"));
+    ColumnStoreScan buffered(store);
+    buffered.pushFilter(equals);
+    rows = drain(buffered);
+    ASSERT_EQ(rows.size(), 2u);
+    EXPECT_EQ(std::get<2>(rows[1]), "late");
+
+    FieldFilter prefix;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::PREFIX, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "u0163",
+                                prefix));
+    ColumnStoreScan prefixed(store);
+    prefixed.pushFilter(prefix);
+    EXPECT_EQ(drain(prefixed).size(), 85u);  // 16300..16384
+    EXPECT_EQ(prefixed.getSegmentsSkipped(), 3u);
+}
+
+TEST_F(ColumnStoreTest, RebuiltAfterReopenAndRollback) {
+    for (uint32_t id = 1; id <= 100; id++) {
+        table->insertRow(Row(id, "user", "user" + std::to_string(id) + "@example.com"));
+    }
+    table->createColumnStore(1u << COLUMN_EMAIL);
+    table.reset();
+    table = std::make_unique<Table>("column_test.db");
+    ASSERT_EQ(table->getColumnStoreColumns(), 1u << COLUMN_EMAIL);
+    EXPECT_EQ(table->getColumnStore()->getNumRows(), 100u);
+
+    table->beginTransaction();
+    for (uint32_t id = 101; id <= 200; id++) {
+        table->insertRow(Row(id, "user", "later"));
+    }
+    table->deleteRow(1);
+    EXPECT_EQ(table->getColumnStore()->getNumRows(), 199u);
+    table->rollbackTransaction();
+    ColumnStoreScan scan(*table->getColumnStore());
+    auto rows = drain(scan);
+    ASSERT_EQ(rows.size(), 100u);
+    EXPECT_EQ(std::get<0>(rows.front()), 1);
+    EXPECT_EQ(std::get<2>(rows.front()), "user1@example.com");
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csv_import.hpp"
+#include "cursor.hpp"
+#include "hash_index.hpp"
+#include "meta_command_processor.hpp"
+#include "scheduler.hpp"
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "secondary_index.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+#include "zone_map.hpp"
+
+class CsvImportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("import_test.db");
+        std::remove("import_test.db-wal");
+        table = std::make_unique<Table>("import_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("import_test.db");
+        std::remove("import_test.db-wal");
+        std::remove("import_test.csv");
+    }
+
+    static void writeFile(const std::string& text) {
+        std::ofstream("import_test.csv", std::ios::binary) << text;
+    }
+
+    // The ids in key order, checking on the way that each row is the one the file gave
+    std::vector<uint32_t> idsInOrder() {
+        std::vector<uint32_t> ids;
+        for (Cursor cursor(*table); !cursor.isEndOfTable(); cursor.cursorAdvance()) {
+            Row row = Row::deserialize(cursor.cursorSlot());
+            EXPECT_EQ(std::string(row.getUsername()), "user" + std::to_string(row.getId()));
+            ids.push_back(row.getId());
+        }
+        return ids;
+    }
+
+    // Rows "id,user<id>,user<id>@example.com" for ids in the given order
+    static std::string usersCsv(const std::vector<uint32_t>& ids) {
+        std::string text;
+        for (uint32_t id : ids) {
+            text += std::to_string(id) + ",user" + std::to_string(id) + ",user" + std::to_string(id) + "@example.com\n";
+        }
+        return text;
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(CsvImportTest, BuildsAnEmptyTreeBottomUpFromShuffledChunks) {
+    // enough leaves for a level of internal nodes between them and the root
+    std::vector<uint32_t> ids(60000);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::mt19937 generator(3);
+    std::shuffle(ids.begin(), ids.end(), generator);
+    writeFile("id,username,email\n" + usersCsv(ids));
+
+    Scheduler scheduler(4);
+    table->setScheduler(&scheduler);
+    ImportResult result = importCsv(*table, "import_test.csv", "users", 64 * 1024);
+    EXPECT_EQ(result.rows, ids.size());
+    EXPECT_TRUE(result.bulkLoaded);
+    EXPECT_GT(result.chunks, 20u);
+    EXPECT_FALSE(table->inTransaction());
+
+    std::vector<uint32_t> expected(ids.size());
+    std::iota(expected.begin(), expected.end(), 1);
+    EXPECT_EQ(idsInOrder(), expected);
+    EXPECT_EQ(table->getNumRows(), ids.size());
+    EXPECT_EQ(table->countRowsBelow(30001), 30000u);
+    uint32_t key = 0;
+    ASSERT_TRUE(table->keyAtRank(44444, key));
+    EXPECT_EQ(key, 44445u);
+    EXPECT_EQ(std::string(table->getRow(12345).getEmail()), "user12345@example.com");
+
+    // the tree takes ordinary changes afterwards, and is all in the file
+    for (uint32_t id = 60001; id <= 61000; id++) {
+        table->insertRow(Row(id, "user" + std::to_string(id), "e"));
+    }
+    EXPECT_THROW(table->insertRow(Row(777, "x", "y")), std::invalid_argument);
+    EXPECT_TRUE(table->deleteRow(777));
+    table->setScheduler(nullptr);
+    table.reset();
+    table = std::make_unique<Table>("import_test.db");
+    EXPECT_EQ(table->getNumRows(), 61000u - 1);
+    EXPECT_EQ(idsInOrder().back(), 61000u);
+    uint32_t leafPageNum = 0;
+    uint32_t cellNum = 0;
+    EXPECT_FALSE(table->findRow(777, leafPageNum, cellNum));
+    EXPECT_TRUE(table->findRow(778, leafPageNum, cellNum));
+}
+
+TEST_F(CsvImportTest, KeepsIndexesAndZoneMapCurrent) {
+    table->createIndex(COLUMN_EMAIL);
+    table->createHashIndex();
+    table->createZoneMap();
+    std::vector<uint32_t> ids(3000);
+    std::iota(ids.begin(), ids.end(), 1);
+    writeFile(usersCsv(ids));
+    ASSERT_TRUE(importCsv(*table, "import_test.csv", "users", 1000).bulkLoaded);
+
+    IndexCursor byEmail(*table->getIndex(COLUMN_EMAIL), "user2222@example.com");
+    ASSERT_FALSE(byEmail.isEnd());
+    EXPECT_EQ(byEmail.key(), "user2222@example.com");
+    EXPECT_EQ(byEmail.id(), 2222u);
+    uint32_t leafPageNum = 0;
+    ASSERT_TRUE(table->getHashIndex()->find(2222, leafPageNum));
+    uint32_t cellNum = 0;
+    uint32_t treeLeaf = 0;
+    ASSERT_TRUE(table->findRow(2222, treeLeaf, cellNum));
+    EXPECT_EQ(leafPageNum, treeLeaf);
+
+    TableScan scan(*table);
+    FieldFilter filter;
+    makeFieldFilter(FieldMatch::EQUALS, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "user2222", filter);
+    scan.pushFilter(filter);
+    Batch batch;
+    uint32_t found = 0;
+    while (scan.next(batch)) {
+        found += batch.selectedCount;
+    }
+    EXPECT_EQ(found, 1u);
+    EXPECT_GT(scan.getLeavesSkipped(), 0u);
+}
+
+TEST_F(CsvImportTest, ReadsQuotesHeadersAndLineEnds) {
+    writeFile("ID,Username,EMAIL\r\n"
+              "2,\"a,b\",\"say \"\"hi\"\"\"\r\n"
+              "\n"
+              "1,,plain\n"
+              "3,\"\",\"x\"");
+    ImportResult result = importCsv(*table, "import_test.csv", "users");
+    EXPECT_EQ(result.rows, 3u);
+    EXPECT_EQ(std::string(table->getRow(2).getUsername()), "a,b");
+    EXPECT_EQ(std::string(table->getRow(2).getEmail()), "say \"hi\"");
+    EXPECT_EQ(std::string(table->getRow(1).getUsername()), "");
+    EXPECT_EQ(std::string(table->getRow(1).getEmail()), "plain");
+    EXPECT_EQ(std::string(table->getRow(3).getEmail()), "x");
+}
+
+TEST_F(CsvImportTest, RejectsBadInputAndLeavesTheTableAsItWas) {
+    table->insertRow(Row(5, "five", "e"));
+    auto expectError = [&](const std::string& text, const std::string& message) {
+        writeFile(text);
+        try {
+            importCsv(*table, "import_test.csv", "users", 16);
+            ADD_FAILURE() << "no error for " << text;
+        } catch (const std::invalid_argument& e) {
+            EXPECT_NE(std::string(e.what()).find(message), std::string::npos) << e.what();
+        }
+        EXPECT_EQ(table->getNumRows(), 1u);
+        EXPECT_FALSE(table->inTransaction());
+    };
+    // line numbers count across chunks
+    expectError("1,a,b\n2,a,b\n3,a,b\n4,a\n", "line 4: 2 fields, not 3");
+    expectError("1,a,b\n2,a,b,c\n", "line 2: more than 3 fields");
+    expectError("1,a,b\n\n-3,a,b\n", "line 3: Row ID cannot be negative");
+    expectError("x1,a,b\n", "line 1: id needs an integer");
+    expectError("4294967296,a,b\n", "id needs an integer");
+    expectError("1,\"open,b\n", "quoted field not closed");
+    expectError("1,a\"b,c\n", "quote inside an unquoted field");
+    expectError("1," + std::string(COLUMN_USERNAME_SIZE, 'u') + ",e\n", "username is longer than 31 characters");
+    expectError("7,a,b\n8,a,b\n7,c,d\n", "Duplicate key 7");
+    // a table with rows takes them through insertRow, which finds the clash
+    expectError("6,a,b\n5,a,b\n", "Duplicate key");
+    EXPECT_THROW(importCsv(*table, "import_test.csv", "nothing"), std::invalid_argument);
+    EXPECT_THROW(importCsv(*table, "no_such_file.csv", "users"), std::runtime_error);
+
+    writeFile("7,seven,e\n6,six,e\n");
+    ImportResult result = importCsv(*table, "import_test.csv", "users");
+    EXPECT_FALSE(result.bulkLoaded);
+    EXPECT_EQ(table->getNumRows(), 3u);
+
+    // inside a transaction the import is undone with it
+    writeFile("8,eight,e\n");
+    table->beginTransaction();
+    importCsv(*table, "import_test.csv", "users");
+    EXPECT_TRUE(table->inTransaction());
+    EXPECT_EQ(table->getNumRows(), 4u);
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getNumRows(), 3u);
+}
+
+TEST_F(CsvImportTest, LoadsCreateTableTablesInKeyOrder) {
+    table->createTable(Schema("items", {{"id", ColumnType::BIGINT, 0}, {"name", ColumnType::TEXT, 10},
+                                        {"price", ColumnType::DOUBLE, 0}}, {0}));
+    writeFile("id,name,price\n30,c,1.5\n-10,a,2\n20,\"b,b\",1e3\n");
+    ImportResult result = importCsv(*table, "import_test.csv", "ITEMS", 8);
+    EXPECT_EQ(result.rows, 3u);
+    SchemaTable* items = table->getSchemaTable("items");
+    ASSERT_NE(items, nullptr);
+    EXPECT_EQ(items->getNumRows(), 3u);
+    Field key;
+    key.integer = 20;
+    std::vector<Field> row;
+    ASSERT_TRUE(items->getRow({key}, row));
+    EXPECT_EQ(row[1].bytes, "b,b");
+    EXPECT_EQ(row[2].real, 1000.0);
+
+    writeFile("40,d,x\n");
+    EXPECT_THROW(importCsv(*table, "import_test.csv", "items"), std::invalid_argument);
+    writeFile("40,waytoolongname,1\n");
+    EXPECT_THROW(importCsv(*table, "import_test.csv", "items"), std::invalid_argument);
+    writeFile("41,d,1\n20,again,1\n");
+    EXPECT_THROW(importCsv(*table, "import_test.csv", "items"), std::invalid_argument);
+    EXPECT_EQ(items->getNumRows(), 3u);
+}
+
+TEST_F(CsvImportTest, MetaCommandImportsAFile) {
+    writeFile(usersCsv({3, 1, 2}));
+    MetaCommandProcessor processor;
+    EXPECT_EQ(processor.execute(".import import_test.csv users", table.get()), MetaCommandResult::META_COMMAND_SUCCESS);
+    EXPECT_EQ(idsInOrder(), (std::vector<uint32_t>{1, 2, 3}));
+    EXPECT_EQ(processor.execute(".import import_test.csv", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(processor.execute(".import import_test.csv users", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(processor.execute(".imports", table.get()), MetaCommandResult::META_COMMAND_UNRECOGNIZED_COMMAND);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "external_sort.hpp"
+
+namespace {
+    // (value, insertion index) pairs, through a sorter keyed on value only
+    std::vector<std::pair<int64_t, uint32_t>> sortThrough(ExternalSorter& sorter, const std::vector<int64_t>& values,
+                                                          bool descending = false) {
+        std::string key;
+        for (uint32_t i = 0; i < values.size(); i++) {
+            key.clear();
+            appendSortKey(key, values[i], descending);
+            std::string payload = std::to_string(values[i]) + "/" + std::to_string(i);
+            sorter.add(key, payload);
+        }
+        std::vector<std::pair<int64_t, uint32_t>> sorted;
+        std::string_view sortedKey;
+        std::string_view payload;
+        while (sorter.next(sortedKey, payload)) {
+            size_t slash = payload.find('/');
+            sorted.emplace_back(std::stoll(std::string(payload.substr(0, slash))),
+                                static_cast<uint32_t>(std::stoul(std::string(payload.substr(slash + 1)))));
+        }
+        return sorted;
+    }
+
+    // What a stable sort of the same input returns
+    std::vector<std::pair<int64_t, uint32_t>> expected(const std::vector<int64_t>& values, bool descending = false,
+                                                       size_t limit = SIZE_MAX) {
+        std::vector<std::pair<int64_t, uint32_t>> sorted;
+        for (uint32_t i = 0; i < values.size(); i++) {
+            sorted.emplace_back(values[i], i);
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [descending](const auto& a, const auto& b) {
+            return descending ? a.first > b.first : a.first < b.first;
+        });
+        sorted.resize(std::min(limit, sorted.size()));
+        return sorted;
+    }
+
+    std::vector<int64_t> randomValues(uint32_t count, int64_t range) {
+        std::mt19937_64 generator(42);
+        std::vector<int64_t> values(count);
+        for (int64_t& value : values) {
+            value = static_cast<int64_t>(generator() % static_cast<uint64_t>(2 * range)) - range;
+        }
+        return values;
+    }
+}
+
+TEST(SortKeyTest, NormalizedKeysCompareLikeTheValues) {
+    auto encodeInteger = [](int64_t value, bool descending) {
+        std::string key;
+        appendSortKey(key, value, descending);
+        return key;
+    };
+    auto encodeText = [](std::string_view value, bool descending) {
+        std::string key;
+        appendSortKey(key, value, descending);
+        return key;
+    };
+    const int64_t integers[] = {INT64_MIN, -300, -1, 0, 1, 255, 256, INT64_MAX};
+    for (size_t i = 0; i + 1 < std::size(integers); i++) {
+        EXPECT_LT(encodeInteger(integers[i], false), encodeInteger(integers[i + 1], false)) << integers[i];
+        EXPECT_GT(encodeInteger(integers[i], true), encodeInteger(integers[i + 1], true)) << integers[i];
+    }
+
+    // a string sorts before its extensions, even ones continuing with a zero byte
+    const std::string texts[] = {"", std::string("a\0", 2), std::string("a\0b", 3), "a", "a\x01", "ab", "b",
+                                 "\xff"};
+    std::vector<std::string> ordered(std::begin(texts), std::end(texts));
+    std::sort(ordered.begin(), ordered.end());
+    for (size_t i = 0; i + 1 < ordered.size(); i++) {
+        EXPECT_LT(encodeText(ordered[i], false), encodeText(ordered[i + 1], false)) << i;
+        EXPECT_GT(encodeText(ordered[i], true), encodeText(ordered[i + 1], true)) << i;
+    }
+
+    // the second column only decides between equal first columns
+    std::string first = encodeText("ab", false) + encodeInteger(9, false);
+    std::string second = encodeText("abc", false) + encodeInteger(1, false);
+    EXPECT_LT(first, second);
+}
+
+TEST(ExternalSorterTest, InMemorySortIsStable) {
+    std::vector<int64_t> values = randomValues(5000, 50);
+    ExternalSorter sorter;
+    EXPECT_EQ(sortThrough(sorter, values), expected(values));
+    EXPECT_EQ(sorter.getSpilledRuns(), 0u);
+
+    ExternalSorter descending;
+    EXPECT_EQ(sortThrough(descending, values, true), expected(values, true));
+}
+
+TEST(ExternalSorterTest, SpilledRunsMergeInOrder) {
+    std::vector<int64_t> values = randomValues(40000, 1000);
+    ExternalSorter sorter(64 * 1024);
+    EXPECT_EQ(sortThrough(sorter, values), expected(values));
+    EXPECT_GT(sorter.getSpilledRuns(), 10u);
+    EXPECT_GT(sorter.getSpilledBytes(), 40000u * 16);
+
+    // a limit too large for the heap still stops the merge early
+    ExternalSorter limited(64 * 1024, TOP_N_MAX_ROWS + 1);
+    std::vector<int64_t> many = randomValues(TOP_N_MAX_ROWS + 5000, 1000);
+    EXPECT_EQ(sortThrough(limited, many), expected(many, false, TOP_N_MAX_ROWS + 1));
+    EXPECT_GT(limited.getSpilledRuns(), 0u);
+}
+
+TEST(ExternalSorterTest, TopNKeepsTheSmallestRows) {
+    std::vector<int64_t> values = randomValues(20000, 100);
+    for (uint64_t limit : {0ull, 1ull, 10ull, 500ull, 30000ull}) {
+        ExternalSorter sorter(64 * 1024, limit);
+        EXPECT_EQ(sortThrough(sorter, values), expected(values, false, limit)) << limit;
+        EXPECT_EQ(sorter.getSpilledRuns(), 0u);
+    }
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "filter_kernels.hpp"
+
+namespace {
+    constexpr uint32_t FIELD_SIZE = 40;
+    constexpr uint32_t STRIDE = 48;
+    constexpr uint32_t OFFSET = 4;
+
+    // Cells of STRIDE bytes with a zero-padded field at OFFSET; the bytes
+    // around the field are 0xFF so a kernel that strays out of it fails
+    std::vector<uint8_t> makeCells(const std::vector<std::string>& values) {
+        std::vector<uint8_t> cells(values.size() * STRIDE, 0xFF);
+        for (size_t i = 0; i < values.size(); i++) {
+            uint8_t* field = cells.data() + i * STRIDE + OFFSET;
+            std::memset(field, 0, FIELD_SIZE);
+            std::memcpy(field, values[i].data(), values[i].size());
+        }
+        return cells;
+    }
+
+    std::vector<uint32_t> matching(FieldMatch match, const std::string& pattern,
+                                   const std::vector<std::string>& values) {
+        FieldFilter filter;
+        EXPECT_TRUE(makeFieldFilter(match, OFFSET, FIELD_SIZE, pattern, filter));
+        std::vector<uint8_t> cells = makeCells(values);
+        std::vector<uint32_t> selection(values.size());
+        for (uint32_t i = 0; i < selection.size(); i++) {
+            selection[i] = i;
+        }
+        uint32_t count = applyFieldFilter(filter, cells.data(), STRIDE, selection.data(),
+                                          static_cast<uint32_t>(selection.size()));
+        selection.resize(count);
+        return selection;
+    }
+}
+
+TEST(FilterKernelsTest, EqualsComparesTheWholeField) {
+    std::string long17(17, 'a');
+    std::string full(FIELD_SIZE - 1, 'a');
+    std::vector<std::string> values = {"alice", "alice2", "alic", "", long17, long17 + "b", full};
+    EXPECT_EQ(matching(FieldMatch::EQUALS, "alice", values), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(matching(FieldMatch::EQUALS, "", values), (std::vector<uint32_t>{3}));
+    EXPECT_EQ(matching(FieldMatch::EQUALS, long17, values), (std::vector<uint32_t>{4}));
+    EXPECT_EQ(matching(FieldMatch::EQUALS, full, values), (std::vector<uint32_t>{6}));
+
+    FieldFilter tooLong;
+    EXPECT_FALSE(makeFieldFilter(FieldMatch::EQUALS, OFFSET, FIELD_SIZE, std::string(FIELD_SIZE, 'a'), tooLong));
+}
+
+TEST(FilterKernelsTest, PrefixSuffixAndContains) {
+    std::vector<std::string> values = {"bob@corp.com", "ann@example.com", "corp", "x@corp.com.au",
+                                       std::string(30, 'z') + "@corp.com"};
+    EXPECT_EQ(matching(FieldMatch::PREFIX, "ann@", values), (std::vector<uint32_t>{1}));
+    EXPECT_EQ(matching(FieldMatch::PREFIX, "", values), (std::vector<uint32_t>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(matching(FieldMatch::PREFIX, std::string(20, 'z'), values), (std::vector<uint32_t>{4}));
+    EXPECT_EQ(matching(FieldMatch::SUFFIX, "@corp.com", values), (std::vector<uint32_t>{0, 4}));
+    EXPECT_EQ(matching(FieldMatch::SUFFIX, "corp", values), (std::vector<uint32_t>{2}));
+    EXPECT_EQ(matching(FieldMatch::CONTAINS, "corp", values), (std::vector<uint32_t>{0, 2, 3, 4}));
+}
+
+TEST(FilterKernelsTest, LikeMatchAndClassify) {
+    EXPECT_TRUE(likeMatch("abc", "abc"));
+    EXPECT_FALSE(likeMatch("abc", "ABC"));
+    EXPECT_TRUE(likeMatch("abc", "a%"));
+    EXPECT_TRUE(likeMatch("abc", "%"));
+    EXPECT_TRUE(likeMatch("", "%"));
+    EXPECT_FALSE(likeMatch("", "_"));
+    EXPECT_TRUE(likeMatch("abcbc", "a%bc"));
+    EXPECT_TRUE(likeMatch("a.b.c", "a%.%c"));
+    EXPECT_FALSE(likeMatch("abcd", "a%c"));
+    EXPECT_TRUE(likeMatch("axc", "a_c"));
+
+    FieldMatch match;
+    std::string_view literal;
+    ASSERT_TRUE(classifyLike("abc", match, literal));
+    EXPECT_EQ(match, FieldMatch::EQUALS);
+    ASSERT_TRUE(classifyLike("abc%", match, literal));
+    EXPECT_EQ(match, FieldMatch::PREFIX);
+    EXPECT_EQ(literal, "abc");
+    ASSERT_TRUE(classifyLike("%@corp.com", match, literal));
+    EXPECT_EQ(match, FieldMatch::SUFFIX);
+    EXPECT_EQ(literal, "@corp.com");
+    ASSERT_TRUE(classifyLike("%corp%", match, literal));
+    EXPECT_EQ(match, FieldMatch::CONTAINS);
+    EXPECT_EQ(literal, "corp");
+    ASSERT_TRUE(classifyLike("%", match, literal));
+    EXPECT_EQ(literal, "");
+    EXPECT_FALSE(classifyLike("a%b", match, literal));
+    EXPECT_FALSE(classifyLike("a_", match, literal));
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "cursor.hpp"
+#include "hash_index.hpp"
+#include "table.hpp"
+
+class HashIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("hash_test.db");
+        table = std::make_unique<Table>("hash_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("hash_test.db");
+    }
+
+    // Whether the index sends key to a leaf that holds it
+    bool findsLeaf(uint32_t key) {
+        uint32_t pageNum;
+        if (!table->getHashIndex()->find(key, pageNum)) {
+            return false;
+        }
+        Node leaf(table->getPageAddress(pageNum));
+        for (uint32_t i = 0; i < *leaf.leafNodeNumCells(); i++) {
+            if (*leaf.leafNodeKey(i) == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(HashIndexTest, FollowsRowsThroughLeafSplits) {
+    table->createHashIndex();
+    EXPECT_THROW(table->createHashIndex(), std::invalid_argument);
+    std::vector<uint32_t> ids(20000);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::mt19937 generator(7);
+    std::shuffle(ids.begin(), ids.begin() + 10000, generator);  // half random, half in key order
+    for (uint32_t id : ids) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+
+    const HashIndex& index = *table->getHashIndex();
+    EXPECT_EQ(index.getEntryCount(), 20000u);
+    // grown a bucket at a time, never past the load limit
+    EXPECT_GE(index.getBucketCount(), 20000 / (HASH_MAX_LOAD * HASH_BUCKET_MAX_ENTRIES));
+    for (uint32_t id = 1; id <= 20000; id++) {
+        ASSERT_TRUE(findsLeaf(id)) << id;
+    }
+    uint32_t pageNum;
+    EXPECT_FALSE(index.find(20001, pageNum));
+
+    for (uint32_t id = 2; id <= 20000; id += 3) {
+        ASSERT_TRUE(table->deleteRow(id));
+    }
+    EXPECT_FALSE(index.find(2, pageNum));
+    EXPECT_TRUE(findsLeaf(3));
+    EXPECT_EQ(index.getEntryCount(), 20000u - 6667);
+    EXPECT_EQ(table->getRow(4).getId(), 4u);
+    EXPECT_THROW(table->getRow(5), std::out_of_range);
+    EXPECT_THROW(table->insertRow(Row(4, "dup", "dup@example.com")), std::invalid_argument);
+    table->insertRow(Row(5, "back", "back@example.com"));
+    EXPECT_STREQ(table->getRow(5).getUsername(), "back");
+}
+
+TEST_F(HashIndexTest, BuildsFromExistingRowsAndPersists) {
+    for (uint32_t id = 1; id <= 3000; id++) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+    table->createHashIndex();
+    EXPECT_EQ(table->getHashIndex()->getEntryCount(), 3000u);
+    uint32_t buckets = table->getHashIndex()->getBucketCount();
+
+    table.reset();
+    table = std::make_unique<Table>("hash_test.db");
+    ASSERT_NE(table->getHashIndex(), nullptr);
+    EXPECT_EQ(table->getHashIndex()->getBucketCount(), buckets);
+    for (uint32_t id = 1; id <= 3000; id++) {
+        ASSERT_TRUE(findsLeaf(id)) << id;
+    }
+    // a cursor for an indexed key lands on the same cell as a descent would
+    Cursor cursor(*table, 1234);
+    EXPECT_EQ(*Node(table->getPageAddress(cursor.getPageNum())).leafNodeKey(cursor.getCellNum()), 1234u);
+}
+
+TEST_F(HashIndexTest, RollbackRestoresTheIndex) {
+    table->createHashIndex();
+    for (uint32_t id = 1; id <= 1000; id++) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+    table->beginTransaction();
+    for (uint32_t id = 1001; id <= 5000; id++) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+    EXPECT_TRUE(table->deleteRow(10));
+    table->rollbackTransaction();
+
+    const HashIndex& index = *table->getHashIndex();
+    EXPECT_EQ(index.getEntryCount(), 1000u);
+    uint32_t pageNum;
+    EXPECT_FALSE(index.find(1001, pageNum));
+    EXPECT_TRUE(findsLeaf(10));
+    table->insertRow(Row(1001, "user", "user@example.com"));
+    EXPECT_TRUE(findsLeaf(1001));
+}
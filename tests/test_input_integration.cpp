@@ -7,6 +7,7 @@
 #include "meta_command_processor.hpp"
 #include "statement_processor.hpp"
 #include "table.hpp"
+#include "node.hpp"
 
 class InputIntegrationTest : public ::testing::Test {
 protected:
@@ -253,5 +254,111 @@ TEST_F(InputIntegrationTest, SelectWorksAfterMultipleSplits) {
     EXPECT_EQ(last.getId(), 90);
     EXPECT_STREQ(last.getUsername(), "user90");
 }
-    
 
+TEST_F(InputIntegrationTest, RollbackDiscardsTransaction) {
+    EXPECT_EQ(processor->execute("insert 1 kept kept@test.com"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("begin"), PrepareResult::PREPARE_SUCCESS);
+    for (int i = 2; i < LEAF_NODE_MAX_CELLS + 5; i++) {
+        std::string cmd = "insert " + std::to_string(i) + " user user@test.com";
+        EXPECT_EQ(processor->execute(cmd), PrepareResult::PREPARE_SUCCESS);
+    }
+    EXPECT_EQ(processor->execute("rollback"), PrepareResult::PREPARE_SUCCESS);
+
+    Node root(table->getPageAddress(table->getRootPageNum()));
+    EXPECT_EQ(root.getNodeType(), NodeType::NODE_LEAF);
+    EXPECT_EQ(table->getNumRows(), 1);
+    EXPECT_EQ(table->getUnusedPageNum(), 1);
+    EXPECT_THROW(table->getRow(2), std::out_of_range);
+}
+
+TEST_F(InputIntegrationTest, CommittedTransactionPersists) {
+    EXPECT_EQ(processor->execute("begin"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("insert 1 a a@test.com"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("insert 2 b b@test.com"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("commit"), PrepareResult::PREPARE_SUCCESS);
+
+    processor.reset();
+    table.reset();
+    table = std::make_unique<Table>(test_filename);
+    EXPECT_EQ(table->getNumRows(), 2);
+    EXPECT_STREQ(table->getRow(2).getUsername(), "b");
+}
+
+TEST_F(InputIntegrationTest, FailedInsertMultipleAppliesNothing) {
+    EXPECT_EQ(processor->execute("insert 8 dup dup@test.com"), PrepareResult::PREPARE_SUCCESS);
+    // rows 1..7 go in, then 8 collides
+    PrepareResult result = processor->execute("insert_multiple 20 1 user user@test.com");
+    EXPECT_EQ(result, PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(table->getNumRows(), 1);
+    EXPECT_THROW(table->getRow(1), std::out_of_range);
+}
+
+TEST_F(InputIntegrationTest, FailedStatementInsideTransactionKeepsEarlierStatements) {
+    EXPECT_EQ(processor->execute("begin"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("insert 5 first first@test.com"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("insert_multiple 3 4 user user@test.com"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(processor->execute("commit"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(table->getNumRows(), 1);
+    EXPECT_STREQ(table->getRow(5).getUsername(), "first");
+}
+
+TEST_F(InputIntegrationTest, CommitWithoutTransactionFails) {
+    EXPECT_EQ(processor->execute("commit"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(processor->execute("rollback"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
+
+TEST_F(InputIntegrationTest, SqlInsertSelectWithWhereOrderAndLimit) {
+    EXPECT_EQ(processor->execute("INSERT INTO users VALUES (3, 'carol', 'c@x'), (1, 'alice', 'a@x'), (2, 'bob', 'b@x')"),
+              PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("insert into users (email, id) values ('d@x', 4)"), PrepareResult::PREPARE_SUCCESS);
+
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(processor->execute("SELECT id, username FROM users WHERE id >= 2 AND id < 4"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "(2, bob)\n(3, carol)\n");
+
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(processor->execute("SELECT * FROM users WHERE username <> '' ORDER BY username DESC LIMIT 2"),
+              PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "(3, carol, c@x)\n(2, bob, b@x)\n");
+
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(processor->execute("SELECT id * 10 FROM users LIMIT 2 OFFSET 1"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "(20)\n(30)\n");
+}
+
+TEST_F(InputIntegrationTest, SqlUpdateAndDeleteAcrossLeaves) {
+    for (int id = 1; id <= 60; id++) {
+        processor->execute("INSERT INTO users VALUES (" + std::to_string(id) + ", 'u', 'e')");
+    }
+    EXPECT_EQ(processor->execute("UPDATE users SET username = 'even' WHERE id / 2 * 2 = id"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_STREQ(table->getRow(42).getUsername(), "even");
+    EXPECT_STREQ(table->getRow(43).getUsername(), "u");
+
+    // emptying the first leaves must not end later scans early
+    EXPECT_EQ(processor->execute("DELETE FROM users WHERE id <= 30"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_THROW(table->getRow(30), std::out_of_range);
+    testing::internal::CaptureStdout();
+    processor->execute("SELECT id FROM users LIMIT 1");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "(31)\n");
+
+    // shifting every id by one must not collide with itself
+    EXPECT_EQ(processor->execute("UPDATE users SET id = id + 1"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_THROW(table->getRow(31), std::out_of_range);
+    EXPECT_STREQ(table->getRow(61).getUsername(), "even");
+
+    // a reinserted key lands in an emptied leaf
+    EXPECT_EQ(processor->execute("INSERT INTO users VALUES (5, 'back', 'b@x')"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_STREQ(table->getRow(5).getUsername(), "back");
+}
+
+TEST_F(InputIntegrationTest, SqlErrorsLeaveTableUnchanged) {
+    EXPECT_EQ(processor->execute("INSERT INTO users VALUES (1, 'a', 'a@x')"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(processor->execute("INSERT INTO users VALUES (2, 'b', 'b@x'), (1, 'dup', 'd@x')"),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_THROW(table->getRow(2), std::out_of_range);
+    EXPECT_EQ(processor->execute("SELECT nope FROM users"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(processor->execute("SELECT * FROM other"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(processor->execute("SELECT * FROM users WHERE"), PrepareResult::PREPARE_SYNTAX_ERROR);
+    EXPECT_EQ(processor->execute("INSERT INTO users VALUES (-1, 'n', 'n@x')"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(table->getNumRows(), 1);
+}
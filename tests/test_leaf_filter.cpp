@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+class LeafFilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("leaf_filter_test.db");
+        table = std::make_unique<Table>("leaf_filter_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("leaf_filter_test.db");
+    }
+
+    // Even ids 2..2*count, in random order
+    void insertEvenIds(uint32_t count) {
+        std::vector<uint32_t> ids(count);
+        std::iota(ids.begin(), ids.end(), 1);
+        std::shuffle(ids.begin(), ids.end(), std::mt19937(5));
+        for (uint32_t id : ids) {
+            table->insertRow(Row(2 * id, "user", "user@example.com"));
+        }
+    }
+
+    bool hasRow(uint32_t key) {
+        uint32_t pageNum;
+        uint32_t cellNum;
+        return table->findRow(key, pageNum, cellNum);
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(LeafFilterTest, AbsentKeysSkipTheLeaf) {
+    insertEvenIds(3000);
+    table.reset();
+    // the filters are rebuilt on open; a one-page cache makes every leaf read count
+    table = std::make_unique<Table>("leaf_filter_test.db", 1);
+
+    uint64_t readsBefore = table->getPager().getStats().pageReads;
+    for (uint32_t id = 1; id <= 6000; id += 2) {
+        EXPECT_THROW(table->getRow(id), std::out_of_range);
+    }
+    uint64_t absentReads = table->getPager().getStats().pageReads - readsBefore;
+    LeafFilters::Stats stats = table->getLeafFilterStats();
+    EXPECT_EQ(stats.probes, 3000u);
+    EXPECT_EQ(stats.negatives + stats.falsePositives, 3000u);
+    EXPECT_LT(stats.falsePositives, 150u);  // under 5%
+
+    readsBefore = table->getPager().getStats().pageReads;
+    for (uint32_t id = 2; id <= 6000; id += 2) {
+        ASSERT_EQ(table->getRow(id).getId(), id);  // no false negatives
+    }
+    uint64_t presentReads = table->getPager().getStats().pageReads - readsBefore;
+    EXPECT_EQ(table->getLeafFilterStats().falsePositives, stats.falsePositives);
+    // an absent key reads only the internal nodes, a present one also its leaf
+    EXPECT_LT(absentReads + 3000 / 2, presentReads);
+}
+
+TEST_F(LeafFilterTest, FollowsSplitsDeletesAndRollback) {
+    EXPECT_FALSE(hasRow(2));
+    insertEvenIds(2000);
+    for (uint32_t id = 1; id <= 4000; id++) {
+        ASSERT_EQ(hasRow(id), id % 2 == 0) << id;
+    }
+
+    for (uint32_t id = 4; id <= 4000; id += 4) {
+        ASSERT_TRUE(table->deleteRow(id));
+    }
+    EXPECT_FALSE(table->deleteRow(4));
+    EXPECT_THROW(table->updateRow(Row(8, "gone", "gone@example.com")), std::out_of_range);
+    LeafFilters::Stats before = table->getLeafFilterStats();
+    for (uint32_t id = 4; id <= 4000; id += 4) {
+        ASSERT_FALSE(hasRow(id));
+    }
+    // deletes rebuild their leaf's filter, so deleted keys are filtered out too
+    LeafFilters::Stats after = table->getLeafFilterStats();
+    EXPECT_GT(after.negatives - before.negatives, 900u);
+
+    table->beginTransaction();
+    for (uint32_t id = 4001; id <= 6000; id++) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+    table->insertRow(Row(4, "back", "back@example.com"));
+    EXPECT_TRUE(hasRow(5999));
+    table->rollbackTransaction();
+    EXPECT_FALSE(hasRow(4));
+    for (uint32_t id = 4001; id <= 6000; id++) {
+        ASSERT_FALSE(hasRow(id)) << id;
+    }
+    EXPECT_TRUE(hasRow(3998));
+    table->insertRow(Row(4, "back", "back@example.com"));
+    EXPECT_STREQ(table->getRow(4).getUsername(), "back");
+}
+
+TEST_F(LeafFilterTest, PointScansUseTheFilters) {
+    insertEvenIds(500);
+    auto pointScan = [&](int64_t id) {
+        TableScan scan(*table, id, id);
+        Batch batch;
+        uint32_t rows = 0;
+        while (scan.next(batch)) {
+            rows += batch.selectedCount;
+        }
+        return rows;
+    };
+    LeafFilters::Stats before = table->getLeafFilterStats();
+    EXPECT_EQ(pointScan(500), 1u);
+    EXPECT_EQ(pointScan(501), 0u);
+    EXPECT_EQ(pointScan(1000), 1u);
+    EXPECT_EQ(pointScan(1001), 0u);
+    EXPECT_EQ(pointScan(-1), 0u);
+    EXPECT_EQ(table->getLeafFilterStats().probes - before.probes, 4u);
+}
+
+TEST_F(LeafFilterTest, RollbackOnlyRebuildsTheRestoredLeaves) {
+    insertEvenIds(3000);
+    table.reset();
+    table = std::make_unique<Table>("leaf_filter_test.db", 16);
+
+    // splits a few leaves in the middle of the table, then undoes them
+    table->beginTransaction();
+    for (uint32_t id = 3001; id <= 3061; id += 2) {
+        table->insertRow(Row(id, "user", "user@example.com"));
+    }
+    table->savepoint();
+    table->insertRow(Row(5001, "user", "user@example.com"));
+    uint64_t readsBefore = table->getPager().getStats().pageReads;
+    table->rollbackToSavepoint();
+    EXPECT_TRUE(hasRow(3061));
+    EXPECT_FALSE(hasRow(5001));
+    table->rollbackTransaction();
+    // over 400 leaves, but the restored pages are all still cached
+    EXPECT_LT(table->getPager().getStats().pageReads - readsBefore, 10u);
+
+    for (uint32_t id = 1; id <= 6000; id++) {
+        ASSERT_EQ(hasRow(id), id % 2 == 0) << id;
+    }
+}
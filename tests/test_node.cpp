@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 #include "node.hpp"
 #include "row.hpp"
 #include <cstdio>
@@ -121,6 +123,29 @@ TEST_F(NodeTest, LeafNodeGetMaxKey) {
     EXPECT_EQ(node->getNodeMaxKey(), 15);
 }
 
+TEST_F(NodeTest, LeafNodeFindMatchesLowerBound) {
+    // dense, evenly spaced, skewed, a single cell and an empty leaf
+    std::vector<std::vector<uint32_t>> layouts = {
+        {100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112},
+        {2, 4, 6, 8, 10, 12, 14},
+        {1, 2, 3, 4, 5, 6, 1000, 4000000000u},
+        {7},
+        {}};
+    Row row(1, "test", "test@example.com");
+    for (const std::vector<uint32_t>& keys : layouts) {
+        node->initializeLeafNode();
+        for (uint32_t i = 0; i < keys.size(); i++) {
+            node->leafNodeInsert(keys[i], &row, i);
+        }
+        std::vector<uint32_t> probes = {0, 1, 3, 5, 7, 8, 50, 99, 100, 105, 112, 113, 999, 1000, 1001,
+                                        3999999999u, 4000000000u, UINT32_MAX};
+        for (uint32_t key : probes) {
+            uint32_t expected = static_cast<uint32_t>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+            EXPECT_EQ(node->leafNodeFind(key), expected) << "key " << key << " in " << keys.size() << " cells";
+        }
+    }
+}
+
 // Internal Node Tests
 
 TEST_F(NodeTest, InitializeInternalNode) {
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "table.hpp"
 #include "pager.hpp"
+#include <fstream>
 
 class PagerTest : public ::testing::Test {
 protected:
@@ -61,3 +62,183 @@ TEST_F(PagerTest, GetPageDoesNotThrowForValidPage) {
 
 
 
+TEST_F(PagerTest, RollbackRestoresBeforeImage) {
+    uint8_t* page = pager->getPageForWrite(0);
+    page[0] = 7;
+    pager->beginTransaction();
+    pager->getPageForWrite(0)[0] = 42;
+    pager->rollbackTransaction();
+    EXPECT_EQ(pager->getPage(0)[0], 7);
+    EXPECT_FALSE(pager->inTransaction());
+}
+
+TEST_F(PagerTest, RollbackDropsPagesAllocatedInTransaction) {
+    pager->getPageForWrite(0);
+    pager->beginTransaction();
+    pager->getPageForWrite(1)[0] = 1;
+    pager->getPageForWrite(2)[0] = 2;
+    EXPECT_EQ(pager->getNumPages(), 3);
+    pager->rollbackTransaction();
+    EXPECT_EQ(pager->getNumPages(), 1);
+}
+
+TEST_F(PagerTest, SavepointRollbackKeepsOuterChanges) {
+    pager->getPageForWrite(0);
+    pager->beginTransaction();
+    pager->getPageForWrite(0)[0] = 1;
+    pager->savepoint();
+    pager->getPageForWrite(0)[0] = 2;
+    pager->getPageForWrite(1)[0] = 3;
+    pager->rollbackToSavepoint();
+    EXPECT_EQ(pager->getPage(0)[0], 1);
+    EXPECT_EQ(pager->getNumPages(), 1);
+    pager->rollbackTransaction();
+    EXPECT_EQ(pager->getPage(0)[0], 0);
+}
+
+TEST_F(PagerTest, CommittedPagesSurviveCrashThroughWal) {
+    pager->beginTransaction();
+    pager->getPageForWrite(0)[0] = 11;
+    pager->getPageForWrite(1)[0] = 22;
+    pager->commitTransaction();
+    // uncommitted work after the commit must not come back
+    pager->beginTransaction();
+    pager->getPageForWrite(0)[0] = 99;
+
+    // "crash": destroy without a checkpoint, so nothing reached test.txt directly
+    pager.reset();
+    pager = std::make_unique<Pager>("test.txt");
+
+    EXPECT_EQ(pager->getNumPages(), 2);
+    EXPECT_EQ(pager->getPage(0)[0], 11);
+    EXPECT_EQ(pager->getPage(1)[0], 22);
+    std::ifstream wal("test.txt-wal");
+    EXPECT_FALSE(wal.good()) << "WAL should be removed once replayed";
+}
+
+TEST_F(PagerTest, WalIsCheckpointedOnceItGrows) {
+    const uint64_t limit = 4 * (PAGE_SIZE + 16);
+    pager->setCheckpointBytes(limit);
+    for (uint32_t i = 0; i < 20; i++) {
+        pager->beginTransaction();
+        pager->getPageForWrite(i % 3)[0] = static_cast<uint8_t>(i + 1);
+        pager->commitTransaction();
+        EXPECT_LT(pager->getWalBytes(), limit);
+    }
+    EXPECT_GE(pager->getStats().checkpoints, 4u);
+    std::ifstream wal("test.txt-wal", std::ios::ate | std::ios::binary);
+    EXPECT_LT(static_cast<uint64_t>(wal.tellg()), limit);
+    wal.close();
+
+    // crash after the checkpoints: the file plus what is left of the WAL
+    pager.reset();
+    pager = std::make_unique<Pager>("test.txt");
+    EXPECT_EQ(pager->getPage(0)[0], 19);
+    EXPECT_EQ(pager->getPage(1)[0], 20);
+    EXPECT_EQ(pager->getPage(2)[0], 18);
+}
+
+TEST_F(PagerTest, CheckpointWaitsForOpenTransaction) {
+    pager->setCheckpointBytes(1);
+    pager->beginTransaction();
+    pager->getPageForWrite(0)[0] = 5;
+    pager->checkpoint();
+    EXPECT_EQ(pager->getStats().checkpoints, 0u);
+    EXPECT_TRUE(pager->isDirty(0));
+    pager->commitTransaction();
+    EXPECT_EQ(pager->getStats().checkpoints, 1u);
+    EXPECT_FALSE(pager->isDirty(0));
+    EXPECT_EQ(pager->getWalBytes(), 0u);
+}
+
+TEST_F(PagerTest, EvictionKeepsCacheAtCapacityAndWritesDirtyVictims) {
+    pager = std::make_unique<Pager>("test.txt", 4);
+    for (uint32_t i = 0; i < 10; i++) {
+        pager->getPageForWrite(i)[0] = static_cast<uint8_t>(i + 1);
+    }
+    EXPECT_EQ(pager->getCachedCount(), 10u) << "getPage itself never evicts";
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 4u);
+    EXPECT_EQ(pager->getStats().dirtyEvictions, 6u);
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_EQ(pager->getPage(i)[0], i + 1) << "page " << i;
+    }
+    EXPECT_GT(pager->getStats().pageReads, 0u);
+}
+
+TEST_F(PagerTest, EvictionNeverDropsUncommittedPages) {
+    pager = std::make_unique<Pager>("test.txt", 2);
+    for (uint32_t i = 0; i < 4; i++) {
+        pager->getPageForWrite(i);
+    }
+    pager->beginTransaction();
+    for (uint32_t i = 0; i < 6; i++) {
+        pager->getPageForWrite(i)[0] = 50;
+    }
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 6u);
+    EXPECT_EQ(pager->getStats().pageWrites, 0u);
+    pager->rollbackTransaction();
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 2u);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ(pager->getPage(i)[0], 0);
+    }
+}
+
+TEST_F(PagerTest, EvictionResumesOnceAPinnedCacheHasSomethingToDrop) {
+    pager = std::make_unique<Pager>("test.txt", 2);
+    for (uint32_t i = 0; i < 8; i++) {
+        pager->getPageForWrite(i);
+    }
+    pager->evictToCapacity();
+    pager->beginTransaction();
+    for (uint32_t i = 0; i < 6; i++) {
+        pager->getPageForWrite(i)[0] = 60;
+    }
+    // every cached page is pinned; later calls skip the sweep
+    pager->evictToCapacity();
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 6u);
+    // a page read from the file can go again
+    pager->getPage(7);
+    EXPECT_EQ(pager->getCachedCount(), 7u);
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 6u);
+    pager->commitTransaction();
+    pager->evictToCapacity();
+    EXPECT_EQ(pager->getCachedCount(), 2u);
+    EXPECT_EQ(pager->getPage(3)[0], 60);
+}
+
+TEST_F(PagerTest, FlushColdPagesCoalescesAdjacentPages) {
+    for (uint32_t i = 0; i < 8; i++) {
+        if (i != 4) {
+            pager->getPageForWrite(i)[0] = 1;
+        }
+    }
+    pager->flushAllPages();
+    for (uint32_t i = 0; i < 8; i++) {
+        if (i != 4) {
+            pager->getPageForWrite(i)[0] = 2;
+        }
+    }
+    Pager::Stats before = pager->getStats();
+    EXPECT_EQ(pager->flushColdPages(100), 7u);
+    Pager::Stats after = pager->getStats();
+    EXPECT_EQ(after.pageWrites - before.pageWrites, 7u);
+    EXPECT_EQ(after.writeCalls - before.writeCalls, 2u) << "runs 0-3 and 5-7";
+    EXPECT_EQ(pager->getDirtyCount(), 0u);
+}
+
+TEST_F(PagerTest, FlushColdPagesSkipsTransactionPages) {
+    pager->getPageForWrite(0)[0] = 1;
+    pager->getPageForWrite(1)[0] = 1;
+    pager->beginTransaction();
+    pager->getPageForWrite(1)[0] = 2;
+    EXPECT_EQ(pager->flushColdPages(100), 1u);
+    EXPECT_TRUE(pager->isDirty(1));
+    EXPECT_FALSE(pager->isDirty(0));
+    pager->commitTransaction();
+    EXPECT_EQ(pager->flushColdPages(100), 1u);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "parallel_scan.hpp"
+#include "cursor.hpp"
+#include "database.hpp"
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
+#include "row.hpp"
+#include "table.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+class ParallelScanTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_filename = "test_parallel_scan.db";
+        std::remove(test_filename.c_str());
+        table = std::make_unique<Table>(test_filename);
+        scheduler = std::make_unique<Scheduler>(4);
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove(test_filename.c_str());
+    }
+
+    // inserted in shuffled order so splits happen all over the tree
+    void insertShuffled(uint32_t count) {
+        std::vector<uint32_t> keys(count);
+        for (uint32_t i = 0; i < count; i++) {
+            keys[i] = i * 2 + 1;
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+        for (uint32_t key : keys) {
+            table->insertRow(Row(key, "user", "user@test.com"));
+        }
+    }
+
+    struct Totals {
+        uint64_t rows = 0;
+        uint64_t keySum = 0;
+        uint32_t lastKey = 0;
+        bool ordered = true;
+    };
+
+    Totals scanAll(uint32_t targetMorsels = 0) {
+        ParallelScan scan(*table, *scheduler);
+        return scan.reduce(Totals{},
+            [](Totals& totals, uint32_t key, const void*) {
+                if (totals.rows > 0 && key <= totals.lastKey) {
+                    totals.ordered = false;
+                }
+                totals.rows++;
+                totals.keySum += key;
+                totals.lastKey = key;
+            },
+            [](Totals& into, const Totals& from) {
+                // partials arrive in key order, so ranges must not overlap
+                if (into.rows > 0 && from.rows > 0 && from.lastKey <= into.lastKey) {
+                    into.ordered = false;
+                }
+                into.ordered = into.ordered && from.ordered;
+                into.rows += from.rows;
+                into.keySum += from.keySum;
+                if (from.rows > 0) {
+                    into.lastKey = from.lastKey;
+                }
+            },
+            targetMorsels);
+    }
+
+    // Every result row of sql, one line each
+    std::vector<std::string> query(const std::string& sql) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        EXPECT_EQ(CompiledStatement::compile(sql, compiled, error), PrepareResult::PREPARE_SUCCESS) << error;
+        PreparedStatement statement(*table, compiled);
+        std::vector<std::string> rows;
+        StepResult result;
+        while ((result = statement.step()) == StepResult::ROW) {
+            std::string line;
+            for (uint32_t i = 0; i < statement.getColumnCount(); i++) {
+                const Value& value = statement.getColumn(i);
+                line += (value.isText ? std::string(value.text) : std::to_string(value.integer)) + "|";
+            }
+            rows.push_back(line);
+        }
+        EXPECT_EQ(result, StepResult::DONE) << statement.getError();
+        return rows;
+    }
+
+    std::string test_filename;
+    std::unique_ptr<Table> table;
+    std::unique_ptr<Scheduler> scheduler;
+};
+
+TEST_F(ParallelScanTest, EmptyTableScansNothing) {
+    Totals totals = scanAll();
+    EXPECT_EQ(totals.rows, 0);
+}
+
+TEST_F(ParallelScanTest, SingleLeafIsOneMorsel) {
+    insertShuffled(5);
+    ParallelScan scan(*table, *scheduler);
+    std::vector<ScanMorsel> morsels = scan.planMorsels(16);
+    ASSERT_EQ(morsels.size(), 1);
+    EXPECT_EQ(morsels[0].lowKey, 0);
+    EXPECT_EQ(morsels[0].highKey, UINT32_MAX);
+    EXPECT_EQ(scanAll().rows, 5);
+}
+
+TEST_F(ParallelScanTest, MorselsFollowSeparatorsAndCoverKeySpace) {
+    insertShuffled(2000);
+    ParallelScan scan(*table, *scheduler);
+    std::vector<ScanMorsel> morsels = scan.planMorsels(8);
+
+    Node root(table->getPageAddress(table->getRootPageNum()));
+    ASSERT_EQ(root.getNodeType(), NodeType::NODE_INTERNAL);
+    ASSERT_EQ(morsels.size(), *root.internalNodeNumKeys() + 1);
+    EXPECT_EQ(morsels.front().lowKey, 0);
+    EXPECT_EQ(morsels[0].highKey, *root.internalNodeKey(0));
+    EXPECT_EQ(morsels.back().highKey, UINT32_MAX);
+    for (size_t i = 1; i < morsels.size(); i++) {
+        EXPECT_EQ(morsels[i].lowKey, morsels[i - 1].highKey + 1);
+    }
+}
+
+TEST_F(ParallelScanTest, MatchesSerialScanOnMultiLevelTree) {
+    const uint32_t numRows = 20000;  // enough leaves to split the root internal node
+    insertShuffled(numRows);
+
+    uint64_t serialSum = 0;
+    uint64_t serialRows = 0;
+    Cursor cursor(*table);
+    while (!cursor.isEndOfTable()) {
+        serialSum += Row::deserialize(cursor.cursorSlot()).getId();
+        serialRows++;
+        cursor.cursorAdvance();
+    }
+    ASSERT_EQ(serialRows, numRows);
+
+    for (uint32_t target : {1u, 4u, 64u, 4096u}) {
+        Totals totals = scanAll(target);
+        EXPECT_EQ(totals.rows, serialRows) << "target " << target;
+        EXPECT_EQ(totals.keySum, serialSum) << "target " << target;
+        EXPECT_TRUE(totals.ordered) << "target " << target;
+    }
+}
+
+TEST_F(ParallelScanTest, AggregatesMatchTheSerialPipeline) {
+    std::vector<uint32_t> keys(3 * PARALLEL_SCAN_MIN_ROWS);
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        keys[i] = i * 3 + 1;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(9));
+    for (uint32_t key : keys) {
+        table->insertRow(Row(key, "user" + std::to_string(key % 7), "mail" + std::to_string(key % 1000)));
+    }
+    const std::vector<std::string> queries = {
+        "SELECT COUNT(*), SUM(id), MIN(email), MAX(id) FROM users",
+        "SELECT username, COUNT(*), SUM(id), MIN(id), MAX(email) FROM users WHERE id > 500 GROUP BY username",
+        "SELECT email, COUNT(*) FROM users WHERE username LIKE '%3' GROUP BY email",
+        "SELECT MIN(id) FROM users WHERE email = 'no such mail'",
+    };
+
+    std::vector<std::vector<std::string>> serial;
+    for (const std::string& sql : queries) {
+        serial.push_back(query(sql));
+    }
+    table->setScheduler(scheduler.get());
+    uint64_t tasksBefore = scheduler->getStats().tasksRun;
+    for (size_t i = 0; i < queries.size(); i++) {
+        EXPECT_EQ(query(queries[i]), serial[i]) << queries[i];
+    }
+    EXPECT_GT(scheduler->getStats().tasksRun, tasksBefore) << "aggregates should run as morsel tasks";
+    EXPECT_EQ(serial[3].size(), 0u);
+    EXPECT_EQ(serial[0][0], std::to_string(keys.size()) + "|" +
+                                std::to_string(uint64_t(keys.size()) * (keys.size() - 1) / 2 * 3 + keys.size()) +
+                                "|mail0|" + std::to_string(keys.size() * 3 - 2) + "|");
+}
+
+TEST_F(ParallelScanTest, SelectAllPrintsRowsInKeyOrder) {
+    insertShuffled(2 * PARALLEL_SCAN_MIN_ROWS);
+    std::ostringstream serial;
+    std::streambuf* saved = std::cout.rdbuf(serial.rdbuf());
+    table->execute_select_all();
+    table->setScheduler(scheduler.get());
+    uint64_t tasksBefore = scheduler->getStats().tasksRun;
+    std::ostringstream parallel;
+    std::cout.rdbuf(parallel.rdbuf());
+    table->execute_select_all();
+    std::cout.rdbuf(saved);
+
+    EXPECT_GT(scheduler->getStats().tasksRun, tasksBefore);
+    EXPECT_EQ(parallel.str(), serial.str());
+    EXPECT_EQ(parallel.str().substr(0, 28), "(1, user@test.com, user)\n(3,");
+}
+
+TEST(DatabaseTest, TableScansOnTheDatabaseScheduler) {
+    std::remove("test_parallel_database.db");
+    {
+        Database database("test_parallel_database.db");
+        EXPECT_EQ(database.getTable().getScheduler(), &database.getScheduler());
+    }
+    std::remove("test_parallel_database.db");
+}
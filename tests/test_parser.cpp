@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "arena.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+namespace {
+    const Statement* parseOk(std::string_view sql, Arena& arena) {
+        Parser parser(sql, arena);
+        const Statement* statement = nullptr;
+        EXPECT_EQ(parser.parse(statement), PrepareResult::PREPARE_SUCCESS) << std::string(sql) << ": " << parser.getError();
+        return statement;
+    }
+}
+
+TEST(LexerTest, KeywordsAreCaseInsensitive) {
+    Lexer lexer("select SeLeCt FROM users");
+    EXPECT_EQ(lexer.next().type, TokenType::KW_SELECT);
+    EXPECT_EQ(lexer.next().type, TokenType::KW_SELECT);
+    EXPECT_EQ(lexer.next().type, TokenType::KW_FROM);
+    Token name = lexer.next();
+    EXPECT_EQ(name.type, TokenType::IDENTIFIER);
+    EXPECT_EQ(name.text, "users");
+    EXPECT_EQ(lexer.next().type, TokenType::END);
+}
+
+TEST(LexerTest, OperatorsAndLiterals) {
+    Lexer lexer("a<=10 <> 'it''s' != >= \"Quoted Name\"");
+    EXPECT_EQ(lexer.next().type, TokenType::IDENTIFIER);
+    EXPECT_EQ(lexer.next().type, TokenType::LESS_EQUAL);
+    Token number = lexer.next();
+    EXPECT_EQ(number.type, TokenType::INTEGER);
+    EXPECT_EQ(number.text, "10");
+    EXPECT_EQ(lexer.next().type, TokenType::NOT_EQUAL);
+    Token text = lexer.next();
+    EXPECT_EQ(text.type, TokenType::STRING);
+    EXPECT_EQ(text.text, "it''s");
+    EXPECT_EQ(lexer.next().type, TokenType::NOT_EQUAL);
+    EXPECT_EQ(lexer.next().type, TokenType::GREATER_EQUAL);
+    Token quoted = lexer.next();
+    EXPECT_EQ(quoted.type, TokenType::IDENTIFIER);
+    EXPECT_EQ(quoted.text, "Quoted Name");
+}
+
+TEST(LexerTest, UnterminatedStringIsAnError) {
+    Lexer lexer("'abc");
+    EXPECT_EQ(lexer.next().type, TokenType::ERROR);
+}
+
+TEST(ParserTest, SelectWithAllClauses) {
+    Arena arena;
+    const Statement* statement = parseOk(
+        "SELECT id, username FROM users WHERE id > 5 AND email = 'x@y' ORDER BY username DESC, id LIMIT 10 OFFSET 2;",
+        arena);
+    ASSERT_NE(statement, nullptr);
+    ASSERT_EQ(statement->kind, StatementKind::SELECT);
+    const SelectStatement& select = *statement->select;
+    EXPECT_FALSE(select.star);
+    ASSERT_EQ(select.columns.size(), 2u);
+    EXPECT_EQ(select.columns[1]->text, "username");
+    EXPECT_EQ(select.table, "users");
+    ASSERT_NE(select.where, nullptr);
+    EXPECT_EQ(select.where->op, Operator::AND);
+    EXPECT_EQ(select.where->right->right->text, "x@y");
+    ASSERT_EQ(select.orderBy.size(), 2u);
+    EXPECT_TRUE(select.orderBy[0].descending);
+    EXPECT_FALSE(select.orderBy[1].descending);
+    EXPECT_EQ(select.limit->integer, 10);
+    EXPECT_EQ(select.offset->integer, 2);
+}
+
+TEST(ParserTest, AndBindsTighterThanOr) {
+    Arena arena;
+    const Statement* statement = parseOk("select * from users where id = 1 or id = 2 and not id = 3", arena);
+    ASSERT_NE(statement, nullptr);
+    const Expr* where = statement->select->where;
+    EXPECT_TRUE(statement->select->star);
+    EXPECT_EQ(where->op, Operator::OR);
+    EXPECT_EQ(where->right->op, Operator::AND);
+    EXPECT_EQ(where->right->right->kind, ExprKind::UNARY);
+}
+
+TEST(ParserTest, InsertWithColumnsAndSeveralRows) {
+    Arena arena;
+    const Statement* statement = parseOk(
+        "INSERT INTO users (id, email, username) VALUES (1, 'a@x', 'a'), (-2, 'b@x', 'it''s')", arena);
+    ASSERT_NE(statement, nullptr);
+    const InsertStatement& insert = *statement->insert;
+    ASSERT_EQ(insert.columns.size(), 3u);
+    EXPECT_EQ(insert.columns[1], "email");
+    ASSERT_EQ(insert.rows.size(), 2u);
+    EXPECT_EQ(insert.rows[1][0]->integer, -2);
+    EXPECT_EQ(insert.rows[1][2]->text, "it's");
+}
+
+TEST(ParserTest, UpdateDeleteAndCreate) {
+    Arena arena;
+    const Statement* update = parseOk("UPDATE users SET username = 'bob', id = id + 1 WHERE id = 4", arena);
+    ASSERT_NE(update, nullptr);
+    ASSERT_EQ(update->kind, StatementKind::UPDATE);
+    ASSERT_EQ(update->update->assignments.size(), 2u);
+    EXPECT_EQ(update->update->assignments[1].value->op, Operator::ADD);
+
+    const Statement* remove = parseOk("DELETE FROM users", arena);
+    ASSERT_NE(remove, nullptr);
+    EXPECT_EQ(remove->kind, StatementKind::DELETE);
+    EXPECT_EQ(remove->remove->where, nullptr);
+
+    const Statement* create = parseOk("CREATE TABLE t (id INT PRIMARY KEY, name TEXT(32))", arena);
+    ASSERT_NE(create, nullptr);
+    const CreateTableStatement& table = *create->createTable;
+    ASSERT_EQ(table.columns.size(), 2u);
+    EXPECT_TRUE(table.columns[0].primaryKey);
+    EXPECT_EQ(table.columns[1].typeName, "TEXT");
+    EXPECT_EQ(table.columns[1].size, 32u);
+    EXPECT_TRUE(table.primaryKey.empty());
+    const Statement* composite =
+        parseOk("CREATE TABLE events (tenant_id INT, seq BIGINT, PRIMARY KEY (tenant_id, seq))", arena);
+    ASSERT_NE(composite, nullptr);
+    ASSERT_EQ(composite->createTable->columns.size(), 2u);
+    ASSERT_EQ(composite->createTable->primaryKey.size(), 2u);
+    EXPECT_EQ(composite->createTable->primaryKey[1], "seq");
+
+    const Statement* index = parseOk("create index users_email on users(email);", arena);
+    ASSERT_NE(index, nullptr);
+    ASSERT_EQ(index->kind, StatementKind::CREATE_INDEX);
+    EXPECT_EQ(index->createIndex->name, "users_email");
+    EXPECT_EQ(index->createIndex->table, "users");
+    EXPECT_EQ(index->createIndex->column, "email");
+    const Statement* unnamed = parseOk("CREATE INDEX ON users (username)", arena);
+    ASSERT_NE(unnamed, nullptr);
+    EXPECT_TRUE(unnamed->createIndex->name.empty());
+    EXPECT_EQ(unnamed->createIndex->column, "username");
+    EXPECT_TRUE(unnamed->createIndex->include.empty());
+    const Statement* covering = parseOk("CREATE INDEX ON users (email) INCLUDE (username, id)", arena);
+    ASSERT_NE(covering, nullptr);
+    ASSERT_EQ(covering->createIndex->include.size(), 2u);
+    EXPECT_EQ(covering->createIndex->include[1], "id");
+    EXPECT_TRUE(covering->createIndex->method.empty());
+    const Statement* hash = parseOk("CREATE INDEX ON users (id) USING HASH", arena);
+    ASSERT_NE(hash, nullptr);
+    EXPECT_EQ(hash->createIndex->method, "HASH");
+}
+
+TEST(ParserTest, TransactionStatements) {
+    Arena arena;
+    EXPECT_EQ(parseOk("BEGIN TRANSACTION", arena)->kind, StatementKind::BEGIN);
+    EXPECT_EQ(parseOk("commit;", arena)->kind, StatementKind::COMMIT);
+    EXPECT_EQ(parseOk("rollback", arena)->kind, StatementKind::ROLLBACK);
+}
+
+TEST(ParserTest, ReportsSyntaxErrorsWithOffset) {
+    Arena arena;
+    Parser parser("SELECT id FROM", arena);
+    const Statement* statement = nullptr;
+    EXPECT_EQ(parser.parse(statement), PrepareResult::PREPARE_SYNTAX_ERROR);
+    EXPECT_EQ(statement, nullptr);
+    EXPECT_NE(parser.getError().find("expected table name"), std::string::npos);
+    EXPECT_NE(parser.getError().find("offset 14"), std::string::npos);
+
+    Parser trailing("DELETE FROM users extra", arena);
+    EXPECT_EQ(trailing.parse(statement), PrepareResult::PREPARE_SYNTAX_ERROR);
+}
+
+TEST(ParserTest, UnknownFirstWordIsUnrecognized) {
+    Arena arena;
+    const Statement* statement = nullptr;
+    Parser parser("frobnicate the table", arena);
+    EXPECT_EQ(parser.parse(statement), PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT);
+    Parser empty("", arena);
+    EXPECT_EQ(empty.parse(statement), PrepareResult::PREPARE_UNRECOGNIZED_STATEMENT);
+}
+
+TEST(ArenaTest, CommonStatementsStayInTheInlineBlock) {
+    Arena arena;
+    parseOk("INSERT INTO users VALUES (1, 'alice', 'alice@example.com')", arena);
+    parseOk("SELECT username FROM users WHERE id >= 10 AND id < 20 ORDER BY username LIMIT 5", arena);
+    EXPECT_EQ(arena.getHeapBlockCount(), 0u);
+}
+
+TEST(ArenaTest, LargeStatementsChainHeapBlocks) {
+    std::string sql = "INSERT INTO users VALUES ";
+    for (int i = 0; i < 2000; i++) {
+        sql += (i ? ", (" : "(") + std::to_string(i) + ", 'u', 'e')";
+    }
+    Arena arena;
+    const Statement* statement = parseOk(sql, arena);
+    ASSERT_NE(statement, nullptr);
+    EXPECT_EQ(statement->insert->rows.size(), 2000u);
+    EXPECT_EQ(statement->insert->rows[1999][0]->integer, 1999);
+    EXPECT_GT(arena.getHeapBlockCount(), 0u);
+    arena.reset();
+    EXPECT_EQ(arena.getHeapBlockCount(), 0u);
+}
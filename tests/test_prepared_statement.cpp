@@ -0,0 +1,537 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
+#include "statement_processor.hpp"
+#include "table.hpp"
+
+class PreparedStatementTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("test_prepared.db");
+        table = std::make_unique<Table>("test_prepared.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("test_prepared.db");
+    }
+
+    std::unique_ptr<PreparedStatement> prepare(const std::string& sql) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        EXPECT_EQ(CompiledStatement::compile(sql, compiled, error), PrepareResult::PREPARE_SUCCESS) << sql << ": " << error;
+        return compiled ? std::make_unique<PreparedStatement>(*table, compiled) : nullptr;
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(PreparedStatementTest, InsertRunsManyTimesWithNewBindings) {
+    auto insert = prepare("INSERT INTO users VALUES (?, ?, ?)");
+    ASSERT_EQ(insert->getParameterCount(), 3u);
+    for (int64_t id = 1; id <= 40; id++) {
+        insert->bindInteger(1, id);
+        insert->bindText(2, "user" + std::to_string(id));
+        insert->bindText(3, "mail");
+        ASSERT_EQ(insert->step(), StepResult::DONE) << insert->getError();
+        insert->reset();
+    }
+    EXPECT_STREQ(table->getRow(1).getUsername(), "user1");
+    EXPECT_STREQ(table->getRow(27).getUsername(), "user27");
+    EXPECT_STREQ(table->getRow(40).getUsername(), "user40");
+}
+
+TEST_F(PreparedStatementTest, SelectStepsOneRowAtATime) {
+    auto insert = prepare("INSERT INTO users VALUES (?, 'name', 'mail')");
+    for (int64_t id = 1; id <= 30; id++) {
+        insert->bindInteger(1, id);
+        ASSERT_EQ(insert->step(), StepResult::DONE);
+        insert->reset();
+    }
+
+    auto select = prepare("SELECT id, username FROM users WHERE id > ? LIMIT ?");
+    select->bindInteger(1, 20);
+    select->bindInteger(2, 3);
+    for (int64_t expected = 21; expected <= 23; expected++) {
+        ASSERT_EQ(select->step(), StepResult::ROW);
+        ASSERT_EQ(select->getColumnCount(), 2u);
+        EXPECT_EQ(select->getColumn(0).integer, expected);
+        EXPECT_EQ(select->getColumn(1).text, "name");
+    }
+    EXPECT_EQ(select->step(), StepResult::DONE);
+    EXPECT_EQ(select->step(), StepResult::DONE);
+
+    // rebinding after reset narrows the scan to the new range
+    select->reset();
+    select->bindInteger(1, 28);
+    ASSERT_EQ(select->step(), StepResult::ROW);
+    EXPECT_EQ(select->getColumn(0).integer, 29);
+
+    auto sorted = prepare("SELECT id FROM users WHERE id <= ? ORDER BY id DESC");
+    sorted->bindInteger(1, 2);
+    ASSERT_EQ(sorted->step(), StepResult::ROW);
+    EXPECT_EQ(sorted->getColumn(0).integer, 2);
+    ASSERT_EQ(sorted->step(), StepResult::ROW);
+    EXPECT_EQ(sorted->getColumn(0).integer, 1);
+    EXPECT_EQ(sorted->step(), StepResult::DONE);
+
+    // the sort keeps only the OFFSET + LIMIT rows it needs
+    auto page = prepare("SELECT id FROM users ORDER BY id DESC LIMIT 2 OFFSET 1");
+    ASSERT_EQ(page->step(), StepResult::ROW);
+    EXPECT_EQ(page->getColumn(0).integer, 29);
+    ASSERT_EQ(page->step(), StepResult::ROW);
+    EXPECT_EQ(page->getColumn(0).integer, 28);
+    EXPECT_EQ(page->step(), StepResult::DONE);
+}
+
+TEST_F(PreparedStatementTest, TextPredicatesMatchWithAndWithoutPushdown) {
+    auto insert = prepare("INSERT INTO users VALUES (?, ?, ?)");
+    for (int64_t id = 1; id <= 200; id++) {
+        insert->bindInteger(1, id);
+        insert->bindText(2, "user" + std::to_string(id % 7));
+        insert->bindText(3, std::to_string(id) + (id % 10 == 0 ? "@corp.com" : "@example.com"));
+        ASSERT_EQ(insert->step(), StepResult::DONE);
+        insert->reset();
+    }
+    auto countRows = [](PreparedStatement& select) {
+        int64_t rows = 0;
+        StepResult result;
+        while ((result = select.step()) == StepResult::ROW) {
+            rows++;
+        }
+        EXPECT_EQ(result, StepResult::DONE) << select.getError();
+        return rows;
+    };
+
+    // pushed into the scan: equality, suffix, prefix, contains, bound patterns
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE username = 'user3'")), 29);
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE 'user3' = username AND id > 100")), 15);
+    EXPECT_EQ(countRows(*prepare("SELECT * FROM users WHERE email LIKE '%@corp.com'")), 20);
+    EXPECT_EQ(countRows(*prepare("SELECT * FROM users WHERE email LIKE '1%' AND email LIKE '%corp%'")), 11);
+    auto bound = prepare("SELECT id FROM users WHERE username = ? AND email LIKE ?");
+    bound->bindText(1, "user0");
+    bound->bindText(2, "%0@corp.com");
+    EXPECT_EQ(countRows(*bound), 2);  // 70 and 140
+
+    // left to the evaluator: inner wildcards, non-column operands, mixed with OR
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE email LIKE '1_@%'")), 10);
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE username = 'user3' OR id = 1")), 30);
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE username LIKE 'USER%'")), 0);
+    EXPECT_EQ(countRows(*prepare("SELECT id FROM users WHERE username = '" + std::string(40, 'u') + "'")), 0);
+
+    auto typeError = prepare("SELECT id FROM users WHERE id LIKE '1%'");
+    EXPECT_EQ(typeError->step(), StepResult::ERROR);
+}
+
+TEST_F(PreparedStatementTest, AggregatesAndGroupBy) {
+    auto insert = prepare("INSERT INTO users VALUES (?, ?, ?)");
+    for (int64_t id = 1; id <= 100; id++) {
+        insert->bindInteger(1, id);
+        insert->bindText(2, "user" + std::to_string(id % 3));
+        insert->bindText(3, std::to_string(id) + "@x");
+        ASSERT_EQ(insert->step(), StepResult::DONE);
+        insert->reset();
+    }
+
+    // answered from the row counts in the tree
+    auto counts = prepare("SELECT COUNT(*), MIN(id), MAX(id) FROM users WHERE id > ? AND id <= 60");
+    counts->bindInteger(1, 10);
+    ASSERT_EQ(counts->step(), StepResult::ROW);
+    EXPECT_EQ(counts->getColumn(0).integer, 50);
+    EXPECT_EQ(counts->getColumn(1).integer, 11);
+    EXPECT_EQ(counts->getColumn(2).integer, 60);
+    EXPECT_EQ(counts->step(), StepResult::DONE);
+    counts->reset();
+    counts->bindInteger(1, 60);
+    ASSERT_EQ(counts->step(), StepResult::DONE);  // MIN of no rows: no row
+
+    auto empty = prepare("SELECT count(*) FROM users WHERE id > 1000");
+    ASSERT_EQ(empty->step(), StepResult::ROW);
+    EXPECT_EQ(empty->getColumn(0).integer, 0);
+
+    // scanned: SUM, text MIN, non-key predicates, expressions over aggregates
+    auto folded = prepare("SELECT SUM(id) * 2, MIN(email), COUNT(*) FROM users WHERE username = 'user1'");
+    ASSERT_EQ(folded->step(), StepResult::ROW);
+    EXPECT_EQ(folded->getColumn(0).integer, 2 * 1717);  // 1 + 4 + ... + 100
+    EXPECT_EQ(folded->getColumn(1).text, "100@x");
+    EXPECT_EQ(folded->getColumn(2).integer, 34);
+
+    auto grouped = prepare("SELECT username, COUNT(*), MAX(id) FROM users GROUP BY username ORDER BY username DESC");
+    const char* names[] = {"user2", "user1", "user0"};
+    const int64_t sizes[] = {33, 34, 33};
+    const int64_t maxima[] = {98, 100, 99};
+    for (int group = 0; group < 3; group++) {
+        ASSERT_EQ(grouped->step(), StepResult::ROW) << grouped->getError();
+        EXPECT_EQ(grouped->getColumn(0).text, names[group]);
+        EXPECT_EQ(grouped->getColumn(1).integer, sizes[group]);
+        EXPECT_EQ(grouped->getColumn(2).integer, maxima[group]);
+    }
+    EXPECT_EQ(grouped->step(), StepResult::DONE);
+
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("SELECT email, COUNT(*) FROM users GROUP BY username", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("SELECT * FROM users WHERE COUNT(*) > 1", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("SELECT SUM(id + 1) FROM users", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("SELECT SUM(*) FROM users", compiled, error),
+              PrepareResult::PREPARE_SYNTAX_ERROR);
+}
+
+TEST_F(PreparedStatementTest, OffsetSkipsByRank) {
+    auto insert = prepare("INSERT INTO users VALUES (?, 'name', 'mail')");
+    for (int64_t id = 1; id <= 300; id++) {
+        insert->bindInteger(1, id * 10);
+        ASSERT_EQ(insert->step(), StepResult::DONE);
+        insert->reset();
+    }
+    auto page = prepare("SELECT id FROM users WHERE id >= ? LIMIT 2 OFFSET ?");
+    page->bindInteger(1, 1000);
+    page->bindInteger(2, 150);
+    ASSERT_EQ(page->step(), StepResult::ROW);
+    EXPECT_EQ(page->getColumn(0).integer, 2500);
+    ASSERT_EQ(page->step(), StepResult::ROW);
+    EXPECT_EQ(page->getColumn(0).integer, 2510);
+    EXPECT_EQ(page->step(), StepResult::DONE);
+
+    page->reset();
+    page->bindInteger(2, 5000);
+    EXPECT_EQ(page->step(), StepResult::DONE);
+
+    // with a filter the offset counts matching rows, not keys
+    auto filtered = prepare("SELECT id FROM users WHERE id = 20 OR id >= 1000 LIMIT 1 OFFSET 1");
+    ASSERT_EQ(filtered->step(), StepResult::ROW);
+    EXPECT_EQ(filtered->getColumn(0).integer, 1000);
+}
+
+TEST_F(PreparedStatementTest, IndexedLookupsMatchScans) {
+    auto insert = prepare("INSERT INTO users VALUES (?, ?, ?)");
+    for (int64_t id = 1; id <= 300; id++) {
+        insert->bindInteger(1, id);
+        insert->bindText(2, "user" + std::to_string(id % 7));
+        insert->bindText(3, std::to_string(id % 50) + "@example.com");
+        ASSERT_EQ(insert->step(), StepResult::DONE);
+        insert->reset();
+    }
+    auto ids = [this](const std::string& sql) {
+        std::vector<int64_t> found;
+        auto select = prepare(sql);
+        StepResult result;
+        while ((result = select->step()) == StepResult::ROW) {
+            found.push_back(select->getColumn(0).integer);
+        }
+        EXPECT_EQ(result, StepResult::DONE) << select->getError();
+        return found;
+    };
+    const std::string queries[] = {
+        "SELECT id FROM users WHERE email = '7@example.com'",
+        "SELECT id FROM users WHERE email LIKE '4%' AND username = 'user3'",
+        "SELECT id FROM users WHERE username = 'user5' AND id > 100 AND id < 250",
+        "SELECT id FROM users WHERE username LIKE 'user%' AND email = '0@example.com' ORDER BY id DESC",
+        "SELECT id FROM users WHERE email = 'missing@example.com'",
+    };
+    std::vector<std::vector<int64_t>> scanned;
+    for (const std::string& query : queries) {
+        scanned.push_back(ids(query));
+    }
+    EXPECT_EQ(scanned[0].size(), 6u);
+
+    ASSERT_EQ(prepare("CREATE INDEX users_email ON users (email)")->step(), StepResult::DONE);
+    ASSERT_EQ(prepare("create index on users(username)")->step(), StepResult::DONE);
+    ASSERT_NE(table->getIndex(COLUMN_EMAIL), nullptr);
+    for (size_t i = 0; i < scanned.size(); i++) {
+        EXPECT_EQ(ids(queries[i]), scanned[i]) << queries[i];
+    }
+
+    // changes made through SQL keep the index current
+    ASSERT_EQ(prepare("UPDATE users SET email = 'moved@example.com' WHERE email = '7@example.com' AND id < 100")->step(),
+              StepResult::DONE);
+    ASSERT_EQ(prepare("DELETE FROM users WHERE email = '7@example.com'")->step(), StepResult::DONE);
+    EXPECT_TRUE(ids(queries[0]).empty());
+    EXPECT_EQ(ids("SELECT id FROM users WHERE email = 'moved@example.com'"), (std::vector<int64_t>{7, 57}));
+
+    // the same answers from an index that holds username too, so no rows are fetched
+    std::vector<std::vector<int64_t>> current;
+    for (const std::string& query : queries) {
+        current.push_back(ids(query));
+    }
+    table.reset();
+    std::remove("test_prepared.db");
+    table = std::make_unique<Table>("test_prepared.db");
+    for (int64_t id = 1; id <= 300; id++) {
+        if (id % 50 != 7) {
+            table->insertRow(Row(static_cast<uint32_t>(id), "user" + std::to_string(id % 7),
+                                 std::to_string(id % 50) + "@example.com"));
+        }
+    }
+    ASSERT_EQ(prepare("CREATE INDEX ON users (email) INCLUDE (username)")->step(), StepResult::DONE);
+    for (size_t i = 0; i < current.size(); i++) {
+        EXPECT_EQ(ids(queries[i]), current[i]) << queries[i];
+    }
+    ASSERT_EQ(prepare("UPDATE users SET username = 'changed' WHERE id = 50")->step(), StepResult::DONE);
+    auto covered = prepare("SELECT username FROM users WHERE email = '0@example.com' AND id < 120");
+    const char* expected[] = {"changed", "user2"};  // ids 50 and 100
+    for (const char* name : expected) {
+        ASSERT_EQ(covered->step(), StepResult::ROW);
+        EXPECT_EQ(covered->getColumn(0).text, name);
+    }
+    EXPECT_EQ(covered->step(), StepResult::DONE);
+
+    auto again = prepare("CREATE INDEX ON users (email)");
+    EXPECT_EQ(again->step(), StepResult::ERROR);
+    EXPECT_EQ(again->getError(), "an index on email already exists");
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (id)", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON people (email)", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (email) INCLUDE (email)", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
+
+TEST_F(PreparedStatementTest, HashIndexServesPointLookups) {
+    for (int64_t id = 1; id <= 500; id++) {
+        table->insertRow(Row(static_cast<uint32_t>(id), "user" + std::to_string(id), "e@example.com"));
+    }
+    ASSERT_EQ(prepare("CREATE INDEX ON users (id) USING HASH")->step(), StepResult::DONE);
+    ASSERT_NE(table->getHashIndex(), nullptr);
+    auto again = prepare("create index on users (id) using hash");
+    EXPECT_EQ(again->step(), StepResult::ERROR);
+    EXPECT_EQ(again->getError(), "a hash index on id already exists");
+
+    ASSERT_EQ(prepare("INSERT INTO users VALUES (501, 'new', 'n@example.com')")->step(), StepResult::DONE);
+    ASSERT_EQ(prepare("UPDATE users SET username = 'changed' WHERE id = 250")->step(), StepResult::DONE);
+    ASSERT_EQ(prepare("DELETE FROM users WHERE id = 300")->step(), StepResult::DONE);
+    auto select = prepare("SELECT username FROM users WHERE id = ?");
+    for (int64_t id : {1, 250, 300, 501, 502}) {
+        select->reset();
+        select->bindInteger(1, id);
+        if (id == 300 || id == 502) {
+            EXPECT_EQ(select->step(), StepResult::DONE) << id;
+            continue;
+        }
+        ASSERT_EQ(select->step(), StepResult::ROW) << id;
+        EXPECT_EQ(select->getColumn(0).text, id == 1 ? "user1" : id == 250 ? "changed" : "new");
+    }
+    auto range = prepare("SELECT COUNT(*) FROM users WHERE id >= 200 AND id < 400");
+    ASSERT_EQ(range->step(), StepResult::ROW);
+    EXPECT_EQ(range->getColumn(0).integer, 199);
+
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (email) USING HASH", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (id) USING btree", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(error, "unknown index method: btree");
+}
+
+TEST_F(PreparedStatementTest, ColumnarIndexAnswersLikeTheTree) {
+    for (int64_t id = 1; id <= 3000; id++) {
+        table->insertRow(Row(static_cast<uint32_t>(id), "user" + std::to_string(id % 13),
+                             std::to_string(id % 40) + "@example.com"));
+    }
+    auto rows = [this](const std::string& sql) {
+        std::vector<std::string> found;
+        auto select = prepare(sql);
+        StepResult result;
+        while ((result = select->step()) == StepResult::ROW) {
+            std::string row;
+            for (uint32_t column = 0; column < select->getColumnCount(); column++) {
+                Value value = select->getColumn(column);
+                row += (value.isText ? std::string(value.text) : std::to_string(value.integer)) + "|";
+            }
+            found.push_back(row);
+        }
+        EXPECT_EQ(result, StepResult::DONE) << select->getError();
+        return found;
+    };
+    const std::string queries[] = {
+        "SELECT id, username FROM users WHERE username = 'user4' AND id > 100 AND id < 2000",
+        "SELECT username, COUNT(*) FROM users GROUP BY username ORDER BY username",
+        "SELECT id FROM users WHERE username LIKE '%er1%' LIMIT 20 OFFSET 5",
+        "SELECT id, email FROM users WHERE email LIKE '3%'",  // email is not in the store
+    };
+    std::vector<std::vector<std::string>> scanned;
+    for (const std::string& query : queries) {
+        scanned.push_back(rows(query));
+    }
+
+    ASSERT_EQ(prepare("CREATE INDEX ON users (username) USING COLUMNAR")->step(), StepResult::DONE);
+    ASSERT_EQ(table->getColumnStoreColumns(), 1u << COLUMN_USERNAME);
+    for (size_t i = 0; i < scanned.size(); i++) {
+        EXPECT_EQ(rows(queries[i]), scanned[i]) << queries[i];
+    }
+
+    // changes made through SQL reach the store
+    ASSERT_EQ(prepare("UPDATE users SET username = 'user4' WHERE id = 3")->step(), StepResult::DONE);
+    ASSERT_EQ(prepare("DELETE FROM users WHERE username = 'user4' AND id > 1000")->step(), StepResult::DONE);
+    ASSERT_EQ(prepare("INSERT INTO users VALUES (5000, 'user4', 'x@example.com')")->step(), StepResult::DONE);
+    std::vector<std::string> expected = {"3|", "4|", "17|"};
+    std::vector<std::string> found = rows("SELECT id FROM users WHERE username = 'user4' AND id < 20");
+    EXPECT_EQ(found, expected);
+    EXPECT_EQ(rows("SELECT COUNT(*) FROM users WHERE username = 'user4'"),
+              std::vector<std::string>{"79|"});  // 77 below 1001, id 3 and id 5000
+
+    auto again = prepare("CREATE INDEX ON users (email) USING columnar INCLUDE (username)");
+    EXPECT_EQ(again->step(), StepResult::ERROR);
+    EXPECT_EQ(again->getError(), "a columnar index already exists");
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (id) USING COLUMNAR", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
+
+TEST_F(PreparedStatementTest, ZoneMapSkipsLeavesAndReportsIt) {
+    for (int64_t id = 1; id <= 2000; id++) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "n%05lld", static_cast<long long>(id));
+        table->insertRow(Row(static_cast<uint32_t>(id), name, "e@example.com"));
+    }
+    auto count = [this](const std::string& sql, PreparedStatement::Stats& stats) {
+        auto select = prepare(sql);
+        EXPECT_EQ(select->step(), StepResult::ROW) << select->getError();
+        int64_t rows = select->getColumn(0).integer;
+        stats = select->getStats();
+        return rows;
+    };
+    const std::string queries[] = {
+        "SELECT COUNT(*) FROM users WHERE username = 'n01234'",
+        "SELECT COUNT(*) FROM users WHERE username LIKE 'n017%'",
+        "SELECT COUNT(*) FROM users WHERE username >= 'n01990'",
+        "SELECT COUNT(*) FROM users WHERE 'n00010' > username AND id > 3",
+    };
+    const int64_t expected[] = {1, 100, 11, 6};
+    PreparedStatement::Stats stats;
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(count(queries[i], stats), expected[i]) << queries[i];
+        EXPECT_EQ(stats.leavesSkipped, 0u);
+    }
+    uint64_t leaves = stats.leavesRead;
+
+    ASSERT_EQ(prepare("CREATE INDEX ON users (email) USING ZONEMAP")->step(), StepResult::DONE);
+    ASSERT_NE(table->getZoneMap(), nullptr);
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(count(queries[i], stats), expected[i]) << queries[i];
+        EXPECT_GT(stats.leavesSkipped, leaves / 2) << queries[i];
+        EXPECT_LT(stats.leavesRead, leaves / 10) << queries[i];
+    }
+
+    // the counts are per execution
+    auto select = prepare("SELECT id FROM users WHERE username = ?");
+    select->bindText(1, "n00002");
+    ASSERT_EQ(select->step(), StepResult::ROW);
+    EXPECT_EQ(select->getStats().leavesRead, 1u);
+    select->reset();
+    EXPECT_EQ(select->getStats().leavesSkipped, 0u);
+
+    auto again = prepare("CREATE INDEX ON users (username) USING zonemap");
+    EXPECT_EQ(again->step(), StepResult::ERROR);
+    EXPECT_EQ(again->getError(), "a zone map already exists");
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON users (id) USING ZONEMAP", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
+
+TEST_F(PreparedStatementTest, ErrorsAreReportedThroughStep) {
+    auto insert = prepare("INSERT INTO users VALUES (?, ?, 'mail')");
+    EXPECT_THROW(insert->bindInteger(0, 1), std::out_of_range);
+    EXPECT_THROW(insert->bindInteger(3, 1), std::out_of_range);
+
+    insert->bindInteger(1, 1);
+    EXPECT_EQ(insert->step(), StepResult::ERROR);  // ?2 unbound
+    EXPECT_NE(insert->getError().find("not bound"), std::string::npos);
+
+    insert->reset();
+    insert->bindText(2, std::string(40, 'x'));
+    EXPECT_EQ(insert->step(), StepResult::ERROR);
+    EXPECT_EQ(table->getNumRows(), 0);
+
+    insert->reset();
+    insert->bindText(2, "ok");
+    EXPECT_EQ(insert->step(), StepResult::DONE);
+    insert->reset();
+    EXPECT_EQ(insert->step(), StepResult::ERROR);
+    EXPECT_EQ(insert->getError(), "Duplicate key 1");
+
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("SELECT nope FROM users", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(error, "no such column: nope");
+    EXPECT_EQ(CompiledStatement::compile("SELECT * FROM users LIMIT id", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
+
+TEST(PlanCacheTest, NormalizesWhitespaceAndCase) {
+    std::string a;
+    std::string b;
+    PlanCache::normalize("select  *\n from Users where ID = ?", a);
+    PlanCache::normalize("SELECT * FROM users WHERE id=?", b);
+    EXPECT_EQ(a, "SELECT * FROM users WHERE id = ?");
+    EXPECT_EQ(a, b);
+
+    // literals and quoted names keep their case
+    PlanCache::normalize("SELECT * FROM users WHERE username = 'Bob'", a);
+    PlanCache::normalize("SELECT * FROM users WHERE username = 'bob'", b);
+    EXPECT_NE(a, b);
+    PlanCache::normalize("SELECT \"from\" FROM users", a);
+    PlanCache::normalize("SELECT from FROM users", b);
+    EXPECT_NE(a, b);
+}
+
+TEST(PlanCacheTest, HitsShareOnePlanAndEvictLeastRecentlyUsed) {
+    PlanCache cache(2);
+    std::shared_ptr<const CompiledStatement> first;
+    std::shared_ptr<const CompiledStatement> second;
+    std::string error;
+    ASSERT_EQ(cache.lookup("SELECT * FROM users", first, error), PrepareResult::PREPARE_SUCCESS);
+    ASSERT_EQ(cache.lookup("select * from USERS", second, error), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache.getStats().hits, 1u);
+    EXPECT_EQ(cache.getStats().misses, 1u);
+
+    cache.lookup("DELETE FROM users", second, error);
+    cache.lookup("SELECT * FROM users", second, error);  // refreshes it
+    cache.lookup("UPDATE users SET id = 1", second, error);  // evicts DELETE
+    EXPECT_EQ(cache.getSize(), 2u);
+    cache.lookup("SELECT * FROM users", second, error);
+    EXPECT_EQ(first, second);
+    cache.lookup("DELETE FROM users", second, error);
+    EXPECT_EQ(cache.getStats().misses, 4u);
+
+    // failures are not cached
+    EXPECT_EQ(cache.lookup("SELECT * FROM", second, error), PrepareResult::PREPARE_SYNTAX_ERROR);
+    EXPECT_EQ(cache.getSize(), 2u);
+}
+
+TEST_F(PreparedStatementTest, ProcessorPrepareSharesThePlanCache) {
+    StatementProcessor processor(*table);
+    std::unique_ptr<PreparedStatement> insert;
+    ASSERT_EQ(processor.prepare("INSERT INTO users VALUES (?, 'a', 'b')", insert), PrepareResult::PREPARE_SUCCESS);
+    insert->bindInteger(1, 7);
+    EXPECT_EQ(insert->step(), StepResult::DONE);
+
+    // parameters cannot be supplied through execute()
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(processor.execute("INSERT INTO users VALUES (?, 'a', 'b')"), PrepareResult::PREPARE_INTERNAL_FAILURE);
+    testing::internal::GetCapturedStdout();
+
+    // inside BEGIN, a failing step only undoes its own statement
+    EXPECT_EQ(processor.execute("BEGIN"), PrepareResult::PREPARE_SUCCESS);
+    insert->reset();
+    insert->bindInteger(1, 8);
+    EXPECT_EQ(insert->step(), StepResult::DONE);
+    insert->reset();
+    EXPECT_EQ(insert->step(), StepResult::ERROR);
+    EXPECT_EQ(processor.execute("COMMIT"), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_EQ(table->getNumRows(), 2);
+}
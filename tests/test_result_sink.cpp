@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "csv_import.hpp"
+#include "meta_command_processor.hpp"
+#include "result_sink.hpp"
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+class ResultSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("export_test.db");
+        std::remove("export_test.db-wal");
+        table = std::make_unique<Table>("export_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("export_test.db");
+        std::remove("export_test.db-wal");
+        std::remove("export_test.out");
+        std::remove("export_copy.db");
+        std::remove("export_copy.db-wal");
+    }
+
+    static int openOutput() {
+        return open("export_test.out", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    static std::string readOutput() {
+        std::ifstream file("export_test.out", std::ios::binary);
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    // Exports tableName to export_test.out and returns what was written
+    std::string exportToFile(std::string_view tableName, ExportFormat format, uint64_t expectedRows) {
+        int fd = openOutput();
+        EXPECT_EQ(exportTable(*table, tableName, fd, format), expectedRows);
+        close(fd);
+        return readOutput();
+    }
+
+    static Value text(std::string_view value) {
+        return Value{true, 0, value};
+    }
+
+    static Value integer(int64_t value) {
+        return Value{false, value, {}};
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(ResultSinkTest, CsvExportImportsBackUnchanged) {
+    table->insertRow(Row(2, "a,b", "say \"hi\""));
+    table->insertRow(Row(1, "", "plain"));
+    EXPECT_EQ(exportToFile("users", ExportFormat::CSV, 2),
+              "id,username,email\n"
+              "1,,plain\n"
+              "2,\"a,b\",\"say \"\"hi\"\"\"\n");
+
+    Table copy("export_copy.db");
+    ImportResult result = importCsv(copy, "export_test.out", "users");
+    EXPECT_EQ(result.rows, 2u);
+    EXPECT_EQ(std::string(copy.getRow(2).getUsername()), "a,b");
+    EXPECT_EQ(std::string(copy.getRow(2).getEmail()), "say \"hi\"");
+}
+
+TEST_F(ResultSinkTest, CsvQuotesLineBreaks) {
+    // .import reads a record per line, so these do not import back
+    table->insertRow(Row(3, "line\nbreak", "cr\r"));
+    EXPECT_EQ(exportToFile("users", ExportFormat::CSV, 1), "id,username,email\n3,\"line\nbreak\",\"cr\r\"\n");
+}
+
+TEST_F(ResultSinkTest, TsvEscapesInsteadOfQuoting) {
+    table->insertRow(Row(7, "tab\there", "back\\slash,\"q\"\r\n"));
+    EXPECT_EQ(exportToFile("users", ExportFormat::TSV, 1),
+              "id\tusername\temail\n"
+              "7\ttab\\there\tback\\\\slash,\"q\"\\r\\n\n");
+}
+
+TEST_F(ResultSinkTest, BinaryRowsDecodeToTheSameValues) {
+    int fd = openOutput();
+    {
+        ResultSink sink(fd, ExportFormat::BINARY);
+        sink.writeHeader({"n", "s"});
+        sink.writeRow({integer(-5), text("five")});
+        sink.writeRow({integer(INT64_MAX), text("")});
+        sink.writeRow({text("swapped"), integer(0)});
+        sink.flush();
+        EXPECT_EQ(sink.getRowsWritten(), 3u);
+        EXPECT_EQ(sink.getBytesWritten(), readOutput().size());
+    }
+    close(fd);
+    std::string data = readOutput();
+    std::vector<std::vector<Value>> rows = ResultSink::decodeBinary(data);
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_FALSE(rows[0][0].isText);
+    EXPECT_EQ(rows[0][0].integer, -5);
+    EXPECT_EQ(rows[0][1].text, "five");
+    EXPECT_EQ(rows[1][0].integer, INT64_MAX);
+    EXPECT_TRUE(rows[1][1].isText);
+    EXPECT_EQ(rows[1][1].text, "");
+    EXPECT_EQ(rows[2][0].text, "swapped");
+    EXPECT_EQ(rows[2][1].integer, 0);
+
+    EXPECT_THROW(ResultSink::decodeBinary(data.substr(0, data.size() - 1)), std::invalid_argument);
+    EXPECT_THROW(ResultSink::decodeBinary("CSV!"), std::invalid_argument);
+}
+
+TEST_F(ResultSinkTest, WritesOnlySelectedRowsOfABatch) {
+    Batch batch;
+    batch.setColumnCount(2);
+    batch.columns[0].setType(false, 3);
+    batch.columns[1].setType(true, 3);
+    const char* names[] = {"a", "b", "c"};
+    for (uint32_t row = 0; row < 3; row++) {
+        batch.columns[0].integers[row] = row * 10;
+        batch.columns[1].texts[row] = names[row];
+    }
+    batch.size = 3;
+    batch.selection = {0, 2};
+    batch.selectedCount = 2;
+
+    int fd = openOutput();
+    {
+        ResultSink sink(fd, ExportFormat::CSV);
+        sink.writeBatch(batch);
+        EXPECT_EQ(sink.getRowsWritten(), 2u);
+    }
+    close(fd);
+    EXPECT_EQ(readOutput(), "0,a\n20,c\n");
+}
+
+TEST_F(ResultSinkTest, OutputLargerThanAllBlocksArrivesWhole) {
+    uint32_t numRows = 0;
+    uint64_t expectedBytes = 0;
+    std::string longText(200, 'x');
+    int fd = openOutput();
+    {
+        ResultSink sink(fd, ExportFormat::CSV);
+        // well past SINK_BLOCKS * SINK_BLOCK_BYTES, with values straddling block ends
+        while (expectedBytes < 3 * SINK_BLOCKS * SINK_BLOCK_BYTES) {
+            sink.writeRow({integer(numRows), text(longText)});
+            expectedBytes += std::to_string(numRows).size() + 1 + longText.size() + 1;
+            numRows++;
+        }
+        sink.flush();
+        EXPECT_EQ(sink.getBytesWritten(), expectedBytes);
+    }
+    close(fd);
+
+    std::string output = readOutput();
+    ASSERT_EQ(output.size(), expectedBytes);
+    std::istringstream lines(output);
+    std::string line;
+    for (uint32_t i = 0; i < numRows; i++) {
+        ASSERT_TRUE(std::getline(lines, line));
+        ASSERT_EQ(line, std::to_string(i) + "," + longText);
+    }
+}
+
+TEST_F(ResultSinkTest, ExportsCreateTableTables) {
+    table->createTable(Schema("items", {{"id", ColumnType::BIGINT, 0}, {"name", ColumnType::TEXT, 10},
+                                        {"price", ColumnType::DOUBLE, 0}}, {0}));
+    SchemaTable* items = table->getSchemaTable("items");
+    ASSERT_NE(items, nullptr);
+    std::vector<Field> row(3);
+    row[0].integer = 20;
+    row[1].bytes = "b,b";
+    row[2].real = 1.5;
+    items->insertRow(row);
+    row[0].integer = -10;
+    row[1].bytes = "a";
+    row[2].real = 2;
+    items->insertRow(row);
+
+    EXPECT_EQ(exportToFile("ITEMS", ExportFormat::CSV, 2), "id,name,price\n-10,a,2\n20,\"b,b\",1.5\n");
+    EXPECT_THROW(exportToFile("nothing", ExportFormat::CSV, 0), std::invalid_argument);
+}
+
+TEST_F(ResultSinkTest, MetaCommandExportsAFile) {
+    table->insertRow(Row(1, "one", "e1"));
+    table->insertRow(Row(2, "two", "e2"));
+    MetaCommandProcessor processor;
+    EXPECT_EQ(processor.execute(".export export_test.out users", table.get()), MetaCommandResult::META_COMMAND_SUCCESS);
+    EXPECT_EQ(readOutput(), "id,username,email\n1,one,e1\n2,two,e2\n");
+    EXPECT_EQ(processor.execute(".export export_test.out users TSV", table.get()), MetaCommandResult::META_COMMAND_SUCCESS);
+    EXPECT_EQ(readOutput(), "id\tusername\temail\n1\tone\te1\n2\ttwo\te2\n");
+    EXPECT_EQ(processor.execute(".export export_test.out users binary", table.get()),
+              MetaCommandResult::META_COMMAND_SUCCESS);
+    EXPECT_EQ(ResultSink::decodeBinary(readOutput()).size(), 2u);
+
+    EXPECT_EQ(processor.execute(".export export_test.out", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(processor.execute(".export export_test.out users xml", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(processor.execute(".export export_test.out nothing", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(processor.execute(".export no_such_dir/x.csv users", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "scheduler.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEST(SchedulerTest, ParallelForRunsEveryIndexOnce) {
+    Scheduler scheduler(4);
+    std::vector<std::atomic<int>> hits(1000);
+    scheduler.parallelFor(1000, [&](uint32_t i) { hits[i]++; });
+    for (auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(SchedulerTest, ParallelForWithZeroCountReturns) {
+    Scheduler scheduler(2);
+    scheduler.parallelFor(0, [](uint32_t) { FAIL(); });
+}
+
+TEST(SchedulerTest, SubmittedTasksRunBeforeDestruction) {
+    std::atomic<int> counter(0);
+    {
+        Scheduler scheduler(3);
+        for (int i = 0; i < 100; i++) {
+            scheduler.submit([&]() { counter++; });
+        }
+        // parallelFor from the caller also helps drain the queues
+        scheduler.parallelFor(10, [&](uint32_t) { counter++; });
+        while (counter.load() < 110) {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_EQ(counter.load(), 110);
+}
+
+TEST(SchedulerTest, NestedParallelForDoesNotDeadlock) {
+    Scheduler scheduler(2);
+    std::atomic<int> counter(0);
+    scheduler.parallelFor(4, [&](uint32_t) {
+        scheduler.parallelFor(4, [&](uint32_t) { counter++; });
+    });
+    EXPECT_EQ(counter.load(), 16);
+}
+
+TEST(SchedulerTest, ParallelForRethrowsTaskException) {
+    Scheduler scheduler(2);
+    EXPECT_THROW(scheduler.parallelFor(8, [](uint32_t i) {
+        if (i == 5) {
+            throw std::runtime_error("boom");
+        }
+    }), std::runtime_error);
+}
+
+TEST(SchedulerTest, WorkerCountRespectsCap) {
+    Scheduler scheduler(2);
+    EXPECT_GE(scheduler.getNumWorkers(), 1);
+    EXPECT_LE(scheduler.getNumWorkers(), 2);
+}
+
+TEST(SchedulerTest, MoreUrgentClassRunsFirst) {
+    Scheduler scheduler(1);
+    std::atomic<bool> release(false);
+    std::atomic<bool> blockerRunning(false);
+    std::mutex orderMutex;
+    std::vector<int> order;
+
+    // occupy the only worker while both classes get queued behind it
+    scheduler.submit([&]() {
+        blockerRunning = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!blockerRunning) {
+        std::this_thread::yield();
+    }
+    scheduler.submit([&]() { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(2); }, TaskPriority::MAINTENANCE);
+    scheduler.submit([&]() { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(1); }, TaskPriority::IO_COMPLETION);
+    scheduler.submit([&]() { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(0); }, TaskPriority::FOREGROUND_QUERY);
+    release = true;
+    scheduler.shutdown();
+
+    ASSERT_EQ(order.size(), 3);
+    EXPECT_EQ(order[0], 0);
+    EXPECT_EQ(order[1], 1);
+    EXPECT_EQ(order[2], 2);
+}
+
+TEST(SchedulerTest, YieldPointLetsForegroundWorkOvertakeMaintenance) {
+    Scheduler scheduler(1);
+    std::atomic<bool> maintenanceStarted(false);
+    std::atomic<bool> foregroundRan(false);
+    std::atomic<bool> maintenanceDone(false);
+
+    scheduler.submit([&]() {
+        maintenanceStarted = true;
+        // the only worker is busy here; the foreground task can only run via the yield
+        while (!foregroundRan) {
+            scheduler.yieldPoint();
+            std::this_thread::yield();
+        }
+        maintenanceDone = true;
+    }, TaskPriority::MAINTENANCE);
+    while (!maintenanceStarted) {
+        std::this_thread::yield();
+    }
+    scheduler.submit([&]() { foregroundRan = true; }, TaskPriority::FOREGROUND_QUERY);
+    scheduler.shutdown();
+
+    EXPECT_TRUE(foregroundRan);
+    EXPECT_TRUE(maintenanceDone);
+}
+
+TEST(SchedulerTest, ShutdownDrainsQueuedTasks) {
+    std::atomic<int> counter(0);
+    Scheduler scheduler(2);
+    for (int i = 0; i < 50; i++) {
+        scheduler.submit([&]() { counter++; }, TaskPriority::MAINTENANCE);
+    }
+    scheduler.shutdown();
+    EXPECT_EQ(counter.load(), 50);
+    EXPECT_EQ(scheduler.getStats().tasksRun, 50);
+}
+
+TEST(SchedulerTest, SubmitAfterRunsOnceDelayHasPassed) {
+    Scheduler scheduler(1);
+    std::atomic<bool> ran(false);
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int64_t> elapsedMs(0);
+    ASSERT_TRUE(scheduler.submitAfter(std::chrono::milliseconds(20), [&]() {
+        elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        ran = true;
+    }));
+    while (!ran.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(elapsedMs.load(), 20);
+}
+
+TEST(SchedulerTest, PendingTimersAreDroppedAtShutdown) {
+    Scheduler scheduler(1);
+    std::atomic<bool> ran(false);
+    scheduler.submitAfter(std::chrono::seconds(60), [&]() { ran = true; });
+    scheduler.shutdown();
+    EXPECT_FALSE(ran.load());
+    EXPECT_FALSE(scheduler.submitAfter(std::chrono::milliseconds(0), []() {}));
+}
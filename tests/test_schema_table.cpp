@@ -0,0 +1,394 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "plan_cache.hpp"
+#include "prepared_statement.hpp"
+#include "schema.hpp"
+#include "schema_table.hpp"
+#include "table.hpp"
+
+namespace {
+    Field integerField(int64_t value) {
+        Field field;
+        field.integer = value;
+        return field;
+    }
+
+    Field realField(double value) {
+        Field field;
+        field.real = value;
+        return field;
+    }
+
+    Field bytesField(std::string value) {
+        Field field;
+        field.bytes = std::move(value);
+        return field;
+    }
+
+    Schema itemsSchema() {
+        return Schema("Items", {{"id", ColumnType::BIGINT, 0}, {"name", ColumnType::TEXT, 0},
+                                {"price", ColumnType::DOUBLE, 0}, {"data", ColumnType::BLOB, 0}}, {0});
+    }
+}
+
+TEST(RowCodecTest, FixedWidthRowsRoundTripAtPlannedOffsets) {
+    Schema schema("t", {{"a", ColumnType::INT, 0}, {"b", ColumnType::TEXT, 8}, {"c", ColumnType::DOUBLE, 0}}, {0});
+    RowCodec codec(schema);
+    ASSERT_TRUE(codec.isFixedWidth());
+    EXPECT_EQ(codec.getFixedSize(), 4u + 2u + 8u + 8u);
+
+    std::string encoded;
+    codec.encode({integerField(-7), bytesField("abc"), realField(2.5)}, encoded);
+    EXPECT_EQ(encoded.size(), codec.getFixedSize()) << "short text is padded to the declared size";
+    EXPECT_EQ(codec.integerAt(encoded, 0), -7);
+    EXPECT_EQ(codec.bytesAt(encoded, 1), "abc");
+    EXPECT_EQ(codec.realAt(encoded, 2), 2.5);
+
+    EXPECT_THROW(codec.encode({integerField(1), bytesField("123456789"), realField(0)}, encoded),
+                 std::invalid_argument);
+    EXPECT_THROW(codec.encode({integerField(int64_t(1) << 40), bytesField(""), realField(0)}, encoded),
+                 std::invalid_argument);
+}
+
+TEST(RowCodecTest, VariableRowsTakeOnlyTheirBytes) {
+    Schema schema = itemsSchema();
+    RowCodec codec(schema);
+    ASSERT_FALSE(codec.isFixedWidth());
+    std::string blob("\0\1\2", 3);
+    std::vector<Field> row{integerField(INT64_MIN), bytesField("widget"), realField(-0.125), bytesField(blob)};
+    std::string encoded;
+    codec.encode(row, encoded);
+    EXPECT_EQ(encoded.size(), 8u + (2u + 6u) + 8u + (2u + 3u));
+
+    std::vector<Field> decoded;
+    codec.decode(encoded, decoded);
+    ASSERT_EQ(decoded.size(), 4u);
+    EXPECT_EQ(decoded[0].integer, INT64_MIN);
+    EXPECT_EQ(decoded[1].bytes, "widget");
+    EXPECT_EQ(decoded[2].real, -0.125);
+    EXPECT_EQ(decoded[3].bytes, blob);
+}
+
+TEST(RowCodecTest, EncodedKeysSortLikeTheirValues) {
+    std::vector<int64_t> values{INT64_MIN, -300, -1, 0, 1, 255, 256, INT64_MAX};
+    for (size_t i = 1; i < values.size(); i++) {
+        EXPECT_LT(encodeKey(integerField(values[i - 1]), ColumnType::BIGINT),
+                  encodeKey(integerField(values[i]), ColumnType::BIGINT))
+            << values[i - 1] << " < " << values[i];
+    }
+    EXPECT_EQ(encodeKey(bytesField("abc"), ColumnType::TEXT), "abc");
+}
+
+TEST(SchemaTest, RejectsBadDefinitions) {
+    EXPECT_THROW(Schema("t", {}, {0}), std::invalid_argument);
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::INT, 0}, {"A", ColumnType::INT, 0}}, {0}), std::invalid_argument);
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::DOUBLE, 0}}, {0}), std::invalid_argument);
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::TEXT, 0}}, {0}), std::invalid_argument) << "a text key needs a size";
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::INT, 0}, {"b", ColumnType::BLOB, 2000}}, {0}), std::invalid_argument);
+
+    Schema schema = itemsSchema();
+    Schema copy = Schema::deserialize(schema.getName(), schema.serialize());
+    EXPECT_EQ(copy.getName(), "items");
+    ASSERT_EQ(copy.getNumColumns(), 4u);
+    EXPECT_EQ(copy.getColumns()[2].type, ColumnType::DOUBLE);
+    EXPECT_EQ(copy.findColumn("PRICE"), 2u);
+}
+
+TEST(SchemaTest, CompositeKeysSortColumnByColumn) {
+    Schema events("events", {{"tenant", ColumnType::TEXT, 8}, {"seq", ColumnType::BIGINT, 0},
+                             {"body", ColumnType::TEXT, 0}}, {0, 1});
+    EXPECT_EQ(events.getKeyFormat(), KeyFormat::BYTES);
+    // (tenant, seq) pairs in key order: a tenant sorts before its extensions,
+    // a 0 byte included, whatever the seq
+    std::vector<std::pair<std::string, int64_t>> keys = {
+        {"", 7}, {"a", INT64_MIN}, {"a", -1}, {"a", int64_t(1) << 40}, {std::string("a\0", 2), 0},
+        {std::string("a\0\0", 3), -5}, {std::string("a\1", 2), 0}, {"ab", 0}, {"b", 0}};
+    for (size_t i = 1; i < keys.size(); i++) {
+        std::string previous = encodeKey({bytesField(keys[i - 1].first), integerField(keys[i - 1].second)}, events);
+        std::string current = encodeKey({bytesField(keys[i].first), integerField(keys[i].second)}, events);
+        EXPECT_LT(previous, current) << i;
+        // the key of the leading column is a prefix of the whole key
+        EXPECT_EQ(current.rfind(encodeKey({bytesField(keys[i].first)}, events), 0), 0u) << i;
+    }
+    Schema copy = Schema::deserialize("events", events.serialize());
+    EXPECT_EQ(copy.getPrimaryKey(), (std::vector<uint32_t>{0, 1}));
+
+    Schema pairs("p", {{"tenant", ColumnType::INT, 0}, {"seq", ColumnType::BIGINT, 0}}, {0, 1});
+    EXPECT_EQ(pairs.getKeyFormat(), KeyFormat::FIXED_16);
+    EXPECT_EQ(encodeKey({integerField(-1), integerField(5)}, pairs).size(), 16u);
+    EXPECT_LT(encodeKey({integerField(-1), integerField(INT64_MAX)}, pairs),
+              encodeKey({integerField(0), integerField(INT64_MIN)}, pairs));
+    EXPECT_EQ(Schema("s", {{"a", ColumnType::BIGINT, 0}}, {0}).getKeyFormat(), KeyFormat::FIXED_8);
+
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::INT, 0}}, {}), std::invalid_argument);
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::INT, 0}, {"b", ColumnType::INT, 0}}, {0, 0}), std::invalid_argument);
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::INT, 0}, {"b", ColumnType::DOUBLE, 0}}, {0, 1}),
+                 std::invalid_argument);
+    // a text column before another key column may take twice its size, escaped
+    EXPECT_NO_THROW(Schema("t", {{"a", ColumnType::TEXT, 120}, {"b", ColumnType::BIGINT, 0}}, {0, 1}));
+    EXPECT_THROW(Schema("t", {{"a", ColumnType::TEXT, 130}, {"b", ColumnType::BIGINT, 0}}, {0, 1}),
+                 std::invalid_argument);
+    EXPECT_NO_THROW(Schema("t", {{"a", ColumnType::BIGINT, 0}, {"b", ColumnType::TEXT, 240}}, {0, 1}));
+}
+
+class SchemaTableTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("test_schema.db");
+        std::remove("test_schema.db-wal");
+        table = std::make_unique<Table>("test_schema.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("test_schema.db");
+        std::remove("test_schema.db-wal");
+    }
+
+    std::unique_ptr<PreparedStatement> prepare(const std::string& sql) {
+        std::shared_ptr<const CompiledStatement> compiled;
+        std::string error;
+        EXPECT_EQ(CompiledStatement::compile(sql, compiled, error, table.get()), PrepareResult::PREPARE_SUCCESS)
+            << sql << ": " << error;
+        return compiled ? std::make_unique<PreparedStatement>(*table, compiled) : nullptr;
+    }
+
+    void run(const std::string& sql) {
+        auto statement = prepare(sql);
+        ASSERT_NE(statement, nullptr);
+        ASSERT_EQ(statement->step(), StepResult::DONE) << sql << ": " << statement->getError();
+    }
+
+    // Every row of a query, each column as text or a decimal integer
+    std::vector<std::vector<std::string>> query(const std::string& sql) {
+        std::vector<std::vector<std::string>> rows;
+        auto statement = prepare(sql);
+        if (statement == nullptr) {
+            return rows;
+        }
+        StepResult result;
+        while ((result = statement->step()) == StepResult::ROW) {
+            std::vector<std::string> row;
+            for (uint32_t i = 0; i < statement->getColumnCount(); i++) {
+                const Value& value = statement->getColumn(i);
+                row.push_back(value.isText ? std::string(value.text) : std::to_string(value.integer));
+            }
+            rows.push_back(row);
+        }
+        EXPECT_EQ(result, StepResult::DONE) << sql << ": " << statement->getError();
+        return rows;
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(SchemaTableTest, RowsSurviveReopeningInKeyOrder) {
+    table->createTable(itemsSchema());
+    SchemaTable* items = table->getSchemaTable("ITEMS");
+    ASSERT_NE(items, nullptr);
+    // enough rows, inserted out of order, to split the tree a few times
+    for (int64_t i = 0; i < 600; i++) {
+        int64_t id = (i * 7919) % 600 - 300;
+        items->insertRow({integerField(id), bytesField("item" + std::to_string(id)), realField(id * 0.5),
+                          bytesField(std::string(static_cast<size_t>(i % 50), 'x'))});
+    }
+    EXPECT_THROW(items->insertRow({integerField(5), bytesField(""), realField(0), bytesField("")}),
+                 std::invalid_argument);
+    EXPECT_TRUE(items->deleteRow({integerField(-300)}));
+    EXPECT_FALSE(items->deleteRow({integerField(-300)}));
+
+    table.reset();
+    table = std::make_unique<Table>("test_schema.db");
+    items = table->getSchemaTable("items");
+    ASSERT_NE(items, nullptr);
+    EXPECT_EQ(items->getNumRows(), 599u);
+    std::vector<Field> row;
+    ASSERT_TRUE(items->getRow({integerField(-17)}, row));
+    EXPECT_EQ(row[1].bytes, "item-17");
+    EXPECT_EQ(row[2].real, -8.5);
+    EXPECT_FALSE(items->getRow({integerField(-300)}, row));
+
+    int64_t previous = INT64_MIN;
+    for (IndexCursor cursor(items->getTree(), std::string_view()); !cursor.isEnd(); cursor.advance()) {
+        int64_t id = items->getCodec().integerAt(cursor.payload(), 0);
+        EXPECT_GT(id, previous);
+        previous = id;
+    }
+    EXPECT_EQ(previous, 299);
+}
+
+TEST_F(SchemaTableTest, TablesShareTheFileWithUsers) {
+    table->insertRow(Row(1, "alice", "alice@example.com"));
+    table->createTable(itemsSchema());
+    table->createTable(Schema("tags", {{"name", ColumnType::TEXT, 16}, {"uses", ColumnType::INT, 0}}, {0}));
+    EXPECT_THROW(table->createTable(itemsSchema()), std::invalid_argument);
+    EXPECT_THROW(table->createTable(Schema("users", {{"id", ColumnType::INT, 0}}, {0})), std::invalid_argument);
+    table->getSchemaTable("tags")->insertRow({bytesField("red"), integerField(3)});
+
+    table.reset();
+    table = std::make_unique<Table>("test_schema.db");
+    EXPECT_EQ(table->getTableNames(), (std::vector<std::string>{"users", "items", "tags"}));
+    EXPECT_STREQ(table->getRow(1).getUsername(), "alice");
+    std::vector<Field> row;
+    ASSERT_TRUE(table->getSchemaTable("tags")->getRow({bytesField("red")}, row));
+    EXPECT_EQ(row[1].integer, 3);
+    EXPECT_TRUE(table->getSchemaTable("tags")->getSchema().isFixedWidth());
+}
+
+TEST_F(SchemaTableTest, RollbackUndoesCreateTable) {
+    uint64_t version = table->getSchemaVersion();
+    table->beginTransaction();
+    table->createTable(itemsSchema());
+    EXPECT_NE(table->getSchemaVersion(), version);
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getSchemaTable("items"), nullptr);
+    EXPECT_EQ(table->getTableNames(), std::vector<std::string>{"users"});
+
+    table->createTable(itemsSchema());
+    uint64_t created = table->getSchemaVersion();
+    // a rollback that leaves the tables as they were keeps the handles
+    SchemaTable* items = table->getSchemaTable("items");
+    table->beginTransaction();
+    items->insertRow({integerField(1), bytesField("a"), realField(1), bytesField("")});
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getSchemaTable("items"), items);
+    EXPECT_EQ(table->getSchemaVersion(), created);
+    EXPECT_EQ(items->getNumRows(), 0u);
+}
+
+TEST_F(SchemaTableTest, SqlCreatesAndQueriesTables) {
+    run("CREATE TABLE products (sku TEXT(12) PRIMARY KEY, name TEXT, stock INT, weight DOUBLE, image BLOB)");
+    run("INSERT INTO products VALUES ('b-200', 'bolt', 500, '0.25', 'x'), ('a-100', 'anchor', 3, 12, '')");
+    run("INSERT INTO products (sku, name) VALUES ('c-300', 'cable')");
+
+    EXPECT_EQ(query("SELECT * FROM products"),
+              (std::vector<std::vector<std::string>>{{"a-100", "anchor", "3", "12", ""},
+                                                     {"b-200", "bolt", "500", "0.25", "x"},
+                                                     {"c-300", "cable", "0", "0", ""}}));
+    EXPECT_EQ(query("SELECT name FROM products WHERE sku = 'b-200'"),
+              (std::vector<std::vector<std::string>>{{"bolt"}}));
+    EXPECT_EQ(query("SELECT name, stock FROM products WHERE stock > 1 ORDER BY stock DESC LIMIT 1"),
+              (std::vector<std::vector<std::string>>{{"bolt", "500"}}));
+    EXPECT_EQ(query("SELECT COUNT(*), SUM(stock) FROM products"),
+              (std::vector<std::vector<std::string>>{{"3", "503"}}));
+
+    run("UPDATE products SET sku = 'z-999', stock = stock - 1 WHERE name = 'anchor'");
+    run("DELETE FROM products WHERE sku = 'c-300'");
+    EXPECT_EQ(query("SELECT sku, stock, weight FROM products"),
+              (std::vector<std::vector<std::string>>{{"b-200", "500", "0.25"}, {"z-999", "2", "12"}}));
+
+    auto duplicate = prepare("INSERT INTO products (sku) VALUES ('b-200')");
+    EXPECT_EQ(duplicate->step(), StepResult::ERROR);
+    auto tooLong = prepare("INSERT INTO products (sku) VALUES ('0123456789abc')");
+    EXPECT_EQ(tooLong->step(), StepResult::ERROR);
+    EXPECT_EQ(query("SELECT COUNT(*) FROM products"), (std::vector<std::vector<std::string>>{{"2"}}));
+
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("SELECT * FROM products", compiled, error),
+              PrepareResult::PREPARE_INTERNAL_FAILURE)
+        << "without the database only users is known";
+    EXPECT_EQ(CompiledStatement::compile("CREATE TABLE t (a FLOAT8)", compiled, error, table.get()),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("CREATE INDEX ON products (name)", compiled, error, table.get()),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    auto again = prepare("CREATE TABLE PRODUCTS (a INT)");
+    EXPECT_EQ(again->step(), StepResult::ERROR);
+}
+
+TEST_F(SchemaTableTest, PlansAreCompiledAgainAfterTheSchemaChanges) {
+    run("CREATE TABLE t (a INT, b TEXT)");
+    run("INSERT INTO t VALUES (1, 'one')");
+    PlanCache cache;
+    std::shared_ptr<const CompiledStatement> first;
+    std::shared_ptr<const CompiledStatement> second;
+    std::string error;
+    ASSERT_EQ(cache.lookup("SELECT * FROM t", first, error, table.get()), PrepareResult::PREPARE_SUCCESS);
+    PreparedStatement select(*table, first);
+
+    // another table, created and rolled back, changes the schema twice
+    table->beginTransaction();
+    run("CREATE TABLE u (x INT)");
+    table->rollbackTransaction();
+    ASSERT_EQ(cache.lookup("SELECT * FROM t", second, error, table.get()), PrepareResult::PREPARE_SUCCESS);
+    EXPECT_NE(first, second) << "a cached plan from an older schema is compiled again";
+    EXPECT_EQ(cache.getStats().misses, 2u);
+
+    // the prepared statement compiles itself again too
+    ASSERT_EQ(select.step(), StepResult::ROW) << select.getError();
+    EXPECT_EQ(select.getColumn(1).text, "one");
+}
+
+TEST_F(SchemaTableTest, VersionOneFilesAreRestampedByTheirFirstTable) {
+    table->insertRow(Row(1, "a", "a@example.com"));
+    table.reset();
+    uint32_t versionOne = DATABASE_FORMAT_MAGIC | DATABASE_FORMAT_MIN_VERSION;
+    {
+        std::fstream file("test_schema.db", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(ROOT_PAGE_FORMAT_OFFSET);
+        file.write(reinterpret_cast<const char*>(&versionOne), sizeof(versionOne));
+    }
+    table = std::make_unique<Table>("test_schema.db");
+    EXPECT_EQ(*reinterpret_cast<uint32_t*>(table->getPageAddress(0) + ROOT_PAGE_FORMAT_OFFSET), versionOne);
+    table->createTable(itemsSchema());
+    EXPECT_EQ(*reinterpret_cast<uint32_t*>(table->getPageAddress(0) + ROOT_PAGE_FORMAT_OFFSET), DATABASE_FORMAT_STAMP);
+    EXPECT_EQ(table->getNumRows(), 1u);
+}
+
+TEST_F(SchemaTableTest, SixtyFourBitAndCompositeKeys) {
+    run("CREATE TABLE events (tenant_id INT, seq BIGINT, kind TEXT, PRIMARY KEY (tenant_id, seq))");
+    // seq values past what 32 bits hold, inserted out of order
+    for (int64_t tenant = 3; tenant >= 1; tenant--) {
+        for (int64_t i = 0; i < 200; i++) {
+            int64_t seq = (int64_t(5) << 32) + (i * 37) % 200;
+            run("INSERT INTO events VALUES (" + std::to_string(tenant) + ", " + std::to_string(seq) + ", 'k" +
+                std::to_string(seq % 3) + "')");
+        }
+    }
+    auto duplicate = prepare("INSERT INTO events VALUES (2, 21474836480, 'again')");
+    EXPECT_EQ(duplicate->step(), StepResult::ERROR);
+    auto noSeq = prepare("INSERT INTO events (tenant_id, kind) VALUES (4, 'x')");
+    EXPECT_EQ(noSeq->step(), StepResult::ERROR);
+
+    // a tenant's rows come from a key prefix, in seq order
+    std::vector<std::vector<std::string>> tenant = query("SELECT seq FROM events WHERE tenant_id = 2");
+    ASSERT_EQ(tenant.size(), 200u);
+    for (size_t i = 0; i < tenant.size(); i++) {
+        EXPECT_EQ(tenant[i][0], std::to_string((int64_t(5) << 32) + static_cast<int64_t>(i)));
+    }
+    EXPECT_EQ(query("SELECT tenant_id, kind FROM events WHERE seq = 21474836485 AND tenant_id = 3"),
+              (std::vector<std::vector<std::string>>{{"3", "k1"}}));
+    EXPECT_EQ(query("SELECT tenant_id, seq FROM events ORDER BY tenant_id, seq LIMIT 2"),
+              (std::vector<std::vector<std::string>>{{"1", "21474836480"}, {"1", "21474836481"}}));
+    EXPECT_EQ(query("SELECT tenant_id, seq FROM events ORDER BY tenant_id DESC, seq LIMIT 1"),
+              (std::vector<std::vector<std::string>>{{"3", "21474836480"}}));
+
+    run("DELETE FROM events WHERE tenant_id = 1 AND kind = 'k0'");
+    run("UPDATE events SET tenant_id = 9 WHERE tenant_id = 3");
+    EXPECT_EQ(query("SELECT COUNT(*) FROM events WHERE tenant_id = 1"), (std::vector<std::vector<std::string>>{{"133"}}));
+    EXPECT_EQ(query("SELECT COUNT(*) FROM events WHERE tenant_id = 9"), (std::vector<std::vector<std::string>>{{"200"}}));
+
+    table.reset();
+    table = std::make_unique<Table>("test_schema.db");
+    SchemaTable* events = table->getSchemaTable("events");
+    ASSERT_NE(events, nullptr);
+    EXPECT_EQ(events->getTree().getKeyFormat(), KeyFormat::FIXED_16);
+    std::vector<Field> row;
+    ASSERT_TRUE(events->getRow({integerField(9), integerField((int64_t(5) << 32) + 7)}, row));
+    EXPECT_EQ(row[2].bytes, "k0");
+    EXPECT_FALSE(events->getRow({integerField(3), integerField((int64_t(5) << 32) + 7)}, row));
+    EXPECT_THROW(events->getRow({integerField(9)}, row), std::invalid_argument);
+
+    std::shared_ptr<const CompiledStatement> compiled;
+    std::string error;
+    EXPECT_EQ(CompiledStatement::compile("CREATE TABLE t (a INT PRIMARY KEY, b INT, PRIMARY KEY (a, b))", compiled,
+                                         error, table.get()),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+    EXPECT_EQ(CompiledStatement::compile("CREATE TABLE t (a INT, PRIMARY KEY (a, c))", compiled, error, table.get()),
+              PrepareResult::PREPARE_INTERNAL_FAILURE);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "meta_command_processor.hpp"
+#include "script_runner.hpp"
+#include "statement_processor.hpp"
+#include "table.hpp"
+
+class ScriptRunnerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("script_test.db");
+        std::remove("script_test.db-wal");
+        table = std::make_unique<Table>("script_test.db");
+        statements = std::make_unique<StatementProcessor>(*table);
+    }
+
+    void TearDown() override {
+        statements.reset();
+        table.reset();
+        std::remove("script_test.db");
+        std::remove("script_test.db-wal");
+        std::remove("script_test.sql");
+        std::remove("script_inner.sql");
+    }
+
+    static void writeFile(const std::string& path, const std::string& text) {
+        std::ofstream(path, std::ios::binary) << text;
+    }
+
+    // Runs script_test.sql, returning what it printed in output
+    ScriptResult run(std::string& output) {
+        testing::internal::CaptureStdout();
+        ScriptResult result = runScript(*table, *statements, metaCommands, "script_test.sql");
+        output = testing::internal::GetCapturedStdout();
+        return result;
+    }
+
+    std::unique_ptr<Table> table;
+    std::unique_ptr<StatementProcessor> statements;
+    MetaCommandProcessor metaCommands;
+};
+
+TEST_F(ScriptRunnerTest, RunsEveryLineSilentlyInOneTransaction) {
+    writeFile("script_test.sql",
+              "-- setup\n"
+              "insert 1 ada ada@example.com\r\n"
+              "\n"
+              "   INSERT INTO users VALUES (2, 'bob', 'bob@example.com');  \n"
+              "insert_multiple 3 10 u e\n"
+              "UPDATE users SET email = 'new' WHERE id = 1\n"
+              "SELECT username FROM users WHERE id = 1\n"
+              "DELETE FROM users WHERE id = 11");
+    std::string output;
+    ScriptResult result = run(output);
+    EXPECT_EQ(result.statements, 6u);
+    EXPECT_EQ(result.errors, 0u);
+    EXPECT_FALSE(result.exitRequested);
+    // only the SELECT's row: no "Table:" line per legacy insert
+    EXPECT_EQ(output, "(ada)\n");
+    EXPECT_EQ(table->getNumRows(), 4u);
+    EXPECT_EQ(std::string(table->getRow(1).getEmail()), "new");
+    EXPECT_FALSE(table->inTransaction());
+    EXPECT_FALSE(statements->isQuiet());
+
+    // the script is already a transaction, so it cannot open another
+    writeFile("script_test.sql", "BEGIN\n");
+    EXPECT_EQ(run(output).errors, 1u);
+}
+
+TEST_F(ScriptRunnerTest, ReportsFailuresWithTheirLineAndCarriesOn) {
+    writeFile("script_test.sql",
+              "INSERT INTO users VALUES (1, 'a', 'a')\n"
+              "INSERT INTO users VALUES (1, 'dup', 'x'), (2, 'b', 'b')\n"
+              "bogus statement\n"
+              "SELECT nothing FROM users\n"
+              ".nothing\n"
+              "INSERT INTO users VALUES (3, 'c', 'c')\n");
+    std::string output;
+    ScriptResult result = run(output);
+    EXPECT_EQ(result.statements, 6u);
+    EXPECT_EQ(result.errors, 4u);
+    EXPECT_NE(output.find("at script_test.sql:2\n"), std::string::npos) << output;
+    EXPECT_NE(output.find("Unrecognized keyword at start of 'bogus statement'.\n  at script_test.sql:3\n"),
+              std::string::npos) << output;
+    EXPECT_NE(output.find("at script_test.sql:4\n"), std::string::npos) << output;
+    EXPECT_NE(output.find("Unrecognized command at start of '.nothing'.\n  at script_test.sql:5\n"),
+              std::string::npos) << output;
+    // the failed multi-row insert left nothing behind; the rest committed
+    EXPECT_EQ(table->getNumRows(), 2u);
+    uint32_t leafPageNum = 0;
+    uint32_t cellNum = 0;
+    EXPECT_FALSE(table->findRow(2, leafPageNum, cellNum));
+
+    EXPECT_THROW(runScript(*table, *statements, metaCommands, "no_such_script.sql"), std::runtime_error);
+    EXPECT_FALSE(table->inTransaction());
+}
+
+TEST_F(ScriptRunnerTest, StaysInsideAnOpenTransaction) {
+    writeFile("script_test.sql", "insert 1 a b\ninsert 2 c d\n");
+    table->beginTransaction();
+    std::string output;
+    EXPECT_EQ(run(output).errors, 0u);
+    EXPECT_TRUE(table->inTransaction());
+    EXPECT_EQ(table->getNumRows(), 2u);
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getNumRows(), 0u);
+}
+
+TEST_F(ScriptRunnerTest, ReadMetaCommandNestsAndStopsAtExit) {
+    writeFile("script_inner.sql", "insert 2 b b\n.exit\ninsert 3 c c\n");
+    writeFile("script_test.sql", "insert 1 a a\n.read script_inner.sql\ninsert 4 d d\n");
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(metaCommands.execute(".read script_test.sql", table.get()), MetaCommandResult::META_COMMAND_EXIT);
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("Ran 2 statements (0 errors)"), std::string::npos) << output;
+    EXPECT_EQ(table->getNumRows(), 2u);
+    EXPECT_FALSE(table->inTransaction());
+
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(metaCommands.execute(".read", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    EXPECT_EQ(metaCommands.execute(".read no_such_script.sql", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    writeFile("script_test.sql", "insert 1 again a\n");
+    EXPECT_EQ(metaCommands.execute(".read script_test.sql", table.get()), MetaCommandResult::META_COMMAND_FAILURE);
+    testing::internal::GetCapturedStdout();
+}
@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "index_node.hpp"
+#include "secondary_index.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+namespace {
+    // Ids of the entries whose key equals key, in index order
+    std::vector<uint32_t> lookup(const SecondaryIndex& index, const std::string& key) {
+        std::vector<uint32_t> ids;
+        for (IndexCursor cursor(index, key); !cursor.isEnd() && cursor.key() == key; cursor.advance()) {
+            ids.push_back(cursor.id());
+        }
+        return ids;
+    }
+
+    // Long enough that a few hundred entries split leaves and internal nodes
+    std::string emailFor(uint32_t group) {
+        return "user" + std::to_string(group) + "@" + std::string(120, 'x') + ".example.com";
+    }
+}
+
+class SecondaryIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        table = std::make_unique<Table>("index_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("index_test.db");
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST(IndexNodeTest, CellsStayOrderedAndHolesAreReused) {
+    std::vector<uint8_t> page(PAGE_SIZE);
+    IndexNode node(page.data());
+    node.initialize(true);
+    std::string key(100, 'k');
+    uint32_t count = 0;
+    while (node.insertCell(count, key, 2 * count)) {
+        count++;
+    }
+    uint32_t perCell = IndexNode::cellSize(true, 100) + INDEX_NODE_SLOT_SIZE;
+    EXPECT_EQ(count, (PAGE_SIZE - INDEX_NODE_HEADER_SIZE) / perCell);
+    EXPECT_LT(node.freeSpace(), perCell);
+
+    node.removeCell(0);  // id 0
+    node.removeCell(5);  // id 12
+    // the holes left by the removed cells make room once compacted
+    ASSERT_EQ(node.lowerBound(key, 1), 0u);
+    ASSERT_TRUE(node.insertCell(0, key, 1));
+    ASSERT_TRUE(node.insertCell(node.numCells(), "short", 7));
+    EXPECT_EQ(node.numCells(), count);
+    EXPECT_EQ(node.id(0), 1u);
+    EXPECT_EQ(node.id(1), 2u);
+    EXPECT_EQ(node.key(node.numCells() - 1), "short");
+    EXPECT_EQ(node.lowerBound(key, 3), 2u);
+    EXPECT_EQ(node.lowerBound(key, 12), 6u);
+    EXPECT_EQ(node.lowerBound("short", 0), node.numCells() - 1);
+}
+
+TEST(IndexNodeTest, InternalNodesStoreTheSharedPrefixOnce) {
+    std::vector<uint8_t> page(PAGE_SIZE);
+    IndexNode node(page.data());
+    node.initialize(false, "user1");
+    ASSERT_TRUE(node.insertCell(0, "user12", 0, 10));
+    ASSERT_TRUE(node.insertCell(1, "user15", 0, 11));
+    ASSERT_TRUE(node.insertCell(2, "user19", 4, 12));
+    EXPECT_EQ(node.prefix(), "user1");
+    EXPECT_EQ(node.key(1), "5");
+    EXPECT_EQ(node.lowerBound("user0", 0), 0u);      // before the prefix
+    EXPECT_EQ(node.lowerBound("user", 0), 0u);       // a prefix of the prefix
+    EXPECT_EQ(node.lowerBound("user13xyz", 0), 1u);
+    EXPECT_EQ(node.lowerBound("user19", 5), 3u);
+    EXPECT_EQ(node.lowerBound("user2", 0), 3u);      // after the prefix
+
+    // a key outside the prefix shortens it, rewriting the cells
+    uint32_t freeBefore = node.freeSpace();
+    ASSERT_TRUE(node.insertCell(0, "user", 9, 13));
+    EXPECT_EQ(node.prefix(), "user");
+    EXPECT_EQ(node.key(0), "");
+    EXPECT_EQ(node.key(2), "15");
+    EXPECT_EQ(node.child(3), 12u);
+    EXPECT_EQ(node.lowerBound("user13", 0), 2u);
+    // three keys a byte longer, the padded prefix two bytes shorter
+    EXPECT_EQ(freeBefore - node.freeSpace(), IndexNode::cellSize(false, 0) + INDEX_NODE_SLOT_SIZE + 3 - 2);
+
+    // when the longer keys would not fit, nothing changes
+    std::string longKey(24, 'u');
+    uint32_t count = node.numCells();
+    while (node.insertCell(count, "user9" + longKey + std::to_string(count), 0, count)) {
+        count++;
+    }
+    ASSERT_GT(node.freeSpace(), IndexNode::cellSize(false, 1) + INDEX_NODE_SLOT_SIZE);
+    EXPECT_FALSE(node.insertCell(0, "a", 0, 99));
+    EXPECT_EQ(node.prefix(), "user");
+    EXPECT_EQ(node.numCells(), count);
+}
+
+TEST_F(SecondaryIndexTest, LookupsFindEveryRowAfterSplits) {
+    table->createIndex(COLUMN_EMAIL);
+    std::vector<uint32_t> ids;
+    for (uint32_t id = 1; id <= 3000; id++) {
+        ids.push_back(id);
+    }
+    std::mt19937 generator(11);
+    std::shuffle(ids.begin(), ids.end(), generator);
+    for (uint32_t id : ids) {
+        table->insertRow(Row(id, "user", emailFor(id % 100)));
+    }
+
+    const SecondaryIndex* index = table->getIndex(COLUMN_EMAIL);
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(table->getIndex(COLUMN_USERNAME), nullptr);
+    // the root is now an internal node over several levels of splits
+    EXPECT_FALSE(IndexNode(table->getPageAddress(index->getRootPageNum())).isLeaf());
+    for (uint32_t group : {0u, 7u, 99u}) {
+        std::vector<uint32_t> found = lookup(*index, emailFor(group));
+        ASSERT_EQ(found.size(), 30u);
+        for (uint32_t i = 0; i < found.size(); i++) {
+            EXPECT_EQ(found[i], group + 100 * i + (group == 0 ? 100 : 0));
+        }
+    }
+    EXPECT_TRUE(lookup(*index, emailFor(100)).empty());
+
+    // a full walk visits every entry in order
+    uint32_t entries = 0;
+    std::string previous;
+    for (IndexCursor cursor(*index, ""); !cursor.isEnd(); cursor.advance()) {
+        EXPECT_LE(previous, cursor.key());
+        previous = std::string(cursor.key());
+        entries++;
+    }
+    EXPECT_EQ(entries, 3000u);
+}
+
+TEST_F(SecondaryIndexTest, BuildsFromExistingRowsAndFollowsChanges) {
+    for (uint32_t id = 1; id <= 200; id++) {
+        table->insertRow(Row(id, "name" + std::to_string(id % 10), "e" + std::to_string(id) + "@example.com"));
+    }
+    table->createIndex(COLUMN_USERNAME);
+    EXPECT_THROW(table->createIndex(COLUMN_USERNAME), std::invalid_argument);
+    EXPECT_THROW(table->createIndex(COLUMN_ID), std::invalid_argument);
+    const SecondaryIndex* index = table->getIndex(COLUMN_USERNAME);
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(lookup(*index, "name3").size(), 20u);
+
+    table->updateRow(Row(3, "renamed", "e3@example.com"));
+    table->updateRow(Row(13, "name3", "changed@example.com"));  // value unchanged
+    EXPECT_TRUE(table->deleteRow(23));
+    EXPECT_EQ(lookup(*index, "name3").size(), 18u);
+    EXPECT_EQ(lookup(*index, "renamed"), std::vector<uint32_t>{3});
+    // a rejected duplicate leaves the index alone
+    EXPECT_THROW(table->insertRow(Row(5, "dup", "d@example.com")), std::invalid_argument);
+    EXPECT_TRUE(lookup(*index, "dup").empty());
+}
+
+TEST_F(SecondaryIndexTest, IncludedColumnsFollowUpdates) {
+    table->createIndex(COLUMN_EMAIL, 1u << COLUMN_USERNAME);
+    // enough rows in key order to fill the table's root, whose last bytes hold the catalog
+    for (uint32_t id = 1; id <= 2500; id++) {
+        table->insertRow(Row(id, "name" + std::to_string(id), "e" + std::to_string(id % 5) + "@example.com"));
+    }
+    EXPECT_THROW(table->createIndex(COLUMN_USERNAME, 1u << COLUMN_USERNAME), std::invalid_argument);
+    table->updateRow(Row(12, "renamed", "e2@example.com"));
+
+    auto namesFor = [this](const std::string& email) {
+        const SecondaryIndex& index = *table->getIndex(COLUMN_EMAIL);
+        std::vector<std::string> names;
+        for (IndexCursor cursor(index, email); !cursor.isEnd() && cursor.key() == email; cursor.advance()) {
+            names.emplace_back(index.includedValue(cursor.payload(), COLUMN_USERNAME));
+        }
+        return names;
+    };
+    std::vector<std::string> names = namesFor("e2@example.com");
+    ASSERT_EQ(names.size(), 500u);
+    EXPECT_EQ(names[0], "name2");
+    EXPECT_EQ(names[1], "name7");
+    EXPECT_EQ(names[2], "renamed");
+
+    // the included columns are part of the catalog
+    table.reset();
+    table = std::make_unique<Table>("index_test.db");
+    EXPECT_EQ(table->getIndex(COLUMN_EMAIL)->getIncludedColumns(), 1u << COLUMN_USERNAME);
+    EXPECT_EQ(namesFor("e2@example.com"), names);
+}
+
+TEST_F(SecondaryIndexTest, PersistsAndRollsBack) {
+    table->createIndex(COLUMN_EMAIL);
+    for (uint32_t id = 1; id <= 500; id++) {
+        table->insertRow(Row(id, "user", emailFor(id % 50)));
+    }
+    table.reset();
+    table = std::make_unique<Table>("index_test.db");
+    ASSERT_NE(table->getIndex(COLUMN_EMAIL), nullptr);
+    EXPECT_EQ(lookup(*table->getIndex(COLUMN_EMAIL), emailFor(4)).size(), 10u);
+
+    table->beginTransaction();
+    table->createIndex(COLUMN_USERNAME);
+    table->insertRow(Row(1000, "user", emailFor(4)));
+    EXPECT_EQ(lookup(*table->getIndex(COLUMN_EMAIL), emailFor(4)).size(), 11u);
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getIndex(COLUMN_USERNAME), nullptr);
+    ASSERT_NE(table->getIndex(COLUMN_EMAIL), nullptr);
+    EXPECT_EQ(lookup(*table->getIndex(COLUMN_EMAIL), emailFor(4)).size(), 10u);
+}
+
+TEST_F(SecondaryIndexTest, SeparatorsAreCutShort) {
+    table->createIndex(COLUMN_EMAIL);
+    std::vector<uint32_t> ids;
+    for (uint32_t id = 1; id <= 3000; id++) {
+        ids.push_back(id);
+    }
+    std::mt19937 generator(7);
+    std::shuffle(ids.begin(), ids.end(), generator);
+    for (uint32_t id : ids) {
+        table->insertRow(Row(id, "user", emailFor(id)));
+    }
+
+    // separators need a few bytes of the 140-byte emails, so one internal
+    // level covers every leaf
+    const SecondaryIndex& index = *table->getIndex(COLUMN_EMAIL);
+    IndexNode root(table->getPageAddress(index.getRootPageNum()));
+    ASSERT_FALSE(root.isLeaf());
+    EXPECT_GT(root.numCells(), 60u);
+    for (uint32_t i = 0; i <= root.numCells(); i++) {
+        EXPECT_TRUE(IndexNode(table->getPageAddress(root.childAt(i))).isLeaf());
+    }
+    EXPECT_EQ(root.prefix(), "user");
+    for (uint32_t i = 0; i < root.numCells(); i++) {
+        EXPECT_LE(root.key(i).size(), 4u);
+    }
+
+    for (uint32_t id = 1; id <= 3000; id++) {
+        ASSERT_EQ(lookup(index, emailFor(id)), std::vector<uint32_t>{id}) << id;
+    }
+    EXPECT_TRUE(lookup(index, "user1").empty());
+    EXPECT_TRUE(lookup(index, emailFor(3001)).empty());
+    EXPECT_TRUE(table->deleteRow(1234));
+    EXPECT_TRUE(lookup(index, emailFor(1234)).empty());
+}
+
+TEST_F(SecondaryIndexTest, KeysOutsideALongPrefixStillSplitCleanly) {
+    // one value for every row: the separators are all that value, so the
+    // internal node stores it once as its prefix and holds over a hundred cells
+    table->createIndex(COLUMN_EMAIL);
+    std::string same = "m" + std::string(100, 'x');
+    for (uint32_t id = 1; id <= 3000; id++) {
+        table->insertRow(Row(id, "user", same));
+    }
+    const SecondaryIndex& index = *table->getIndex(COLUMN_EMAIL);
+    IndexNode root(table->getPageAddress(index.getRootPageNum()));
+    ASSERT_EQ(root.prefix(), same);
+    ASSERT_GT(root.numCells(), 100u);
+
+    // these sort after it and split the last leaf a few times; their
+    // separators share nothing with the prefix, so every key in the node
+    // would grow by 100 bytes
+    for (uint32_t id = 3001; id <= 3200; id++) {
+        table->insertRow(Row(id, "user", emailFor(id % 2 ? 0 : 1) + "." + std::to_string(id % 10)));
+    }
+    EXPECT_EQ(lookup(index, same).size(), 3000u);
+    EXPECT_EQ(lookup(index, emailFor(0) + ".3").size(), 20u);
+    EXPECT_EQ(lookup(index, emailFor(1) + ".8").size(), 20u);
+    uint32_t entries = 0;
+    for (IndexCursor cursor(index, ""); !cursor.isEnd(); cursor.advance()) {
+        entries++;
+    }
+    EXPECT_EQ(entries, 3200u);
+}
+
+TEST(KeyFormatTest, FixedProbesCompareLikeBytes) {
+    // rests of every length a fixed-width internal node may hold, each
+    // followed by 8 bytes of cell, as in a page
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<int> byte(0, 3);  // few values, so keys often share bytes
+    for (uint32_t length = 1; length <= 16; length++) {
+        for (uint32_t trial = 0; trial < 200; trial++) {
+            std::string a(length + 8, '\xff');
+            std::string b(length, '\0');
+            for (uint32_t i = 0; i < length; i++) {
+                a[i] = static_cast<char>(byte(generator) * 85);
+                b[i] = static_cast<char>(byte(generator) * 85);
+            }
+            std::string_view nodeKey(a.data(), length);
+            int expected = ByteKeys::Probe(b).compare(nodeKey);
+            int fixed = Fixed16Keys::Probe(b).compare(nodeKey);
+            ASSERT_EQ((fixed > 0) - (fixed < 0), (expected > 0) - (expected < 0)) << length;
+            if (length <= 8) {
+                int narrow = Fixed8Keys::Probe(b).compare(nodeKey);
+                ASSERT_EQ((narrow > 0) - (narrow < 0), (expected > 0) - (expected < 0)) << length;
+            }
+        }
+    }
+    // a search key of another length, such as the empty one a full scan starts from
+    EXPECT_GT(Fixed8Keys::Probe("").compare("\x01\x02\x03\x04\x05\x06\x07\x08"), 0);
+}
+
+TEST_F(SecondaryIndexTest, FixedWidthTreesSplitUnderWholeKeys) {
+    for (KeyFormat format : {KeyFormat::FIXED_8, KeyFormat::FIXED_16}) {
+        uint32_t width = format == KeyFormat::FIXED_8 ? 8 : 16;
+        uint32_t rootPageNum = table->getUnusedPageNum();
+        SecondaryIndex::initializeRoot(*table, rootPageNum);
+        SecondaryIndex tree(*table, INDEX_NO_COLUMN, rootPageNum, 0, format);
+        // big-endian numbers, so byte order is number order; the high bytes
+        // repeat and give internal nodes a prefix
+        auto keyOf = [width](uint64_t value) {
+            std::string key(width, '\0');
+            for (uint32_t i = 0; i < 8; i++) {
+                key[width - 1 - i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+            return key;
+        };
+        std::vector<uint64_t> values;
+        for (uint64_t i = 0; i < 5000; i++) {
+            values.push_back(i * 2654435761u);
+        }
+        std::vector<uint64_t> shuffled = values;
+        std::mt19937 generator(5);
+        std::shuffle(shuffled.begin(), shuffled.end(), generator);
+        for (uint64_t value : shuffled) {
+            tree.insert(keyOf(value), 0, "row");
+        }
+
+        IndexNode root(table->getPageAddress(rootPageNum));
+        ASSERT_FALSE(root.isLeaf());
+        for (uint32_t i = 0; i < root.numCells(); i++) {
+            EXPECT_EQ(root.prefix().size() + root.key(i).size(), width) << "separators are whole keys";
+        }
+        std::sort(values.begin(), values.end());
+        size_t next = 0;
+        for (IndexCursor cursor(tree, ""); !cursor.isEnd(); cursor.advance()) {
+            ASSERT_EQ(cursor.key(), keyOf(values[next++]));
+        }
+        EXPECT_EQ(next, values.size());
+        for (uint64_t value : values) {
+            ASSERT_EQ(lookup(tree, keyOf(value)).size(), 1u) << value;
+            ASSERT_TRUE(lookup(tree, keyOf(value + 1)).empty()) << value;
+        }
+        EXPECT_TRUE(tree.remove(keyOf(values[17]), 0));
+        EXPECT_TRUE(lookup(tree, keyOf(values[17])).empty());
+    }
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+#include "sql_liter.hpp"
+
+class SqlLiterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        removeFiles();
+    }
+
+    void TearDown() override {
+        setLogLevel(LogLevel::OFF);
+        setLogSink(nullptr);
+        removeFiles();
+    }
+
+    static void removeFiles() {
+        std::remove("api_test.db");
+        std::remove("api_test.db-wal");
+    }
+
+    static Value text(std::string_view value) {
+        return Value{true, 0, value};
+    }
+
+    static Value integer(int64_t value) {
+        return Value{false, value, {}};
+    }
+};
+
+TEST_F(SqlLiterTest, PreparesBindsAndStepsWithoutPrinting) {
+    testing::internal::CaptureStdout();
+    testing::internal::CaptureStderr();
+    {
+        Connection db("api_test.db");
+        db.execute("INSERT INTO users VALUES (1, 'ada', 'ada@example.com')");
+        db.execute("INSERT INTO users VALUES (2, 'bob', 'bob@example.com')");
+        db.execute("INSERT INTO users VALUES (3, 'cy', 'cy@example.com')");
+
+        Query query = db.prepare("SELECT id, username FROM users WHERE id >= ?");
+        query.bind(1, int64_t{2});
+        ASSERT_TRUE(query.step());
+        EXPECT_EQ(query.getColumnCount(), 2u);
+        EXPECT_FALSE(query.columnIsText(0));
+        EXPECT_EQ(query.columnInteger(0), 2);
+        EXPECT_TRUE(query.columnIsText(1));
+        EXPECT_EQ(query.columnText(1), "bob");
+        ASSERT_TRUE(query.step());
+        EXPECT_EQ(query.columnText(1), "cy");
+        EXPECT_FALSE(query.step());
+        EXPECT_FALSE(query.step());
+
+        // bindings survive reset()
+        query.reset();
+        std::vector<std::string> names;
+        for (const Query& row : query) {
+            names.emplace_back(row.columnText(1));
+        }
+        EXPECT_EQ(names, (std::vector<std::string>{"bob", "cy"}));
+        EXPECT_EQ(db.execute("SELECT * FROM users"), 3u);
+
+        // failures are exceptions, not output
+        EXPECT_THROW(db.execute("INSERT INTO users VALUES (1, 'again', 'x')"), ExecutionError);
+        EXPECT_THROW(db.prepare("SELEC * FROM users"), std::invalid_argument);
+        EXPECT_THROW(db.prepare("SELECT * FROM users WHERE"), std::invalid_argument);
+        EXPECT_THROW(db.prepare("SELECT nothing FROM users"), std::invalid_argument);
+        EXPECT_THROW(query.bind(2, "x"), std::out_of_range);
+    }
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+}
+
+TEST_F(SqlLiterTest, InsertBatchIsAllOrNothing) {
+    Connection db("api_test.db");
+    db.execute("CREATE TABLE items (id BIGINT PRIMARY KEY, name TEXT(8))");
+    std::vector<std::vector<Value>> rows;
+    std::vector<std::string> names;
+    for (int64_t id = 0; id < 500; id++) {
+        names.push_back("item" + std::to_string(id));
+    }
+    for (int64_t id = 0; id < 500; id++) {
+        rows.push_back({integer(id * 7 % 500), text(names[id])});
+    }
+    EXPECT_EQ(db.insertBatch("INSERT INTO items VALUES (?, ?)", rows), 500u);
+    EXPECT_FALSE(db.getDatabase().getTable().inTransaction());
+
+    Query count = db.prepare("SELECT COUNT(*) FROM items");
+    ASSERT_TRUE(count.step());
+    EXPECT_EQ(count.columnInteger(0), 500);
+
+    // a duplicate in the middle undoes the rows before it
+    std::vector<std::vector<Value>> clash = {{integer(1000), text("a")}, {integer(7), text("b")}};
+    EXPECT_THROW(db.insertBatch("INSERT INTO items VALUES (?, ?)", clash), ExecutionError);
+    std::vector<std::vector<Value>> narrow = {{integer(1001)}};
+    EXPECT_THROW(db.insertBatch("INSERT INTO items VALUES (?, ?)", narrow), std::invalid_argument);
+    EXPECT_THROW(db.insertBatch("SELECT * FROM items WHERE id = ?", narrow), std::invalid_argument);
+    count.reset();
+    ASSERT_TRUE(count.step());
+    EXPECT_EQ(count.columnInteger(0), 500);
+
+    // inside BEGIN it is a savepoint, undone with the transaction
+    db.execute("BEGIN");
+    db.insertBatch("INSERT INTO items (id, name) VALUES (?, ?)", {{integer(2000), text("x")}});
+    db.execute("ROLLBACK");
+    count.reset();
+    ASSERT_TRUE(count.step());
+    EXPECT_EQ(count.columnInteger(0), 500);
+}
+
+TEST_F(SqlLiterTest, CloseKeepsTheDataAndEndsTheConnection) {
+    {
+        Connection db("api_test.db");
+        db.insertBatch("INSERT INTO users VALUES (?, ?, ?)",
+                       {{integer(5), text("five"), text("5@x")}, {integer(4), text("four"), text("4@x")}});
+        db.close();
+        EXPECT_FALSE(db.isOpen());
+        EXPECT_THROW(db.prepare("SELECT * FROM users"), std::logic_error);
+        db.close();
+    }
+    Connection db("api_test.db");
+    Query query = db.prepare("SELECT username FROM users");
+    ASSERT_TRUE(query.step());
+    EXPECT_EQ(query.columnText(0), "four");
+}
+
+TEST_F(SqlLiterTest, OpenFailuresThrowAndLogOnlyWhenAsked) {
+    EXPECT_THROW(Connection("no_such_dir/api_test.db"), std::runtime_error);
+
+    std::ofstream("api_test.db", std::ios::binary) << std::string(100, 'x');
+    testing::internal::CaptureStderr();
+    EXPECT_THROW(Connection("api_test.db"), std::runtime_error);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+
+    std::vector<std::string> messages;
+    setLogSink([&](LogLevel level, const std::string& message) {
+        EXPECT_EQ(level, LogLevel::ERROR);
+        messages.push_back(message);
+    });
+    logMessage(LogLevel::ERROR, "dropped while off");
+    setLogLevel(LogLevel::ERROR);
+    EXPECT_TRUE(logEnabled(LogLevel::ERROR));
+    EXPECT_FALSE(logEnabled(LogLevel::DEBUG));
+    logMessage(LogLevel::DEBUG, "too detailed");
+    logMessage(LogLevel::ERROR, "kept");
+    EXPECT_EQ(messages, (std::vector<std::string>{"kept"}));
+}
@@ -3,6 +3,9 @@
 #include "row.hpp"
 #include <cstdio>
 #include "node.hpp"
+#include <algorithm>
+#include <fstream>
+#include <random>
 
 class TableTest : public ::testing::Test {
 protected:
@@ -121,7 +124,8 @@ TEST_F(TableTest, InsertionPastMaxCellsDoesNotCrash) {
     table->insertRow(Row(LEAF_NODE_MAX_CELLS, "test", "test@example.com"));
     table->insertRow(Row(LEAF_NODE_MAX_CELLS + 1, "test", "test@example.com"));    
     table->insertRow(Row(LEAF_NODE_MAX_CELLS + 2, "test", "test@example.com"));    
-    EXPECT_EQ(table->getUnusedPageNum(), 4);
+    // one split: the root (page 0) becomes internal over two leaves, pages 1 and 2
+    EXPECT_EQ(table->getUnusedPageNum(), 3);
 }
 
 
@@ -243,3 +247,79 @@ TEST_F(TableTest, InternalNodeSplitWorks) {
     // After split, root should have fewer keys (or still be internal with new structure)
     EXPECT_EQ(rootNode.getNodeType(), NodeType::NODE_INTERNAL);
 }
+
+TEST_F(TableTest, RowCountsAnswerRankQueries) {
+    // even keys in shuffled order: enough leaves to split internal nodes too
+    std::vector<uint32_t> keys;
+    for (uint32_t key = 2; key <= 12000; key += 2) {
+        keys.push_back(key);
+    }
+    std::mt19937 generator(7);
+    std::shuffle(keys.begin(), keys.end(), generator);
+    for (uint32_t key : keys) {
+        table->insertRow(Row(key, "test", "test@example.com"));
+    }
+    for (uint32_t key = 4; key <= 12000; key += 4) {
+        table->deleteRow(key);
+    }
+
+    // left: 2, 6, 10, ... (key = 4 * rank + 2)
+    ASSERT_EQ(table->getNumRows(), 3000u);
+    EXPECT_EQ(table->countRowsBelow(0), 0u);
+    EXPECT_EQ(table->countRowsBelow(2), 0u);
+    EXPECT_EQ(table->countRowsBelow(3), 1u);
+    EXPECT_EQ(table->countRowsBelow(4001), 1000u);
+    EXPECT_EQ(table->countRowsBelow(1ull << 40), 3000u);
+    uint32_t key = 0;
+    for (uint32_t rank : {0u, 1u, 1234u, 2999u}) {
+        ASSERT_TRUE(table->keyAtRank(rank, key));
+        EXPECT_EQ(key, 4 * rank + 2);
+    }
+    EXPECT_FALSE(table->keyAtRank(3000, key));
+}
+
+TEST_F(TableTest, OpeningAFileWithoutAValidRootThrows) {
+    table.reset();
+    {
+        std::ofstream zeros("test2.txt", std::ios::binary);
+        std::vector<char> page(2 * PAGE_SIZE, 0);
+        zeros.write(page.data(), page.size());
+    }
+    EXPECT_THROW(Table("test2.txt"), std::runtime_error);
+    // with a valid stamp, an all-zero page 0 reads as an internal node whose
+    // right child is itself
+    {
+        std::fstream file("test2.txt", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(ROOT_PAGE_FORMAT_OFFSET);
+        file.write(reinterpret_cast<const char*>(&DATABASE_FORMAT_STAMP), sizeof(uint32_t));
+    }
+    EXPECT_THROW(Table("test2.txt"), std::runtime_error);
+
+    // a reopened multi-level tree still passes
+    table = std::make_unique<Table>("test.txt");
+    for (uint32_t key = 1; key <= 40; key++) {
+        table->insertRow(Row(key, "test", "test@example.com"));
+    }
+    table.reset();
+    table = std::make_unique<Table>("test.txt");
+    EXPECT_EQ(table->getNumRows(), 40u);
+}
+
+TEST_F(TableTest, OpeningAnotherFormatVersionThrows) {
+    table->insertRow(Row(1, "test", "test@example.com"));
+    table.reset();
+    {
+        std::fstream file("test.txt", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t stamp = DATABASE_FORMAT_MAGIC | (DATABASE_FORMAT_VERSION + 1);
+        file.seekp(ROOT_PAGE_FORMAT_OFFSET);
+        file.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+    }
+    try {
+        Table newer("test.txt");
+        FAIL() << "a file from a newer format must be refused";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("version " + std::to_string(DATABASE_FORMAT_VERSION + 1)),
+                  std::string::npos)
+            << e.what();
+    }
+}
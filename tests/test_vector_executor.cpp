@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <numeric>
+#include <string>
+
+#include "arena.hpp"
+#include "parser.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+
+class VectorExecutorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("test_vector.db");
+        table = std::make_unique<Table>("test_vector.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("test_vector.db");
+    }
+
+    // rows 1..count; username "u<id % 10>", email "<id>@x"
+    void fill(uint32_t count) {
+        for (uint32_t id = 1; id <= count; id++) {
+            table->insertRow(Row(id, "u" + std::to_string(id % 10), std::to_string(id) + "@x"));
+        }
+    }
+
+    // WHERE clause of "SELECT * FROM users WHERE <condition>", with columns resolved
+    const Expr* parseCondition(const std::string& condition) {
+        // kept alive for as long as the fixture: the AST refers to the text
+        const std::string& text = conditions.emplace_back("SELECT * FROM users WHERE " + condition);
+        Parser parser(text, arena);
+        const Statement* statement = nullptr;
+        EXPECT_EQ(parser.parse(statement), PrepareResult::PREPARE_SUCCESS) << parser.getError();
+        resolve(statement->select->where);
+        return statement->select->where;
+    }
+
+    static void resolve(const Expr* expr) {
+        if (expr == nullptr) {
+            return;
+        }
+        if (expr->kind == ExprKind::COLUMN) {
+            expr->column = expr->text == "id" ? COLUMN_ID : expr->text == "username" ? COLUMN_USERNAME : COLUMN_EMAIL;
+        }
+        resolve(expr->left);
+        resolve(expr->right);
+    }
+
+    // Drains op, returning the selected ids in output order
+    static std::vector<int64_t> drainIds(BatchOperator& op, uint32_t idColumn = COLUMN_ID) {
+        std::vector<int64_t> ids;
+        Batch batch;
+        while (op.next(batch)) {
+            EXPECT_GT(batch.selectedCount, 0u);
+            for (uint32_t i = 0; i < batch.selectedCount; i++) {
+                ids.push_back(batch.columns[idColumn].integers[batch.selection[i]]);
+            }
+        }
+        return ids;
+    }
+
+    std::unique_ptr<Table> table;
+    std::string sql;
+    std::deque<std::string> conditions;
+    Arena arena;
+    std::vector<Value> noBindings;
+    VectorEvaluator evaluator{noBindings};
+};
+
+TEST_F(VectorExecutorTest, ScanEmitsFullBatchesAcrossLeaves) {
+    fill(2500);
+    TableScan scan(*table, 100, 2200);
+    Batch batch;
+    ASSERT_TRUE(scan.next(batch));
+    EXPECT_EQ(batch.selectedCount, BATCH_SIZE);
+    EXPECT_EQ(batch.columns[COLUMN_ID].integers[0], 100);
+    EXPECT_EQ(batch.columns[COLUMN_USERNAME].texts[0], "u0");
+    EXPECT_EQ(batch.columns[COLUMN_EMAIL].texts[5], "105@x");
+    ASSERT_TRUE(scan.next(batch));
+    EXPECT_EQ(batch.selectedCount, BATCH_SIZE);
+    ASSERT_TRUE(scan.next(batch));
+    EXPECT_EQ(batch.selectedCount, 2101u - 2 * BATCH_SIZE);
+    EXPECT_EQ(batch.columns[COLUMN_ID].integers[batch.selectedCount - 1], 2200);
+    EXPECT_FALSE(scan.next(batch));
+
+    TableScan empty(*table, 10, 5);
+    EXPECT_FALSE(empty.next(batch));
+}
+
+TEST_F(VectorExecutorTest, FilterKeepsMatchingRowsAndShortCircuits) {
+    fill(300);
+    // id - 150 is zero on row 150, which the left side of AND rejects
+    FilterOperator filter(std::make_unique<TableScan>(*table),
+                          {parseCondition("id <> 150 AND 300 / (id - 150) > 2 OR username = 'u7' AND id < 20")},
+                          evaluator);
+    std::vector<int64_t> ids = drainIds(filter);
+    std::vector<int64_t> expected;
+    for (int64_t id = 1; id <= 300; id++) {
+        if ((id != 150 && 300 / (id - 150) > 2) || (id % 10 == 7 && id < 20)) {
+            expected.push_back(id);
+        }
+    }
+    EXPECT_EQ(ids, expected);
+
+    FilterOperator typeError(std::make_unique<TableScan>(*table), {parseCondition("username = 5")}, evaluator);
+    Batch batch;
+    EXPECT_THROW(typeError.next(batch), ExecutionError);
+
+    FilterOperator like(std::make_unique<TableScan>(*table, 1, 100),
+                        {parseCondition("email LIKE '_7%'"), parseCondition("username LIKE 'u_'")}, evaluator);
+    EXPECT_EQ(drainIds(like), (std::vector<int64_t>{17, 27, 37, 47, 57, 67, 77, 87, 97}));
+}
+
+TEST_F(VectorExecutorTest, ScanFiltersCellsBeforeDecoding) {
+    fill(3000);
+    FieldFilter username;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::EQUALS, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "u3", username));
+    FieldFilter email;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::PREFIX, Row::getEmailOffset(), COLUMN_EMAIL_SIZE, "2", email));
+    TableScan scan(*table, 100, 2900);
+    scan.pushFilter(username);
+    scan.pushFilter(email);
+    std::vector<int64_t> expected;
+    for (int64_t id = 100; id <= 2900; id++) {
+        if (id % 10 == 3 && std::to_string(id)[0] == '2') {
+            expected.push_back(id);
+        }
+    }
+    EXPECT_EQ(drainIds(scan), expected);
+    EXPECT_EQ(scan.getRowsExamined(), 2801u);
+    EXPECT_EQ(scan.getRowsMaterialized(), expected.size());
+
+    // batches still fill up to BATCH_SIZE and resume mid-leaf
+    FieldFilter all;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::SUFFIX, Row::getEmailOffset(), COLUMN_EMAIL_SIZE, "@x", all));
+    TableScan everything(*table);
+    everything.pushFilter(all);
+    Batch batch;
+    ASSERT_TRUE(everything.next(batch));
+    EXPECT_EQ(batch.selectedCount, BATCH_SIZE);
+    EXPECT_EQ(drainIds(everything).size(), 3000u - BATCH_SIZE);
+}
+
+TEST_F(VectorExecutorTest, IndexScanFetchesOnlyMatchingRows) {
+    fill(3000);
+    table->createIndex(COLUMN_EMAIL);
+    table->createIndex(COLUMN_USERNAME);
+
+    IndexScan point(*table, *table->getIndex(COLUMN_EMAIL), FieldMatch::EQUALS, "1234@x");
+    EXPECT_EQ(drainIds(point), std::vector<int64_t>{1234});
+    EXPECT_EQ(point.getRowsExamined(), 1u);
+
+    // prefix matches come back in id order, restricted to the key range and the pushed filter
+    IndexScan prefix(*table, *table->getIndex(COLUMN_EMAIL), FieldMatch::PREFIX, "12", 100, 2000);
+    FieldFilter username;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::EQUALS, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "u5", username));
+    prefix.pushFilter(username);
+    std::vector<int64_t> expected;
+    for (int64_t id = 100; id <= 2000; id++) {
+        if (std::to_string(id).compare(0, 2, "12") == 0 && id % 10 == 5) {
+            expected.push_back(id);
+        }
+    }
+    EXPECT_EQ(drainIds(prefix), expected);
+    EXPECT_EQ(prefix.getRowsExamined(), 110u);  // 120..129 and 1200..1299
+
+    // more matches than a batch holds
+    IndexScan many(*table, *table->getIndex(COLUMN_USERNAME), FieldMatch::EQUALS, "u0");
+    Batch batch;
+    ASSERT_TRUE(many.next(batch));
+    EXPECT_EQ(batch.selectedCount, 300u);
+    EXPECT_EQ(batch.columns[COLUMN_EMAIL].texts[batch.selection[299]], "3000@x");
+    EXPECT_FALSE(many.next(batch));
+}
+
+TEST_F(VectorExecutorTest, CoveringIndexScanNeverReadsTheTable) {
+    fill(3000);
+    table->createIndex(COLUMN_EMAIL, 1u << COLUMN_USERNAME);
+    const SecondaryIndex& index = *table->getIndex(COLUMN_EMAIL);
+    FieldFilter username;
+    ASSERT_TRUE(makeFieldFilter(FieldMatch::EQUALS, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, "u7", username));
+
+    IndexScan fetching(*table, index, FieldMatch::PREFIX, "2", 0, 2500);
+    IndexScan covering(*table, index, FieldMatch::PREFIX, "2", 0, 2500, true);
+    fetching.pushFilter(username);
+    covering.pushFilter(username);
+    Batch fetched;
+    Batch covered;
+    ASSERT_TRUE(fetching.next(fetched));
+    ASSERT_TRUE(covering.next(covered));
+    ASSERT_EQ(covered.selectedCount, fetched.selectedCount);
+    EXPECT_EQ(covered.selectedCount, 61u);  // 27, 207..297 and 2007..2497
+    for (uint32_t i = 0; i < covered.selectedCount; i++) {
+        for (uint32_t column = 0; column < NUM_TABLE_COLUMNS; column++) {
+            EXPECT_EQ(covered.columns[column].get(i).integer, fetched.columns[column].get(i).integer);
+            EXPECT_EQ(covered.columns[column].get(i).text, fetched.columns[column].get(i).text);
+        }
+    }
+    EXPECT_FALSE(covering.next(covered));
+    EXPECT_EQ(covering.getRowsExamined(), fetching.getRowsExamined());
+    EXPECT_EQ(fetching.getTableLookups(), fetching.getRowsExamined());
+    EXPECT_EQ(covering.getTableLookups(), 0u);
+}
+
+TEST_F(VectorExecutorTest, SortLimitAndProject) {
+    fill(1500);
+    std::unique_ptr<BatchOperator> root = std::make_unique<TableScan>(*table);
+    root = std::make_unique<SortOperator>(std::move(root),
+                                          std::vector<SortKey>{{COLUMN_USERNAME, true}, {COLUMN_ID, false}});
+    root = std::make_unique<LimitOperator>(std::move(root), 1200, 5);
+    std::vector<int64_t> ids = drainIds(*root);
+    // 150 rows per username, u9 first: rows 1200.. are the u1 group in id order
+    EXPECT_EQ(ids, (std::vector<int64_t>{1, 11, 21, 31, 41}));
+
+    sql = "SELECT id * 2, email FROM users";
+    Parser parser(sql, arena);
+    const Statement* statement = nullptr;
+    ASSERT_EQ(parser.parse(statement), PrepareResult::PREPARE_SUCCESS);
+    std::vector<const Expr*> columns(statement->select->columns.begin(), statement->select->columns.end());
+    for (const Expr* column : columns) {
+        resolve(column);
+    }
+    Batch projectInput;
+    ProjectOperator project(std::make_unique<LimitOperator>(std::make_unique<TableScan>(*table), 1023, 2),
+                            columns, evaluator, projectInput);
+    Batch batch;
+    ASSERT_TRUE(project.next(batch));
+    ASSERT_EQ(batch.columns.size(), 2u);
+    ASSERT_EQ(batch.selectedCount, 1u);  // the second row is in the next scan batch
+    EXPECT_EQ(batch.columns[0].integers[batch.selection[0]], 2048);
+    EXPECT_EQ(batch.columns[1].texts[batch.selection[0]], "1024@x");
+    ASSERT_TRUE(project.next(batch));
+    EXPECT_EQ(batch.columns[0].integers[batch.selection[0]], 2050);
+    EXPECT_FALSE(project.next(batch));
+}
+
+TEST_F(VectorExecutorTest, SortSpillsAndKeepsTopRows) {
+    fill(3000);
+    auto descendingByEmail = [](uint32_t id, uint32_t other) {
+        return std::to_string(id) + "@x" > std::to_string(other) + "@x";
+    };
+    std::vector<uint32_t> ids(3000);
+    std::iota(ids.begin(), ids.end(), 1u);
+    std::sort(ids.begin(), ids.end(), descendingByEmail);
+
+    // a budget far below the input: sorted runs spill and are merged back
+    SortOperator spilling(std::make_unique<TableScan>(*table), {{COLUMN_EMAIL, true}}, UINT64_MAX, 16 * 1024);
+    Batch batch;
+    std::vector<uint32_t> seen;
+    while (spilling.next(batch)) {
+        for (uint32_t i = 0; i < batch.selectedCount; i++) {
+            uint32_t row = batch.selection[i];
+            EXPECT_EQ(batch.columns[2].texts[row], std::to_string(batch.columns[0].integers[row]) + "@x");
+            seen.push_back(static_cast<uint32_t>(batch.columns[0].integers[row]));
+        }
+    }
+    EXPECT_GT(spilling.getSpilledRuns(), 1u);
+    EXPECT_EQ(seen, ids);
+
+    SortOperator topN(std::make_unique<TableScan>(*table), {{COLUMN_EMAIL, true}}, 5);
+    ASSERT_TRUE(topN.next(batch));
+    ASSERT_EQ(batch.selectedCount, 5u);
+    for (uint32_t i = 0; i < 5; i++) {
+        EXPECT_EQ(batch.columns[0].integers[batch.selection[i]], ids[i]);
+    }
+    EXPECT_FALSE(topN.next(batch));
+    EXPECT_EQ(topN.getSpilledRuns(), 0u);
+}
+
+TEST_F(VectorExecutorTest, AggregatesFoldEveryBatch) {
+    fill(2000);
+    AggregateOperator aggregate(std::make_unique<TableScan>(*table),
+                                {{AggregateFunction::COUNT, 0},
+                                 {AggregateFunction::SUM, COLUMN_ID},
+                                 {AggregateFunction::MIN, COLUMN_EMAIL},
+                                 {AggregateFunction::MAX, COLUMN_ID}});
+    Batch batch;
+    ASSERT_TRUE(aggregate.next(batch));
+    EXPECT_EQ(batch.columns[0].integers[0], 2000);
+    EXPECT_EQ(batch.columns[1].integers[0], 2000 * 2001 / 2);
+    EXPECT_EQ(batch.columns[2].texts[0], "1000@x");
+    EXPECT_EQ(batch.columns[3].integers[0], 2000);
+    EXPECT_FALSE(aggregate.next(batch));
+
+    AggregateOperator count(std::make_unique<TableScan>(*table, 5000, 6000), {{AggregateFunction::COUNT, 0}});
+    ASSERT_TRUE(count.next(batch));
+    EXPECT_EQ(batch.columns[0].integers[0], 0);
+    AggregateOperator minimum(std::make_unique<TableScan>(*table, 5000, 6000), {{AggregateFunction::MIN, COLUMN_ID}});
+    EXPECT_FALSE(minimum.next(batch));
+}
+
+TEST_F(VectorExecutorTest, AggregateGroupsByHashedKey) {
+    fill(3000);  // usernames cycle through u0 .. u9
+    AggregateOperator grouped(std::make_unique<TableScan>(*table), {COLUMN_USERNAME},
+                              {{AggregateFunction::COUNT, 0}, {AggregateFunction::MIN, COLUMN_ID}});
+    Batch batch;
+    ASSERT_TRUE(grouped.next(batch));
+    ASSERT_EQ(batch.selectedCount, 10u);
+    int64_t total = 0;
+    for (uint32_t i = 0; i < batch.selectedCount; i++) {
+        uint32_t row = batch.selection[i];
+        // groups come out in order of first appearance: ids 1..10
+        EXPECT_EQ(batch.columns[2].integers[row], i + 1);
+        EXPECT_EQ(batch.columns[0].texts[row], "u" + std::to_string((i + 1) % 10));
+        total += batch.columns[1].integers[row];
+    }
+    EXPECT_EQ(total, 3000);
+    EXPECT_FALSE(grouped.next(batch));
+
+    // every row its own group: the output spans several batches
+    AggregateOperator byId(std::make_unique<TableScan>(*table), {COLUMN_ID}, {{AggregateFunction::COUNT, 0}});
+    uint32_t groups = 0;
+    while (byId.next(batch)) {
+        groups += batch.selectedCount;
+    }
+    EXPECT_EQ(groups, 3000u);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cursor.hpp"
+#include "node.hpp"
+#include "table.hpp"
+#include "vector_executor.hpp"
+#include "zone_map.hpp"
+
+class ZoneMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::remove("zone_test.db");
+        std::remove("zone_test.db-wal");
+        table = std::make_unique<Table>("zone_test.db");
+    }
+
+    void TearDown() override {
+        table.reset();
+        std::remove("zone_test.db");
+        std::remove("zone_test.db-wal");
+    }
+
+    // Usernames rise with the id, so each leaf covers its own run of them
+    static std::string nameOf(uint32_t id) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "u%06u", id);
+        return name;
+    }
+
+    static FieldFilter usernameFilter(FieldMatch match, const std::string& literal) {
+        FieldFilter filter;
+        makeFieldFilter(match, Row::getUsernameOffset(), COLUMN_USERNAME_SIZE, literal, filter);
+        return filter;
+    }
+
+    // Ids a scan returns
+    static std::vector<int64_t> drain(TableScan& scan) {
+        std::vector<int64_t> ids;
+        Batch batch;
+        while (scan.next(batch)) {
+            for (uint32_t s = 0; s < batch.selectedCount; s++) {
+                ids.push_back(batch.columns[COLUMN_ID].integers[batch.selection[s]]);
+            }
+        }
+        return ids;
+    }
+
+    // Every row's username and email lie in its leaf's zone
+    void expectZonesHoldTheirRows() {
+        const ZoneMap& zones = *table->getZoneMap();
+        for (Cursor cursor(*table); !cursor.isEndOfTable(); cursor.cursorAdvance()) {
+            Row row = Row::deserialize(cursor.cursorSlot());
+            ZoneRange username;
+            ZoneRange email;
+            ASSERT_TRUE(ZoneMap::rangeOf(usernameFilter(FieldMatch::EQUALS, row.getUsername()), username));
+            FieldFilter emailFilter;
+            makeFieldFilter(FieldMatch::EQUALS, Row::getEmailOffset(), COLUMN_EMAIL_SIZE, row.getEmail(), emailFilter);
+            ASSERT_TRUE(ZoneMap::rangeOf(emailFilter, email));
+            ASSERT_TRUE(zones.mayMatch(cursor.getPageNum(), {username, email})) << row.getId();
+        }
+    }
+
+    std::unique_ptr<Table> table;
+};
+
+TEST_F(ZoneMapTest, ScansSkipLeavesOutsideTheFilter) {
+    for (uint32_t id = 1; id <= 2000; id++) {
+        table->insertRow(Row(id, nameOf(id), "e" + std::to_string(id % 7) + "@example.com"));
+    }
+    TableScan before(*table);
+    before.pushFilter(usernameFilter(FieldMatch::EQUALS, nameOf(1234)));
+    EXPECT_EQ(drain(before), std::vector<int64_t>{1234});
+    EXPECT_EQ(before.getLeavesSkipped(), 0u);
+    uint64_t leaves = before.getLeavesRead();
+
+    table->createZoneMap();
+    EXPECT_THROW(table->createZoneMap(), std::invalid_argument);
+    EXPECT_GT(table->getZoneMap()->getZonePageCount(), 0u);
+
+    ScanStats stats;
+    TableScan point(*table);
+    point.pushFilter(usernameFilter(FieldMatch::EQUALS, nameOf(1234)));
+    point.countInto(&stats);
+    EXPECT_EQ(drain(point), std::vector<int64_t>{1234});
+    EXPECT_EQ(point.getLeavesRead(), 1u);
+    EXPECT_EQ(point.getLeavesRead() + point.getLeavesSkipped(), leaves);
+    EXPECT_EQ(stats.leavesSkipped.load(), point.getLeavesSkipped());
+
+    // u0015xx: ids 1500..1599, within a key range that cuts through leaves
+    TableScan prefix(*table, 1550, 1800);
+    prefix.pushFilter(usernameFilter(FieldMatch::PREFIX, "u0015"));
+    std::vector<int64_t> expected(50);
+    std::iota(expected.begin(), expected.end(), 1550);
+    EXPECT_EQ(drain(prefix), expected);
+    EXPECT_GT(prefix.getLeavesSkipped(), 0u);
+
+    // ranges from comparisons only skip; the rows themselves are not checked
+    TableScan range(*table);
+    range.pushZoneRange(ZoneMap::rangeFrom(COLUMN_USERNAME, nameOf(1990)));
+    std::vector<int64_t> ids = drain(range);
+    EXPECT_EQ(ids.back(), 2000);
+    EXPECT_LT(ids.size(), 2 * LEAF_NODE_MAX_CELLS + 11);
+    EXPECT_LE(ids.front(), 1990);
+
+    // a filter on a column no leaf's range separates skips nothing
+    FieldFilter email;
+    makeFieldFilter(FieldMatch::EQUALS, Row::getEmailOffset(), COLUMN_EMAIL_SIZE, "e3@example.com", email);
+    TableScan common(*table);
+    common.pushFilter(email);
+    EXPECT_EQ(drain(common).size(), 2000u / 7 + 1);
+    EXPECT_EQ(common.getLeavesSkipped(), 0u);
+}
+
+TEST_F(ZoneMapTest, KeptCurrentThroughSplitsUpdatesAndDeletes) {
+    table->createZoneMap();
+    std::vector<uint32_t> ids(3000);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::mt19937 generator(7);
+    std::shuffle(ids.begin(), ids.end(), generator);
+    std::map<uint32_t, std::string> names;
+    for (uint32_t id : ids) {
+        table->insertRow(Row(id, nameOf(id), "e@example.com"));
+        names[id] = nameOf(id);
+    }
+    expectZonesHoldTheirRows();
+
+    // a renamed row widens its leaf's zone; a delete recomputes it
+    for (uint32_t i = 0; i < 30; i++) {
+        table->updateRow(Row(ids[i], "z" + nameOf(ids[i]), "zz@example.com"));
+        names[ids[i]] = "z" + nameOf(ids[i]);
+    }
+    for (uint32_t i = 300; i < 1300; i++) {
+        ASSERT_TRUE(table->deleteRow(ids[i]));
+        names.erase(ids[i]);
+    }
+    expectZonesHoldTheirRows();
+
+    for (uint32_t probe : {ids[5], ids[29], ids[1500], ids[2999]}) {
+        TableScan scan(*table);
+        scan.pushFilter(usernameFilter(FieldMatch::EQUALS, names[probe]));
+        EXPECT_EQ(drain(scan), std::vector<int64_t>{probe});
+        EXPECT_GT(scan.getLeavesSkipped(), 0u);
+    }
+    // a deleted row's name is found nowhere, and most leaves are not even read
+    TableScan all(*table);
+    EXPECT_EQ(drain(all).size(), names.size());
+    TableScan gone(*table);
+    gone.pushFilter(usernameFilter(FieldMatch::EQUALS, nameOf(ids[700])));
+    EXPECT_TRUE(drain(gone).empty());
+    EXPECT_LT(gone.getLeavesRead() * 4, all.getLeavesRead());
+    EXPECT_EQ(gone.getLeavesRead() + gone.getLeavesSkipped(), all.getLeavesRead());
+
+    TableScan renamed(*table);
+    renamed.pushFilter(usernameFilter(FieldMatch::PREFIX, "z"));
+    EXPECT_EQ(drain(renamed).size(), 30u);
+}
+
+TEST_F(ZoneMapTest, PersistsAndFollowsRollbacks) {
+    for (uint32_t id = 1; id <= 1000; id++) {
+        table->insertRow(Row(id, nameOf(id), "e"));
+    }
+    table->createZoneMap();
+    table.reset();
+    table = std::make_unique<Table>("zone_test.db");
+    ASSERT_NE(table->getZoneMap(), nullptr);
+    TableScan point(*table);
+    point.pushFilter(usernameFilter(FieldMatch::EQUALS, nameOf(500)));
+    EXPECT_EQ(drain(point), std::vector<int64_t>{500});
+    EXPECT_GT(point.getLeavesSkipped(), 0u);
+
+    // a rolled-back rename leaves the zone as it was before
+    table->beginTransaction();
+    table->updateRow(Row(1, "zzz", "e"));
+    for (uint32_t id = 1001; id <= 1100; id++) {
+        table->insertRow(Row(id, "zzz", "e"));
+    }
+    table->rollbackTransaction();
+    TableScan renamed(*table);
+    renamed.pushFilter(usernameFilter(FieldMatch::EQUALS, "zzz"));
+    EXPECT_TRUE(drain(renamed).empty());
+    EXPECT_EQ(renamed.getLeavesRead(), 0u);
+    expectZonesHoldTheirRows();
+
+    // a rolled-back CREATE drops the map
+    table.reset();
+    std::remove("zone_test.db");
+    table = std::make_unique<Table>("zone_test.db");
+    table->beginTransaction();
+    table->createZoneMap();
+    table->rollbackTransaction();
+    EXPECT_EQ(table->getZoneMap(), nullptr);
+}